@@ -11,6 +11,7 @@
 #include "Error.h"
 #include "InputFiles.h"
 #include "Symbols.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Support/COFF.h"
 #include "llvm/Support/Debug.h"
@@ -147,25 +148,37 @@ void SectionChunk::writeTo(uint8_t *Buf) const {
   ArrayRef<uint8_t> A = getContents();
   memcpy(Buf + OutputSectionOff, A.data(), A.size());
 
-  // Apply relocations.
-  for (const coff_relocation &Rel : Relocs) {
-    uint8_t *Off = Buf + OutputSectionOff + Rel.VirtualAddress;
-    SymbolBody *Body = File->getSymbolBody(Rel.SymbolTableIndex);
-    Defined *Sym = cast<Defined>(Body);
-    uint64_t P = RVA + Rel.VirtualAddress;
-    switch (Config->Machine) {
-    case AMD64:
-      applyRelX64(Off, Rel.Type, Sym, P);
-      break;
-    case I386:
-      applyRelX86(Off, Rel.Type, Sym, P);
-      break;
-    case ARMNT:
-      applyRelARM(Off, Rel.Type, Sym, P);
-      break;
-    default:
-      llvm_unreachable("unknown machine type");
-    }
+  if (!NumRelocs)
+    return;
+
+  // Apply relocations. Resolve all targets in one batch pass first,
+  // then run a tight per-machine apply loop, so that neither the
+  // symbol table lookup nor the machine dispatch sits inside the
+  // per-relocation hot loop.
+  SmallVector<Defined *, 64> Targets;
+  Targets.reserve(NumRelocs);
+  for (const coff_relocation &Rel : Relocs)
+    Targets.push_back(cast<Defined>(File->getSymbolBody(Rel.SymbolTableIndex)));
+
+  size_t I = 0;
+  switch (Config->Machine) {
+  case AMD64:
+    for (const coff_relocation &Rel : Relocs)
+      applyRelX64(Buf + OutputSectionOff + Rel.VirtualAddress, Rel.Type,
+                  Targets[I++], RVA + Rel.VirtualAddress);
+    break;
+  case I386:
+    for (const coff_relocation &Rel : Relocs)
+      applyRelX86(Buf + OutputSectionOff + Rel.VirtualAddress, Rel.Type,
+                  Targets[I++], RVA + Rel.VirtualAddress);
+    break;
+  case ARMNT:
+    for (const coff_relocation &Rel : Relocs)
+      applyRelARM(Buf + OutputSectionOff + Rel.VirtualAddress, Rel.Type,
+                  Targets[I++], RVA + Rel.VirtualAddress);
+    break;
+  default:
+    llvm_unreachable("unknown machine type");
   }
 }
 
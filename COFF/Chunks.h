@@ -115,6 +115,9 @@ class SectionChunk : public Chunk {
   // Identical COMDAT Folding feature accesses section internal data.
   friend class ICF;
 
+  // /merge:strings redirects duplicate literal sections through Repl.
+  friend void mergeStrings(const std::vector<Chunk *> &Chunks);
+
 public:
   class symbol_iterator : public llvm::iterator_adaptor_base<
                               symbol_iterator, const coff_relocation *,
@@ -159,6 +162,9 @@ public:
   StringRef getDebugName() override;
   void setSymbol(DefinedRegular *S) { if (!Sym) Sym = S; }
 
+  // Returns the object file this chunk was created from.
+  ObjectFile *getFile() const { return File; }
+
   // Used by the garbage collector.
   bool isLive() { return !Config->DoGC || Live; }
   void markLive() {
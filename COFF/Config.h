@@ -80,11 +80,19 @@ struct Configuration {
   SymbolBody *Entry = nullptr;
   bool NoEntry = false;
   std::string OutputFile;
+  // For /map: the writer emits a link.exe-style map of the final image
+  // layout (see MapFile.cpp). Empty means no map is written.
+  std::string MapFile;
   bool DoGC = true;
   bool DoICF = true;
+  bool MergeStrings = false;
   bool Relocatable = true;
   bool Force = false;
   bool Debug = false;
+  // For /debug:fastlink: write a minimal PDB that leaves type and
+  // symbol records in the object files instead of merging them.
+  bool PDBFastlink = false;
+  bool Release = false;
   bool WriteSymtab = true;
   unsigned DebugTypes = static_cast<unsigned>(DebugType::None);
   StringRef PDBPath;
@@ -116,6 +124,11 @@ struct Configuration {
   // Used for /merge:from=to (e.g. /merge:.rdata=.text)
   std::map<StringRef, StringRef> Merge;
 
+  // Used for /order:@file and /call-graph-ordering-file. Listed symbols
+  // get negative priorities, so the writer lays out their chunks before
+  // unlisted ones (which default to priority zero).
+  std::map<StringRef, int> Order;
+
   // Used for /section=.name,{DEKPRSW} to set section attributes.
   std::map<StringRef, uint32_t> Section;
 
@@ -28,6 +28,7 @@
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <climits>
 #include <memory>
 
 using namespace llvm;
@@ -91,9 +92,100 @@ static bool isDecorated(StringRef Sym) {
   return Sym.startswith("_") || Sym.startswith("@") || Sym.startswith("?");
 }
 
+// Parses the file given to /order:@file. The file is a list of symbol
+// names, one per line; everything after a ';' is a comment. Listed
+// functions are given negative, ascending priorities, so the writer
+// lays their chunks out before unlisted ones and in the listed order.
+static void parseOrderFile(MemoryBufferRef MB) {
+  SmallVector<StringRef, 0> Lines;
+  MB.getBuffer().split(Lines, '\n');
+  for (StringRef Line : Lines) {
+    StringRef S = Line.split(';').first.trim();
+    if (S.empty())
+      continue;
+    if (Config->Machine == I386 && !isDecorated(S))
+      S = Saver.save("_" + S);
+    // The first occurrence wins, so explicit /order entries keep
+    // priority over names coming from a call graph profile.
+    Config->Order.insert({S, INT_MIN + (int)Config->Order.size()});
+  }
+}
+
+// Parses the file given to /call-graph-ordering-file. The file holds one
+// profile edge per line:
+// <caller> <callee> <weight>
+// Edges are taken in descending weight order and the callee's cluster is
+// appended to the caller's, so hot caller/callee pairs end up adjacent.
+// The flattened cluster sequence is appended to Config->Order behind any
+// explicit /order entries.
+static void parseCallGraphFile(MemoryBufferRef MB) {
+  struct Edge {
+    StringRef From;
+    StringRef To;
+    uint64_t Weight;
+  };
+  std::vector<Edge> Edges;
+  SmallVector<StringRef, 0> Lines;
+  MB.getBuffer().split(Lines, '\n');
+  for (StringRef Line : Lines) {
+    SmallVector<StringRef, 3> Fields;
+    Line.split(Fields, ' ', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    if (Fields.empty())
+      continue;
+    uint64_t Weight;
+    if (Fields.size() != 3 || Fields[2].getAsInteger(10, Weight))
+      fatal("malformed call graph profile line: " + Line);
+    StringRef From = Fields[0];
+    StringRef To = Fields[1];
+    if (Config->Machine == I386) {
+      if (!isDecorated(From))
+        From = Saver.save("_" + From);
+      if (!isDecorated(To))
+        To = Saver.save("_" + To);
+    }
+    Edges.push_back({From, To, Weight});
+  }
+  std::stable_sort(Edges.begin(), Edges.end(),
+                   [](const Edge &A, const Edge &B) {
+                     return A.Weight > B.Weight;
+                   });
+
+  // Greedily merge clusters along the heaviest edges.
+  std::vector<std::vector<StringRef>> Clusters;
+  std::map<StringRef, unsigned> ClusterOf;
+  auto IdFor = [&](StringRef S) {
+    auto It = ClusterOf.insert({S, (unsigned)Clusters.size()});
+    if (It.second)
+      Clusters.push_back({S});
+    return It.first->second;
+  };
+  for (const Edge &E : Edges) {
+    unsigned From = IdFor(E.From);
+    unsigned To = IdFor(E.To);
+    if (From == To)
+      continue;
+    for (StringRef S : Clusters[To]) {
+      Clusters[From].push_back(S);
+      ClusterOf[S] = From;
+    }
+    Clusters[To].clear();
+  }
+  for (std::vector<StringRef> &C : Clusters)
+    for (StringRef S : C)
+      Config->Order.insert({S, INT_MIN + (int)Config->Order.size()});
+}
+
 // Parses .drectve section contents and returns a list of files
 // specified by /defaultlib.
 void LinkerDriver::parseDirectives(StringRef S) {
+  // Most objects carry byte-identical directive strings (compilers
+  // inject the same /DEFAULTLIB list into every TU), and every
+  // directive below is idempotent: re-running one adds no libraries,
+  // exports, or symbols the first run did not. So each unique string
+  // is parsed and applied exactly once.
+  if (!SeenDirectives.insert(CachedHashStringRef(S)).second)
+    return;
+
   opt::InputArgList Args = Parser.parse(S);
 
   for (auto *Arg : Args) {
@@ -139,25 +231,60 @@ void LinkerDriver::parseDirectives(StringRef S) {
   }
 }
 
+// Returns true if a file named Filename may exist in directory Dir.
+// Probing every search directory for every library with stat calls is
+// wasteful -- a link against the Windows SDK issues tens of thousands
+// of redundant stats -- so each directory is listed once and misses
+// are answered from memory. Names are compared case-insensitively to
+// match Windows filesystem semantics. If a directory cannot be
+// listed, every probe reports "maybe" so the caller falls back to
+// stat and error semantics do not change.
+bool LinkerDriver::mayExistInDir(StringRef Dir, StringRef Filename) {
+  auto It = DirListings.find(Dir);
+  if (It == DirListings.end()) {
+    std::error_code EC;
+    Optional<llvm::StringSet<>> Set = llvm::StringSet<>();
+    for (sys::fs::directory_iterator I(Dir.empty() ? "." : Dir, EC), E;
+         I != E && !EC; I.increment(EC))
+      Set->insert(StringRef(sys::path::filename(I->path())).lower());
+    if (EC)
+      Set = None;
+    It = DirListings.insert(std::make_pair(Dir, std::move(Set))).first;
+  }
+  if (!It->second)
+    return true;
+  return It->second->count(Filename.lower());
+}
+
 // Find file from search paths. You can omit ".obj", this function takes
 // care of that. Note that the returned path is not guaranteed to exist.
 StringRef LinkerDriver::doFindFile(StringRef Filename) {
   bool HasPathSep = (Filename.find_first_of("/\\") != StringRef::npos);
   if (HasPathSep)
     return Filename;
+  auto Memo = ResolvedFilenames.find(Filename);
+  if (Memo != ResolvedFilenames.end())
+    return Memo->second;
+  StringRef Ret = Filename;
   bool HasExt = (Filename.find('.') != StringRef::npos);
   for (StringRef Dir : SearchPaths) {
     SmallString<128> Path = Dir;
     sys::path::append(Path, Filename);
-    if (sys::fs::exists(Path.str()))
-      return Saver.save(Path.str());
+    if (mayExistInDir(Dir, Filename) && sys::fs::exists(Path.str())) {
+      Ret = Saver.save(Path.str());
+      break;
+    }
     if (!HasExt) {
       Path.append(".obj");
-      if (sys::fs::exists(Path.str()))
-        return Saver.save(Path.str());
+      if (mayExistInDir(Dir, sys::path::filename(Path.str())) &&
+          sys::fs::exists(Path.str())) {
+        Ret = Saver.save(Path.str());
+        break;
+      }
     }
   }
-  return Filename;
+  ResolvedFilenames[Filename] = Ret;
+  return Ret;
 }
 
 // Resolves a file path. This never returns the same path
@@ -377,6 +504,10 @@ void LinkerDriver::link(ArrayRef<const char *> ArgsArr) {
   if (Args.hasArg(OPT_force) || Args.hasArg(OPT_force_unresolved))
     Config->Force = true;
 
+  // Handle /release
+  if (Args.hasArg(OPT_release))
+    Config->Release = true;
+
   // Handle /debug
   if (Args.hasArg(OPT_debug)) {
     Config->Debug = true;
@@ -386,6 +517,21 @@ void LinkerDriver::link(ArrayRef<const char *> ArgsArr) {
             : getDefaultDebugType(Args);
   }
 
+  // Handle /debug:{full,fastlink}. Fastlink writes a minimal PDB whose
+  // module table refers to the debug info left in the object files
+  // instead of merging it, for fast developer-loop links.
+  if (auto *Arg = Args.getLastArg(OPT_debug_opt)) {
+    StringRef S = Arg->getValue();
+    if (S.equals_lower("fastlink"))
+      Config->PDBFastlink = true;
+    else if (!S.equals_lower("full"))
+      fatal("/debug: unknown option: " + S);
+    if (!Config->Debug) {
+      Config->Debug = true;
+      Config->DebugTypes = getDefaultDebugType(Args);
+    }
+  }
+
   // Create a dummy PDB file to satisfy build sytem rules.
   if (auto *Arg = Args.getLastArg(OPT_pdb))
     Config->PDBPath = Arg->getValue();
@@ -562,8 +708,8 @@ void LinkerDriver::link(ArrayRef<const char *> ArgsArr) {
   }
 
   // Windows specific -- Input files can be Windows resource files (.res files).
-  // We invoke cvtres.exe to convert resource files to a regular COFF file
-  // then link the result file normally.
+  // We convert them to a regular COFF file in memory and then link the
+  // result normally.
   std::vector<MemoryBufferRef> Resources;
   auto NotResource = [](MemoryBufferRef MB) {
     return identify_magic(MB.getBuffer()) != file_magic::windows_resource;
@@ -600,6 +746,18 @@ void LinkerDriver::link(ArrayRef<const char *> ArgsArr) {
     Config->Machine = AMD64;
   }
 
+  // Handle /order and /call-graph-ordering-file. This has to be done
+  // after the machine type is known because x86 symbol names in the
+  // files may need to be decorated.
+  if (auto *Arg = Args.getLastArg(OPT_order)) {
+    StringRef V = Arg->getValue();
+    if (!V.startswith("@"))
+      fatal("malformed /order option: '@' missing");
+    parseOrderFile(openFile(V.substr(1)));
+  }
+  if (auto *Arg = Args.getLastArg(OPT_call_graph_ordering_file))
+    parseCallGraphFile(openFile(Arg->getValue()));
+
   // Windows specific -- Convert Windows resource files to a COFF file.
   if (!Resources.empty()) {
     std::unique_ptr<MemoryBuffer> MB = convertResToCOFF(Resources);
@@ -766,10 +924,25 @@ void LinkerDriver::link(ArrayRef<const char *> ArgsArr) {
   if (Config->DoGC)
     markLive(Symtab.getChunks());
 
+  // Merge duplicate string literal sections.
+  if (Config->MergeStrings)
+    mergeStrings(Symtab.getChunks());
+
   // Identify identical COMDAT sections to merge them.
   if (Config->DoICF)
     doICF(Symtab.getChunks());
 
+  // Handle /map. The map itself is emitted by the writer (see
+  // MapFile.cpp) because it describes the final image layout.
+  if (auto *Arg = Args.getLastArg(OPT_map, OPT_map_colon)) {
+    if (Arg->getOption().getID() == OPT_map_colon) {
+      Config->MapFile = Arg->getValue();
+    } else {
+      StringRef OutFile = Config->OutputFile;
+      Config->MapFile = (OutFile.substr(0, OutFile.rfind('.')) + ".map").str();
+    }
+  }
+
   // Write the result.
   writeResult(&Symtab);
 
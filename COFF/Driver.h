@@ -14,8 +14,12 @@
 #include "SymbolTable.h"
 #include "lld/Core/LLVM.h"
 #include "lld/Core/Reproduce.h"
+#include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Option/Arg.h"
 #include "llvm/Option/ArgList.h"
@@ -40,6 +44,9 @@ void markLive(const std::vector<Chunk *> &Chunks);
 // Implemented in ICF.cpp.
 void doICF(const std::vector<Chunk *> &Chunks);
 
+// Implemented in MergeStrings.cpp.
+void mergeStrings(const std::vector<Chunk *> &Chunks);
+
 class ArgParser {
 public:
   // Parses command line options.
@@ -83,10 +90,29 @@ private:
   // Parses LIB environment which contains a list of search paths.
   void addLibSearchPaths();
 
+  // Returns true if a file named Filename may exist in Dir, answering
+  // from a directory listing that is read once per directory.
+  bool mayExistInDir(StringRef Dir, StringRef Filename);
+
   // Library search path. The first element is always "" (current directory).
   std::vector<StringRef> SearchPaths;
   std::set<std::string> VisitedFiles;
 
+  // Directory listings backing mayExistInDir, keyed by directory.
+  // None means the directory could not be listed.
+  llvm::StringMap<Optional<llvm::StringSet<>>> DirListings;
+
+  // Memoized doFindFile results. /defaultlib directives from .drectve
+  // sections name the same handful of libraries over and over; the
+  // memo answers repeats without touching the filesystem.
+  llvm::StringMap<StringRef> ResolvedFilenames;
+
+  // .drectve strings already parsed, keyed by content hash. Most
+  // objects in a tree carry byte-identical directives (typically a
+  // /DEFAULTLIB list injected by the compiler), so each unique string
+  // is run through the option parser only once.
+  llvm::DenseSet<llvm::CachedHashStringRef> SeenDirectives;
+
   SymbolBody *addUndefined(StringRef Sym);
   StringRef mangle(StringRef Sym);
 
@@ -152,8 +178,8 @@ void assignExportOrdinals();
 // incompatible objects.
 void checkFailIfMismatch(StringRef Arg);
 
-// Convert Windows resource files (.res files) to a .obj file
-// using cvtres.exe.
+// Convert Windows resource files (.res files) to a COFF object file,
+// in memory. Defined in Resources.cpp.
 std::unique_ptr<MemoryBuffer>
 convertResToCOFF(const std::vector<MemoryBufferRef> &MBs);
 
@@ -18,6 +18,8 @@
 #include "Error.h"
 #include "Symbols.h"
 #include "lld/Support/Memory.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Object/COFF.h"
@@ -25,7 +27,10 @@
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
@@ -158,6 +163,12 @@ void parseAlternateName(StringRef S) {
 // Parse a string of the form of "<from>=<to>".
 // Results are directly written to Config.
 void parseMerge(StringRef S) {
+  // "strings" does not name a section pair; it enables folding of
+  // duplicate string literal sections (see MergeStrings.cpp).
+  if (S == "strings") {
+    Config->MergeStrings = true;
+    return;
+  }
   StringRef From, To;
   std::tie(From, To) = S.split('=');
   if (From.empty() || To.empty())
@@ -258,26 +269,6 @@ void parseManifestUAC(StringRef Arg) {
   }
 }
 
-// Quote each line with "". Existing double-quote is converted
-// to two double-quotes.
-static void quoteAndPrint(raw_ostream &Out, StringRef S) {
-  while (!S.empty()) {
-    StringRef Line;
-    std::tie(Line, S) = S.split("\n");
-    if (Line.empty())
-      continue;
-    Out << '\"';
-    for (int I = 0, E = Line.size(); I != E; ++I) {
-      if (Line[I] == '\"') {
-        Out << "\"\"";
-      } else {
-        Out << Line[I];
-      }
-    }
-    Out << "\"\n";
-  }
-}
-
 // An RAII temporary file class that automatically removes a temporary file.
 namespace {
 class TemporaryFile {
@@ -316,16 +307,10 @@ public:
 };
 }
 
-// Create the default manifest file as a temporary file.
-TemporaryFile createDefaultXml() {
-  // Create a temporary file.
-  TemporaryFile File("defaultxml", "manifest");
-
-  // Open the temporary file for writing.
-  std::error_code EC;
-  raw_fd_ostream OS(File.Path, EC, sys::fs::F_Text);
-  if (EC)
-    fatal(EC, "failed to open " + File.Path);
+// Create the default manifest XML in memory.
+static std::string createDefaultXml() {
+  std::string Ret;
+  raw_string_ostream OS(Ret);
 
   // Emit the XML. Note that we do *not* verify that the XML attributes are
   // syntactically correct. This is intentional for link.exe compatibility.
@@ -350,8 +335,8 @@ TemporaryFile createDefaultXml() {
     }
   }
   OS << "</assembly>\n";
-  OS.close();
-  return File;
+  OS.flush();
+  return Ret;
 }
 
 static std::string readFile(StringRef Path) {
@@ -361,13 +346,21 @@ static std::string readFile(StringRef Path) {
 }
 
 static std::string createManifestXml() {
-  // Create the default manifest file.
-  TemporaryFile File1 = createDefaultXml();
+  std::string Default = createDefaultXml();
   if (Config->ManifestInput.empty())
-    return readFile(File1.Path);
+    return Default;
 
   // If manifest files are supplied by the user using /MANIFESTINPUT
-  // option, we need to merge them with the default manifest.
+  // option, we need to merge them with the default manifest. Merging
+  // needs a real XML parser, so this is still delegated to mt.exe.
+  TemporaryFile File1("defaultxml", "manifest");
+  {
+    std::error_code EC;
+    raw_fd_ostream OS(File1.Path, EC, sys::fs::F_Text);
+    if (EC)
+      fatal(EC, "failed to open " + File1.Path);
+    OS << Default;
+  }
   TemporaryFile File2("user", "manifest");
 
   Executor E("mt.exe");
@@ -383,38 +376,53 @@ static std::string createManifestXml() {
   return readFile(File2.Path);
 }
 
-// Create a resource file containing a manifest XML.
-std::unique_ptr<MemoryBuffer> createManifestRes() {
-  // Create a temporary file for the resource script file.
-  TemporaryFile RCFile("manifest", "rc");
+// The header of one entry of a .res file. Type and name are encoded as
+// 0xFFFF followed by a numeric ID here, so the header has a fixed size.
+namespace {
+struct ResEntryHeader {
+  support::ulittle32_t DataSize;
+  support::ulittle32_t HeaderSize;
+  support::ulittle16_t TypeFlag;
+  support::ulittle16_t TypeID;
+  support::ulittle16_t NameFlag;
+  support::ulittle16_t NameID;
+  support::ulittle32_t DataVersion;
+  support::ulittle16_t MemoryFlags;
+  support::ulittle16_t LanguageID;
+  support::ulittle32_t Version;
+  support::ulittle32_t Characteristics;
+};
+}
 
-  // Open the temporary file for writing.
-  std::error_code EC;
-  raw_fd_ostream Out(RCFile.Path, EC, sys::fs::F_Text);
-  if (EC)
-    fatal(EC, "failed to open " + RCFile.Path);
-
-  // Write resource script to the RC file.
-  Out << "#define LANG_ENGLISH 9\n"
-      << "#define SUBLANG_DEFAULT 1\n"
-      << "#define APP_MANIFEST " << Config->ManifestID << "\n"
-      << "#define RT_MANIFEST 24\n"
-      << "LANGUAGE LANG_ENGLISH, SUBLANG_DEFAULT\n"
-      << "APP_MANIFEST RT_MANIFEST {\n";
-  quoteAndPrint(Out, createManifestXml());
-  Out << "}\n";
-  Out.close();
-
-  // Create output resource file.
-  TemporaryFile ResFile("output-resource", "res");
-
-  Executor E("rc.exe");
-  E.add("/fo");
-  E.add(ResFile.Path);
-  E.add("/nologo");
-  E.add(RCFile.Path);
-  E.run();
-  return ResFile.getMemoryBuffer();
+// Create an in-memory resource file containing a manifest XML.
+std::unique_ptr<MemoryBuffer> createManifestRes() {
+  std::string Manifest = createManifestXml();
+
+  // A .res file starts with an empty entry that serves as the file
+  // signature, followed by the actual entries. Ours has exactly one:
+  // the manifest XML, with the same type, language and flags rc.exe
+  // would have given it.
+  ResEntryHeader Null = {};
+  Null.HeaderSize = sizeof(ResEntryHeader);
+  Null.TypeFlag = 0xFFFF;
+  Null.NameFlag = 0xFFFF;
+
+  ResEntryHeader H = {};
+  H.DataSize = Manifest.size();
+  H.HeaderSize = sizeof(ResEntryHeader);
+  H.TypeFlag = 0xFFFF;
+  H.TypeID = 24; // RT_MANIFEST
+  H.NameFlag = 0xFFFF;
+  H.NameID = Config->ManifestID;
+  H.MemoryFlags = 0x0030; // MOVEABLE | PURE
+  H.LanguageID = 0x0409;  // en-US
+
+  std::string Out;
+  Out.append(reinterpret_cast<const char *>(&Null), sizeof(Null));
+  Out.append(reinterpret_cast<const char *>(&H), sizeof(H));
+  Out += Manifest;
+  Out.resize(alignTo(Out.size(), 4));
+  return MemoryBuffer::getMemBufferCopy(Out, "<manifest-res>");
 }
 
 void createSideBySideManifest() {
@@ -501,7 +509,7 @@ static StringRef undecorate(StringRef Sym) {
 // It also sets ordinals.
 void fixupExports() {
   // Symbol ordinals must be unique.
-  std::set<uint16_t> Ords;
+  DenseSet<uint16_t> Ords;
   for (Export &E : Config->Exports) {
     if (E.Ordinal == 0)
       continue;
@@ -529,9 +537,11 @@ void fixupExports() {
     }
   }
 
-  // Uniquefy by name.
-  std::map<StringRef, Export *> Map;
+  // Uniquefy by name. Generated .def files can carry tens of thousands
+  // of exports, so use hash containers rather than trees here.
+  DenseMap<StringRef, Export *> Map(Config->Exports.size());
   std::vector<Export> V;
+  V.reserve(Config->Exports.size());
   for (Export &E : Config->Exports) {
     auto Pair = Map.insert(std::make_pair(E.ExportName, &E));
     bool Inserted = Pair.second;
@@ -577,46 +587,6 @@ void checkFailIfMismatch(StringRef Arg) {
   Config->MustMatch[K] = V;
 }
 
-// Convert Windows resource files (.res files) to a .obj file
-// using cvtres.exe.
-std::unique_ptr<MemoryBuffer>
-convertResToCOFF(const std::vector<MemoryBufferRef> &MBs) {
-  // Create an output file path.
-  TemporaryFile File("resource-file", "obj");
-
-  // Execute cvtres.exe.
-  Executor E("cvtres.exe");
-  E.add("/machine:" + machineToStr(Config->Machine));
-  E.add("/readonly");
-  E.add("/nologo");
-  E.add("/out:" + Twine(File.Path));
-
-  // We must create new files because the memory buffers we have may have no
-  // underlying file still existing on the disk.
-  // It happens if it was created from a TemporaryFile, which usually delete
-  // the file just after creating the MemoryBuffer.
-  std::vector<TemporaryFile> ResFiles;
-  ResFiles.reserve(MBs.size());
-  for (MemoryBufferRef MB : MBs) {
-    // We store the temporary file in a vector to avoid deletion
-    // before running cvtres
-    ResFiles.emplace_back("resource-file", "res");
-    TemporaryFile& ResFile = ResFiles.back();
-    // Write the content of the resource in a temporary file
-    std::error_code EC;
-    raw_fd_ostream OS(ResFile.Path, EC, sys::fs::F_None);
-    if (EC)
-      fatal(EC, "failed to open " + ResFile.Path);
-    OS << MB.getBuffer();
-    OS.close();
-
-    E.add(ResFile.Path);
-  }
-
-  E.run();
-  return File.getMemoryBuffer();
-}
-
 // Create OptTable
 
 // Create prefix string literals used in Options.td
@@ -25,6 +25,7 @@
 #include "llvm/ADT/Hashing.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <atomic>
 #include <vector>
@@ -62,12 +63,31 @@ private:
 
 // Returns a hash value for S.
 uint32_t ICF::getHash(SectionChunk *C) {
-  return hash_combine(C->getPermissions(),
-                      hash_value(C->SectionName),
-                      C->NumRelocs,
-                      C->getAlign(),
-                      uint32_t(C->Header->SizeOfRawData),
-                      C->Checksum);
+  ArrayRef<uint8_t> Contents = C->getContents();
+  uint32_t H = hash_combine(C->getPermissions(),
+                            hash_value(C->SectionName),
+                            C->NumRelocs,
+                            C->getAlign(),
+                            uint32_t(C->Header->SizeOfRawData),
+                            C->Checksum,
+                            xxHash64(StringRef((const char *)Contents.data(),
+                                               Contents.size())));
+
+  // Fold in the relocations so that sections that cannot possibly be
+  // equal land in different classes before the quadratic comparisons
+  // run. For a DefinedRegular target only its value takes part in the
+  // constant comparison, and for any other target the symbol identity
+  // does; external symbols are interned by name, so hashing the name
+  // never separates sections that equalsConstant would call equal.
+  for (const coff_relocation &R : C->Relocs) {
+    H = hash_combine(H, R.Type, R.VirtualAddress);
+    SymbolBody *B = C->File->getSymbolBody(R.SymbolTableIndex);
+    if (auto *D = dyn_cast<DefinedRegular>(B))
+      H = hash_combine(H, D->getValue());
+    else
+      H = hash_combine(H, hash_value(B->getName()));
+  }
+  return H;
 }
 
 // Returns true if section S is subject of ICF.
@@ -200,18 +220,23 @@ void ICF::run(const std::vector<Chunk *> &Vec) {
     if (!SC)
       continue;
 
-    if (isEligible(SC)) {
-      // Set MSB to 1 to avoid collisions with non-hash colors.
-      SC->Color[0] = getHash(SC) | (1 << 31);
+    if (isEligible(SC))
       Chunks.push_back(SC);
-    } else {
+    else
       SC->Color[0] = NextId++;
-    }
   }
 
   if (Chunks.empty())
     return;
 
+  // Initial colors are content hashes. Computing them reads section
+  // contents and relocations but writes only to the section itself,
+  // so it parallelizes trivially.
+  parallel_for_each(Chunks.begin(), Chunks.end(), [&](SectionChunk *SC) {
+    // Set MSB to 1 to avoid collisions with non-hash colors.
+    SC->Color[0] = getHash(SC) | (1 << 31);
+  });
+
   // From now on, sections in Chunks are ordered so that sections in
   // the same group are consecutive in the vector.
   std::stable_sort(Chunks.begin(), Chunks.end(),
@@ -55,15 +55,21 @@ void ArchiveFile::parse() {
   // Parse a MemoryBufferRef as an archive file.
   File = check(Archive::create(MB), toString(this));
 
-  // Seen is a map from member files to boolean values. Initially
-  // all members are mapped to false, which indicates all these files
-  // are not read yet.
+  // Build a hashed member index up front: each member's offset in the
+  // archive maps to a flag recording whether that member has been read
+  // yet. Members are slices of the mmapped archive buffer, so reading
+  // one later costs no extra I/O.
   Error Err = Error::success();
+  std::vector<uint64_t> Offsets;
   for (auto &Child : File->children(Err))
-    Seen[Child.getChildOffset()].clear();
+    Offsets.push_back(Child.getChildOffset());
   if (Err)
     fatal(Err, toString(this));
 
+  SeenFlags.reset(new std::atomic<bool>[Offsets.size()]());
+  for (size_t I = 0, E = Offsets.size(); I != E; ++I)
+    Seen[Offsets[I]] = &SeenFlags[I];
+
   // Read the symbol table to construct Lazy objects.
   for (const Archive::Symbol &Sym : File->symbols())
     Symtab->addLazy(this, Sym);
@@ -77,7 +83,10 @@ InputFile *ArchiveFile::getMember(const Archive::Symbol *Sym) {
             "could not get the member for symbol " + Sym->getName());
 
   // Return an empty buffer if we have already returned the same buffer.
-  if (Seen[C.getChildOffset()].test_and_set())
+  // The index is immutable after parse(), so this is just a hash lookup
+  // plus one atomic exchange.
+  std::atomic<bool> *Flag = Seen.lookup(C.getChildOffset());
+  if (Flag && Flag->exchange(true))
     return nullptr;
 
   MemoryBufferRef MB =
@@ -153,7 +162,10 @@ void ObjectFile::initializeChunks() {
     // CodeView needs a linker support. We need to interpret and debug
     // info, and then write it to a separate .pdb file.
 
-    // Ignore debug info unless /debug is given.
+    // Ignore debug info unless /debug is given. Skipping here, before any
+    // SectionChunk is created, means non-debug links never allocate chunks
+    // for .debug$S/.debug$T/.debug_* sections or touch their contents;
+    // only the section header and name are ever read.
     if (!Config->Debug && Name.startswith(".debug"))
       continue;
 
@@ -176,10 +188,16 @@ void ObjectFile::initializeSymbols() {
   uint32_t NumSymbols = COFFObj->getNumberOfSymbols();
   SymbolBodies.reserve(NumSymbols);
   SparseSymbolBodies.resize(NumSymbols);
-  SmallVector<std::pair<SymbolBody *, uint32_t>, 8> WeakAliases;
+
+  // Convert the raw symbol records in one batch pass first. This loop
+  // walks sequential file memory decoding bounds-checked symbol refs,
+  // aux pointers and names, so the second pass that creates bodies no
+  // longer interleaves string table probes with symbol table lookups.
+  // Names are fetched only for symbols that can reach the symbol table.
+  std::vector<SymbolRecord> Records;
+  Records.reserve(NumSymbols);
   int32_t LastSectionNumber = 0;
   for (uint32_t I = 0; I < NumSymbols; ++I) {
-    // Get a COFFSymbolRef object.
     ErrorOr<COFFSymbolRef> SymOrErr = COFFObj->getSymbol(I);
     if (!SymOrErr)
       fatal(SymOrErr.getError(), "broken object file: " + toString(this));
@@ -188,25 +206,35 @@ void ObjectFile::initializeSymbols() {
     const void *AuxP = nullptr;
     if (Sym.getNumberOfAuxSymbols())
       AuxP = COFFObj->getSymbol(I + 1)->getRawPtr();
-    bool IsFirst = (LastSectionNumber != Sym.getSectionNumber());
+    StringRef Name;
+    if (Sym.isUndefined() || Sym.isWeakExternal() || Sym.isCommon() ||
+        Sym.isAbsolute() || Sym.isExternal())
+      COFFObj->getSymbolName(Sym, Name);
+    Records.emplace_back(Sym, AuxP, Name, I,
+                         LastSectionNumber != Sym.getSectionNumber());
 
+    I += Sym.getNumberOfAuxSymbols();
+    LastSectionNumber = Sym.getSectionNumber();
+  }
+
+  // Create symbol bodies and resolve them against the symbol table.
+  SmallVector<std::pair<SymbolBody *, uint32_t>, 8> WeakAliases;
+  for (const SymbolRecord &R : Records) {
     SymbolBody *Body = nullptr;
-    if (Sym.isUndefined()) {
-      Body = createUndefined(Sym);
-    } else if (Sym.isWeakExternal()) {
-      Body = createUndefined(Sym);
+    if (R.Sym.isUndefined()) {
+      Body = createUndefined(R);
+    } else if (R.Sym.isWeakExternal()) {
+      Body = createUndefined(R);
       uint32_t TagIndex =
-          static_cast<const coff_aux_weak_external *>(AuxP)->TagIndex;
+          static_cast<const coff_aux_weak_external *>(R.AuxP)->TagIndex;
       WeakAliases.emplace_back(Body, TagIndex);
     } else {
-      Body = createDefined(Sym, AuxP, IsFirst);
+      Body = createDefined(R);
     }
     if (Body) {
       SymbolBodies.push_back(Body);
-      SparseSymbolBodies[I] = Body;
+      SparseSymbolBodies[R.Index] = Body;
     }
-    I += Sym.getNumberOfAuxSymbols();
-    LastSectionNumber = Sym.getSectionNumber();
   }
   for (auto WeakAlias : WeakAliases) {
     auto *U = dyn_cast<Undefined>(WeakAlias.first);
@@ -219,22 +247,19 @@ void ObjectFile::initializeSymbols() {
   }
 }
 
-SymbolBody *ObjectFile::createUndefined(COFFSymbolRef Sym) {
-  StringRef Name;
-  COFFObj->getSymbolName(Sym, Name);
-  return Symtab->addUndefined(Name, this, Sym.isWeakExternal())->body();
+SymbolBody *ObjectFile::createUndefined(const SymbolRecord &R) {
+  return Symtab->addUndefined(R.Name, this, R.Sym.isWeakExternal())->body();
 }
 
-SymbolBody *ObjectFile::createDefined(COFFSymbolRef Sym, const void *AuxP,
-                                      bool IsFirst) {
-  StringRef Name;
+SymbolBody *ObjectFile::createDefined(const SymbolRecord &R) {
+  COFFSymbolRef Sym = R.Sym;
   if (Sym.isCommon()) {
     auto *C = new (Alloc) CommonChunk(Sym);
     Chunks.push_back(C);
-    return Symtab->addCommon(this, Sym, C)->body();
+    return Symtab->addCommon(this, R.Name, Sym, C)->body();
   }
   if (Sym.isAbsolute()) {
-    COFFObj->getSymbolName(Sym, Name);
+    StringRef Name = R.Name;
     // Skip special symbols.
     if (Name == "@comp.id")
       return nullptr;
@@ -268,8 +293,8 @@ SymbolBody *ObjectFile::createDefined(COFFSymbolRef Sym, const void *AuxP,
     return nullptr;
 
   // Handle section definitions
-  if (IsFirst && AuxP) {
-    auto *Aux = reinterpret_cast<const coff_aux_section_definition *>(AuxP);
+  if (R.IsFirst && R.AuxP) {
+    auto *Aux = reinterpret_cast<const coff_aux_section_definition *>(R.AuxP);
     if (Aux->Selection == IMAGE_COMDAT_SELECT_ASSOCIATIVE)
       if (auto *ParentSC = cast_or_null<SectionChunk>(
               SparseChunks[Aux->getNumber(Sym.isBigObj())]))
@@ -279,10 +304,10 @@ SymbolBody *ObjectFile::createDefined(COFFSymbolRef Sym, const void *AuxP,
 
   DefinedRegular *B;
   if (Sym.isExternal())
-    B = cast<DefinedRegular>(Symtab->addRegular(this, Sym, SC)->body());
+    B = cast<DefinedRegular>(Symtab->addRegular(this, R.Name, Sym, SC)->body());
   else
     B = new (Alloc) DefinedRegular(this, Sym, SC);
-  if (SC->isCOMDAT() && Sym.getValue() == 0 && !AuxP)
+  if (SC->isCOMDAT() && Sym.getValue() == 0 && !R.AuxP)
     SC->setSymbol(B);
 
   return B;
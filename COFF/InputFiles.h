@@ -12,11 +12,13 @@
 
 #include "lld/Core/LLVM.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/LTO/legacy/LTOModule.h"
 #include "llvm/Object/Archive.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Support/StringSaver.h"
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -91,7 +93,13 @@ public:
 private:
   std::unique_ptr<Archive> File;
   std::string Filename;
-  std::map<uint64_t, std::atomic_flag> Seen;
+
+  // Maps a member's offset in the archive to a flag recording whether
+  // the member has been materialized yet. The index is built once in
+  // parse() and is read-only afterwards, so lookups need no lock; the
+  // flags are atomic because getMember may be called concurrently.
+  llvm::DenseMap<uint64_t, std::atomic<bool> *> Seen;
+  std::unique_ptr<std::atomic<bool>[]> SeenFlags;
 };
 
 // .obj or .o file. This may be a member of an archive file.
@@ -127,8 +135,23 @@ private:
   void initializeSymbols();
   void initializeSEH();
 
-  SymbolBody *createDefined(COFFSymbolRef Sym, const void *Aux, bool IsFirst);
-  SymbolBody *createUndefined(COFFSymbolRef Sym);
+  // A symbol record prepared by the batch conversion pass of
+  // initializeSymbols. The hot resolution fields -- classification
+  // inputs, aux pointer and name -- are decoded up front so that the
+  // pass creating bodies touches only the symbol table.
+  struct SymbolRecord {
+    SymbolRecord(COFFSymbolRef Sym, const void *AuxP, StringRef Name,
+                 uint32_t Index, bool IsFirst)
+        : Sym(Sym), AuxP(AuxP), Name(Name), Index(Index), IsFirst(IsFirst) {}
+    COFFSymbolRef Sym;
+    const void *AuxP;
+    StringRef Name;
+    uint32_t Index;
+    bool IsFirst;
+  };
+
+  SymbolBody *createDefined(const SymbolRecord &R);
+  SymbolBody *createUndefined(const SymbolRecord &R);
 
   std::unique_ptr<COFFObjectFile> COFFObj;
   llvm::BumpPtrAllocator Alloc;
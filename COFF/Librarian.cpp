@@ -17,6 +17,7 @@
 #include "Driver.h"
 #include "Error.h"
 #include "Symbols.h"
+#include "lld/Core/Parallel.h"
 #include "llvm/Object/Archive.h"
 #include "llvm/Object/ArchiveWriter.h"
 #include "llvm/Object/COFF.h"
@@ -148,10 +149,17 @@ public:
   // is used to terminate the IAT and ILT.
   NewArchiveMember createNullThunk(std::vector<uint8_t> &Buffer);
 
-  // Create a short import file which is described in PE/COFF spec 7. Import
-  // Library Format.
-  NewArchiveMember createShortImport(StringRef Sym, uint16_t Ordinal,
-                                     ImportNameType NameType, bool isData);
+  // Create short import files, which are described in PE/COFF spec 7. Import
+  // Library Format, for all given exports at once. The members are laid out
+  // back to back in one pooled allocation and filled in in parallel.
+  void createShortImports(ArrayRef<Export *> Exports,
+                          ArrayRef<std::string> Names,
+                          ArrayRef<ImportNameType> Types,
+                          std::vector<NewArchiveMember> &Members);
+
+private:
+  void writeShortImport(char *Buf, StringRef Sym, uint16_t Ordinal,
+                        ImportNameType NameType, bool isData);
 };
 }
 
@@ -427,14 +435,11 @@ NewArchiveMember ObjectFactory::createNullThunk(std::vector<uint8_t> &Buffer) {
   return {MemoryBufferRef{F, DLLName}};
 }
 
-NewArchiveMember ObjectFactory::createShortImport(StringRef Sym,
-                                                  uint16_t Ordinal,
-                                                  ImportNameType NameType,
-                                                  bool isData) {
+// Writes a short import file to a preallocated, zeroed buffer.
+void ObjectFactory::writeShortImport(char *Buf, StringRef Sym,
+                                     uint16_t Ordinal,
+                                     ImportNameType NameType, bool isData) {
   size_t ImpSize = DLLName.size() + Sym.size() + 2; // +2 for NULs
-  size_t Size = sizeof(coff_import_header) + ImpSize;
-  char *Buf = Alloc.Allocate<char>(Size);
-  memset(Buf, 0, Size);
   char *P = Buf;
 
   // Write short import library.
@@ -452,8 +457,36 @@ NewArchiveMember ObjectFactory::createShortImport(StringRef Sym,
   memcpy(P, Sym.data(), Sym.size());
   P += Sym.size() + 1;
   memcpy(P, DLLName.data(), DLLName.size());
+}
 
-  return {MemoryBufferRef(StringRef(Buf, Size), DLLName)};
+void ObjectFactory::createShortImports(ArrayRef<Export *> Exports,
+                                       ArrayRef<std::string> Names,
+                                       ArrayRef<ImportNameType> Types,
+                                       std::vector<NewArchiveMember> &Members) {
+  // Lay the members out back to back in a single pooled allocation
+  // instead of one allocation per member.
+  std::vector<size_t> Offsets(Exports.size());
+  size_t Total = 0;
+  for (size_t I = 0, E = Exports.size(); I != E; ++I) {
+    Offsets[I] = Total;
+    Total += sizeof(coff_import_header) + DLLName.size() + Names[I].size() + 2;
+  }
+  char *Buf = Alloc.Allocate<char>(Total);
+  memset(Buf, 0, Total);
+
+  // Each member covers a disjoint slice of the pool, so the contents
+  // can be filled in in parallel.
+  parallel_for(size_t(0), Exports.size(), [&](size_t I) {
+    writeShortImport(Buf + Offsets[I], Names[I], Exports[I]->Ordinal,
+                     Types[I], Exports[I]->Data);
+  });
+
+  for (size_t I = 0, E = Exports.size(); I != E; ++I) {
+    size_t Size =
+        sizeof(coff_import_header) + DLLName.size() + Names[I].size() + 2;
+    Members.push_back(
+        {MemoryBufferRef(StringRef(Buf + Offsets[I], Size), DLLName)});
+  }
 }
 
 // Creates an import library for a DLL. In this function, we first
@@ -475,16 +508,24 @@ void lld::coff::writeImportLibrary() {
   std::vector<uint8_t> NullThunk;
   Members.push_back(OF.createNullThunk(NullThunk));
 
-  for (Export &E : Config->Exports) {
-    if (E.Private)
-      continue;
-
-    ImportNameType Type = getNameType(E.SymbolName, E.Name);
-    std::string Name = E.ExtName.empty()
-                           ? std::string(E.SymbolName)
-                           : replace(E.SymbolName, E.Name, E.ExtName);
-    Members.push_back(OF.createShortImport(Name, E.Ordinal, Type, E.Data));
-  }
+  // Classify the exports and build their (possibly renamed) symbol
+  // names in parallel, then create all short import members in one
+  // batch. The archive itself is gathered and written in a single
+  // writeArchive call below.
+  std::vector<Export *> Exports;
+  for (Export &E : Config->Exports)
+    if (!E.Private)
+      Exports.push_back(&E);
+
+  std::vector<std::string> Names(Exports.size());
+  std::vector<ImportNameType> Types(Exports.size());
+  parallel_for(size_t(0), Exports.size(), [&](size_t I) {
+    Export &E = *Exports[I];
+    Types[I] = getNameType(E.SymbolName, E.Name);
+    Names[I] = E.ExtName.empty() ? std::string(E.SymbolName)
+                                 : replace(E.SymbolName, E.Name, E.ExtName);
+  });
+  OF.createShortImports(Exports, Names, Types, Members);
 
   std::pair<StringRef, std::error_code> Result =
       writeArchive(Path, Members, /*WriteSymtab*/ true, object::Archive::K_GNU,
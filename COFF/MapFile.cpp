@@ -0,0 +1,152 @@
+//===- MapFile.cpp --------------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the /map option. It shows lists in order and
+// hierarchically the output sections, input sections, input files and
+// symbol:
+//
+//   Address  Size     Align Out     In      Symbol
+//   00001000 00000015     4 .text
+//   00001000 0000000e     4         .text
+//   00001000 0000000e     4                 test.obj
+//   00001005 00000000     0                         main
+//
+// All addresses are RVAs. Each output section's block is formatted
+// independently, so the formatting runs in parallel, and the writer
+// kicks the whole thing off on a background thread once the layout is
+// final, so map generation adds no critical-path time to the link.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MapFile.h"
+#include "Chunks.h"
+#include "Config.h"
+#include "Error.h"
+#include "InputFiles.h"
+#include "SymbolTable.h"
+#include "Symbols.h"
+#include "Writer.h"
+#include "lld/Core/Parallel.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace llvm::object;
+
+using namespace lld;
+using namespace lld::coff;
+
+// RVAs fit in 32 bits even for 64-bit images.
+static const int Width = 8;
+
+static void writeOutSecLine(raw_ostream &OS, uint64_t Address, uint64_t Size,
+                            uint64_t Align, StringRef Name) {
+  OS << format("%0*llx %0*llx %5lld ", Width, Address, Width, Size, Align)
+     << left_justify(Name, 7);
+}
+
+static void writeInSecLine(raw_ostream &OS, uint64_t Address, uint64_t Size,
+                           uint64_t Align, StringRef Name) {
+  // Pass an empty name to align the text to the correct column.
+  writeOutSecLine(OS, Address, Size, Align, "");
+  OS << ' ' << left_justify(Name, 7);
+}
+
+static void writeFileLine(raw_ostream &OS, uint64_t Address, uint64_t Size,
+                          uint64_t Align, StringRef Name) {
+  writeInSecLine(OS, Address, Size, Align, "");
+  OS << ' ' << left_justify(Name, 7);
+}
+
+static void writeSymbolLine(raw_ostream &OS, uint64_t Address, StringRef Name) {
+  writeFileLine(OS, Address, 0, 0, "");
+  OS << ' ' << left_justify(Name, 7);
+}
+
+namespace {
+// Maps a section chunk to the symbols defined in it, so that the inner
+// loop below does not rescan the symbol table per chunk.
+typedef DenseMap<SectionChunk *, SmallVector<DefinedRegular *, 4>>
+    ChunkSymMap;
+}
+
+static void writeSectionChunk(raw_ostream &OS, SectionChunk *SC,
+                              const ChunkSymMap &ChunkSyms,
+                              StringRef &PrevName) {
+  StringRef Name = SC->getSectionName();
+  if (Name != PrevName) {
+    writeInSecLine(OS, SC->getRVA(), SC->getSize(), SC->getAlign(), Name);
+    OS << '\n';
+    PrevName = Name;
+  }
+
+  writeFileLine(OS, SC->getRVA(), SC->getSize(), SC->getAlign(),
+                toString(SC->getFile()));
+  OS << '\n';
+
+  auto It = ChunkSyms.find(SC);
+  if (It == ChunkSyms.end())
+    return;
+  for (DefinedRegular *Sym : It->second) {
+    writeSymbolLine(OS, Sym->getRVA(), toString(*Sym));
+    OS << '\n';
+  }
+}
+
+static void writeMapFileBody(raw_ostream &OS,
+                             ArrayRef<OutputSection *> OutputSections,
+                             SymbolTable *Symtab) {
+  // Collect the defined symbols per chunk up front. This is a
+  // read-only index for the parallel formatting loop below.
+  ChunkSymMap ChunkSyms;
+  for (ObjectFile *File : Symtab->ObjectFiles)
+    for (SymbolBody *B : File->getSymbols())
+      if (auto *Sym = dyn_cast_or_null<DefinedRegular>(B))
+        if (Sym->getChunk()->isLive())
+          ChunkSyms[Sym->getChunk()].push_back(Sym);
+  for (auto &It : ChunkSyms)
+    std::stable_sort(It.second.begin(), It.second.end(),
+                     [](DefinedRegular *A, DefinedRegular *B) {
+                       return A->getRVA() < B->getRVA();
+                     });
+
+  // Format each output section's block into its own string so the
+  // blocks can be produced in parallel and emitted in order.
+  std::vector<std::string> Blocks(OutputSections.size());
+  parallel_for(size_t(0), OutputSections.size(), [&](size_t I) {
+    OutputSection *Sec = OutputSections[I];
+    raw_string_ostream SOS(Blocks[I]);
+    writeOutSecLine(SOS, Sec->getRVA(), Sec->getVirtualSize(), 0,
+                    Sec->getName());
+    SOS << '\n';
+    StringRef PrevName = "";
+    for (Chunk *C : Sec->getChunks())
+      if (auto *SC = dyn_cast<SectionChunk>(C))
+        writeSectionChunk(SOS, SC, ChunkSyms, PrevName);
+    SOS.flush();
+  });
+
+  OS << left_justify("Address", Width) << ' ' << left_justify("Size", Width)
+     << " Align Out     In      File    Symbol\n";
+  for (const std::string &Block : Blocks)
+    OS << Block;
+}
+
+void coff::writeMapFile(ArrayRef<OutputSection *> OutputSections,
+                        SymbolTable *Symtab) {
+  if (Config->MapFile.empty())
+    return;
+  std::error_code EC;
+  raw_fd_ostream OS(Config->MapFile, EC, sys::fs::F_Text);
+  if (EC)
+    fatal(EC, "could not create the map file " + Config->MapFile);
+  writeMapFileBody(OS, OutputSections, Symtab);
+}
@@ -9,6 +9,7 @@
 
 #include "Chunks.h"
 #include "Symbols.h"
+#include "lld/Core/Parallel.h"
 #include "llvm/ADT/STLExtras.h"
 #include <vector>
 
@@ -42,18 +43,36 @@ void markLive(const std::vector<Chunk *> &Chunks) {
     if (auto *D = dyn_cast<DefinedRegular>(B))
       Enqueue(D->getChunk());
 
-  while (!Worklist.empty()) {
-    SectionChunk *SC = Worklist.pop_back_val();
-    assert(SC->isLive() && "We mark as live when pushing onto the worklist!");
+  // Traverse the graph one BFS frontier at a time. Resolving the
+  // relocation symbols and associative children of the frontier chunks
+  // is read-only and runs in parallel; the marks are then committed
+  // serially, so the (non-atomic) Live bit is never written from two
+  // threads and the traversal order stays deterministic. This mirrors
+  // the frontier traversal in ELF/MarkLive.cpp.
+  std::vector<SectionChunk *> Frontier(Worklist.begin(), Worklist.end());
+  Worklist.clear();
+  while (!Frontier.empty()) {
+    std::vector<std::vector<SectionChunk *>> Succs(Frontier.size());
+    parallel_for((size_t)0, Frontier.size(), [&](size_t I) {
+      SectionChunk *SC = Frontier[I];
+      assert(SC->isLive() && "We mark as live when pushing onto the worklist!");
 
-    // Mark all symbols listed in the relocation table for this section.
-    for (SymbolBody *S : SC->symbols())
-      if (auto *D = dyn_cast<DefinedRegular>(S))
-        Enqueue(D->getChunk());
+      // Collect all symbols listed in the relocation table for this section.
+      for (SymbolBody *S : SC->symbols())
+        if (auto *D = dyn_cast<DefinedRegular>(S))
+          Succs[I].push_back(D->getChunk());
 
-    // Mark associative sections if any.
-    for (SectionChunk *C : SC->children())
-      Enqueue(C);
+      // Collect associative sections if any.
+      for (SectionChunk *C : SC->children())
+        Succs[I].push_back(C);
+    });
+
+    for (std::vector<SectionChunk *> &V : Succs)
+      for (SectionChunk *C : V)
+        Enqueue(C);
+
+    Frontier.assign(Worklist.begin(), Worklist.end());
+    Worklist.clear();
   }
 }
 
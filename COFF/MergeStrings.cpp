@@ -0,0 +1,115 @@
+//===- MergeStrings.cpp ---------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements /merge:strings, an opt-in pass that folds
+// duplicate string literal sections.
+//
+// MSVC and Clang place each string literal in a read-only COMDAT
+// section of its own (.rdata$str), but COMDAT deduplication during
+// symbol resolution and ICF both key off an external leader symbol,
+// and string literals usually have none. A literal that appears in N
+// translation units therefore survives N times in the output. This
+// pass folds such sections by contents: duplicates are redirected to
+// one representative through SectionChunk::Repl, the same mechanism
+// ICF uses, so no relocation needs rewriting -- references resolve
+// through the replacement pointer.
+//
+// Only whole COMDAT sections are folded. A non-COMDAT .rdata section
+// may hold many literals referenced at interior offsets, and there is
+// no per-symbol indirection that would let us split one.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Chunks.h"
+#include "lld/Core/Parallel.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include <atomic>
+#include <vector>
+
+using namespace llvm;
+
+namespace lld {
+namespace coff {
+
+void mergeStrings(const std::vector<Chunk *> &Vec) {
+  // Returns true if C looks like a string literal section that is
+  // safe to fold by contents: a live COMDAT holding only initialized,
+  // non-writable data ending in a NUL. Interior NULs are accepted
+  // because wide literals contain them.
+  auto IsEligible = [](SectionChunk *C) {
+    if (!C->isCOMDAT() || !C->isLive() || !C->hasData() || C->NumRelocs ||
+        !C->children().empty())
+      return false;
+    uint32_t P = C->getPermissions();
+    if (!(P & IMAGE_SCN_CNT_INITIALIZED_DATA) ||
+        (P & (IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_EXECUTE |
+              IMAGE_SCN_MEM_WRITE)))
+      return false;
+    ArrayRef<uint8_t> D = C->getContents();
+    return !D.empty() && D.back() == 0;
+  };
+
+  std::vector<SectionChunk *> Chunks;
+  for (Chunk *C : Vec)
+    if (auto *SC = dyn_cast<SectionChunk>(C))
+      if (IsEligible(SC))
+        Chunks.push_back(SC);
+  if (Chunks.empty())
+    return;
+
+  // Hash every literal once in parallel. The hash picks the shard, so
+  // all candidates for one merge land in the same shard.
+  std::vector<uint64_t> Hashes(Chunks.size());
+  parallel_for((size_t)0, Chunks.size(), [&](size_t I) {
+    ArrayRef<uint8_t> D = Chunks[I]->getContents();
+    Hashes[I] = xxHash64(StringRef((const char *)D.data(), D.size()));
+  });
+
+  const size_t NumShards = 256;
+  std::vector<std::vector<size_t>> Shards(NumShards);
+  for (size_t I = 0, E = Chunks.size(); I != E; ++I)
+    Shards[Hashes[I] % NumShards].push_back(I);
+
+  // Each chunk belongs to exactly one shard, so the shards deduplicate
+  // independently without locking. Within a shard the first occurrence
+  // in input order becomes the representative, which keeps the output
+  // deterministic.
+  std::atomic<uint64_t> NumFolded(0);
+  parallel_for((size_t)0, NumShards, [&](size_t S) {
+    DenseMap<uint64_t, SmallVector<SectionChunk *, 1>> Reps;
+    for (size_t I : Shards[S]) {
+      SectionChunk *C = Chunks[I];
+      SmallVector<SectionChunk *, 1> &Bucket = Reps[Hashes[I]];
+      SectionChunk *Rep = nullptr;
+      for (SectionChunk *R : Bucket) {
+        if (R->getAlign() == C->getAlign() &&
+            R->getPermissions() == C->getPermissions() &&
+            R->getContents() == C->getContents()) {
+          Rep = R;
+          break;
+        }
+      }
+      if (Rep) {
+        Rep->replace(C);
+        ++NumFolded;
+      } else {
+        Bucket.push_back(C);
+      }
+    }
+  });
+
+  if (Config->Verbose)
+    outs() << "Merged " << NumFolded.load() << " string literals\n";
+}
+
+} // namespace coff
+} // namespace lld
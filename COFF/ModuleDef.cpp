@@ -64,7 +64,9 @@ public:
   explicit Lexer(StringRef S) : Buf(S) {}
 
   Token lex() {
-    Buf = Buf.trim();
+    // ltrim, not trim: rescanning the tail of the buffer on every token
+    // adds up on generated .def files with tens of thousands of exports.
+    Buf = Buf.ltrim();
     if (Buf.empty())
       return Token(Eof);
 
@@ -283,7 +285,13 @@ private:
 
 } // anonymous namespace
 
-void parseModuleDefs(MemoryBufferRef MB) { Parser(MB.getBuffer()).parse(); }
+void parseModuleDefs(MemoryBufferRef MB) {
+  // Nearly every line of a .def file is an export; reserving up front
+  // avoids repeated reallocation of the (fat) Export elements.
+  Config->Exports.reserve(Config->Exports.size() +
+                          MB.getBuffer().count('\n'));
+  Parser(MB.getBuffer()).parse();
+}
 
 } // namespace coff
 } // namespace lld
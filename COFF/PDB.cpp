@@ -26,10 +26,13 @@
 #include "llvm/DebugInfo/PDB/Raw/PDBFileBuilder.h"
 #include "llvm/DebugInfo/PDB/Raw/TpiStream.h"
 #include "llvm/DebugInfo/PDB/Raw/TpiStreamBuilder.h"
+#include "lld/Core/Parallel.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/ScopedPrinter.h"
+#include "llvm/Support/xxhash.h"
 #include <memory>
 
 using namespace lld;
@@ -114,12 +117,32 @@ static void dumpCodeView(SymbolTable *Symtab) {
 
 static void addTypeInfo(SymbolTable *Symtab,
                         pdb::TpiStreamBuilder &TpiBuilder) {
-  for (ObjectFile *File : Symtab->ObjectFiles) {
-    ArrayRef<uint8_t> Data = getDebugT(File);
-    if (Data.empty())
+  // Extract and hash every object's .debug$T payload in parallel;
+  // only the appends below run serially, in file order, so the
+  // output is deterministic.
+  std::vector<ObjectFile *> &Files = Symtab->ObjectFiles;
+  std::vector<ArrayRef<uint8_t>> Data(Files.size());
+  std::vector<uint64_t> Hashes(Files.size());
+  parallel_for(size_t(0), Files.size(), [&](size_t I) {
+    Data[I] = getDebugT(Files[I]);
+    if (!Data[I].empty())
+      Hashes[I] = xxHash64(
+          StringRef((const char *)Data[I].data(), Data[I].size()));
+  });
+
+  // Objects compiled from the same PCH or the same TU carry identical
+  // type streams; fold those wholesale. Full cross-module type
+  // merging needs record-level index remapping, which this TPI
+  // builder does not support yet.
+  DenseMap<uint64_t, size_t> Seen;
+  for (size_t I = 0, E = Files.size(); I != E; ++I) {
+    if (Data[I].empty())
+      continue;
+    auto P = Seen.insert({Hashes[I], I});
+    if (!P.second && Data[P.first->second] == Data[I])
       continue;
 
-    msf::ByteStream Stream(Data);
+    msf::ByteStream Stream(Data[I]);
     codeview::CVTypeArray Records;
     msf::StreamReader Reader(Stream);
     if (auto EC = Reader.readArray(Records, Reader.getLength()))
@@ -159,10 +182,14 @@ void coff::createPDB(StringRef Path, SymbolTable *Symtab,
   auto &DbiBuilder = Builder.getDbiBuilder();
   DbiBuilder.setVersionHeader(pdb::PdbDbiV110);
 
-  // Add an empty TPI stream.
+  // Add an empty TPI stream. With /debug:fastlink no type records are
+  // copied at all: the module table below points the debugger at the
+  // .debug$T and .debug$S sections left in the object files, so the
+  // link pays nothing for type info no matter how large the tree is.
   auto &TpiBuilder = Builder.getTpiBuilder();
   TpiBuilder.setVersionHeader(pdb::PdbTpiV80);
-  addTypeInfo(Symtab, TpiBuilder);
+  if (!Config->PDBFastlink)
+    addTypeInfo(Symtab, TpiBuilder);
 
   // Add an empty IPI stream.
   auto &IpiBuilder = Builder.getIpiBuilder();
@@ -181,6 +208,13 @@ void coff::createPDB(StringRef Path, SymbolTable *Symtab,
       pdb::DbiStreamBuilder::createSectionMap(Sections);
   DbiBuilder.setSectionMap(SectionMap);
 
+  // One module per object whose debug info stayed in place, so
+  // consumers know where to find it.
+  if (Config->PDBFastlink)
+    for (ObjectFile *File : Symtab->ObjectFiles)
+      if (!File->getDebugChunks().empty())
+        ExitOnErr(DbiBuilder.addModuleInfo(File->getName(), File->getName()));
+
   ExitOnErr(DbiBuilder.addModuleInfo("", "* Linker *"));
 
   // Add COFF section header stream.
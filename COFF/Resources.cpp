@@ -0,0 +1,440 @@
+//===- Resources.cpp ------------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file converts Windows resource files (.res files) to a COFF
+// object file equivalent to the one cvtres.exe would produce, without
+// spawning an external process or touching the disk.
+//
+// A .res file is a flat list of resource entries, each identified by a
+// type, a name and a language. Type and name are either numeric IDs or
+// UTF-16 strings; the language is always numeric. The entries are
+// parsed into the three-level directory tree that the PE .rsrc section
+// uses, and the tree is then serialized into two sections: .rsrc$01
+// containing the directory tables, the data entry descriptors and the
+// name strings, and .rsrc$02 containing the raw resource data. Each
+// data entry descriptor carries a relocation against a symbol in
+// .rsrc$02, so the loader-visible data RVAs become correct once the
+// sections are laid out. The resulting buffer is fed back into the
+// linker like any other object file.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Config.h"
+#include "Driver.h"
+#include "Error.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Object/COFF.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <map>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::COFF;
+using namespace llvm::support;
+using namespace llvm::support::endian;
+
+namespace lld {
+namespace coff {
+namespace {
+
+// A resource name is either a numeric ID or a UTF-16 string. Strings
+// are copied out of the input buffers so that the key type is an
+// ordinary value type.
+typedef std::vector<uint16_t> ResString;
+
+// A node of the type/name/language directory tree. Interior nodes own
+// their children; leaves (language nodes) point at resource data in
+// the input .res buffers, which stay alive for the whole link.
+struct ResourceTree {
+  // Named entries precede ID entries in a directory table and both
+  // groups are sorted, so ordered maps give the right emission order.
+  std::map<ResString, ResourceTree> StringChildren;
+  std::map<uint32_t, ResourceTree> IDChildren;
+
+  ArrayRef<uint8_t> Data;
+  bool IsLeaf = false;
+
+  // Offsets assigned by the layout pass of the writer.
+  uint32_t TableOffset = 0;     // of the directory table (interior)
+  uint32_t DataEntryOffset = 0; // of the data entry descriptor (leaf)
+  uint32_t DataOffset = 0;      // of the raw data in .rsrc$02 (leaf)
+};
+
+// On-disk structures of the .rsrc section. These are not defined in
+// llvm/Object/COFF.h.
+struct ResourceDirTable {
+  ulittle32_t Characteristics;
+  ulittle32_t TimeDateStamp;
+  ulittle16_t MajorVersion;
+  ulittle16_t MinorVersion;
+  ulittle16_t NumNameEntries;
+  ulittle16_t NumIDEntries;
+};
+
+struct ResourceDirEntry {
+  ulittle32_t Name;   // ID, or string offset with the high bit set
+  ulittle32_t Offset; // subdir offset with the high bit set, or data entry
+};
+
+struct ResourceDataEntry {
+  ulittle32_t DataRVA; // filled in by a relocation
+  ulittle32_t DataSize;
+  ulittle32_t Codepage;
+  ulittle32_t Reserved;
+};
+
+// Parses one .res file and merges its entries into a directory tree.
+class ResourceParser {
+public:
+  ResourceParser(MemoryBufferRef M)
+      : MB(M), Cur(reinterpret_cast<const uint8_t *>(M.getBufferStart())),
+        End(reinterpret_cast<const uint8_t *>(M.getBufferEnd())) {}
+
+  void parseInto(ResourceTree &Root) {
+    while (Cur != End)
+      parseEntry(Root);
+  }
+
+private:
+  void check(size_t N) {
+    if ((size_t)(End - Cur) < N)
+      fatal(MB.getBufferIdentifier() + ": truncated resource file");
+  }
+
+  uint16_t read16() {
+    check(2);
+    uint16_t V = read16le(Cur);
+    Cur += 2;
+    return V;
+  }
+
+  uint32_t read32() {
+    check(4);
+    uint32_t V = read32le(Cur);
+    Cur += 4;
+    return V;
+  }
+
+  // Reads a resource identifier: 0xFFFF followed by a numeric ID, or a
+  // null-terminated UTF-16 string. Returns true for a string.
+  bool readIdent(uint32_t &ID, ResString &Str) {
+    uint16_t First = read16();
+    if (First == 0xFFFF) {
+      ID = read16();
+      return false;
+    }
+    while (First) {
+      Str.push_back(First);
+      First = read16();
+    }
+    return true;
+  }
+
+  void parseEntry(ResourceTree &Root) {
+    const uint8_t *Start = Cur;
+    uint32_t DataSize = read32();
+    uint32_t HeaderSize = read32();
+
+    uint32_t TypeID = 0, NameID = 0;
+    ResString TypeStr, NameStr;
+    bool TypeIsStr = readIdent(TypeID, TypeStr);
+    bool NameIsStr = readIdent(NameID, NameStr);
+
+    // Two identifiers can end on a 2 mod 4 boundary; the fixed part of
+    // the header is 4-byte aligned.
+    if ((Cur - Start) % 4)
+      read16();
+    read32(); // DataVersion
+    read16(); // MemoryFlags
+    uint16_t Lang = read16();
+    read32(); // Version
+    read32(); // Characteristics
+
+    if (HeaderSize < (size_t)(Cur - Start))
+      fatal(MB.getBufferIdentifier() + ": malformed resource header");
+    Cur = Start + HeaderSize;
+    check(DataSize);
+    ArrayRef<uint8_t> Data(Cur, DataSize);
+    Cur += DataSize;
+
+    // Entries start on 4-byte boundaries.
+    while ((Cur - Start) % 4 && Cur != End)
+      ++Cur;
+
+    // The empty entry at the beginning of the file is the signature
+    // that identify_magic recognized; it carries no resource.
+    if (DataSize == 0 && !TypeIsStr && TypeID == 0)
+      return;
+
+    ResourceTree &Type =
+        TypeIsStr ? Root.StringChildren[TypeStr] : Root.IDChildren[TypeID];
+    ResourceTree &Name =
+        NameIsStr ? Type.StringChildren[NameStr] : Type.IDChildren[NameID];
+    ResourceTree &Leaf = Name.IDChildren[Lang];
+    if (Leaf.IsLeaf)
+      fatal(MB.getBufferIdentifier() + ": duplicate resource");
+    Leaf.IsLeaf = true;
+    Leaf.Data = Data;
+  }
+
+  MemoryBufferRef MB;
+  const uint8_t *Cur;
+  const uint8_t *End;
+};
+
+// Serializes a directory tree into a COFF object file.
+class ResourceObjectWriter {
+public:
+  ResourceObjectWriter(ResourceTree &Root) : Root(Root) {}
+
+  std::unique_ptr<MemoryBuffer> write() {
+    layout();
+    writeHeaders();
+    writeDirectory();
+    writeRelocations();
+    writeData();
+    writeSymbols();
+    return MemoryBuffer::getMemBufferCopy(Out, "<resource-obj>");
+  }
+
+private:
+  // Walks the tree breadth-first and assigns offsets to every
+  // directory table, data entry descriptor and name string. The write
+  // pass below traverses in the same order.
+  void layout() {
+    uint32_t Off = 0;
+    Tables.push_back(&Root);
+    for (size_t I = 0; I != Tables.size(); ++I) {
+      ResourceTree *T = Tables[I];
+      T->TableOffset = Off;
+      Off += sizeof(ResourceDirTable) +
+             sizeof(ResourceDirEntry) *
+                 (T->StringChildren.size() + T->IDChildren.size());
+      for (auto &P : T->StringChildren)
+        visitChild(P.second);
+      for (auto &P : T->IDChildren)
+        visitChild(P.second);
+    }
+
+    for (ResourceTree *L : Leaves) {
+      L->DataEntryOffset = Off;
+      Off += sizeof(ResourceDataEntry);
+    }
+
+    for (ResourceTree *T : Tables)
+      for (auto &P : T->StringChildren)
+        if (StringOffsets.insert(std::make_pair(P.first, Off)).second) {
+          Strings.push_back(&P.first);
+          Off += 2 + 2 * P.first.size();
+        }
+    Rsrc01Size = Off;
+
+    // cvtres.exe pads every data blob to 8 bytes; match it so that
+    // aligned resource data stays aligned in the output.
+    uint32_t DataOff = 0;
+    for (ResourceTree *L : Leaves) {
+      L->DataOffset = DataOff;
+      DataOff += alignTo(L->Data.size(), 8);
+    }
+    Rsrc02Size = DataOff;
+  }
+
+  void visitChild(ResourceTree &Child) {
+    if (Child.IsLeaf)
+      Leaves.push_back(&Child);
+    else
+      Tables.push_back(&Child);
+  }
+
+  void append(const void *Data, size_t Size) {
+    Out.append(reinterpret_cast<const char *>(Data), Size);
+  }
+
+  template <typename T> void append(const T &Obj) { append(&Obj, sizeof(T)); }
+
+  void writeHeaders() {
+    uint32_t NumLeaves = Leaves.size();
+    uint32_t HeaderSize = sizeof(object::coff_file_header) +
+                          2 * sizeof(object::coff_section);
+    uint32_t Rsrc01Off = HeaderSize;
+    uint32_t RelocOff = Rsrc01Off + Rsrc01Size;
+    uint32_t Rsrc02Off = RelocOff + NumLeaves * sizeof(object::coff_relocation);
+    uint32_t SymtabOff = Rsrc02Off + Rsrc02Size;
+
+    object::coff_file_header FH = {};
+    FH.Machine = Config->Machine;
+    FH.NumberOfSections = 2;
+    FH.PointerToSymbolTable = SymtabOff;
+    FH.NumberOfSymbols = 5 + NumLeaves;
+    append(FH);
+
+    object::coff_section S1 = {};
+    memcpy(S1.Name, ".rsrc$01", 8);
+    S1.SizeOfRawData = Rsrc01Size;
+    S1.PointerToRawData = Rsrc01Off;
+    S1.PointerToRelocations = RelocOff;
+    S1.NumberOfRelocations = NumLeaves;
+    S1.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ |
+                         IMAGE_SCN_ALIGN_4BYTES;
+    append(S1);
+
+    object::coff_section S2 = {};
+    memcpy(S2.Name, ".rsrc$02", 8);
+    S2.SizeOfRawData = Rsrc02Size;
+    S2.PointerToRawData = Rsrc02Off;
+    S2.Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ |
+                         IMAGE_SCN_ALIGN_8BYTES;
+    append(S2);
+  }
+
+  void writeDirectory() {
+    for (ResourceTree *T : Tables) {
+      ResourceDirTable Tbl = {};
+      Tbl.NumNameEntries = T->StringChildren.size();
+      Tbl.NumIDEntries = T->IDChildren.size();
+      append(Tbl);
+      for (auto &P : T->StringChildren) {
+        ResourceDirEntry E;
+        E.Name = 0x80000000 | StringOffsets[P.first];
+        E.Offset = getChildOffset(P.second);
+        append(E);
+      }
+      for (auto &P : T->IDChildren) {
+        ResourceDirEntry E;
+        E.Name = P.first;
+        E.Offset = getChildOffset(P.second);
+        append(E);
+      }
+    }
+
+    for (ResourceTree *L : Leaves) {
+      ResourceDataEntry E = {};
+      E.DataSize = L->Data.size();
+      append(E);
+    }
+
+    for (const ResString *S : Strings) {
+      ulittle16_t Len;
+      Len = S->size();
+      append(Len);
+      for (uint16_t C : *S) {
+        ulittle16_t U;
+        U = C;
+        append(U);
+      }
+    }
+  }
+
+  uint32_t getChildOffset(ResourceTree &Child) {
+    if (Child.IsLeaf)
+      return Child.DataEntryOffset;
+    return 0x80000000 | Child.TableOffset;
+  }
+
+  uint16_t getRelocType() {
+    switch (Config->Machine) {
+    case AMD64:
+      return IMAGE_REL_AMD64_ADDR32NB;
+    case I386:
+      return IMAGE_REL_I386_DIR32NB;
+    case ARMNT:
+      return IMAGE_REL_ARM_ADDR32NB;
+    default:
+      llvm_unreachable("unknown machine type");
+    }
+  }
+
+  // One relocation per data entry descriptor, turning its DataRVA
+  // field into the final RVA of the data in .rsrc$02.
+  void writeRelocations() {
+    for (size_t I = 0, E = Leaves.size(); I != E; ++I) {
+      object::coff_relocation R;
+      R.VirtualAddress = Leaves[I]->DataEntryOffset;
+      R.SymbolTableIndex = 5 + I;
+      R.Type = getRelocType();
+      append(R);
+    }
+  }
+
+  void writeData() {
+    for (ResourceTree *L : Leaves) {
+      append(L->Data.data(), L->Data.size());
+      Out.append(alignTo(L->Data.size(), 8) - L->Data.size(), '\0');
+    }
+  }
+
+  void addSectionSymbol(StringRef Name, int SectionNumber, uint32_t Size,
+                        uint16_t NumRelocs) {
+    object::coff_symbol16 Sym = {};
+    memcpy(Sym.Name.ShortName, Name.data(), Name.size());
+    Sym.SectionNumber = SectionNumber;
+    Sym.StorageClass = IMAGE_SYM_CLASS_STATIC;
+    Sym.NumberOfAuxSymbols = 1;
+    append(Sym);
+    object::coff_aux_section_definition Aux = {};
+    Aux.Length = Size;
+    Aux.NumberOfRelocations = NumRelocs;
+    append(Aux);
+  }
+
+  void writeSymbols() {
+    // The same feature flags symbol cvtres.exe emits.
+    object::coff_symbol16 Feat = {};
+    memcpy(Feat.Name.ShortName, "@feat.00", 8);
+    Feat.Value = 0x11;
+    Feat.SectionNumber = IMAGE_SYM_ABSOLUTE;
+    Feat.StorageClass = IMAGE_SYM_CLASS_STATIC;
+    append(Feat);
+
+    addSectionSymbol(".rsrc$01", 1, Rsrc01Size, Leaves.size());
+    addSectionSymbol(".rsrc$02", 2, Rsrc02Size, 0);
+
+    for (size_t I = 0, E = Leaves.size(); I != E; ++I) {
+      object::coff_symbol16 Sym = {};
+      SmallString<8> Name;
+      raw_svector_ostream(Name) << format("$R%06zX", I);
+      memcpy(Sym.Name.ShortName, Name.data(), 8);
+      Sym.Value = Leaves[I]->DataOffset;
+      Sym.SectionNumber = 2;
+      Sym.StorageClass = IMAGE_SYM_CLASS_STATIC;
+      append(Sym);
+    }
+
+    // An empty string table: just its size field.
+    ulittle32_t StrtabSize;
+    StrtabSize = 4;
+    append(StrtabSize);
+  }
+
+  ResourceTree &Root;
+  std::vector<ResourceTree *> Tables;
+  std::vector<ResourceTree *> Leaves;
+  std::map<ResString, uint32_t> StringOffsets;
+  std::vector<const ResString *> Strings;
+  uint32_t Rsrc01Size = 0;
+  uint32_t Rsrc02Size = 0;
+  std::string Out;
+};
+
+} // anonymous namespace
+
+// Convert Windows resource files to a COFF object file, in memory.
+std::unique_ptr<MemoryBuffer>
+convertResToCOFF(const std::vector<MemoryBufferRef> &MBs) {
+  ResourceTree Root;
+  for (MemoryBufferRef MB : MBs)
+    ResourceParser(MB).parseInto(Root);
+  return ResourceObjectWriter(Root).write();
+}
+
+} // namespace coff
+} // namespace lld
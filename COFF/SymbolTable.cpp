@@ -17,6 +17,7 @@
 #include "llvm/LTO/legacy/LTOCodeGenerator.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <utility>
 
 using namespace llvm;
@@ -241,13 +242,11 @@ Symbol *SymbolTable::addRelative(StringRef N, uint64_t VA) {
   return S;
 }
 
-Symbol *SymbolTable::addRegular(ObjectFile *F, COFFSymbolRef Sym,
+Symbol *SymbolTable::addRegular(ObjectFile *F, StringRef N, COFFSymbolRef Sym,
                                 SectionChunk *C) {
-  StringRef Name;
-  F->getCOFFObj()->getSymbolName(Sym, Name);
   Symbol *S;
   bool WasInserted;
-  std::tie(S, WasInserted) = insert(Name);
+  std::tie(S, WasInserted) = insert(N);
   S->IsUsedInRegularObj = true;
   if (WasInserted || isa<Undefined>(S->body()) || isa<Lazy>(S->body()))
     replaceBody<DefinedRegular>(S, F, Sym, C);
@@ -281,13 +280,11 @@ Symbol *SymbolTable::addBitcode(BitcodeFile *F, StringRef N, bool IsReplaceable)
   return S;
 }
 
-Symbol *SymbolTable::addCommon(ObjectFile *F, COFFSymbolRef Sym,
+Symbol *SymbolTable::addCommon(ObjectFile *F, StringRef N, COFFSymbolRef Sym,
                                CommonChunk *C) {
-  StringRef Name;
-  F->getCOFFObj()->getSymbolName(Sym, Name);
   Symbol *S;
   bool WasInserted;
-  std::tie(S, WasInserted) = insert(Name);
+  std::tie(S, WasInserted) = insert(N);
   S->IsUsedInRegularObj = true;
   if (WasInserted || !isa<DefinedCOFF>(S->body()))
     replaceBody<DefinedCommon>(S, F, Sym, C);
@@ -357,12 +354,23 @@ Symbol *SymbolTable::findUnderscore(StringRef Name) {
   return find(Name);
 }
 
+// Returns some symbol name starting with Prefix, or "" if there's none.
+// mangleMaybe probes the table once per unresolved symbol, so a linear
+// scan per probe is quadratic on large links; keep the names sorted and
+// binary-search instead. The index is rebuilt if symbols were added
+// since it was last built (resolving an alias doesn't add any).
 StringRef SymbolTable::findByPrefix(StringRef Prefix) {
-  for (auto Pair : Symtab) {
-    StringRef Name = Pair.first;
-    if (Name.startswith(Prefix))
-      return Name;
+  if (SortedNamesSize != Symtab.size()) {
+    SortedNames.clear();
+    SortedNames.reserve(Symtab.size());
+    for (auto Pair : Symtab)
+      SortedNames.push_back(Pair.first);
+    std::sort(SortedNames.begin(), SortedNames.end());
+    SortedNamesSize = Symtab.size();
   }
+  auto It = std::lower_bound(SortedNames.begin(), SortedNames.end(), Prefix);
+  if (It != SortedNames.end() && It->startswith(Prefix))
+    return *It;
   return "";
 }
 
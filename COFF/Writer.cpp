@@ -12,6 +12,7 @@
 #include "DLL.h"
 #include "Error.h"
 #include "InputFiles.h"
+#include "MapFile.h"
 #include "PDB.h"
 #include "SymbolTable.h"
 #include "Symbols.h"
@@ -23,12 +24,15 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/FileOutputBuffer.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/RandomNumberGenerator.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdio>
+#include <functional>
 #include <map>
 #include <memory>
+#include <thread>
 #include <utility>
 
 using namespace llvm;
@@ -119,8 +123,10 @@ private:
   void fixSafeSEHSymbols();
   void setSectionPermissions();
   void writeSections();
+  void writeSymbolAndStringTable();
   void sortExceptionTable();
   void writeBuildId();
+  void writeChecksum();
   void applyRelocations();
 
   llvm::Optional<coff_symbol16> createSymbol(Defined *D);
@@ -142,6 +148,10 @@ private:
   IdataContents Idata;
   DelayLoadContents DelayIdata;
   EdataContents Edata;
+
+  // Location of the optional header CheckSum field, saved by
+  // writeHeader and backfilled by writeChecksum for /release.
+  llvm::support::ulittle32_t *ChecksumField = nullptr;
   std::unique_ptr<SEHTableChunk> SEHTable;
 
   std::unique_ptr<Chunk> DebugDirectory;
@@ -163,51 +173,6 @@ namespace coff {
 
 void writeResult(SymbolTable *T) { Writer(T).run(); }
 
-// OutputSection represents a section in an output file. It's a
-// container of chunks. OutputSection and Chunk are 1:N relationship.
-// Chunks cannot belong to more than one OutputSections. The writer
-// creates multiple OutputSections and assign them unique,
-// non-overlapping file offsets and RVAs.
-class OutputSection {
-public:
-  OutputSection(StringRef N) : Name(N), Header({}) {}
-  void setRVA(uint64_t);
-  void setFileOffset(uint64_t);
-  void addChunk(Chunk *C);
-  StringRef getName() { return Name; }
-  std::vector<Chunk *> &getChunks() { return Chunks; }
-  void addPermissions(uint32_t C);
-  void setPermissions(uint32_t C);
-  uint32_t getPermissions() { return Header.Characteristics & PermMask; }
-  uint32_t getCharacteristics() { return Header.Characteristics; }
-  uint64_t getRVA() { return Header.VirtualAddress; }
-  uint64_t getFileOff() { return Header.PointerToRawData; }
-  void writeHeaderTo(uint8_t *Buf);
-
-  // Returns the size of this section in an executable memory image.
-  // This may be smaller than the raw size (the raw size is multiple
-  // of disk sector size, so there may be padding at end), or may be
-  // larger (if that's the case, the loader reserves spaces after end
-  // of raw data).
-  uint64_t getVirtualSize() { return Header.VirtualSize; }
-
-  // Returns the size of the section in the output file.
-  uint64_t getRawSize() { return Header.SizeOfRawData; }
-
-  // Set offset into the string table storing this section name.
-  // Used only when the name is longer than 8 bytes.
-  void setStringTableOff(uint32_t V) { StringTableOff = V; }
-
-  // N.B. The section index is one based.
-  uint32_t SectionIndex = 0;
-
-private:
-  StringRef Name;
-  coff_section Header;
-  uint32_t StringTableOff = 0;
-  std::vector<Chunk *> Chunks;
-};
-
 void OutputSection::setRVA(uint64_t RVA) {
   Header.VirtualAddress = RVA;
   for (Chunk *C : Chunks)
@@ -292,7 +257,20 @@ void Writer::run() {
   removeEmptySections();
   setSectionPermissions();
   createSymbolAndStringTable();
+
+  // Read back the previous output on a background thread while the
+  // new image is composed; the unchanged-output check below needs it
+  // and the read is pure I/O. The read must start before openFile:
+  // FileOutputBuffer deletes the destination before creating its
+  // temporary, so a read started afterwards always fails with ENOENT.
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Old = std::error_code();
+  std::thread OldReader([&Old] {
+    Old = MemoryBuffer::getFile(Config->OutputFile, /*FileSize*/ -1,
+                                /*RequiresNullTerminator*/ false);
+  });
+
   openFile(Config->OutputFile);
+
   if (Config->is64()) {
     writeHeader<pe32plus_header>();
   } else {
@@ -300,12 +278,35 @@ void Writer::run() {
   }
   fixSafeSEHSymbols();
   writeSections();
+
+  // The map describes the final layout, which does not change past this
+  // point, so format and write it on a background thread while the main
+  // thread finishes the image. The map goes to its own file, so it can
+  // proceed whether or not the image itself ends up being rewritten.
+  std::thread MapWriter;
+  if (!Config->MapFile.empty())
+    MapWriter = std::thread(
+        [this] { writeMapFile(OutputSections, Symtab); });
+
   sortExceptionTable();
   writeBuildId();
+  writeChecksum();
 
   if (!Config->PDBPath.empty())
     createPDB(Config->PDBPath, Symtab, SectionTable);
 
+  // The image carries no timestamp, so an unchanged input set
+  // reproduces the output byte for byte. If the new image is identical
+  // to the file already on disk, keep the old file and its timestamp
+  // so downstream build steps treat the output as up to date.
+  // (FileOutputBuffer wrote to a temporary; dropping it is free.)
+  OldReader.join();
+  if (MapWriter.joinable())
+    MapWriter.join();
+  if (Old && (*Old)->getBufferSize() == FileSize &&
+      memcmp((*Old)->getBufferStart(), Buffer->getBufferStart(), FileSize) == 0)
+    return;
+
   if (auto EC = Buffer->commit())
     fatal(EC, "failed to write the output file");
 }
@@ -320,16 +321,73 @@ static StringRef getOutputSection(StringRef Name) {
 
 // Create output section objects and add them to OutputSections.
 void Writer::createSections() {
-  // First, bin chunks by name.
-  std::map<StringRef, std::vector<Chunk *>> Map;
-  for (Chunk *C : Symtab->getChunks()) {
-    auto *SC = dyn_cast<SectionChunk>(C);
-    if (SC && !SC->isLive()) {
-      if (Config->Verbose)
-        SC->printDiscardedMessage();
-      continue;
+  // First, bin chunks by name. With function-level sections (/Gy) this
+  // is one lookup per function, so the bins are hashed rather than
+  // tree-based, and the chunk list is binned as per-slice partial bins
+  // in parallel. Appending the partials in slice order preserves the
+  // sequential chunk order within every bin.
+  const std::vector<Chunk *> &Chunks = Symtab->getChunks();
+
+  if (Config->Verbose)
+    for (Chunk *C : Chunks)
+      if (auto *SC = dyn_cast<SectionChunk>(C))
+        if (!SC->isLive())
+          SC->printDiscardedMessage();
+
+  const size_t NumSlices = 16;
+  size_t SliceSize = (Chunks.size() + NumSlices - 1) / NumSlices;
+  std::vector<DenseMap<StringRef, std::vector<Chunk *>>> Partial(NumSlices);
+  parallel_for((size_t)0, NumSlices, [&](size_t S) {
+    DenseMap<StringRef, std::vector<Chunk *>> &Bin = Partial[S];
+    Bin.reserve(64);
+    size_t Begin = std::min(Chunks.size(), S * SliceSize);
+    size_t End = std::min(Chunks.size(), Begin + SliceSize);
+    for (size_t I = Begin; I != End; ++I) {
+      Chunk *C = Chunks[I];
+      auto *SC = dyn_cast<SectionChunk>(C);
+      if (SC && !SC->isLive())
+        continue;
+      Bin[C->getSectionName()].push_back(C);
+    }
+  });
+
+  // Only the chunk order within a bin matters below; the bins
+  // themselves are visited through the sorted name list, which keeps
+  // the output section order the tree-based map used to provide.
+  DenseMap<StringRef, std::vector<Chunk *>> Map;
+  std::vector<StringRef> Names;
+  for (DenseMap<StringRef, std::vector<Chunk *>> &Bin : Partial) {
+    for (auto &Pair : Bin) {
+      std::vector<Chunk *> &V = Map[Pair.first];
+      if (V.empty()) {
+        Names.push_back(Pair.first);
+        V = std::move(Pair.second);
+      } else {
+        V.insert(V.end(), Pair.second.begin(), Pair.second.end());
+      }
+    }
+  }
+  std::sort(Names.begin(), Names.end());
+
+  // Apply /order priorities. Listed symbols have negative priorities,
+  // so their chunks sort before unlisted ones (priority zero); the
+  // stable sort otherwise preserves input order.
+  if (!Config->Order.empty()) {
+    auto GetPriority = [](Chunk *C) {
+      if (auto *SC = dyn_cast<SectionChunk>(C))
+        if (SC->Sym) {
+          auto It = Config->Order.find(SC->Sym->getName());
+          if (It != Config->Order.end())
+            return It->second;
+        }
+      return 0;
+    };
+    for (StringRef Name : Names) {
+      std::vector<Chunk *> &V = Map[Name];
+      std::stable_sort(V.begin(), V.end(), [&](Chunk *A, Chunk *B) {
+        return GetPriority(A) < GetPriority(B);
+      });
     }
-    Map[C->getSectionName()].push_back(C);
   }
 
   // Then create an OutputSection for each section.
@@ -337,15 +395,14 @@ void Writer::createSections() {
   // discarded when determining output section. So, .text$foo
   // contributes to .text, for example. See PE/COFF spec 3.2.
   SmallDenseMap<StringRef, OutputSection *> Sections;
-  for (auto Pair : Map) {
-    StringRef Name = getOutputSection(Pair.first);
+  for (StringRef BinName : Names) {
+    StringRef Name = getOutputSection(BinName);
     OutputSection *&Sec = Sections[Name];
     if (!Sec) {
       Sec = make<OutputSection>(Name);
       OutputSections.push_back(Sec);
     }
-    std::vector<Chunk *> &Chunks = Pair.second;
-    for (Chunk *C : Chunks) {
+    for (Chunk *C : Map[BinName]) {
       Sec->addChunk(C);
       Sec->addPermissions(C->getPermissions());
     }
@@ -437,8 +494,8 @@ void Writer::createImportTables() {
     for (Chunk *C : DelayIdata.getDataChunks())
       Sec->addChunk(C);
     Sec = createSection(".text");
-    for (std::unique_ptr<Chunk> &C : DelayIdata.getCodeChunks())
-      Sec->addChunk(C.get());
+    for (Chunk *C : DelayIdata.getCodeChunks())
+      Sec->addChunk(C);
   }
 }
 
@@ -446,8 +503,8 @@ void Writer::createExportTable() {
   if (Config->Exports.empty())
     return;
   OutputSection *Sec = createSection(".edata");
-  for (std::unique_ptr<Chunk> &C : Edata.Chunks)
-    Sec->addChunk(C.get());
+  for (Chunk *C : Edata.Chunks)
+    Sec->addChunk(C);
 }
 
 // The Windows loader doesn't seem to like empty sections,
@@ -653,6 +710,7 @@ template <typename PEHeaderTy> void Writer::writeHeader() {
   if (Config->TerminalServerAware)
     PE->DLLCharacteristics |= IMAGE_DLL_CHARACTERISTICS_TERMINAL_SERVER_AWARE;
   PE->NumberOfRvaAndSize = NumberfOfDataDirectory;
+  ChecksumField = &PE->CheckSum;
   if (OutputSection *Text = findSection(".text")) {
     PE->BaseOfCode = Text->getRVA();
     PE->SizeOfCode = Text->getRawSize();
@@ -730,19 +788,10 @@ template <typename PEHeaderTy> void Writer::writeHeader() {
   if (OutputSymtab.empty())
     return;
 
+  // The tables themselves are copied out by writeSymbolAndStringTable
+  // as part of the parallel drain in writeSections.
   COFF->PointerToSymbolTable = PointerToSymbolTable;
-  uint32_t NumberOfSymbols = OutputSymtab.size();
-  COFF->NumberOfSymbols = NumberOfSymbols;
-  auto *SymbolTable = reinterpret_cast<coff_symbol16 *>(
-      Buffer->getBufferStart() + COFF->PointerToSymbolTable);
-  for (size_t I = 0; I != NumberOfSymbols; ++I)
-    SymbolTable[I] = OutputSymtab[I];
-  // Create the string table, it follows immediately after the symbol table.
-  // The first 4 bytes is length including itself.
-  Buf = reinterpret_cast<uint8_t *>(&SymbolTable[NumberOfSymbols]);
-  write32le(Buf, Strtab.size() + 4);
-  if (!Strtab.empty())
-    memcpy(Buf + 4, Strtab.data(), Strtab.size());
+  COFF->NumberOfSymbols = OutputSymtab.size();
 }
 
 void Writer::openFile(StringRef Path) {
@@ -774,16 +823,49 @@ void Writer::setSectionPermissions() {
 // Write section contents to a mmap'ed file.
 void Writer::writeSections() {
   uint8_t *Buf = Buffer->getBufferStart();
+
+  // Writing one section at a time limits parallelism to the chunks of
+  // that single section, so flatten the chunks of all sections into
+  // one task list and drain it with a single parallel loop. The mmap
+  // destination means the OS can start writing completed pages back
+  // while later tasks are still running.
+  std::vector<std::function<void()>> Tasks;
   for (OutputSection *Sec : OutputSections) {
     uint8_t *SecBuf = Buf + Sec->getFileOff();
     // Fill gaps between functions in .text with INT3 instructions
     // instead of leaving as NUL bytes (which can be interpreted as
-    // ADD instructions).
+    // ADD instructions). The fill must precede the chunk writes, so
+    // it stays ahead of the task list.
     if (Sec->getPermissions() & IMAGE_SCN_CNT_CODE)
       memset(SecBuf, 0xCC, Sec->getRawSize());
-    parallel_for_each(Sec->getChunks().begin(), Sec->getChunks().end(),
-                      [&](Chunk *C) { C->writeTo(SecBuf); });
+    for (Chunk *C : Sec->getChunks())
+      Tasks.push_back([=] { C->writeTo(SecBuf); });
   }
+
+  // The symbol and string tables occupy a buffer region disjoint from
+  // all section contents, so copying them out is just another task.
+  if (!OutputSymtab.empty())
+    Tasks.push_back([this] { writeSymbolAndStringTable(); });
+
+  parallel_for_each(Tasks.begin(), Tasks.end(),
+                    [](const std::function<void()> &Fn) { Fn(); });
+}
+
+// Copies the symbol table, and the string table that immediately
+// follows it, into the output buffer. Called from the parallel drain
+// in writeSections; writeHeader has already filled in the file
+// header's symbol table fields.
+void Writer::writeSymbolAndStringTable() {
+  auto *SymbolTable = reinterpret_cast<coff_symbol16 *>(
+      Buffer->getBufferStart() + PointerToSymbolTable);
+  for (size_t I = 0, E = OutputSymtab.size(); I != E; ++I)
+    SymbolTable[I] = OutputSymtab[I];
+  // The string table follows immediately after the symbol table.
+  // The first 4 bytes is length including itself.
+  auto *Buf = reinterpret_cast<uint8_t *>(&SymbolTable[OutputSymtab.size()]);
+  write32le(Buf, Strtab.size() + 4);
+  if (!Strtab.empty())
+    memcpy(Buf + 4, Strtab.data(), Strtab.size());
 }
 
 // Sort .pdata section contents according to PE/COFF spec 5.5.
@@ -794,23 +876,62 @@ void Writer::sortExceptionTable() {
   // We assume .pdata contains function table entries only.
   uint8_t *Begin = Buffer->getBufferStart() + Sec->getFileOff();
   uint8_t *End = Begin + Sec->getVirtualSize();
+  // The entries order by their 32-bit begin RVA, so a key-based radix
+  // sort spreads the work evenly across workers; the comparator-based
+  // parallel quicksort left a long serial tail on large tables, and
+  // this sort runs right before the file is committed.
   if (Config->Machine == AMD64) {
     struct Entry { ulittle32_t Begin, End, Unwind; };
-    parallel_sort(
+    parallel_radix_sort(
         (Entry *)Begin, (Entry *)End,
-        [](const Entry &A, const Entry &B) { return A.Begin < B.Begin; });
+        [](const Entry &E) { return (uint32_t)E.Begin; });
     return;
   }
   if (Config->Machine == ARMNT) {
     struct Entry { ulittle32_t Begin, Unwind; };
-    parallel_sort(
+    parallel_radix_sort(
         (Entry *)Begin, (Entry *)End,
-        [](const Entry &A, const Entry &B) { return A.Begin < B.Begin; });
+        [](const Entry &E) { return (uint32_t)E.Begin; });
     return;
   }
   errs() << "warning: don't know how to handle .pdata.\n";
 }
 
+// Backfill the optional header CheckSum for /release. The algorithm is
+// the one imagehlp's CheckSumMappedFile uses: a 16-bit one's-complement
+// folded sum of every little-endian word in the image (with the
+// CheckSum field itself still zero) plus the file size. One's
+// complement addition is associative, so the image is split into fixed
+// chunks whose plain 64-bit word sums are computed in parallel and
+// folded once at the end; signing tools then accept the binary without
+// a separate imagehlp pass re-reading the whole file.
+void Writer::writeChecksum() {
+  if (!Config->Release)
+    return;
+
+  uint8_t *Begin = Buffer->getBufferStart();
+  const size_t ChunkBytes = 1024 * 1024;
+  size_t NumChunks = (FileSize + ChunkBytes - 1) / ChunkBytes;
+  std::vector<uint64_t> Partial(NumChunks);
+  parallel_for((size_t)0, NumChunks, [&](size_t I) {
+    // FileSize is a multiple of the sector size, so every chunk covers
+    // whole 16-bit words.
+    auto *P = reinterpret_cast<ulittle16_t *>(Begin + I * ChunkBytes);
+    size_t N = std::min<uint64_t>(ChunkBytes, FileSize - I * ChunkBytes) / 2;
+    uint64_t Sum = 0;
+    for (size_t J = 0; J != N; ++J)
+      Sum += P[J];
+    Partial[I] = Sum;
+  });
+
+  uint64_t Sum = 0;
+  for (uint64_t P : Partial)
+    Sum += P;
+  while (Sum >> 16)
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+  *ChecksumField = Sum + FileSize;
+}
+
 // Backfill the CVSignature in a PDB70 Debug Record.  This backfilling allows us
 // to get reproducible builds.
 void Writer::writeBuildId() {
@@ -879,9 +1000,17 @@ void Writer::addBaserels(OutputSection *Dest) {
   for (OutputSection *Sec : OutputSections) {
     if (Sec == Dest)
       continue;
-    // Collect all locations for base relocations.
-    for (Chunk *C : Sec->getChunks())
-      C->getBaserels(&V);
+    // Collect all locations for base relocations. Chunks are laid out
+    // in RVA order and each chunk emits its baserels in address order,
+    // so collecting into per-chunk vectors in parallel and
+    // concatenating them preserves the page order that
+    // addBaserelBlocks expects.
+    std::vector<Chunk *> &Chunks = Sec->getChunks();
+    std::vector<std::vector<Baserel>> Tmp(Chunks.size());
+    parallel_for(size_t(0), Chunks.size(),
+                 [&](size_t I) { Chunks[I]->getBaserels(&Tmp[I]); });
+    for (std::vector<Baserel> &T : Tmp)
+      V.insert(V.end(), T.begin(), T.end());
     // Add the addresses to .reloc section.
     if (!V.empty())
       addBaserelBlocks(Dest, V);
@@ -85,7 +85,21 @@ struct Configuration {
   llvm::StringRef OutputFile;
   llvm::StringRef SoName;
   llvm::StringRef Sysroot;
+  llvm::StringRef ThinLTOCacheDir;
+  // For --thinlto-index-only=<file> and --thinlto-prefix-replace=old;new.
+  llvm::StringRef ThinLTOIndexOnlyObjectsFile;
+  llvm::StringRef ThinLTOPrefixReplaceOld;
+  llvm::StringRef ThinLTOPrefixReplaceNew;
+  // File for --layout-only ("-" means stdout). When non-empty, the link
+  // stops once addresses are assigned and no output file is written.
+  std::string LayoutOnly;
+  std::string MapFile;
   std::string RPath;
+  // File for --section-digests. When non-empty, a manifest of
+  // per-output-section content hashes is written next to the output.
+  std::string SectionDigestsFile;
+  std::string SeparateDebugFilename;
+  std::string TimeTraceFile;
   std::vector<VersionDefinition> VersionDefinitions;
   std::vector<llvm::StringRef> AuxiliaryList;
   std::vector<llvm::StringRef> SearchPaths;
@@ -94,22 +108,29 @@ struct Configuration {
   std::vector<SymbolVersion> VersionScriptLocals;
   std::vector<uint8_t> BuildIdVector;
   bool AllowMultipleDefinition;
+  bool AndroidPackDynRelocs = false;
   bool AsNeeded = false;
   bool Bsymbolic;
   bool BsymbolicFunctions;
   bool ColorDiagnostics = false;
+  bool CompressDebugSections = false;
   bool Demangle = true;
   bool DisableVerify;
   bool EhFrameHdr;
   bool EnableNewDtags;
   bool ExportDynamic;
   bool FatalWarnings;
+  bool FixCortexA53Errata843419;
   bool GcSections;
   bool GdbIndex;
   bool GnuHash = false;
   bool ICF;
+  bool ICFData;
+  bool Incremental;
+  bool LinkProfile;
   bool Mips64EL = false;
   bool MipsN32Abi = false;
+  bool MmapOutputFile;
   bool NoGnuUnique;
   bool NoUndefinedVersion;
   bool Nostdlib;
@@ -120,11 +141,20 @@ struct Configuration {
   bool PrintGcSections;
   bool Rela;
   bool Relocatable;
+  bool RelrPackDynRelocs = false;
   bool SaveTemps;
+  bool SeparateDebugFile = false;
   bool SingleRoRx;
   bool Shared;
   bool Static = false;
+  bool Stats;
+  // For --stream-output: write the image to stdout instead of a file,
+  // handing finished byte ranges to the consumer while later ones are
+  // still being composed.
+  bool StreamOutput;
   bool SysvHash = true;
+  bool ThinLTOEmitImportsFiles;
+  bool ThinLTOIndexOnly;
   bool Target1Rel;
   bool Threads;
   bool Trace;
@@ -148,12 +178,16 @@ struct Configuration {
   ELFKind EKind = ELFNoneKind;
   uint16_t DefaultSymbolVersion = llvm::ELF::VER_NDX_GLOBAL;
   uint16_t EMachine = llvm::ELF::EM_NONE;
+  uint64_t ErrorBudget = 0;
   uint64_t ErrorLimit = 20;
   uint64_t ImageBase;
   uint64_t MaxPageSize;
   uint64_t SdaBase = ~0;
   uint64_t Sda2Base = ~0;
   uint64_t ZStackSize;
+  // Number of shards ICF splits its class traversal into. Retuned by
+  // the link profile; see LinkProfile.cpp.
+  unsigned ICFShards = 256;
   unsigned LTOPartitions;
   unsigned LTOO;
   unsigned Optimize;
@@ -11,26 +11,38 @@
 #include "Config.h"
 #include "Error.h"
 #include "ICF.h"
+#include "IncrementalCache.h"
 #include "InputFiles.h"
 #include "InputSection.h"
+#include "LinkContext.h"
+#include "LinkProfile.h"
 #include "LinkerScript.h"
+#include "Relocations.h"
 #include "Strings.h"
 #include "SymbolTable.h"
 #include "Target.h"
 #include "Threads.h"
+#include "Timer.h"
 #include "Writer.h"
 #include "lld/Config/Version.h"
+#include "lld/Core/TimeTrace.h"
 #include "lld/Driver/Driver.h"
 #include "lld/Support/Memory.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdlib>
+#include <thread>
 #include <utility>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 using namespace llvm;
 using namespace llvm::ELF;
 using namespace llvm::object;
@@ -44,6 +56,7 @@ LinkerDriver *elf::Driver;
 
 bool elf::link(ArrayRef<const char *> Args, bool CanExitEarly,
                raw_ostream &Error) {
+  ScopedLinkContext Ctx;
   ErrorCount = 0;
   ErrorOS = &Error;
   Argv0 = Args[0];
@@ -53,7 +66,9 @@ bool elf::link(ArrayRef<const char *> Args, bool CanExitEarly,
   ScriptConfig = make<ScriptConfiguration>();
 
   Driver->main(Args, CanExitEarly);
-  freeArena();
+  // Ends the arena epoch but keeps slab mappings cached, so a process
+  // running several links (lld -batch, library use) reuses capacity.
+  resetArenas();
   return !ErrorCount;
 }
 
@@ -205,6 +220,49 @@ Optional<MemoryBufferRef> LinkerDriver::readFileCopyBuf(StringRef Path) {
   return MBRef;
 }
 
+// Tell the kernel to start reading a byte range into the page cache.
+// This is purely advisory; errors (for example for small files that
+// were read into heap memory instead of being mmap'ed) are ignored.
+static void adviseWillNeed(const char *Data, size_t Size) {
+#if defined(__linux__)
+  uintptr_t PageMask = sys::Process::getPageSize() - 1;
+  uintptr_t Begin = reinterpret_cast<uintptr_t>(Data) & ~PageMask;
+  uintptr_t End = reinterpret_cast<uintptr_t>(Data) + Size;
+  (void)::madvise(reinterpret_cast<void *>(Begin), End - Begin, MADV_WILLNEED);
+#else
+  (void)Data;
+  (void)Size;
+#endif
+}
+
+// Start faulting the input files into memory in the background so that
+// the I/O overlaps parsing instead of being paid one page at a time
+// inside the parse loops. This matters most on a cold cache and over
+// networked filesystems, where each scattered fault is a round trip.
+// The first pass covers the regions the parsers touch first -- the ELF
+// header at the front and the section table, symbol table and string
+// tables that compilers place at the end of the file -- and the second
+// pass covers the section bodies in between. The thread is detached:
+// it only passes address ranges it holds by value to madvise, so it
+// never dereferences the buffers and may safely outlive them.
+void LinkerDriver::prefetchInputs() {
+  std::vector<std::pair<const char *, size_t>> Bufs;
+  for (std::unique_ptr<MemoryBuffer> &MB : OwningMBs)
+    Bufs.push_back({MB->getBufferStart(), MB->getBufferSize()});
+
+  std::thread([=] {
+    const size_t Head = 4096;
+    const size_t Tail = 1 << 20;
+    for (auto &B : Bufs) {
+      adviseWillNeed(B.first, std::min(B.second, Head));
+      if (B.second > Tail)
+        adviseWillNeed(B.first + B.second - Tail, Tail);
+    }
+    for (auto &B : Bufs)
+      adviseWillNeed(B.first, B.second);
+  }).detach();
+}
+
 // Add a given library by searching it from input search paths.
 void LinkerDriver::addLibrary(StringRef Name) {
   if (Optional<std::string> Path = searchLibrary(Name))
@@ -325,6 +383,7 @@ void LinkerDriver::main(ArrayRef<const char *> ArgsArr, bool CanExitEarly) {
   opt::InputArgList Args = Parser.parse(ArgsArr.slice(1));
 
   // Read some flags early because error() depends on them.
+  Config->ErrorBudget = getInteger(Args, OPT_error_budget, 0);
   Config->ErrorLimit = getInteger(Args, OPT_error_limit, 20);
   Config->ColorDiagnostics = getColorDiagnostics(Args);
 
@@ -358,29 +417,62 @@ void LinkerDriver::main(ArrayRef<const char *> ArgsArr, bool CanExitEarly) {
   }
 
   readConfigs(Args);
+
+  // The profile from the previous link of this output may downgrade
+  // the threading default, so it has to be consulted before the first
+  // parallel pass starts the process-wide pool.
+  loadLinkProfile(Args.hasArg(OPT_threads, OPT_no_threads, OPT_threads_eq));
+
   initLLVM(Args);
   createFiles(Args);
+  prefetchInputs();
   inferMachineType();
   checkOptions(Args);
   if (ErrorCount)
     return;
 
+  // If the incremental cache from a previous run proves that neither
+  // the command line nor any input has changed, the existing output is
+  // already the file this link would produce, so we are done.
+  std::vector<MemoryBufferRef> Inputs;
+  if (Config->Incremental) {
+    for (std::unique_ptr<MemoryBuffer> &MB : OwningMBs)
+      Inputs.push_back(MB->getMemBufferRef());
+    if (isLinkUpToDate(ArgsArr, Inputs)) {
+      if (Config->Verbose)
+        outs() << Config->OutputFile << " is up to date\n";
+      return;
+    }
+  }
+
   switch (Config->EKind) {
   case ELF32LEKind:
     link<ELF32LE>(Args);
-    return;
+    break;
   case ELF32BEKind:
     link<ELF32BE>(Args);
-    return;
+    break;
   case ELF64LEKind:
     link<ELF64LE>(Args);
-    return;
+    break;
   case ELF64BEKind:
     link<ELF64BE>(Args);
-    return;
+    break;
   default:
     llvm_unreachable("unknown Config->EKind");
   }
+
+  // Re-collect the buffers before writing the cache: members of thin
+  // archives fetched during resolution get their own buffers, and they
+  // are inputs in their own right.
+  if (Config->Incremental && !ErrorCount) {
+    Inputs.clear();
+    for (std::unique_ptr<MemoryBuffer> &MB : OwningMBs)
+      Inputs.push_back(MB->getMemBufferRef());
+    writeLinkCache(ArgsArr, Inputs);
+    writeBitcodeSymbolCache();
+    writeArchiveMemberCache();
+  }
 }
 
 static UnresolvedPolicy getUnresolvedSymbolOption(opt::InputArgList &Args) {
@@ -506,6 +598,68 @@ static void parseSymbolOrderingList(MemoryBufferRef MB) {
     Config->SymbolOrderingFile.insert({CachedHashStringRef(S.trim()), I++});
 }
 
+// Parse the --call-graph-ordering-file argument. File has one profile
+// edge per line:
+// <caller> <callee> <weight>
+// Edges are taken in descending weight order and the callee's cluster is
+// appended to the caller's, so hot caller/callee pairs end up adjacent.
+// The resulting symbol sequence seeds SymbolOrderingFile; layout is then
+// applied by the same writer code as --symbol-ordering-file, and symbols
+// given there explicitly keep their positions.
+static void parseCallGraphOrderingList(MemoryBufferRef MB) {
+  struct Edge {
+    StringRef From;
+    StringRef To;
+    uint64_t Weight;
+  };
+  std::vector<Edge> Edges;
+  SmallVector<StringRef, 0> Lines;
+  MB.getBuffer().split(Lines, '\n');
+  for (StringRef Line : Lines) {
+    SmallVector<StringRef, 3> Fields;
+    Line.split(Fields, ' ', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    if (Fields.empty())
+      continue;
+    uint64_t Weight;
+    if (Fields.size() != 3 || Fields[2].getAsInteger(10, Weight)) {
+      error("malformed call graph profile line: " + Line);
+      return;
+    }
+    Edges.push_back({Fields[0], Fields[1], Weight});
+  }
+  std::stable_sort(Edges.begin(), Edges.end(),
+                   [](const Edge &A, const Edge &B) {
+                     return A.Weight > B.Weight;
+                   });
+
+  // Greedily merge clusters along the heaviest edges.
+  std::vector<std::vector<StringRef>> Clusters;
+  DenseMap<CachedHashStringRef, unsigned> ClusterOf;
+  auto IdFor = [&](StringRef S) {
+    auto It = ClusterOf.insert(
+        {CachedHashStringRef(S), (unsigned)Clusters.size()});
+    if (It.second)
+      Clusters.push_back({S});
+    return It.first->second;
+  };
+  for (const Edge &E : Edges) {
+    unsigned From = IdFor(E.From);
+    unsigned To = IdFor(E.To);
+    if (From == To)
+      continue;
+    for (StringRef S : Clusters[To]) {
+      Clusters[From].push_back(S);
+      ClusterOf[CachedHashStringRef(S)] = From;
+    }
+    Clusters[To].clear();
+  }
+
+  unsigned I = Config->SymbolOrderingFile.size();
+  for (std::vector<StringRef> &C : Clusters)
+    for (StringRef S : C)
+      Config->SymbolOrderingFile.insert({CachedHashStringRef(S), I++});
+}
+
 // Initializes Config members by the command line options.
 void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   for (auto *Arg : Args.filtered(OPT_L))
@@ -535,9 +689,15 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   Config->EnableNewDtags = !Args.hasArg(OPT_disable_new_dtags);
   Config->ExportDynamic = Args.hasArg(OPT_export_dynamic);
   Config->FatalWarnings = Args.hasArg(OPT_fatal_warnings);
+  Config->FixCortexA53Errata843419 = Args.hasArg(OPT_fix_cortex_a53_843419);
   Config->GcSections = getArg(Args, OPT_gc_sections, OPT_no_gc_sections, false);
   Config->GdbIndex = Args.hasArg(OPT_gdb_index);
-  Config->ICF = Args.hasArg(OPT_icf);
+  Config->ICF = Args.hasArg(OPT_icf) || Args.hasArg(OPT_icf_data);
+  Config->ICFData = Args.hasArg(OPT_icf_data);
+  Config->Incremental = Args.hasArg(OPT_incremental);
+  Config->LinkProfile = Args.hasArg(OPT_link_profile);
+  Config->MmapOutputFile =
+      getArg(Args, OPT_mmap_output_file, OPT_no_mmap_output_file, true);
   Config->NoGnuUnique = Args.hasArg(OPT_no_gnu_unique);
   Config->NoUndefinedVersion = Args.hasArg(OPT_no_undefined_version);
   Config->Nostdlib = Args.hasArg(OPT_nostdlib);
@@ -547,14 +707,55 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   Config->Relocatable = Args.hasArg(OPT_relocatable);
   Config->Discard = getDiscardOption(Args);
   Config->SaveTemps = Args.hasArg(OPT_save_temps);
+  if (auto *Arg = Args.getLastArg(OPT_separate_debug_file,
+                                  OPT_separate_debug_file_eq)) {
+    Config->SeparateDebugFile = true;
+    if (Arg->getOption().getID() == OPT_separate_debug_file_eq)
+      Config->SeparateDebugFilename = Arg->getValue();
+  }
   Config->SingleRoRx = Args.hasArg(OPT_no_rosegment);
   Config->Shared = Args.hasArg(OPT_shared);
+  Config->Stats = Args.hasArg(OPT_stats);
+  Config->StreamOutput = Args.hasArg(OPT_stream_output);
+  // Streaming composes the image in anonymous memory and pipes it out,
+  // so the mmap output engine does not apply.
+  if (Config->StreamOutput)
+    Config->MmapOutputFile = false;
   Config->Target1Rel = getArg(Args, OPT_target1_rel, OPT_target1_abs, false);
   Config->Threads = getArg(Args, OPT_threads, OPT_no_threads, true);
+  if (auto *Arg = Args.getLastArg(OPT_threads_eq)) {
+    // --threads=N[:policy]. The count and policy must be set before the
+    // first parallel call starts the process-wide pool.
+    StringRef S = Arg->getValue();
+    StringRef CountStr, Policy;
+    std::tie(CountStr, Policy) = S.split(':');
+    unsigned Count;
+    if (CountStr.getAsInteger(10, Count) || Count == 0)
+      error("--threads: number expected, but got " + CountStr);
+    else {
+      Config->Threads = Count > 1;
+      poolThreadCount() = Count;
+    }
+    if (Policy == "pin")
+      poolPinThreads() = true;
+    else if (!Policy.empty() && Policy != "none")
+      error("--threads: unknown policy: " + Policy);
+  }
+  if (auto *Arg = Args.getLastArg(OPT_time_trace, OPT_time_trace_eq)) {
+    timeTraceEnabled() = true;
+    if (Arg->getOption().getID() == OPT_time_trace_eq)
+      Config->TimeTraceFile = Arg->getValue();
+  }
   Config->Trace = Args.hasArg(OPT_trace);
   Config->Verbose = Args.hasArg(OPT_verbose);
   Config->WarnCommon = Args.hasArg(OPT_warn_common);
 
+  Config->MapFile = getString(Args, OPT_Map);
+  if (Args.hasArg(OPT_print_map))
+    Config->MapFile = "-";
+  Config->LayoutOnly = getString(Args, OPT_layout_only);
+  Config->SectionDigestsFile = getString(Args, OPT_section_digests);
+
   Config->DynamicLinker = getString(Args, OPT_dynamic_linker);
   Config->Entry = getString(Args, OPT_entry);
   Config->Fini = getString(Args, OPT_fini, "_fini");
@@ -572,9 +773,22 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   Config->LTOPartitions = getInteger(Args, OPT_lto_partitions, 1);
   if (Config->LTOPartitions == 0)
     error("--lto-partitions: number of threads must be > 0");
+  Config->ThinLTOCacheDir = getString(Args, OPT_thinlto_cache_dir);
   Config->ThinLTOJobs = getInteger(Args, OPT_thinlto_jobs, -1u);
   if (Config->ThinLTOJobs == 0)
     error("--thinlto-jobs: number of threads must be > 0");
+  Config->ThinLTOIndexOnly = Args.hasArg(OPT_thinlto_index_only) ||
+                             Args.hasArg(OPT_thinlto_index_only_eq);
+  Config->ThinLTOIndexOnlyObjectsFile =
+      getString(Args, OPT_thinlto_index_only_eq);
+  Config->ThinLTOEmitImportsFiles = Args.hasArg(OPT_thinlto_emit_imports_files);
+  if (auto *Arg = Args.getLastArg(OPT_thinlto_prefix_replace)) {
+    StringRef S = Arg->getValue();
+    if (S.find(';') == StringRef::npos)
+      error("--thinlto-prefix-replace: expects 'old;new' format");
+    std::tie(Config->ThinLTOPrefixReplaceOld, Config->ThinLTOPrefixReplaceNew) =
+        S.split(';');
+  }
 
   Config->ZCombreloc = !hasZOption(Args, "nocombreloc");
   Config->ZExecstack = hasZOption(Args, "execstack");
@@ -615,6 +829,29 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
       error("unknown hash style: " + S);
   }
 
+  // Parse --pack-dyn-relocs=<format>.
+  if (auto *Arg = Args.getLastArg(OPT_pack_dyn_relocs)) {
+    StringRef S = Arg->getValue();
+    if (S == "android")
+      Config->AndroidPackDynRelocs = true;
+    else if (S == "relr")
+      Config->RelrPackDynRelocs = true;
+    else if (S != "none")
+      error("unknown --pack-dyn-relocs format: " + S);
+  }
+
+  if (auto *Arg = Args.getLastArg(OPT_compress_debug_sections)) {
+    StringRef S = Arg->getValue();
+    if (S == "zlib") {
+      if (!zlib::isAvailable())
+        error("--compress-debug-sections: zlib is not available");
+      else
+        Config->CompressDebugSections = true;
+    } else if (S != "none") {
+      error("unknown --compress-debug-sections value: " + S);
+    }
+  }
+
   // Parse --build-id or --build-id=<style>.
   if (Args.hasArg(OPT_build_id))
     Config->BuildId = BuildIdKind::Fast;
@@ -652,6 +889,10 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
     if (Optional<MemoryBufferRef> Buffer = readFile(Arg->getValue()))
       parseSymbolOrderingList(*Buffer);
 
+  if (auto *Arg = Args.getLastArg(OPT_call_graph_ordering_file))
+    if (Optional<MemoryBufferRef> Buffer = readFile(Arg->getValue()))
+      parseCallGraphOrderingList(*Buffer);
+
   for (auto *Arg : Args.filtered(OPT_export_dynamic_symbol))
     Config->VersionScriptGlobals.push_back(
         {Arg->getValue(), /*IsExternCpp*/ false, /*HasWildcard*/ false});
@@ -828,10 +1069,84 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
   for (auto *Arg : Args.filtered(OPT_trace_symbol))
     Symtab.trace(Arg->getValue());
 
+  // Load the archive member history before the pre-parse stage below
+  // consults it from worker threads.
+  loadArchiveMemberCache();
+
+  // Pre-parse the ELF headers, section tables and symbol tables of all
+  // object files, the symbol indices of all archives, and the symbol
+  // tables of all bitcode files, in parallel.
+  // This part of the parse depends only on the file itself and
+  // dominates profiles of large links, while the order-dependent work
+  // -- symbol resolution and comdat group selection -- is still done
+  // serially by addFile below.
+  ScopedTimer ParseTimer("parse");
+  forEach(Files.begin(), Files.end(), [](InputFile *F) {
+    if (auto *A = dyn_cast<ArchiveFile>(F)) {
+      A->preParse();
+      return;
+    }
+    if (auto *L = dyn_cast<LazyObjectFile>(F)) {
+      L->preParse();
+      return;
+    }
+    if (auto *B = dyn_cast<BitcodeFile>(F)) {
+      B->preParse();
+      return;
+    }
+    if (F->EKind == Config->EKind && F->EMachine == Config->EMachine) {
+      if (auto *Obj = dyn_cast<elf::ObjectFile<ELFT>>(F)) {
+        Obj->preParse();
+        return;
+      }
+      if (auto *S = dyn_cast<SharedFile<ELFT>>(F))
+        S->preParse();
+    }
+  });
+
+  // The pre-parse has read every symbol table header, so the global
+  // symbol counts are known before any name is resolved; reserve the
+  // symbol table's big maps from them instead of growing the tables by
+  // rehash-and-copy. The "symtab-reserve" stat against the final
+  // "symbols" stat shows how far the estimate overshoots.
+  size_t EstimatedGlobals = 0;
+  for (InputFile *F : Files)
+    if (F->EKind == Config->EKind && F->EMachine == Config->EMachine) {
+      if (auto *Obj = dyn_cast<elf::ObjectFile<ELFT>>(F))
+        EstimatedGlobals += Obj->getGlobalSymbols().size();
+      else if (auto *S = dyn_cast<SharedFile<ELFT>>(F))
+        EstimatedGlobals += S->getGlobalSymbols().size();
+    }
+  Symtab.reserve(EstimatedGlobals);
+  addStat("symtab-reserve", EstimatedGlobals);
+
+  // Speculatively materialize the archive members the previous link
+  // extracted (--incremental keeps a history of them). The files are
+  // created serially -- creation allocates from the arena -- and then
+  // pre-parsed with the same parallel stage the command-line inputs
+  // just went through, so warm-history links start resolution with
+  // most member objects already parsed instead of discovering them
+  // one lazy fetch at a time. A mispredicted member just sits unused.
+  std::vector<InputFile *> Speculative;
+  for (InputFile *F : Files)
+    if (auto *A = dyn_cast<ArchiveFile>(F))
+      A->createSpeculativeMembers(Speculative);
+  forEach(Speculative.begin(), Speculative.end(), [](InputFile *F) {
+    if (auto *B = dyn_cast<BitcodeFile>(F)) {
+      B->preParse();
+      return;
+    }
+    if (F->EKind == Config->EKind && F->EMachine == Config->EMachine)
+      if (auto *Obj = dyn_cast<elf::ObjectFile<ELFT>>(F))
+        Obj->preParse();
+  });
+  addStat("speculated-members", Speculative.size());
+
   // Add all files to the symbol table. This will add almost all
   // symbols that we need to the symbol table.
   for (InputFile *F : Files)
     Symtab.addFile(F);
+  ParseTimer.stop();
 
   // If an entry symbol is in a static archive, pull out that file now
   // to complete the symbol table. After this, no new names except a
@@ -847,10 +1162,20 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
   Symtab.scanShlibUndefined();
   Symtab.scanVersionScript();
 
-  Symtab.addCombinedLTOObject();
+  {
+    ScopedTimer T("lto");
+    Symtab.addCombinedLTOObject();
+  }
   if (ErrorCount)
     return;
 
+  // With --thinlto-index-only the link stops after the thin-link. The
+  // backend compiles run on other machines against the emitted index
+  // files, and a regular link of the returned native objects produces
+  // the final output.
+  if (Config->ThinLTOIndexOnly)
+    return;
+
   for (auto *Arg : Args.filtered(OPT_wrap))
     Symtab.wrap(Arg->getValue());
 
@@ -864,25 +1189,59 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
   for (BinaryFile *F : Symtab.getBinaryFiles())
     for (InputSectionData *S : F->getSections())
       Symtab.Sections.push_back(cast<InputSection<ELFT>>(S));
+  addStat("input-files", Files.size());
+  addStat("input-sections", Symtab.Sections.size());
+  addStat("symbols", Symtab.getSymbols().size());
+
+  // Resolve every relocation's target symbol once, in parallel.
+  // Garbage collection, ICF, the thunk scan and the relocation scan
+  // all consume the shared index instead of re-deriving the targets.
+  {
+    ScopedTimer T("reloc-index");
+    buildRelocTargetIndex<ELFT>();
+  }
 
   // Do size optimizations: garbage collection and identical code folding.
-  if (Config->GcSections)
+  if (Config->GcSections) {
+    ScopedTimer T("gc-sections");
     markLive<ELFT>();
-  if (Config->ICF)
+  }
+  if (Config->ICF) {
+    ScopedTimer T("icf");
     doIcf<ELFT>();
+  }
 
   // MergeInputSection::splitIntoPieces needs to be called before
   // any call of MergeInputSection::getOffset. Do that.
+  ScopedTimer SplitTimer("split-sections");
   forEach(Symtab.Sections.begin(), Symtab.Sections.end(),
           [](InputSectionBase<ELFT> *S) {
             if (!S->Live)
               return;
-            if (S->Compressed)
-              S->uncompress();
+            if (S->Compressed) {
+              // A progbits section that is simply copied to the output
+              // can be inflated straight into the output file mapping
+              // at write time, so only record its decompressed size
+              // now. Everything whose contents are consumed before the
+              // copy -- mergeable strings, sections the .gdb_index
+              // writer parses, and REL targets whose implicit addends
+              // are read during the relocation scan -- is decompressed
+              // here.
+              if (S->kind() == InputSectionData::Regular &&
+                  S->Type == SHT_PROGBITS && !Config->GdbIndex &&
+                  (Config->Rela || !S->NumRelocations))
+                S->deferUncompress();
+              else
+                S->uncompress();
+            }
             if (auto *MS = dyn_cast<MergeInputSection<ELFT>>(S))
               MS->splitIntoPieces();
           });
+  SplitTimer.stop();
 
   // Write the result to the file.
   writeResult<ELFT>();
+  writeTimeTraceFile();
+  printTimingStats();
+  writeLinkProfile();
 }
@@ -37,6 +37,7 @@ protected:
   llvm::Optional<MemoryBufferRef> readFileCopyBuf(StringRef Path);
   void readConfigs(llvm::opt::InputArgList &Args);
   void createFiles(llvm::opt::InputArgList &Args);
+  void prefetchInputs();
   void inferMachineType();
   template <class ELFT> void link(llvm::opt::InputArgList &Args);
 
@@ -75,6 +76,7 @@ std::string createResponseFile(const llvm::opt::InputArgList &Args);
 
 llvm::Optional<std::string> findFromSearchPaths(StringRef Path);
 llvm::Optional<std::string> searchLibrary(StringRef Path);
+void resetDirectoryListings();
 
 } // namespace elf
 } // namespace lld
@@ -17,14 +17,18 @@
 #include "Error.h"
 #include "ScriptParser.h"
 #include "lld/Config/Version.h"
+#include "lld/Core/Parallel.h"
 #include "lld/Core/Reproduce.h"
 #include "lld/Support/Memory.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Option/Option.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 
 using namespace llvm;
@@ -65,6 +69,117 @@ static cl::TokenizerCallback getQuotingStyle(opt::InputArgList &Args) {
   return cl::TokenizeGNUCommandLine;
 }
 
+// Response file separators. NUL counts so that the terminator written
+// over the previous separator can never start a new token.
+static bool isSep(char C) {
+  return C == ' ' || C == '\t' || C == '\n' || C == '\r' || C == '\0';
+}
+
+// Splits [Begin, End) into NUL-terminated tokens in place. The byte at
+// End must already be a separator (or the buffer's own terminator).
+static void tokenize(char *Begin, char *End,
+                     std::vector<const char *> &Tokens) {
+  char *P = Begin;
+  while (P != End) {
+    while (P != End && isSep(*P))
+      ++P;
+    if (P == End)
+      break;
+    Tokens.push_back(P);
+    while (P != End && !isSep(*P))
+      ++P;
+    if (P != End)
+      *P++ = '\0';
+  }
+}
+
+// Tokenizes one plain response file. Build systems hand us response
+// files with hundreds of thousands of lines, so large buffers are
+// chopped at whitespace and the chunks are tokenized in parallel; the
+// chunk boundary separators are overwritten serially before the
+// workers start, so no worker writes outside its own chunk.
+static void tokenizeFile(char *Buf, size_t Size,
+                         std::vector<const char *> &Tokens) {
+  const size_t ParallelThreshold = 1024 * 1024;
+  char *End = Buf + Size;
+  if (Size < ParallelThreshold) {
+    tokenize(Buf, End, Tokens);
+    return;
+  }
+
+  size_t NumChunks = poolConcurrency() * 2;
+  std::vector<char *> Bounds;
+  Bounds.push_back(Buf);
+  for (size_t I = 1; I < NumChunks; ++I) {
+    char *P = std::max(Buf + Size * I / NumChunks, Bounds.back());
+    while (P != End && !isSep(*P))
+      ++P;
+    if (P == End)
+      break;
+    *P = '\0';
+    if (P + 1 != Bounds.back())
+      Bounds.push_back(P + 1);
+  }
+  Bounds.push_back(End);
+
+  std::vector<std::vector<const char *>> Shards(Bounds.size() - 1);
+  parallel_for((size_t)0, Shards.size(), [&](size_t I) {
+    tokenize(Bounds[I], Bounds[I + 1], Shards[I]);
+  });
+  for (std::vector<const char *> &Shard : Shards)
+    Tokens.insert(Tokens.end(), Shard.begin(), Shard.end());
+}
+
+// Appends Arg to Out, expanding it first if it names a response file.
+// The file is loaded once into the arena and tokenized in place, so
+// every argument is a NUL-terminated slice of that single buffer
+// instead of a per-token heap copy. Returns false if the file needs
+// the generic quoting-aware tokenizer.
+static bool expandArg(const char *Arg, std::vector<const char *> &Out) {
+  if (Arg[0] != '@') {
+    Out.push_back(Arg);
+    return true;
+  }
+
+  // An unreadable response file is kept as-is, matching
+  // cl::ExpandResponseFiles; the option parser reports it later.
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getFile(Arg + 1);
+  if (!MBOrErr) {
+    Out.push_back(Arg);
+    return true;
+  }
+  StringRef Data = (*MBOrErr)->getBuffer();
+
+  // Quotes, escapes or a BOM demand the full tokenizer.
+  if (Data.find_first_of("\"'\\") != StringRef::npos ||
+      Data.startswith("\xef\xbb\xbf"))
+    return false;
+
+  char *Buf = BAlloc.Allocate<char>(Data.size() + 1);
+  memcpy(Buf, Data.data(), Data.size());
+  Buf[Data.size()] = '\0';
+
+  std::vector<const char *> Tokens;
+  tokenizeFile(Buf, Data.size(), Tokens);
+  for (const char *Tok : Tokens)
+    if (!expandArg(Tok, Out))
+      return false;
+  return true;
+}
+
+// Fast path for expanding GNU-style response files that use no quoting
+// (the common case for generated files). Returns false without
+// modifying Vec if some file needs the generic expander.
+static bool expandPlainResponseFiles(SmallVectorImpl<const char *> &Vec) {
+  std::vector<const char *> Out;
+  for (const char *Arg : Vec)
+    if (!expandArg(Arg, Out))
+      return false;
+  Vec.assign(Out.begin(), Out.end());
+  return true;
+}
+
 // Parses a given list of options.
 opt::InputArgList ELFOptTable::parse(ArrayRef<const char *> Argv) {
   // Make InputArgList from string vectors.
@@ -78,7 +193,10 @@ opt::InputArgList ELFOptTable::parse(ArrayRef<const char *> Argv) {
   opt::InputArgList Args = this->ParseArgs(Vec, MissingIndex, MissingCount);
 
   // Expand response files. '@<filename>' is replaced by the file's contents.
-  cl::ExpandResponseFiles(Saver, getQuotingStyle(Args), Vec);
+  cl::TokenizerCallback Tokenizer = getQuotingStyle(Args);
+  if (Tokenizer != cl::TokenizeGNUCommandLine ||
+      !expandPlainResponseFiles(Vec))
+    cl::ExpandResponseFiles(Saver, Tokenizer, Vec);
 
   // Parse options and then do error checking.
   Args = this->ParseArgs(Vec, MissingIndex, MissingCount);
@@ -125,14 +243,62 @@ std::string elf::createResponseFile(const opt::InputArgList &Args) {
   return Data.str();
 }
 
+// Returns true if a file named File may exist in directory Dir,
+// answering from a directory listing that is read once and kept in
+// memory. A -l flag probes every search directory (twice when both
+// .so and .a are tried) until it hits, so resolving hundreds of
+// libraries against tens of directories costs O(dirs * libs) stat
+// calls, which is brutal on network filesystems; one readdir per
+// directory answers all the misses from memory instead. If a
+// directory cannot be listed, every probe reports "maybe" so the
+// caller falls back to stat and error semantics do not change.
+//
+// The listings live for one link, not for the process: a library
+// produced by an earlier link in the same process (e.g. with -batch)
+// must be visible to a later link's probes, so ScopedLinkContext
+// clears them with the other per-link globals.
+static StringMap<Optional<StringSet<>>> Listings;
+
+void elf::resetDirectoryListings() { Listings.clear(); }
+
+static bool mayExistInDir(StringRef Dir, StringRef File) {
+  auto It = Listings.find(Dir);
+  if (It == Listings.end()) {
+    std::error_code EC;
+    Optional<StringSet<>> Set = StringSet<>();
+    for (fs::directory_iterator I(Dir, EC), E; I != E && !EC; I.increment(EC))
+      Set->insert(path::filename(I->path()));
+    if (EC)
+      Set = None;
+    It = Listings.insert(std::make_pair(Dir, std::move(Set))).first;
+  }
+  if (!It->second)
+    return true;
+  return It->second->count(File);
+}
+
 // Find a file by concatenating given paths. If a resulting path
 // starts with "=", the character is replaced with a --sysroot value.
 static Optional<std::string> findFile(StringRef Path1, const Twine &Path2) {
-  SmallString<128> S;
+  SmallString<128> Dir;
   if (Path1.startswith("="))
-    path::append(S, Config->Sysroot, Path1.substr(1), Path2);
+    path::append(Dir, Config->Sysroot, Path1.substr(1));
   else
-    path::append(S, Path1, Path2);
+    path::append(Dir, Path1);
+
+  SmallString<128> File;
+  Path2.toVector(File);
+  SmallString<128> S = Dir;
+  path::append(S, File);
+
+  // Plain filenames -- every -l probe -- are answered from the cached
+  // directory listing. Paths that descend into subdirectories (e.g.
+  // INPUT() with a relative path) go to the filesystem directly, and
+  // a listing hit is still confirmed with a stat because readdir also
+  // reports dangling symlinks.
+  if (StringRef(File).find_first_of("/\\") == StringRef::npos &&
+      !mayExistInDir(Dir, File))
+    return None;
 
   if (fs::exists(S))
     return S.str().str();
@@ -14,7 +14,11 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/raw_ostream.h"
+
 #include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
 #include <unistd.h>
@@ -25,7 +29,8 @@ using namespace llvm;
 
 namespace lld {
 
-uint64_t elf::ErrorCount;
+std::atomic<uint64_t> elf::ErrorCount;
+std::atomic<bool> elf::LinkCancelled;
 raw_ostream *elf::ErrorOS;
 StringRef elf::Argv0;
 
@@ -33,6 +38,31 @@ StringRef elf::Argv0;
 // but outs() or errs() are not thread-safe. We protect them using a mutex.
 static std::mutex Mu;
 
+// Inside a ScopedDiagnosticBuffer region, diagnostics go to per-thread
+// buffers and are written out when the region ends, so parallel
+// workers don't contend on Mu per message. A thread's buffer is
+// created on its first buffered diagnostic and registered under Mu
+// (once per thread, like the make<T> arenas); the buffer itself leaks
+// intentionally because pool threads outlive the passes.
+namespace {
+struct DiagBuffer {
+  std::vector<std::pair<bool, std::string>> Msgs; // (IsError, Text)
+};
+}
+
+static std::vector<DiagBuffer *> DiagBuffers;
+static int BufferingDepth = 0;
+static LLVM_THREAD_LOCAL DiagBuffer *LocalDiags = nullptr;
+
+static DiagBuffer *getLocalDiags() {
+  if (!LocalDiags) {
+    LocalDiags = new DiagBuffer;
+    std::lock_guard<std::mutex> Lock(Mu);
+    DiagBuffers.push_back(LocalDiags);
+  }
+  return LocalDiags;
+}
+
 static void print(StringRef S, raw_ostream::Colors C) {
   *ErrorOS << Argv0 + ": ";
   if (Config->ColorDiagnostics) {
@@ -55,26 +85,75 @@ void elf::warn(const Twine &Msg) {
     error(Msg);
     return;
   }
+  if (BufferingDepth) {
+    getLocalDiags()->Msgs.push_back({false, Msg.str()});
+    return;
+  }
   std::lock_guard<std::mutex> Lock(Mu);
   print("warning: ", raw_ostream::MAGENTA);
   *ErrorOS << Msg << "\n";
 }
 
 void elf::error(const Twine &Msg) {
-  std::lock_guard<std::mutex> Lock(Mu);
+  // Claim a slot below the error limit with one atomic increment; past
+  // the cap the message is dropped without formatting or locking, so a
+  // failing parallel pass aborts cheaply.
+  uint64_t N = ++ErrorCount;
+
+  // Crossing the error budget flags outstanding parallel work to wind
+  // down (see Threads.h); the note emitted below tells the user why
+  // the diagnostics stop short.
+  bool BudgetHit = Config->ErrorBudget != 0 && N == Config->ErrorBudget;
+  if (BudgetHit)
+    LinkCancelled = true;
+
+  if (Config->ErrorLimit != 0 && N > Config->ErrorLimit) {
+    if (N == Config->ErrorLimit + 1) {
+      std::lock_guard<std::mutex> Lock(Mu);
+      print("error: ", raw_ostream::RED);
+      *ErrorOS << "too many errors emitted, stopping now"
+               << " (use -error-limit=0 to see all errors)\n";
+      if (Config->ExitEarly)
+        exitLld(1);
+    }
+    return;
+  }
 
-  if (Config->ErrorLimit == 0 || ErrorCount < Config->ErrorLimit) {
-    print("error: ", raw_ostream::RED);
-    *ErrorOS << Msg << "\n";
-  } else if (ErrorCount == Config->ErrorLimit) {
+  static const char *BudgetMsg =
+      "error budget exhausted, cancelling remaining work";
+  if (BufferingDepth) {
+    DiagBuffer *B = getLocalDiags();
+    B->Msgs.push_back({true, Msg.str()});
+    if (BudgetHit)
+      B->Msgs.push_back({true, BudgetMsg});
+    return;
+  }
+  std::lock_guard<std::mutex> Lock(Mu);
+  print("error: ", raw_ostream::RED);
+  *ErrorOS << Msg << "\n";
+  if (BudgetHit) {
     print("error: ", raw_ostream::RED);
-    *ErrorOS << "too many errors emitted, stopping now"
-             << " (use -error-limit=0 to see all errors)\n";
-    if (Config->ExitEarly)
-      exitLld(1);
+    *ErrorOS << BudgetMsg << "\n";
   }
+}
 
-  ++ErrorCount;
+ScopedDiagnosticBuffer::ScopedDiagnosticBuffer() {
+  std::lock_guard<std::mutex> Lock(Mu);
+  ++BufferingDepth;
+}
+
+ScopedDiagnosticBuffer::~ScopedDiagnosticBuffer() {
+  std::lock_guard<std::mutex> Lock(Mu);
+  if (--BufferingDepth)
+    return;
+  for (DiagBuffer *B : DiagBuffers) {
+    for (std::pair<bool, std::string> &P : B->Msgs) {
+      print(P.first ? "error: " : "warning: ",
+            P.first ? raw_ostream::RED : raw_ostream::MAGENTA);
+      *ErrorOS << P.second << "\n";
+    }
+    B->Msgs.clear();
+  }
 }
 
 void elf::error(std::error_code EC, const Twine &Prefix) {
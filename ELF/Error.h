@@ -28,16 +28,40 @@
 
 #include "llvm/Support/Error.h"
 
+#include <atomic>
+
 namespace lld {
 namespace elf {
 
-extern uint64_t ErrorCount;
+extern std::atomic<uint64_t> ErrorCount;
+extern std::atomic<bool> LinkCancelled;
 extern llvm::raw_ostream *ErrorOS;
 extern llvm::StringRef Argv0;
 
+// True once --error-budget errors have been reported. The parallel
+// loops in Threads.h turn their remaining tasks into no-ops when this
+// is set, so a doomed link winds down quickly instead of completing
+// most of the work before exiting.
+inline bool linkCancelled() {
+  return LinkCancelled.load(std::memory_order_relaxed);
+}
+
 void log(const Twine &Msg);
 void warn(const Twine &Msg);
 
+// While an instance of this class is live, error() and warn() append
+// to per-thread buffers instead of locking and writing to the output
+// stream, so workers in a parallel pass don't serialize on the
+// diagnostics mutex when something goes wrong at scale (e.g. thousands
+// of relocation overflows). The buffers are flushed on destruction,
+// grouped by worker; messages from one worker stay in order. Errors
+// past --error-limit are dropped before formatting either way.
+class ScopedDiagnosticBuffer {
+public:
+  ScopedDiagnosticBuffer();
+  ~ScopedDiagnosticBuffer();
+};
+
 void error(const Twine &Msg);
 void error(std::error_code EC, const Twine &Prefix);
 
@@ -11,10 +11,13 @@
 #include "Config.h"
 #include "Error.h"
 #include "ICF.h"
+#include "IncrementalCache.h"
 #include "InputFiles.h"
+#include "LinkContext.h"
 #include "InputSection.h"
 #include "LinkerScript.h"
 #include "OutputSections.h"
+#include "Relocations.h"
 #include "Strings.h"
 #include "SymbolTable.h"
 #include "Target.h"
@@ -23,11 +26,16 @@
 #include "lld/Config/Version.h"
 #include "lld/Driver/Driver.h"
 #include "lld/Support/Memory.h"
+#include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/MC/MCDisassembler/MCDisassembler.h"
 #include "llvm/MC/MCInst.h"
@@ -40,6 +48,14 @@
 #include <utility>
 #include <unordered_map>
 
+#if LLVM_ON_UNIX
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 using namespace llvm;
 using namespace llvm::ELF;
 using namespace llvm::object;
@@ -54,6 +70,14 @@ namespace hanafuda {
 
 class LinkerDriver;
 
+/// A changed region of the output image, in both file-offset and
+/// load-address terms, for --hanafuda-live-patch.
+struct LiveRange {
+  uint32_t Addr;
+  uint32_t Offset;
+  uint32_t Length;
+};
+
 /// Maintains structural information about loaded base file
 /// and template for outputting a new file.
 ///
@@ -145,18 +169,23 @@ private:
     uint32_t Offset;
     uint32_t Type;
 
+    static uint32_t classifyHigh(uint32_t Type, uint32_t Val) {
+      if (Type == R_PPC_ADDR16_HA || Type == R_PPC_ADDR16_HI)
+        return ((Val & 0xffff) >= 0x8000) ? R_PPC_ADDR16_HA : R_PPC_ADDR16_HI;
+      return Type;
+    }
+
     void patch(MemoryBufferRef MB, uint32_t Val) const {
+      patchAs(MB, classifyHigh(Type, Val), Val);
+    }
+
+    void patchAs(MemoryBufferRef MB, uint32_t ActualType, uint32_t Val) const {
       const uint32_t BufSz = MB.getBuffer().size();
       if (Offset >= BufSz) {
         BufOverflowErr(Offset, BufSz);
         return;
       }
       const uint8_t *Ptr = MB.getBuffer().bytes_begin() + Offset;
-      uint32_t ActualType;
-      if (Type == R_PPC_ADDR16_HA || Type == R_PPC_ADDR16_HI)
-        ActualType = ((Val & 0xffff) >= 0x8000) ? R_PPC_ADDR16_HA : R_PPC_ADDR16_HI;
-      else
-        ActualType = Type;
 
       uint32_t OldVal;
       if (Config->Verbose) {
@@ -188,8 +217,10 @@ private:
     Relocation Hi, Lo;
 
     void patch(MemoryBufferRef MB, uint32_t Val) const {
-      Hi.patch(MB, Val);
-      Lo.patch(MB, Val);
+      // Both halves derive from the same value, so the HA/HI carry
+      // classification is made once per pair rather than per site.
+      Hi.patchAs(MB, Relocation::classifyHigh(Hi.Type, Val), Val);
+      Lo.patchAs(MB, Lo.Type, Val);
     }
   };
 
@@ -201,9 +232,11 @@ private:
   std::unordered_multimap<uint32_t, Relocation>
       OrigCallAddrToInstFileOffs;
   void scanForRelocations(LinkerDriver &Drv);
+  bool loadScanCache(StringRef Path);
+  void saveScanCache(StringRef Path) const;
 
 public:
-  DOLFile(MemoryBufferRef M, LinkerDriver &Drv) : MB(M) {
+  DOLFile(MemoryBufferRef M, LinkerDriver &Drv, StringRef Path) : MB(M) {
     Header head = *reinterpret_cast<const Header*>(M.getBufferStart());
     head.swapBig();
 
@@ -234,9 +267,17 @@ public:
     BssSize = head.BssSize;
     EntryPoint = head.EntryPoint;
 
-    scanForRelocations(Drv);
+    // The base DOL never changes between patch iterations, so the
+    // branch sites and relocation candidates found by the disassembly
+    // scan are memoized in a sidecar next to it.
+    if (!loadScanCache(Path)) {
+      scanForRelocations(Drv);
+      saveScanCache(Path);
+    }
   }
 
+  MemoryBufferRef getBuffer() const { return MB; }
+
   int getTextSectionCount() const {
     for (int i = 0; i < 7; ++i)
       if (!Texts[i].Offset)
@@ -418,22 +459,48 @@ public:
 
   void patchTargetAddressRelocations(uint32_t oldAddr, uint32_t newAddr);
 
+  /// Translates a span of the output file to the load-address ranges
+  /// it occupies, clipping to section extents. Bytes outside every
+  /// section (the header) map to nothing. Only meaningful once the
+  /// pre-write callback has entered the appended patch sections into
+  /// the section tables.
+  void mapFileSpanToAddrs(uint32_t Offset, uint32_t Length,
+                          std::vector<LiveRange> &Out) const {
+    auto Clip = [&](const Section &Sec) {
+      if (!Sec.Offset)
+        return;
+      uint32_t Begin = std::max(Offset, Sec.Offset);
+      uint32_t End = std::min(Offset + Length, Sec.Offset + Sec.Length);
+      if (Begin >= End)
+        return;
+      Out.push_back({Sec.Addr + (Begin - Sec.Offset), Begin, End - Begin});
+    };
+    for (int i = 0; i < 7; ++i)
+      Clip(Texts[i]);
+    for (int i = 0; i < 11; ++i)
+      Clip(Datas[i]);
+  }
+
   void patchForGrowDelta(uint32_t Delta) {
     StackBase += Delta;
     StackEnd += Delta;
     ArenaLo += Delta;
     if (Config->Verbose)
-      outs() << "Patching _stack_base_\n";
+      outs() << "Patching _stack_base_, _stack_end_ and __ArenaLo\n";
+
+    // Flatten the three pair lists into one batch and patch it in
+    // parallel; every pair owns its own two instruction words.
+    std::vector<std::pair<const RelocationPair *, uint32_t>> Batch;
     for (const RelocationPair &Rel : StackBaseRels)
-      Rel.patch(MB, StackBase);
-    if (Config->Verbose)
-      outs() << "Patching _stack_end_\n";
+      Batch.emplace_back(&Rel, StackBase);
     for (const RelocationPair &Rel : StackEndRels)
-      Rel.patch(MB, StackEnd);
-    if (Config->Verbose)
-      outs() << "Patching __ArenaLo\n";
+      Batch.emplace_back(&Rel, StackEnd);
     for (const RelocationPair &Rel : ArenaLoRels)
-      Rel.patch(MB, ArenaLo);
+      Batch.emplace_back(&Rel, ArenaLo);
+    forEach(Batch.begin(), Batch.end(),
+            [&](const std::pair<const RelocationPair *, uint32_t> &P) {
+              P.first->patch(MB, P.second);
+            });
   }
 
   void writeTo(uint8_t *BufData) const {
@@ -442,6 +509,11 @@ public:
     SwappedHead.BssSize = BssSize;
     SwappedHead.EntryPoint = EntryPoint;
 
+    // Fill in the header serially, but run the section copies in
+    // parallel; each one writes a disjoint range of the output file
+    // mapping, and together they move the whole base image.
+    std::vector<std::pair<uint32_t, StringRef>> Copies;
+
     for (int i = 0; i < 7; ++i) {
       const Section& sec = getTextSection(i);
       if (!sec.Offset)
@@ -449,7 +521,7 @@ public:
       SwappedHead.TextOffs[i] = sec.Offset;
       SwappedHead.TextLoads[i] = sec.Addr;
       SwappedHead.TextSizes[i] = sec.Length;
-      memmove(BufData + sec.Offset, _getTextSectionData(i).data(), sec.Length);
+      Copies.emplace_back(sec.Offset, _getTextSectionData(i));
     }
 
     for (int i = 0; i < 11; ++i) {
@@ -459,9 +531,14 @@ public:
       SwappedHead.DataOffs[i] = sec.Offset;
       SwappedHead.DataLoads[i] = sec.Addr;
       SwappedHead.DataSizes[i] = sec.Length;
-      memmove(BufData + sec.Offset, _getDataSectionData(i).data(), sec.Length);
+      Copies.emplace_back(sec.Offset, _getDataSectionData(i));
     }
 
+    forEach(Copies.begin(), Copies.end(),
+            [&](const std::pair<uint32_t, StringRef> &C) {
+              memcpy(BufData + C.first, C.second.data(), C.second.size());
+            });
+
     SwappedHead.swapBig();
     memmove(BufData, &SwappedHead, sizeof(SwappedHead));
   }
@@ -473,33 +550,83 @@ public:
 private:
   ListType List;
 public:
+  // Community symbol maps run to tens of thousands of lines, so the
+  // buffer is cut into per-task slices at line boundaries and the
+  // slices are parsed in parallel. Lines are located with memchr
+  // (vectorized in any decent libc) instead of per-line StringRef
+  // splitting, and names are captured in place as StringRefs into the
+  // mmapped buffer; nothing is copied. Appending the partial lists in
+  // slice order keeps the sequential entry order, which the duplicate
+  // detection downstream depends on.
   SymbolListFile(StringRef S) {
-    while (!S.empty()) {
-      // Split off each line in the file.
-      std::pair<StringRef, StringRef> lineAndRest = S.split('\n');
-      StringRef line = lineAndRest.first;
-      S = lineAndRest.second;
-      S = S.ltrim();
-
-      // Consume address and symbol name
-      uint32_t offset;
-      if (line.consumeInteger(0, offset))
-        continue;
-      line = line.ltrim().rtrim();
-      if (!line.empty())
-        List.emplace_back(offset, line);
+    const size_t NumSlices = 16;
+    const char *Begin = S.data();
+    const char *End = Begin + S.size();
+    const char *Cuts[NumSlices + 1];
+    Cuts[0] = Begin;
+    Cuts[NumSlices] = End;
+    for (size_t I = 1; I < NumSlices; ++I) {
+      const char *P = Begin + S.size() * I / NumSlices;
+      if (P < Cuts[I - 1])
+        P = Cuts[I - 1];
+      auto *NL = static_cast<const char *>(memchr(P, '\n', End - P));
+      Cuts[I] = NL ? NL + 1 : End;
     }
+
+    std::vector<ListType> Partial(NumSlices);
+    forLoop(0, NumSlices, [&](size_t I) {
+      const char *P = Cuts[I];
+      const char *SliceEnd = Cuts[I + 1];
+      ListType &Out = Partial[I];
+      while (P != SliceEnd) {
+        auto *NL = static_cast<const char *>(memchr(P, '\n', SliceEnd - P));
+        StringRef Line(P, (NL ? NL : SliceEnd) - P);
+        P = NL ? NL + 1 : SliceEnd;
+
+        // Consume address and symbol name
+        uint32_t Offset;
+        Line = Line.ltrim();
+        if (Line.consumeInteger(0, Offset))
+          continue;
+        Line = Line.ltrim().rtrim();
+        if (!Line.empty())
+          Out.emplace_back(Offset, Line);
+      }
+    });
+
+    size_t N = 0;
+    for (ListType &P : Partial)
+      N += P.size();
+    List.reserve(N);
+    for (ListType &P : Partial)
+      List.insert(List.end(), P.begin(), P.end());
   }
 
   ListType::const_iterator begin() const { return List.cbegin(); }
   ListType::const_iterator end() const { return List.cend(); }
 };
 
+/// A parsed and address-validated DOL symbol list entry.
+struct DolListSymbol {
+  uint32_t Addr;
+  HanafudaSecType Type;
+  uint8_t SecIdx;
+  StringRef Name;
+};
+
 class LinkerDriver : public elf::LinkerDriver {
   friend class HanafudaSymbolTable;
   friend class DOLFile;
   Optional<DOLFile> DolFile;
 
+  void loadDolSymbolList(StringRef Path, MemoryBufferRef MB,
+                         SymbolTable<ELF32BE> &Symtab);
+  bool loadDolSymbolListCache(StringRef Path, uint64_t ListHash,
+                              uint64_t DolHash,
+                              std::vector<DolListSymbol> &Syms);
+  void saveDolSymbolListCache(StringRef Path, uint64_t ListHash,
+                              uint64_t DolHash, ArrayRef<DolListSymbol> Syms);
+
   std::unique_ptr<MCSubtargetInfo> STI;
   std::unique_ptr<MCRegisterInfo> MRI;
   std::unique_ptr<MCAsmInfo> MAI;
@@ -815,6 +942,7 @@ void DOLFile::patchTargetAddressRelocations(uint32_t oldAddr, uint32_t newAddr)
 
 bool link(ArrayRef<const char *> Args, bool CanExitEarly,
           raw_ostream &Error) {
+  ScopedLinkContext Ctx;
   ErrorCount = false;
   ErrorOS = &Error;
   Argv0 = Args[0];
@@ -827,7 +955,8 @@ bool link(ArrayRef<const char *> Args, bool CanExitEarly,
   ScriptConfig = &SC;
 
   D.main(Args, CanExitEarly);
-  freeArena();
+  // Keep slab mappings cached for the next link in this process.
+  resetArenas();
   return !ErrorCount;
 }
 
@@ -986,7 +1115,7 @@ void LinkerDriver::main(ArrayRef<const char *> ArgsArr, bool CanExitEarly) {
   Optional<MemoryBufferRef> dolBuffer = readFileCopyBuf(dolArg);
   if (!dolBuffer.hasValue())
     return;
-  DolFile.emplace(dolBuffer.getValue(), *this);
+  DolFile.emplace(dolBuffer.getValue(), *this, dolArg);
 
   if (DolFile->getUnusedTextSectionIndex() == -1 ||
       DolFile->getUnusedDataSectionIndex() == -1) {
@@ -1026,12 +1155,464 @@ void LinkerDriver::main(ArrayRef<const char *> ArgsArr, bool CanExitEarly) {
   Config->SdaBase = DolFile->getSdataBase();
   Config->Sda2Base = DolFile->getSdata2Base();
 
+  // With --incremental, a patch-development iteration where neither the
+  // command line nor any input (patch objects, base DOL, symbol list)
+  // changed can skip the whole link: the cache proves the existing
+  // output is the file this run would produce. The DOL and symbol-list
+  // buffers are driver-owned, so they participate in the check like any
+  // other input.
+  std::vector<MemoryBufferRef> Inputs;
+  if (Config->Incremental) {
+    for (std::unique_ptr<MemoryBuffer> &MB : OwningMBs)
+      Inputs.push_back(MB->getMemBufferRef());
+    if (isLinkUpToDate(ArgsArr, Inputs)) {
+      if (Config->Verbose)
+        outs() << Config->OutputFile << " is up to date\n";
+      return;
+    }
+  }
+
   // Do actual link, merging base symbols with linked symbols
   link(Args);
+
+  if (Config->Incremental && !ErrorCount) {
+    Inputs.clear();
+    for (std::unique_ptr<MemoryBuffer> &MB : OwningMBs)
+      Inputs.push_back(MB->getMemBufferRef());
+    writeLinkCache(ArgsArr, Inputs);
+  }
 }
 
 // Do actual linking. Note that when this function is called,
 // all linker scripts have already been parsed.
+static const char DolListCacheMagic[4] = {'H', 'F', 'S', 'C'};
+static const uint32_t DolListCacheVersion = 1;
+
+static void writeU16(raw_ostream &OS, uint16_t V) {
+  char Buf[2];
+  write16le(Buf, V);
+  OS.write(Buf, 2);
+}
+
+static void writeU32(raw_ostream &OS, uint32_t V) {
+  char Buf[4];
+  write32le(Buf, V);
+  OS.write(Buf, 4);
+}
+
+static void writeU64(raw_ostream &OS, uint64_t V) {
+  char Buf[8];
+  write64le(Buf, V);
+  OS.write(Buf, 8);
+}
+
+static const char DolScanCacheMagic[4] = {'H', 'F', 'D', 'X'};
+static const uint32_t DolScanCacheVersion = 1;
+
+// Reads a disassembly scan sidecar written by saveScanCache. Returns
+// false if the sidecar is missing, malformed, or was produced from a
+// different DOL, in which case the caller re-runs the scan.
+bool DOLFile::loadScanCache(StringRef Path) {
+  auto MBOrErr = MemoryBuffer::getFile((Path + ".scan").str());
+  if (!MBOrErr)
+    return false;
+
+  const uint8_t *P = (const uint8_t *)(*MBOrErr)->getBufferStart();
+  const uint8_t *End = (const uint8_t *)(*MBOrErr)->getBufferEnd();
+  if (End - P < 52 || memcmp(P, DolScanCacheMagic, 4) ||
+      read32le(P + 4) != DolScanCacheVersion ||
+      read64le(P + 8) != xxHash64(MB.getBuffer()))
+    return false;
+
+  StackBase = read32le(P + 16);
+  StackEnd = read32le(P + 20);
+  SdataBase = read32le(P + 24);
+  Sdata2Base = read32le(P + 28);
+  ArenaLo = read32le(P + 32);
+  uint32_t NumStackBase = read32le(P + 36);
+  uint32_t NumStackEnd = read32le(P + 40);
+  uint32_t NumArenaLo = read32le(P + 44);
+  uint32_t NumCalls = read32le(P + 48);
+  P += 52;
+
+  uint64_t Needed = uint64_t(NumStackBase + NumStackEnd + NumArenaLo) * 24 +
+                    uint64_t(NumCalls) * 16;
+  if (uint64_t(End - P) < Needed)
+    return false;
+
+  auto ReadRel = [&P] {
+    Relocation R{read32le(P), read32le(P + 4), read32le(P + 8)};
+    P += 12;
+    return R;
+  };
+  auto ReadRelPair = [&] {
+    RelocationPair Pair;
+    Pair.Hi = ReadRel();
+    Pair.Lo = ReadRel();
+    return Pair;
+  };
+
+  for (uint32_t I = 0; I != NumStackBase; ++I)
+    StackBaseRels.push_back(ReadRelPair());
+  for (uint32_t I = 0; I != NumStackEnd; ++I)
+    StackEndRels.push_back(ReadRelPair());
+  for (uint32_t I = 0; I != NumArenaLo; ++I)
+    ArenaLoRels.push_back(ReadRelPair());
+
+  OrigCallAddrToInstFileOffs.reserve(NumCalls);
+  for (uint32_t I = 0; I != NumCalls; ++I) {
+    uint32_t Target = read32le(P);
+    P += 4;
+    OrigCallAddrToInstFileOffs.insert(std::make_pair(Target, ReadRel()));
+  }
+  return true;
+}
+
+// A failure to write the sidecar only costs the next run a re-scan,
+// so it is reported as a warning, not an error.
+void DOLFile::saveScanCache(StringRef Path) const {
+  std::error_code EC;
+  raw_fd_ostream OS((Path + ".scan").str(), EC, fs::F_None);
+  if (EC) {
+    warn("cannot write DOL scan cache " + Path + ".scan: " + EC.message());
+    return;
+  }
+
+  OS.write(DolScanCacheMagic, 4);
+  writeU32(OS, DolScanCacheVersion);
+  writeU64(OS, xxHash64(MB.getBuffer()));
+  writeU32(OS, StackBase);
+  writeU32(OS, StackEnd);
+  writeU32(OS, SdataBase);
+  writeU32(OS, Sdata2Base);
+  writeU32(OS, ArenaLo);
+  writeU32(OS, StackBaseRels.size());
+  writeU32(OS, StackEndRels.size());
+  writeU32(OS, ArenaLoRels.size());
+  writeU32(OS, OrigCallAddrToInstFileOffs.size());
+
+  auto WriteRel = [&](const Relocation &R) {
+    writeU32(OS, R.Addr);
+    writeU32(OS, R.Offset);
+    writeU32(OS, R.Type);
+  };
+  auto WriteRelPair = [&](const RelocationPair &Pair) {
+    WriteRel(Pair.Hi);
+    WriteRel(Pair.Lo);
+  };
+
+  for (const RelocationPair &Pair : StackBaseRels)
+    WriteRelPair(Pair);
+  for (const RelocationPair &Pair : StackEndRels)
+    WriteRelPair(Pair);
+  for (const RelocationPair &Pair : ArenaLoRels)
+    WriteRelPair(Pair);
+  for (const std::pair<const uint32_t, Relocation> &P :
+       OrigCallAddrToInstFileOffs) {
+    writeU32(OS, P.first);
+    WriteRel(P.second);
+  }
+}
+
+// --hanafuda-delta-patch: most of a patched DOL is byte-identical to
+// the base image, so archives holding many of them only need the spans
+// that changed. The artifact is a manifest keyed to the base-image
+// hash (the same xxHash64 the list and scan caches use), a span table,
+// and the raw bytes of each span. An applier verifies the hash of its
+// base copy, writes each span at its offset, and truncates or extends
+// the file to the recorded output size.
+static const char DeltaPatchMagic[4] = {'H', 'F', 'D', 'P'};
+static const uint32_t DeltaPatchVersion = 1;
+
+// Collects maximal spans over which the output differs from the base
+// image, merging spans separated by short equal runs so the tables
+// stay small. Anything past the end of the base image becomes one
+// trailing span.
+static std::vector<std::pair<uint32_t, uint32_t>>
+collectChangedSpans(StringRef Old, StringRef New) {
+  std::vector<std::pair<uint32_t, uint32_t>> Spans;
+  size_t Common = std::min(Old.size(), New.size());
+  size_t I = 0;
+  while (I < Common) {
+    if (Old[I] == New[I]) {
+      ++I;
+      continue;
+    }
+    size_t Begin = I;
+    size_t End = I + 1;
+    size_t EqualRun = 0;
+    while (I < Common) {
+      if (Old[I] != New[I]) {
+        End = I + 1;
+        EqualRun = 0;
+      } else if (++EqualRun > 15) {
+        break;
+      }
+      ++I;
+    }
+    Spans.emplace_back(Begin, End - Begin);
+  }
+  if (New.size() > Old.size())
+    Spans.emplace_back(Old.size(), New.size() - Old.size());
+  return Spans;
+}
+
+static void writeDeltaPatch(StringRef Path, MemoryBufferRef Base) {
+  auto OutOrErr = MemoryBuffer::getFile(Config->OutputFile);
+  if (std::error_code EC = OutOrErr.getError()) {
+    error("cannot reopen " + Config->OutputFile + ": " + EC.message());
+    return;
+  }
+  StringRef New = (*OutOrErr)->getBuffer();
+  StringRef Old = Base.getBuffer();
+
+  std::vector<std::pair<uint32_t, uint32_t>> Spans =
+      collectChangedSpans(Old, New);
+
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, fs::F_None);
+  if (EC) {
+    error("cannot write delta patch " + Path + ": " + EC.message());
+    return;
+  }
+  OS.write(DeltaPatchMagic, 4);
+  writeU32(OS, DeltaPatchVersion);
+  writeU64(OS, xxHash64(Old));
+  writeU64(OS, New.size());
+  writeU32(OS, Spans.size());
+  for (const std::pair<uint32_t, uint32_t> &S : Spans) {
+    writeU32(OS, S.first);
+    writeU32(OS, S.second);
+  }
+  for (const std::pair<uint32_t, uint32_t> &S : Spans)
+    OS.write(New.data() + S.first, S.second);
+}
+
+// --hanafuda-live-patch: a patch-development iteration normally pays
+// for an emulator restart and a reload of the game to see a relink
+// that took seconds. When a <host>:<port> is given, the memory ranges
+// this link changed - the in-place patches to the base image plus the
+// appended patch sections - are also streamed to a listener in the
+// running emulator, so the new code lands without a reload. The frame
+// is the magic, a version, a range count, then each range as load
+// address, length, and raw bytes; values are little-endian like the
+// other Hanafuda sidecar formats. The listener answers one byte once
+// the ranges are applied, so the iteration script cannot race ahead
+// of the emulator.
+static const char LivePatchMagic[4] = {'H', 'F', 'L', 'P'};
+static const uint32_t LivePatchVersion = 1;
+
+#if LLVM_ON_UNIX
+static void streamLivePatch(StringRef HostPort, MemoryBufferRef Base,
+                            const DOLFile &Dol) {
+  StringRef Host, Port;
+  std::tie(Host, Port) = HostPort.rsplit(':');
+  if (Host.empty() || Port.empty()) {
+    error("--hanafuda-live-patch: expected <host>:<port>, got " + HostPort);
+    return;
+  }
+
+  auto OutOrErr = MemoryBuffer::getFile(Config->OutputFile);
+  if (std::error_code EC = OutOrErr.getError()) {
+    error("cannot reopen " + Config->OutputFile + ": " + EC.message());
+    return;
+  }
+  StringRef New = (*OutOrErr)->getBuffer();
+
+  // Translate the changed file spans to load-address ranges. Header
+  // bytes have no load address and are dropped; the running game never
+  // consults its copy of the header again.
+  std::vector<LiveRange> Ranges;
+  for (const std::pair<uint32_t, uint32_t> &S :
+       collectChangedSpans(Base.getBuffer(), New))
+    Dol.mapFileSpanToAddrs(S.first, S.second, Ranges);
+
+  SmallString<0> Msg;
+  raw_svector_ostream OS(Msg);
+  OS.write(LivePatchMagic, 4);
+  writeU32(OS, LivePatchVersion);
+  writeU32(OS, Ranges.size());
+  for (const LiveRange &R : Ranges) {
+    writeU32(OS, R.Addr);
+    writeU32(OS, R.Length);
+    OS.write(New.data() + R.Offset, R.Length);
+  }
+
+  addrinfo Hints = {};
+  Hints.ai_family = AF_UNSPEC;
+  Hints.ai_socktype = SOCK_STREAM;
+  addrinfo *AI;
+  if (int Err = getaddrinfo(Host.str().c_str(), Port.str().c_str(), &Hints,
+                            &AI)) {
+    error("--hanafuda-live-patch: cannot resolve " + HostPort + ": " +
+          gai_strerror(Err));
+    return;
+  }
+  int Sock = -1;
+  for (addrinfo *A = AI; A; A = A->ai_next) {
+    Sock = socket(A->ai_family, A->ai_socktype, A->ai_protocol);
+    if (Sock < 0)
+      continue;
+    if (connect(Sock, A->ai_addr, A->ai_addrlen) == 0)
+      break;
+    close(Sock);
+    Sock = -1;
+  }
+  freeaddrinfo(AI);
+  if (Sock < 0) {
+    error("--hanafuda-live-patch: cannot connect to " + HostPort);
+    return;
+  }
+
+  size_t Off = 0;
+  while (Off < Msg.size()) {
+    ssize_t N = ::write(Sock, Msg.data() + Off, Msg.size() - Off);
+    if (N < 0) {
+      error("--hanafuda-live-patch: send to " + HostPort + " failed: " +
+            strerror(errno));
+      close(Sock);
+      return;
+    }
+    Off += N;
+  }
+  if (Config->Verbose)
+    outs() << format("Streamed %zu live ranges (%zu bytes) to ",
+                     Ranges.size(), Msg.size())
+           << HostPort << "\n";
+
+  char Ack;
+  if (read(Sock, &Ack, 1) != 1)
+    warn("--hanafuda-live-patch: no acknowledgement from " + HostPort);
+  close(Sock);
+}
+#else
+static void streamLivePatch(StringRef HostPort, MemoryBufferRef,
+                            const DOLFile &) {
+  error("--hanafuda-live-patch is not supported on this platform");
+}
+#endif
+
+// Reads a binary sidecar written by saveDolSymbolListCache. Returns
+// false if the sidecar is missing, malformed, or was produced from a
+// different symbol list or base DOL, in which case the caller falls
+// back to parsing the text list.
+bool LinkerDriver::loadDolSymbolListCache(StringRef Path, uint64_t ListHash,
+                                          uint64_t DolHash,
+                                          std::vector<DolListSymbol> &Syms) {
+  auto MBOrErr = MemoryBuffer::getFile(Path);
+  if (!MBOrErr)
+    return false;
+  std::unique_ptr<MemoryBuffer> &MB = *MBOrErr;
+
+  const uint8_t *P = (const uint8_t *)MB->getBufferStart();
+  const uint8_t *End = (const uint8_t *)MB->getBufferEnd();
+  if (End - P < 28 || memcmp(P, DolListCacheMagic, 4) ||
+      read32le(P + 4) != DolListCacheVersion || read64le(P + 8) != ListHash ||
+      read64le(P + 16) != DolHash)
+    return false;
+  uint32_t Count = read32le(P + 24);
+  P += 28;
+
+  Syms.reserve(Count);
+  for (uint32_t I = 0; I != Count; ++I) {
+    if (End - P < 8)
+      return false;
+    DolListSymbol S;
+    S.Addr = read32le(P);
+    S.Type = (HanafudaSecType)P[4];
+    S.SecIdx = P[5];
+    uint16_t NameLen = read16le(P + 6);
+    P += 8;
+    if (End - P < NameLen)
+      return false;
+    S.Name = StringRef((const char *)P, NameLen);
+    P += NameLen;
+    Syms.push_back(S);
+  }
+
+  // The symbol names point into the sidecar, so keep it alive for the
+  // rest of the link.
+  OwningMBs.push_back(std::move(MB));
+  return true;
+}
+
+// A failure to write the sidecar only costs the next run a re-parse,
+// so it is reported as a warning, not an error.
+void LinkerDriver::saveDolSymbolListCache(StringRef Path, uint64_t ListHash,
+                                          uint64_t DolHash,
+                                          ArrayRef<DolListSymbol> Syms) {
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, fs::F_None);
+  if (EC) {
+    warn("cannot write DOL symbol list cache " + Path + ": " + EC.message());
+    return;
+  }
+
+  OS.write(DolListCacheMagic, 4);
+  writeU32(OS, DolListCacheVersion);
+  writeU64(OS, ListHash);
+  writeU64(OS, DolHash);
+  writeU32(OS, Syms.size());
+  for (const DolListSymbol &S : Syms) {
+    writeU32(OS, S.Addr);
+    OS.write((char)S.Type);
+    OS.write((char)S.SecIdx);
+    writeU16(OS, S.Name.size());
+    OS.write(S.Name.data(), S.Name.size());
+  }
+}
+
+// Loads a DOL symbol list and registers every entry as an absolute
+// symbol. Lists for commercial titles run to tens of thousands of
+// entries, so the slow parts are batched: the parsed and validated
+// list is memoized in a binary sidecar keyed on the list and DOL
+// contents, the names are hashed and uniquified in one pass, and the
+// symbol table insertions then run in parallel (the table's shards
+// are individually locked).
+void LinkerDriver::loadDolSymbolList(StringRef Path, MemoryBufferRef MB,
+                                     SymbolTable<ELF32BE> &Symtab) {
+  uint64_t ListHash = xxHash64(MB.getBuffer());
+  uint64_t DolHash = xxHash64(DolFile->getBuffer().getBuffer());
+  std::string CachePath = (Path + ".cache").str();
+
+  std::vector<DolListSymbol> Syms;
+  if (!loadDolSymbolListCache(CachePath, ListHash, DolHash, Syms)) {
+    SymbolListFile DolSymListFile(MB.getBuffer());
+
+    // Validate addresses and uniquify names in one pass. Exact
+    // duplicate entries are common in map exports and are dropped;
+    // entries that redefine a name with a different address are
+    // reported here, deterministically, before the parallel insert.
+    DenseMap<CachedHashStringRef, uint32_t> Seen;
+    for (const std::pair<uint32_t, StringRef> &sym : DolSymListFile) {
+      HanafudaSecType secType;
+      int secIdx = 0;
+      if (DolFile->validateSymbolAddr(sym.first, secType, secIdx))
+        continue;
+      auto P = Seen.insert({CachedHashStringRef(sym.second), sym.first});
+      if (!P.second) {
+        if (P.first->second != sym.first)
+          error("duplicate symbol '" + sym.second + "' in " + Path);
+        continue;
+      }
+      Syms.push_back({sym.first, secType, (uint8_t)secIdx, sym.second});
+    }
+
+    if (!ErrorCount)
+      saveDolSymbolListCache(CachePath, ListHash, DolHash, Syms);
+  }
+
+  // All names are unique at this point, so each Symbol is touched by
+  // exactly one task.
+  forEach(Syms.begin(), Syms.end(), [&](const DolListSymbol &S) {
+    DefinedRegular<ELF32BE> *asym =
+        Symtab.addAbsolute(S.Name, llvm::ELF::STV_DEFAULT);
+    asym->HanafudaType = S.Type;
+    asym->HanafudaSection = S.SecIdx;
+    asym->Value = S.Addr;
+  });
+}
+
 void LinkerDriver::link(opt::InputArgList &Args) {
   // Create symbol table and propogate to user code
   SymbolTable<ELF32BE> Symtab;
@@ -1041,21 +1622,18 @@ void LinkerDriver::link(opt::InputArgList &Args) {
   if (Args.hasArg(OPT_hanafuda_dol_symbol_list)) {
     StringRef dolListArg = Args.getLastArgValue(OPT_hanafuda_dol_symbol_list);
     Optional<MemoryBufferRef> dolListBuffer = readFile(dolListArg);
-    if (dolListBuffer.hasValue()) {
-      SymbolListFile DolSymListFile(dolListBuffer.getValue().getBuffer());
-      for (const std::pair<uint32_t, StringRef>& sym : DolSymListFile) {
-        HanafudaSecType secType;
-        int secIdx = 0;
-        if (DolFile->validateSymbolAddr(sym.first, secType, secIdx))
-          continue;
-        DefinedRegular<ELF32BE> *asym = Symtab.addAbsolute(sym.second, llvm::ELF::STV_DEFAULT);
-        asym->HanafudaType = secType;
-        asym->HanafudaSection = secIdx;
-        asym->Value = sym.first;
-      }
-    }
+    if (dolListBuffer.hasValue())
+      loadDolSymbolList(dolListArg, dolListBuffer.getValue(), Symtab);
   }
 
+  // The base image buffer is patched in place during the link, so take
+  // a pristine copy up front for the delta-patch and live-patch diffs.
+  std::unique_ptr<MemoryBuffer> BaseCopy;
+  if (Args.hasArg(OPT_hanafuda_delta_patch) ||
+      Args.hasArg(OPT_hanafuda_live_patch))
+    BaseCopy =
+        MemoryBuffer::getMemBufferCopy(DolFile->getBuffer().getBuffer());
+
   // Configure text/data/bss for hanafuda
   ScriptConfig->HasSections = true;
   Config->OFormatBinary = true;
@@ -1065,7 +1643,11 @@ void LinkerDriver::link(opt::InputArgList &Args) {
   Config->OPreWrite = [&,InitialAddr](uint8_t *BufData,
       const std::vector<OutputSectionBase *> &OutputSections) {
 
-    // Patch original calls
+    // Patch original calls. Resolve every patch symbol first so the
+    // diagnostics stay deterministic, then apply the patches in
+    // parallel: each original call target owns a disjoint set of call
+    // sites in the base image.
+    std::vector<std::pair<uint32_t, uint32_t>> Patches;
     for (const auto &P : Symtab.HanafudaPatches) {
       DefinedRegular<ELF32BE> *OldSym =
           dyn_cast_or_null<DefinedRegular<ELF32BE>>(
@@ -1088,12 +1670,18 @@ void LinkerDriver::link(opt::InputArgList &Args) {
       if (Config->Verbose)
         outs() << "Patching '" << OldSym->getName() <<
                   "' to '" << NewSym->getName() << "'\n";
-      DolFile->patchTargetAddressRelocations(OldSym->Value,
-                                             NewSym->getVA<ELF32BE>(0));
+      Patches.emplace_back(OldSym->Value, NewSym->getVA<ELF32BE>(0));
     }
     if (ErrorCount)
       return;
 
+    forEach(Patches.begin(), Patches.end(),
+            [&](const std::pair<uint32_t, uint32_t> &P) {
+              DolFile->patchTargetAddressRelocations(P.first, P.second);
+            });
+    if (ErrorCount)
+      return;
+
     // I'm called after lld has assigned file offsets and VAs to new output sections,
     // and before the file buffer has been committed to disk
     DOLFile::Section *DataSec = nullptr;
@@ -1278,6 +1866,10 @@ void LinkerDriver::link(opt::InputArgList &Args) {
     for (InputSectionData *S : F->getSections())
       Symtab.Sections.push_back(cast<InputSection<ELFT>>(S));
 
+  // Resolve every relocation's target symbol once; GC, ICF and the
+  // relocation scan consume the shared index.
+  buildRelocTargetIndex<ELFT>();
+
   // Do size optimizations: garbage collection and identical code folding.
   if (Config->GcSections)
     markLive<ELFT>();
@@ -1298,6 +1890,16 @@ void LinkerDriver::link(opt::InputArgList &Args) {
 
   // Write the result to the file.
   writeResult<ELFT>();
+
+  // Optionally emit the delta-patch artifact alongside the output.
+  if (auto *Arg = Args.getLastArg(OPT_hanafuda_delta_patch))
+    if (!ErrorCount)
+      writeDeltaPatch(Arg->getValue(), BaseCopy->getMemBufferRef());
+
+  // Optionally stream the changed memory ranges to a running emulator.
+  if (auto *Arg = Args.getLastArg(OPT_hanafuda_live_patch))
+    if (!ErrorCount)
+      streamLivePatch(Arg->getValue(), BaseCopy->getMemBufferRef(), *DolFile);
 }
 
 }
@@ -75,14 +75,19 @@
 
 #include "ICF.h"
 #include "Config.h"
+#include "LinkProfile.h"
+#include "Strings.h"
 #include "SymbolTable.h"
 #include "Threads.h"
 
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/Object/ELF.h"
 #include "llvm/Support/ELF.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 
 using namespace lld;
 using namespace lld::elf;
@@ -101,10 +106,6 @@ private:
   template <class RelTy>
   bool constantEq(ArrayRef<RelTy> RelsA, ArrayRef<RelTy> RelsB);
 
-  template <class RelTy>
-  bool variableEq(const InputSection<ELFT> *A, ArrayRef<RelTy> RelsA,
-                  const InputSection<ELFT> *B, ArrayRef<RelTy> RelsB);
-
   bool equalsConstant(const InputSection<ELFT> *A, const InputSection<ELFT> *B);
   bool equalsVariable(const InputSection<ELFT> *A, const InputSection<ELFT> *B);
 
@@ -117,6 +118,11 @@ private:
 
   std::vector<InputSection<ELFT> *> Sections;
 
+  // Per-shard wall time accumulated across the iterations of the main
+  // loop, in microseconds. Only collected with --link-profile; each
+  // shard writes its own slot, so the parallel loop needs no locking.
+  std::vector<uint64_t> ShardUs;
+
   // We repeat the main loop while `Repeat` is true.
   std::atomic<bool> Repeat;
 
@@ -152,19 +158,52 @@ private:
 };
 }
 
+// Returns a hash of the "constant" part of the relocations of S,
+// i.e. everything except the target symbols.
+template <class ELFT, class RelTy>
+static uint32_t relocationHash(ArrayRef<RelTy> Rels) {
+  uint32_t H = 0;
+  for (const RelTy &R : Rels)
+    H = hash_combine(H, (uint64_t)R.r_offset, R.getType(Config->Mips64EL),
+                     (uint64_t)getAddend<ELFT>(R));
+  return H;
+}
+
 // Returns a hash value for S. Note that the information about
-// relocation targets is not included in the hash value.
+// relocation targets is not included in the hash value. Everything
+// else that equalsConstant compares is: the more of the "constant"
+// part we fold into the hash, the finer the initial partition and the
+// fewer expensive byte-by-byte comparisons segregate has to do.
 template <class ELFT> static uint32_t getHash(InputSection<ELFT> *S) {
-  return hash_combine(S->Flags, S->getSize(), S->NumRelocations);
+  uint32_t RelHash = S->AreRelocsRela ? relocationHash<ELFT>(S->relas())
+                                      : relocationHash<ELFT>(S->rels());
+  return hash_combine(S->Flags, S->getSize(), S->NumRelocations,
+                      xxHash64(toStringRef(S->Data)), RelHash);
 }
 
-// Returns true if section S is subject of ICF.
-template <class ELFT> static bool isEligible(InputSection<ELFT> *S) {
+// Returns true if section S is subject of ICF. Exported is the set of
+// sections defining a symbol that is visible to other modules; see the
+// comment in ICF<ELFT>::run.
+template <class ELFT>
+static bool isEligible(InputSection<ELFT> *S,
+                       const DenseSet<InputSectionBase<ELFT> *> &Exported) {
+  if (!S->Live || !(S->Flags & SHF_ALLOC) || (S->Flags & SHF_WRITE))
+    return false;
+
   // .init and .fini contains instructions that must be executed to
   // initialize and finalize the process. They cannot and should not
   // be merged.
-  return S->Live && (S->Flags & SHF_ALLOC) && !(S->Flags & SHF_WRITE) &&
-         S->Name != ".init" && S->Name != ".fini";
+  if (S->Name == ".init" || S->Name == ".fini")
+    return false;
+
+  if (S->Flags & SHF_EXECINSTR)
+    return true;
+
+  // Read-only data (vtables, switch tables, generated lookup arrays) is
+  // folded only in all-data mode because, unlike code, distinct objects
+  // are guaranteed to have distinct addresses. Even then, keep sections
+  // whose addresses can be observed from other modules.
+  return Config->ICFData && !Exported.count(S);
 }
 
 // Split an equivalence class into smaller classes.
@@ -232,16 +271,15 @@ bool ICF<ELFT>::equalsConstant(const InputSection<ELFT> *A,
   return constantEq(A->rels(), B->rels());
 }
 
-// Compare two lists of relocations. Returns true if all pairs of
-// relocations point to the same section in terms of ICF.
+// Compare "moving" part of two InputSections, namely relocation
+// targets. Returns true if all pairs of relocations point to the same
+// section in terms of ICF. The targets come from the shared
+// RelocTargets index, so no symbol lookups are repeated here.
 template <class ELFT>
-template <class RelTy>
-bool ICF<ELFT>::variableEq(const InputSection<ELFT> *A, ArrayRef<RelTy> RelsA,
-                           const InputSection<ELFT> *B, ArrayRef<RelTy> RelsB) {
-  auto Eq = [&](const RelTy &RA, const RelTy &RB) {
+bool ICF<ELFT>::equalsVariable(const InputSection<ELFT> *A,
+                               const InputSection<ELFT> *B) {
+  auto Eq = [&](SymbolBody &SA, SymbolBody &SB) {
     // The two sections must be identical.
-    SymbolBody &SA = A->getFile()->getRelocTargetSym(RA);
-    SymbolBody &SB = B->getFile()->getRelocTargetSym(RB);
     if (&SA == &SB)
       return true;
 
@@ -266,16 +304,10 @@ bool ICF<ELFT>::variableEq(const InputSection<ELFT> *A, ArrayRef<RelTy> RelsA,
     return X->Class[Current] == Y->Class[Current];
   };
 
-  return std::equal(RelsA.begin(), RelsA.end(), RelsB.begin(), Eq);
-}
-
-// Compare "moving" part of two InputSections, namely relocation targets.
-template <class ELFT>
-bool ICF<ELFT>::equalsVariable(const InputSection<ELFT> *A,
-                               const InputSection<ELFT> *B) {
-  if (A->AreRelocsRela)
-    return variableEq(A, A->relas(), B, B->relas());
-  return variableEq(A, A->rels(), B, B->rels());
+  for (size_t I = 0, E = A->NumRelocations; I != E; ++I)
+    if (!Eq(*A->RelocTargets[I], *B->RelocTargets[I]))
+      return false;
+  return true;
 }
 
 template <class ELFT> size_t ICF<ELFT>::findBoundary(size_t Begin, size_t End) {
@@ -320,27 +352,54 @@ void ICF<ELFT>::forEachClass(std::function<void(size_t, size_t)> Fn) {
   Current = Cnt % 2;
   Next = (Cnt + 1) % 2;
 
-  // Split sections into 256 shards and call Fn in parallel.
-  size_t NumShards = 256;
+  // Split sections into shards and call Fn in parallel. 256 shards by
+  // default; the link profile retunes the count from the imbalance it
+  // measured on the previous link of this output.
+  size_t NumShards = Config->ICFShards;
   size_t Step = Sections.size() / NumShards;
-  forLoop(0, NumShards,
-          [&](size_t I) { forEachClassRange(I * Step, (I + 1) * Step, Fn); });
+  if (Config->LinkProfile)
+    ShardUs.resize(NumShards);
+  forLoop(0, NumShards, [&](size_t I) {
+    if (!Config->LinkProfile) {
+      forEachClassRange(I * Step, (I + 1) * Step, Fn);
+      return;
+    }
+    auto Start = std::chrono::steady_clock::now();
+    forEachClassRange(I * Step, (I + 1) * Step, Fn);
+    ShardUs[I] += std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - Start)
+                      .count();
+  });
   forEachClassRange(Step * NumShards, Sections.size(), Fn);
   ++Cnt;
 }
 
 // The main function of ICF.
 template <class ELFT> void ICF<ELFT>::run() {
+  // In all-data mode, folding a read-only data section that defines an
+  // exported symbol could change address identity observable from other
+  // modules, so collect the sections defining such symbols first.
+  DenseSet<InputSectionBase<ELFT> *> Exported;
+  if (Config->ICFData)
+    for (Symbol *S : Symtab<ELFT>::X->getSymbols())
+      if (S->includeInDynsym())
+        if (auto *D = dyn_cast<DefinedRegular<ELFT>>(S->body()))
+          if (D->Section)
+            Exported.insert(D->Section);
+
   // Collect sections to merge.
   for (InputSectionBase<ELFT> *Sec : Symtab<ELFT>::X->Sections)
     if (auto *S = dyn_cast<InputSection<ELFT>>(Sec))
-      if (isEligible(S))
+      if (isEligible(S, Exported))
         Sections.push_back(S);
 
-  // Initially, we use hash values to partition sections.
-  for (InputSection<ELFT> *S : Sections)
+  // Initially, we use hash values to partition sections. Hashing the
+  // section contents is by far the most expensive part of this, and
+  // each section is independent, so do it in parallel.
+  forEach(Sections.begin(), Sections.end(), [](InputSection<ELFT> *S) {
     // Set MSB to 1 to avoid collisions with non-hash IDs.
     S->Class[0] = getHash(S) | (1 << 31);
+  });
 
   // From now on, sections in Sections vector are ordered so that sections
   // in the same equivalence class are consecutive in the vector.
@@ -360,6 +419,7 @@ template <class ELFT> void ICF<ELFT>::run() {
   } while (Repeat);
 
   log("ICF needed " + Twine(Cnt) + " iterations");
+  recordShardTimes("icf", ShardUs);
 
   // Merge sections by the equivalence class.
   forEachClass([&](size_t Begin, size_t End) {
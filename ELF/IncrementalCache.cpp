@@ -0,0 +1,405 @@
+//===- IncrementalCache.cpp -----------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// When --incremental is given, the driver writes a cache file next to
+// the output after every successful link, and consults it on startup.
+// The cache is a text file of the following form:
+//
+//   LLD incremental cache v1
+//   cmd <hash>
+//   out <size> <head-hash>
+//   in <hash> <size> <identifier>
+//   in <hash> <size> <identifier>
+//   ...
+//
+// "cmd" is a hash of the entire command line. Each "in" line records
+// the content hash, size and buffer identifier of one file the driver
+// read (objects, archives, shared objects, linker scripts and the
+// like; members fetched from an archive are covered by the archive's
+// own line). "out" records the size of the produced output and a hash
+// of its leading bytes, which guards against the output having been
+// replaced or truncated since the previous run.
+//
+// If every line matches the current invocation, re-running the link
+// would reproduce the existing output bit for bit, so the driver skips
+// it. If anything differs, the link runs normally and the cache is
+// rewritten. Reusing the layout of the previous run for partially
+// changed input sets is not implemented.
+//
+//===----------------------------------------------------------------------===//
+
+#include "IncrementalCache.h"
+#include "Config.h"
+#include "Error.h"
+#include "lld/Support/Memory.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+using namespace llvm;
+
+using namespace lld;
+using namespace lld::elf;
+
+// Number of leading output bytes covered by the "out" hash. Hashing
+// the whole output would add a full-file pass to every no-op relink.
+static const size_t OutHeadSize = 65536;
+
+static std::string getCachePath() {
+  return (Config->OutputFile + ".lldcache").str();
+}
+
+static uint64_t getCmdLineHash(ArrayRef<const char *> Args) {
+  std::string S;
+  for (const char *Arg : Args) {
+    S += Arg;
+    S += '\0';
+  }
+  return xxHash64(S);
+}
+
+static uint64_t getOutputHeadHash(MemoryBufferRef MB) {
+  StringRef Buf = MB.getBuffer();
+  return xxHash64(Buf.substr(0, OutHeadSize));
+}
+
+// Parses "<a> <b> <rest...>" and returns false on malformed input.
+static bool parseTwoInts(StringRef Line, uint64_t &A, uint64_t &B,
+                         StringRef &Rest) {
+  StringRef S;
+  std::tie(S, Line) = Line.split(' ');
+  if (S.getAsInteger(16, A))
+    return false;
+  std::tie(S, Rest) = Line.split(' ');
+  return !S.getAsInteger(10, B);
+}
+
+bool elf::isLinkUpToDate(ArrayRef<const char *> Args,
+                         ArrayRef<MemoryBufferRef> Inputs) {
+  auto MBOrErr = MemoryBuffer::getFile(getCachePath());
+  if (!MBOrErr)
+    return false;
+  SmallVector<StringRef, 0> Lines;
+  (*MBOrErr)->getBuffer().split(Lines, '\n');
+
+  // Every line must match the current invocation, in order. The inputs
+  // are recorded in the order the driver read them, which is a function
+  // of the command line, so an order-sensitive comparison is exact.
+  size_t I = 0;
+  auto Next = [&]() -> StringRef {
+    return I < Lines.size() ? Lines[I++].trim() : StringRef();
+  };
+
+  if (Next() != "LLD incremental cache v1")
+    return false;
+  if (Next() != "cmd " + utohexstr(getCmdLineHash(Args)))
+    return false;
+
+  // Check that the output is still the file the previous run wrote.
+  uint64_t OutSize, OutHash;
+  StringRef Rest;
+  StringRef OutLine = Next();
+  if (!OutLine.consume_front("out ") ||
+      !parseTwoInts(OutLine, OutHash, OutSize, Rest))
+    return false;
+  auto OutOrErr = MemoryBuffer::getFileSlice(Config->OutputFile,
+                                             std::min<uint64_t>(OutSize,
+                                                                OutHeadSize),
+                                             0);
+  if (!OutOrErr)
+    return false;
+  sys::fs::file_status St;
+  if (sys::fs::status(Config->OutputFile, St) || St.getSize() != OutSize)
+    return false;
+  if (getOutputHeadHash((*OutOrErr)->getMemBufferRef()) != OutHash)
+    return false;
+
+  for (MemoryBufferRef MB : Inputs) {
+    uint64_t Hash, Size;
+    StringRef Line = Next();
+    if (!Line.consume_front("in ") || !parseTwoInts(Line, Hash, Size, Rest))
+      return false;
+    if (Size != MB.getBufferSize() || Rest != MB.getBufferIdentifier() ||
+        Hash != xxHash64(MB.getBuffer()))
+      return false;
+  }
+  // Any remaining lines correspond to members of thin archives that
+  // the previous run fetched lazily during symbol resolution. The
+  // current run has not read them yet, so verify them against the
+  // filesystem directly; their identifiers are plain paths.
+  for (StringRef Line = Next(); !Line.empty(); Line = Next()) {
+    uint64_t Hash, Size;
+    if (!Line.consume_front("in ") || !parseTwoInts(Line, Hash, Size, Rest))
+      return false;
+    auto MemberOrErr = MemoryBuffer::getFile(Rest);
+    if (!MemberOrErr || (*MemberOrErr)->getBufferSize() != Size ||
+        xxHash64((*MemberOrErr)->getBuffer()) != Hash)
+      return false;
+  }
+  return true;
+}
+
+void elf::writeLinkCache(ArrayRef<const char *> Args,
+                         ArrayRef<MemoryBufferRef> Inputs) {
+  std::error_code EC;
+  raw_fd_ostream OS(getCachePath(), EC, sys::fs::F_None);
+  if (EC) {
+    warn("--incremental: cannot write " + getCachePath() + ": " + EC.message());
+    return;
+  }
+
+  OS << "LLD incremental cache v1\n";
+  OS << "cmd " << utohexstr(getCmdLineHash(Args)) << "\n";
+
+  auto OutOrErr = MemoryBuffer::getFile(Config->OutputFile);
+  if (!OutOrErr)
+    return;
+  OS << "out " << utohexstr(getOutputHeadHash((*OutOrErr)->getMemBufferRef()))
+     << " " << (*OutOrErr)->getBufferSize() << "\n";
+
+  for (MemoryBufferRef MB : Inputs)
+    OS << "in " << utohexstr(xxHash64(MB.getBuffer())) << " "
+       << MB.getBufferSize() << " " << MB.getBufferIdentifier() << "\n";
+}
+
+//===----------------------------------------------------------------------===//
+// Bitcode lazy-symbol cache
+//
+// A text file of the following form, next to the link cache:
+//
+//   LLD bitcode symbol cache v1
+//   bc <hash> <count>
+//   <symbol name>
+//   ...
+//
+// Each "bc" record maps the content hash of one bitcode file to the
+// names of its globally-visible defined symbols, one per line. The
+// hash both keys and validates an entry: changed bitcode simply
+// misses and is re-enumerated through the bitcode reader. The cache
+// is only consulted and written from the serial lazy-resolution path,
+// so no locking is needed.
+//===----------------------------------------------------------------------===//
+
+static std::string getSymCachePath() {
+  return (Config->OutputFile + ".lldsymcache").str();
+}
+
+namespace {
+struct BitcodeSymCache {
+  bool Loaded = false;
+  bool Dirty = false;
+  llvm::DenseMap<uint64_t, std::vector<StringRef>> Entries;
+};
+}
+
+static BitcodeSymCache SymCache;
+
+static void loadSymCache() {
+  SymCache.Loaded = true;
+  auto MBOrErr = MemoryBuffer::getFile(getSymCachePath());
+  if (!MBOrErr)
+    return;
+  SmallVector<StringRef, 0> Lines;
+  (*MBOrErr)->getBuffer().split(Lines, '\n');
+
+  size_t I = 0;
+  auto Next = [&]() -> StringRef {
+    return I < Lines.size() ? Lines[I++] : StringRef();
+  };
+
+  if (Next().trim() != "LLD bitcode symbol cache v1")
+    return;
+  while (I < Lines.size()) {
+    StringRef Line = Next().trim();
+    if (Line.empty())
+      break;
+    uint64_t Hash, Count;
+    StringRef Rest;
+    if (!Line.consume_front("bc ") ||
+        !parseTwoInts(Line, Hash, Count, Rest) || I + Count > Lines.size()) {
+      // Malformed cache; drop everything rather than trust part of it.
+      SymCache.Entries.clear();
+      return;
+    }
+    // The names must outlive the cache buffer.
+    std::vector<StringRef> &Syms = SymCache.Entries[Hash];
+    Syms.reserve(Count);
+    for (uint64_t J = 0; J != Count; ++J)
+      Syms.push_back(Saver.save(Next()));
+  }
+}
+
+Optional<std::vector<StringRef>> elf::lookupBitcodeSymbols(MemoryBufferRef MB) {
+  if (!Config->Incremental)
+    return None;
+  if (!SymCache.Loaded)
+    loadSymCache();
+  auto It = SymCache.Entries.find(xxHash64(MB.getBuffer()));
+  if (It == SymCache.Entries.end())
+    return None;
+  return It->second;
+}
+
+void elf::addBitcodeSymbols(MemoryBufferRef MB, ArrayRef<StringRef> Syms) {
+  if (!Config->Incremental)
+    return;
+  // A name containing a newline cannot be represented in the
+  // line-oriented format; such a file is just not cached.
+  for (StringRef S : Syms)
+    if (S.find('\n') != StringRef::npos)
+      return;
+  if (!SymCache.Loaded)
+    loadSymCache();
+  if (SymCache.Entries
+          .insert({xxHash64(MB.getBuffer()),
+                   std::vector<StringRef>(Syms.begin(), Syms.end())})
+          .second)
+    SymCache.Dirty = true;
+}
+
+//===----------------------------------------------------------------------===//
+// Archive member prefetch history
+//
+// A text file of the following form, next to the link cache:
+//
+//   LLD archive member cache v1
+//   ar <hash> <count>
+//   <offset>
+//   ...
+//
+// Each "ar" record maps the content hash of one archive to the child
+// offsets of the members the previous link extracted from it, one per
+// line. As with the bitcode symbol cache, the hash both keys and
+// validates an entry: a changed archive misses and contributes no
+// predictions. The loaded entries are immutable so the parallel
+// pre-parse stage can consult them without locking; extractions of
+// the current run are recorded separately, from the serial resolution
+// path.
+//===----------------------------------------------------------------------===//
+
+static std::string getMemberCachePath() {
+  return (Config->OutputFile + ".lldmembers").str();
+}
+
+namespace {
+struct MemberCache {
+  bool Dirty = false;
+  llvm::DenseMap<uint64_t, std::vector<uint64_t>> Entries;
+  llvm::DenseMap<uint64_t, std::vector<uint64_t>> Extracted;
+};
+}
+
+static MemberCache MemCache;
+
+void elf::loadArchiveMemberCache() {
+  if (!Config->Incremental)
+    return;
+  auto MBOrErr = MemoryBuffer::getFile(getMemberCachePath());
+  if (!MBOrErr)
+    return;
+  SmallVector<StringRef, 0> Lines;
+  (*MBOrErr)->getBuffer().split(Lines, '\n');
+
+  size_t I = 0;
+  auto Next = [&]() -> StringRef {
+    return I < Lines.size() ? Lines[I++] : StringRef();
+  };
+
+  if (Next().trim() != "LLD archive member cache v1")
+    return;
+  while (I < Lines.size()) {
+    StringRef Line = Next().trim();
+    if (Line.empty())
+      break;
+    uint64_t Hash, Count;
+    StringRef Rest;
+    if (!Line.consume_front("ar ") ||
+        !parseTwoInts(Line, Hash, Count, Rest) || I + Count > Lines.size()) {
+      // Malformed cache; drop everything rather than trust part of it.
+      MemCache.Entries.clear();
+      return;
+    }
+    std::vector<uint64_t> &Offsets = MemCache.Entries[Hash];
+    Offsets.reserve(Count);
+    for (uint64_t J = 0; J != Count; ++J) {
+      uint64_t Off;
+      if (Next().trim().getAsInteger(10, Off)) {
+        MemCache.Entries.clear();
+        return;
+      }
+      Offsets.push_back(Off);
+    }
+  }
+}
+
+Optional<std::vector<uint64_t>> elf::lookupArchiveMembers(uint64_t Hash) {
+  auto It = MemCache.Entries.find(Hash);
+  if (It == MemCache.Entries.end())
+    return None;
+  return It->second;
+}
+
+void elf::addExtractedMember(uint64_t Hash, uint64_t Offset) {
+  MemCache.Extracted[Hash].push_back(Offset);
+  MemCache.Dirty = true;
+}
+
+void elf::writeArchiveMemberCache() {
+  if (MemCache.Dirty) {
+    // This run's extractions replace the loaded set per archive;
+    // entries of archives this run did not consult are carried over,
+    // so the history survives links that touch a subset of inputs.
+    for (auto &P : MemCache.Extracted)
+      MemCache.Entries[P.first] = std::move(P.second);
+
+    std::error_code EC;
+    raw_fd_ostream OS(getMemberCachePath(), EC, sys::fs::F_None);
+    if (EC) {
+      warn("--incremental: cannot write " + getMemberCachePath() + ": " +
+           EC.message());
+    } else {
+      OS << "LLD archive member cache v1\n";
+      for (auto &P : MemCache.Entries) {
+        OS << "ar " << utohexstr(P.first) << " " << P.second.size() << "\n";
+        for (uint64_t Off : P.second)
+          OS << Off << "\n";
+      }
+    }
+  }
+  MemCache.Dirty = false;
+  MemCache.Entries.clear();
+  MemCache.Extracted.clear();
+}
+
+void elf::writeBitcodeSymbolCache() {
+  if (SymCache.Dirty) {
+    std::error_code EC;
+    raw_fd_ostream OS(getSymCachePath(), EC, sys::fs::F_None);
+    if (EC) {
+      warn("--incremental: cannot write " + getSymCachePath() + ": " +
+           EC.message());
+    } else {
+      OS << "LLD bitcode symbol cache v1\n";
+      for (auto &P : SymCache.Entries) {
+        OS << "bc " << utohexstr(P.first) << " " << P.second.size() << "\n";
+        for (StringRef S : P.second)
+          OS << S << "\n";
+      }
+    }
+  }
+  // The cached names live in the string arena, which is freed when the
+  // link finishes; reset so a second in-process link starts clean.
+  SymCache.Loaded = false;
+  SymCache.Dirty = false;
+  SymCache.Entries.clear();
+}
@@ -0,0 +1,83 @@
+//===- IncrementalCache.h ---------------------------------------*- C++ -*-===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The incremental cache records the identity of every input of a link
+// (and of the produced output) so that a subsequent run with identical
+// inputs can skip relinking entirely. See IncrementalCache.cpp for the
+// cache file format.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_INCREMENTAL_CACHE_H
+#define LLD_ELF_INCREMENTAL_CACHE_H
+
+#include "lld/Core/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include <vector>
+
+namespace lld {
+namespace elf {
+
+// Returns true if the cache written by a previous run proves that the
+// command line and all input files are unchanged and that the existing
+// output file is still the one that run produced. In that case the
+// whole link can be skipped.
+bool isLinkUpToDate(ArrayRef<const char *> Args,
+                    ArrayRef<MemoryBufferRef> Inputs);
+
+// Records the identity of the command line, all inputs and the
+// just-written output. Called after a successful link.
+void writeLinkCache(ArrayRef<const char *> Args,
+                    ArrayRef<MemoryBufferRef> Inputs);
+
+// Bitcode lazy-symbol cache. Enumerating the defined names of a lazy
+// bitcode file (an archive or --start-lib member) requires spinning up
+// the LLVM bitcode reader, which dominates the startup of LTO links.
+// With --incremental the name lists are persisted next to the link
+// cache, keyed and validated by the content hash of the bitcode, so
+// subsequent runs answer the enumeration from disk.
+llvm::Optional<std::vector<StringRef>>
+lookupBitcodeSymbols(MemoryBufferRef MB);
+void addBitcodeSymbols(MemoryBufferRef MB, ArrayRef<StringRef> Syms);
+
+// Writes out entries added by addBitcodeSymbols, if any. Called after
+// a successful link.
+void writeBitcodeSymbolCache();
+
+// Archive member prefetch history. Which members a link extracts is
+// almost always the same as on the previous build of the same output,
+// but each link rediscovers them one lazy resolution at a time. With
+// --incremental the set of extracted member offsets is persisted next
+// to the link cache, keyed and validated by the content hash of the
+// archive, so the next link can speculatively pre-parse those members
+// before symbol resolution starts; a mispredicted member is simply
+// never fetched.
+
+// Reads the history written by the previous run. Must be called
+// before the parallel pre-parse stage consults it: the loaded entries
+// are immutable afterwards, so lookups need no locking.
+void loadArchiveMemberCache();
+
+// Returns the member offsets the previous run extracted from the
+// archive with the given content hash, if it is in the history.
+llvm::Optional<std::vector<uint64_t>> lookupArchiveMembers(uint64_t Hash);
+
+// Records that this run extracted the member at Offset from the
+// archive with the given content hash.
+void addExtractedMember(uint64_t Hash, uint64_t Offset);
+
+// Writes out the history recorded by this run, if any. Called after a
+// successful link.
+void writeArchiveMemberCache();
+
+} // namespace elf
+} // namespace lld
+
+#endif
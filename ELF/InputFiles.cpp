@@ -10,6 +10,7 @@
 #include "InputFiles.h"
 #include "Driver.h"
 #include "Error.h"
+#include "IncrementalCache.h"
 #include "InputSection.h"
 #include "LinkerScript.h"
 #include "SymbolTable.h"
@@ -25,7 +26,15 @@
 #include "llvm/MC/StringTableBuilder.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include <algorithm>
+#include <mutex>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 using namespace llvm;
 using namespace llvm::ELF;
@@ -75,8 +84,9 @@ template <class ELFT> void elf::ObjectFile<ELFT>::initializeDwarfLine() {
 template <class ELFT>
 std::string elf::ObjectFile<ELFT>::getLineInfo(InputSectionBase<ELFT> *S,
                                                uintX_t Offset) {
-  if (!DwarfLine)
-    initializeDwarfLine();
+  // Parse the line table once per file, no matter how many diagnostics
+  // hit it and from how many threads.
+  std::call_once(DwarfLineInit, [this] { initializeDwarfLine(); });
 
   // The offset to CU is 0.
   const DWARFDebugLine::LineTable *Tbl = DwarfLine->getLineTable(0);
@@ -85,14 +95,61 @@ std::string elf::ObjectFile<ELFT>::getLineInfo(InputSectionBase<ELFT> *S,
 
   // Use fake address calcuated by adding section file offset and offset in
   // section. See comments for ObjectInfo class.
+  uint64_t Addr = S->Offset + Offset;
+  {
+    std::lock_guard<std::mutex> Lock(LineInfoMu);
+    auto It = LineInfoCache.find(Addr);
+    if (It != LineInfoCache.end())
+      return It->second;
+  }
+
   DILineInfo Info;
   Tbl->getFileLineInfoForAddress(
-      S->Offset + Offset, nullptr,
-      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath, Info);
-  if (Info.Line == 0)
-    return "";
-  return convertToUnixPathSeparator(Info.FileName) + ":" +
-         std::to_string(Info.Line);
+      Addr, nullptr, DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+      Info);
+  std::string Ret;
+  if (Info.Line != 0)
+    Ret = convertToUnixPathSeparator(Info.FileName) + ":" +
+          std::to_string(Info.Line);
+
+  std::lock_guard<std::mutex> Lock(LineInfoMu);
+  return LineInfoCache.insert({Addr, Ret}).first->second;
+}
+
+// Returns the defined function symbol that encloses a given section
+// offset, if any. The per-section index is built on first use and
+// shared by every subsequent diagnostic against this file, so a flood
+// of errors does one symbol-table scan instead of one per error.
+template <class ELFT>
+DefinedRegular<ELFT> *
+elf::ObjectFile<ELFT>::getEnclosingFunction(InputSectionBase<ELFT> *S,
+                                            uintX_t Offset) {
+  std::call_once(FuncSymIndexInit, [this] {
+    for (SymbolBody *B : getSymbols())
+      if (auto *D = dyn_cast<DefinedRegular<ELFT>>(B))
+        if (D->Section && D->Type == STT_FUNC)
+          FuncSymIndex[D->Section].push_back(D);
+    for (auto &P : FuncSymIndex)
+      std::sort(P.second.begin(), P.second.end(),
+                [](DefinedRegular<ELFT> *A, DefinedRegular<ELFT> *B) {
+                  return A->Value < B->Value;
+                });
+  });
+
+  auto It = FuncSymIndex.find(S);
+  if (It == FuncSymIndex.end())
+    return nullptr;
+  std::vector<DefinedRegular<ELFT> *> &Syms = It->second;
+  auto I = std::upper_bound(Syms.begin(), Syms.end(), Offset,
+                            [](uintX_t Off, DefinedRegular<ELFT> *D) {
+                              return Off < D->Value;
+                            });
+  if (I == Syms.begin())
+    return nullptr;
+  DefinedRegular<ELFT> *D = *--I;
+  if (D->Value <= Offset && Offset < D->Value + D->Size)
+    return D;
+  return nullptr;
 }
 
 // Returns "(internal)", "foo.a(bar.o)" or "baz.o".
@@ -161,6 +218,36 @@ ArrayRef<SymbolBody *> elf::ObjectFile<ELFT>::getSymbols() {
   return makeArrayRef(this->SymbolBodies).slice(1);
 }
 
+// Reads the parts of an object file that do not depend on any other
+// file: the section header table, the section name string table and
+// the symbol table. This work is independent for each file, so the
+// driver calls this function for all inputs in parallel before
+// starting the order-dependent symbol resolution.
+template <class ELFT> void elf::ObjectFile<ELFT>::preParse() {
+  const ELFFile<ELFT> Obj = this->getObj();
+  ELFSections = check(Obj.sections());
+  SectionStringTable = check(Obj.getSectionStringTable(ELFSections));
+  for (const Elf_Shdr &Sec : ELFSections) {
+    if (Sec.sh_type == SHT_SYMTAB) {
+      this->initSymtab(ELFSections, &Sec);
+      break;
+    }
+  }
+
+  // Hash the comdat group signatures here as well. Template-heavy
+  // inputs carry hundreds of thousands of groups, and the string
+  // table lookups and hashing dominate the dedup work, so doing them
+  // in this parallel stage leaves only the set insertions to the
+  // serial resolution pass.
+  unsigned I = -1;
+  for (const Elf_Shdr &Sec : ELFSections) {
+    ++I;
+    if (Sec.sh_type == SHT_GROUP)
+      ComdatSignatures.push_back(std::make_pair(
+          I, CachedHashStringRef(getShtGroupSignature(ELFSections, Sec))));
+  }
+}
+
 template <class ELFT>
 void elf::ObjectFile<ELFT>::parse(DenseSet<CachedHashStringRef> &ComdatGroups) {
   // Read section and symbol tables.
@@ -250,12 +337,17 @@ bool elf::ObjectFile<ELFT>::shouldMerge(const Elf_Shdr &Sec) {
 template <class ELFT>
 void elf::ObjectFile<ELFT>::initializeSections(
     DenseSet<CachedHashStringRef> &ComdatGroups) {
-  ArrayRef<Elf_Shdr> ObjSections = check(this->getObj().sections());
+  // If the driver did not pre-parse this file, read the section and
+  // symbol tables now.
+  if (ELFSections.empty())
+    preParse();
+
+  ArrayRef<Elf_Shdr> ObjSections = ELFSections;
   const ELFFile<ELFT> &Obj = this->getObj();
   uint64_t Size = ObjSections.size();
   Sections.resize(Size);
+  size_t ComdatIdx = 0;
   unsigned I = -1;
-  StringRef SectionStringTable = check(Obj.getSectionStringTable(ObjSections));
   for (const Elf_Shdr &Sec : ObjSections) {
     ++I;
     if (Sections[I] == &InputSection<ELFT>::Discarded)
@@ -270,11 +362,20 @@ void elf::ObjectFile<ELFT>::initializeSections(
     }
 
     switch (Sec.sh_type) {
-    case SHT_GROUP:
+    case SHT_GROUP: {
       Sections[I] = &InputSection<ELFT>::Discarded;
-      if (ComdatGroups.insert(CachedHashStringRef(
-                                  getShtGroupSignature(ObjSections, Sec)))
-              .second)
+      // Signatures were looked up and hashed by preParse; find the
+      // entry for this section. Groups may themselves be discarded by
+      // an earlier group, so advance a cursor rather than counting.
+      while (ComdatIdx < ComdatSignatures.size() &&
+             ComdatSignatures[ComdatIdx].first < I)
+        ++ComdatIdx;
+      CachedHashStringRef Signature =
+          (ComdatIdx < ComdatSignatures.size() &&
+           ComdatSignatures[ComdatIdx].first == I)
+              ? ComdatSignatures[ComdatIdx].second
+              : CachedHashStringRef(getShtGroupSignature(ObjSections, Sec));
+      if (ComdatGroups.insert(Signature).second)
         continue;
       for (uint32_t SecIndex : getShtGroupEntries(Sec)) {
         if (SecIndex >= Size)
@@ -283,8 +384,10 @@ void elf::ObjectFile<ELFT>::initializeSections(
         Sections[SecIndex] = &InputSection<ELFT>::Discarded;
       }
       break;
+    }
     case SHT_SYMTAB:
-      this->initSymtab(ObjSections, &Sec);
+      if (this->Symbols.empty())
+        this->initSymtab(ObjSections, &Sec);
       break;
     case SHT_SYMTAB_SHNDX:
       this->SymtabSHNDX = check(Obj.getSHNDXTable(Sec, ObjSections));
@@ -404,6 +507,10 @@ elf::ObjectFile<ELFT>::createInputSection(const Elf_Shdr &Sec,
 }
 
 template <class ELFT> void elf::ObjectFile<ELFT>::initializeSymbols() {
+  // One contiguous block for all of this file's local symbol bodies;
+  // createSymbolBody places them into consecutive slots.
+  if (this->FirstNonLocal)
+    LocalBodies = BAlloc.Allocate<LocalBodySlot>(this->FirstNonLocal);
   SymbolBodies.reserve(this->Symbols.size());
   for (const Elf_Sym &Sym : this->Symbols)
     SymbolBodies.push_back(createSymbolBody(&Sym));
@@ -453,11 +560,11 @@ SymbolBody *elf::ObjectFile<ELFT>::createSymbolBody(const Elf_Sym *Sym) {
 
     StringRefZ Name = this->StringTable.data() + Sym->st_name;
     if (Sym->st_shndx == SHN_UNDEF)
-      return new (BAlloc)
+      return new (nextLocalSlot())
           Undefined(Name, /*IsLocal=*/true, StOther, Type, this);
 
-    return new (BAlloc) DefinedRegular<ELFT>(Name, /*IsLocal=*/true, StOther,
-                                             Type, Value, Size, Sec, this);
+    return new (nextLocalSlot()) DefinedRegular<ELFT>(
+        Name, /*IsLocal=*/true, StOther, Type, Value, Size, Sec, this);
   }
 
   StringRef Name = check(Sym->getName(this->StringTable));
@@ -494,10 +601,63 @@ SymbolBody *elf::ObjectFile<ELFT>::createSymbolBody(const Elf_Sym *Sym) {
   }
 }
 
-template <class ELFT> void ArchiveFile::parse() {
+void ArchiveFile::preParse() {
   File = check(Archive::create(MB),
                MB.getBufferIdentifier() + ": failed to parse archive");
 
+  // Resolve the member offsets the previous link extracted to their
+  // buffers. This only slices the archive's mapping, so it is safe in
+  // this parallel stage; the actual file creation goes through the
+  // arena and is left to the driver (createSpeculativeMembers). Thin
+  // archive members live in separate files addressed by path, not by
+  // offset, and are not speculated.
+  if (!Config->Incremental || File->isThin())
+    return;
+  Hash = xxHash64(MB.getBuffer());
+  Optional<std::vector<uint64_t>> Offsets = lookupArchiveMembers(Hash);
+  if (!Offsets)
+    return;
+  for (uint64_t Off : *Offsets) {
+    if (Off >= MB.getBufferSize())
+      continue;
+    Error Err = Error::success();
+    Archive::Child C(File.get(), MB.getBufferStart() + Off, &Err);
+    if (Err) {
+      consumeError(std::move(Err));
+      continue;
+    }
+    auto RetOrErr = C.getMemoryBufferRef();
+    if (!RetOrErr) {
+      consumeError(RetOrErr.takeError());
+      continue;
+    }
+    Predicted.push_back({*RetOrErr, Off});
+  }
+}
+
+// Creates the input files for the members predicted by preParse and
+// indexes them by offset so that the lazy-fetch path reuses them.
+// Called serially, because file creation allocates from the arena.
+void ArchiveFile::createSpeculativeMembers(std::vector<InputFile *> &Out) {
+  for (std::pair<MemoryBufferRef, uint64_t> &P : Predicted) {
+    InputFile *F = createObjectFile(P.first, getName(), P.second);
+    Speculated[P.second] = F;
+    Out.push_back(F);
+  }
+  Predicted.clear();
+}
+
+InputFile *ArchiveFile::createMemberFile(MemoryBufferRef MB, uint64_t Offset) {
+  auto It = Speculated.find(Offset);
+  if (It != Speculated.end())
+    return It->second;
+  return createObjectFile(MB, getName(), Offset);
+}
+
+template <class ELFT> void ArchiveFile::parse() {
+  if (!File)
+    preParse();
+
   // Read the symbol table to construct Lazy objects.
   for (const Archive::Symbol &Sym : File->symbols())
     Symtab<ELFT>::X->addLazyArchive(this, Sym);
@@ -513,6 +673,11 @@ ArchiveFile::getMember(const Archive::Symbol *Sym) {
   if (!Seen.insert(C.getChildOffset()).second)
     return {MemoryBufferRef(), 0};
 
+  // Remember the extraction so the next link of this output can
+  // speculate it. Hash is nonzero only when a history is being kept.
+  if (Hash)
+    addExtractedMember(Hash, C.getChildOffset());
+
   MemoryBufferRef Ret =
       check(C.getMemoryBufferRef(),
             "could not get the buffer for the member defining symbol " +
@@ -540,6 +705,10 @@ SharedFile<ELFT>::getSection(const Elf_Sym &Sym) const {
 // Partially parse the shared object file so that we can call
 // getSoName on this object.
 template <class ELFT> void SharedFile<ELFT>::parseSoName() {
+  if (SoNameParsed)
+    return;
+  SoNameParsed = true;
+
   const Elf_Shdr *DynamicSec = nullptr;
 
   const ELFFile<ELFT> Obj = this->getObj();
@@ -632,13 +801,20 @@ SharedFile<ELFT>::parseVerdefs(const Elf_Versym *&Versym) {
   return Verdefs;
 }
 
-// Fully parse the shared object file. This must be called after parseSoName().
-template <class ELFT> void SharedFile<ELFT>::parseRest() {
+// Reads the parts of a DSO that do not depend on any other file: the
+// soname, the dynamic symbol table and the version definitions. Like
+// ObjectFile::preParse, this is called for all inputs in parallel ahead
+// of symbol resolution; parseRest() then only inserts the precomputed
+// symbols into the symbol table.
+template <class ELFT> void SharedFile<ELFT>::preParse() {
+  parseSoName();
+
   // Create mapping from version identifiers to Elf_Verdef entries.
   const Elf_Versym *Versym = nullptr;
   std::vector<const Elf_Verdef *> Verdefs = parseVerdefs(Versym);
 
   Elf_Sym_Range Syms = this->getGlobalSymbols();
+  DynSyms.reserve(Syms.end() - Syms.begin());
   for (const Elf_Sym &Sym : Syms) {
     unsigned VersymIndex = 0;
     if (Versym) {
@@ -660,8 +836,51 @@ template <class ELFT> void SharedFile<ELFT>::parseRest() {
 
     const Elf_Verdef *V =
         VersymIndex == VER_NDX_GLOBAL ? nullptr : Verdefs[VersymIndex];
-    elf::Symtab<ELFT>::X->addShared(this, Name, Sym, V);
+    DynSyms.push_back({Name, &Sym, V});
   }
+  PreParsed = true;
+}
+
+// Fully parse the shared object file. This must be called after parseSoName().
+template <class ELFT> void SharedFile<ELFT>::parseRest() {
+  if (!PreParsed)
+    preParse();
+  for (const DynSym &S : DynSyms)
+    elf::Symtab<ELFT>::X->addShared(this, S.Name, *S.Sym, S.Verdef);
+}
+
+// A copy relocation has to interpose every alias of the copied symbol,
+// so the writer asks for all symbols at the same address. Against a
+// DSO like glibc with thousands of dynamic symbols that query is too
+// hot for a scan; the first call builds a value-sorted index and every
+// lookup after that is a binary search.
+template <class ELFT>
+ArrayRef<const typename ELFT::Sym *>
+SharedFile<ELFT>::getSymbolsAt(uintX_t Shndx, uintX_t Value) {
+  if (!SymbolsByValueBuilt) {
+    SymbolsByValueBuilt = true;
+    for (const Elf_Sym &S : this->getGlobalSymbols())
+      if (S.st_shndx != SHN_UNDEF)
+        SymbolsByValue.push_back(&S);
+    std::sort(SymbolsByValue.begin(), SymbolsByValue.end(),
+              [](const Elf_Sym *A, const Elf_Sym *B) {
+                return A->st_shndx != B->st_shndx ? A->st_shndx < B->st_shndx
+                                                  : A->st_value < B->st_value;
+              });
+  }
+
+  auto Begin = std::lower_bound(
+      SymbolsByValue.begin(), SymbolsByValue.end(), std::make_pair(Shndx, Value),
+      [](const Elf_Sym *S, std::pair<uintX_t, uintX_t> Key) {
+        return S->st_shndx != Key.first ? S->st_shndx < Key.first
+                                        : S->st_value < Key.second;
+      });
+  auto End = Begin;
+  while (End != SymbolsByValue.end() && (*End)->st_shndx == Shndx &&
+         (*End)->st_value == Value)
+    ++End;
+  return makeArrayRef(SymbolsByValue)
+      .slice(Begin - SymbolsByValue.begin(), End - Begin);
 }
 
 static ELFKind getBitcodeELFKind(MemoryBufferRef MB) {
@@ -757,9 +976,14 @@ static Symbol *createBitcodeSymbol(const std::vector<bool> &KeptComdats,
                                      CanOmitFromDynSym, F);
 }
 
-template <class ELFT>
-void BitcodeFile::parse(DenseSet<CachedHashStringRef> &ComdatGroups) {
-
+// Materializing LLVM's bitcode symbol table is by far the most
+// expensive part of reading a bitcode file and depends only on the
+// file itself, so like ObjectFile::preParse this is called for all
+// command-line inputs in parallel ahead of symbol resolution; parse()
+// then only selects comdats and resolves the symbols, serially and in
+// command-line order. Bitcode fetched from archives during resolution
+// has not been pre-parsed and takes the serial path in parse().
+void BitcodeFile::preParse() {
   // Here we pass a new MemoryBufferRef which is identified by ArchiveName
   // (the fully resolved path of the archive) + member name + offset of the
   // member in the archive.
@@ -767,10 +991,19 @@ void BitcodeFile::parse(DenseSet<CachedHashStringRef> &ComdatGroups) {
   // data structures and if two archives define two members with the same name,
   // this causes a collision which result in only one of the objects being
   // taken into consideration at LTO time (which very likely causes undefined
-  // symbols later in the link stage).
-  Obj = check(lto::InputFile::create(MemoryBufferRef(
-      MB.getBuffer(), Saver.save(ArchiveName + MB.getBufferIdentifier() +
-                                 utostr(OffsetInArchive)))));
+  // symbols later in the link stage). The identifier is kept in a
+  // member instead of the string arena because the arena is not
+  // thread-safe.
+  LTOName = (ArchiveName + MB.getBufferIdentifier() +
+             Twine(OffsetInArchive)).str();
+  Obj = check(lto::InputFile::create(MemoryBufferRef(MB.getBuffer(),
+                                                     LTOName)));
+}
+
+template <class ELFT>
+void BitcodeFile::parse(DenseSet<CachedHashStringRef> &ComdatGroups) {
+  if (!Obj)
+    preParse();
 
   std::vector<bool> KeptComdats;
   for (StringRef S : Obj->getComdatTable()) {
@@ -839,6 +1072,81 @@ template <class ELFT> void BinaryFile::parse() {
                                    nullptr);
 }
 
+// Returns the page-aligned interior of the buffer to the OS. Clean
+// file-backed pages are simply dropped and fault back in from the
+// file if a later pass -- such as the string table writer reading
+// symbol names -- still touches them. Partial pages at either end are
+// kept: archive members are slices of the archive's mapping and may
+// share their boundary pages with a sibling member.
+static void releaseBuffer(MemoryBufferRef MB) {
+#if defined(__linux__)
+  uintptr_t PageMask = sys::Process::getPageSize() - 1;
+  uintptr_t Begin =
+      (reinterpret_cast<uintptr_t>(MB.getBufferStart()) + PageMask) &
+      ~PageMask;
+  uintptr_t End = reinterpret_cast<uintptr_t>(MB.getBufferEnd()) & ~PageMask;
+  if (End > Begin)
+    (void)::madvise(reinterpret_cast<void *>(Begin), End - Begin,
+                    MADV_DONTNEED);
+#else
+  (void)MB;
+#endif
+}
+
+void InputFile::sectionCopied() {
+  // The plain load first keeps untracked files (and files whose last
+  // section has already retired) from wrapping the counter around.
+  if (PendingSections.load(std::memory_order_relaxed) == 0)
+    return;
+  if (PendingSections.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    releaseBuffer(MB);
+}
+
+bool elf::isBufferFileBacked(MemoryBufferRef MB) {
+#if defined(__linux__)
+  // Snapshot the file-backed mappings of the process on first use;
+  // every input has been opened by the time the writer asks. Lines of
+  // /proc/self/maps look like
+  // "<begin>-<end> <perms> <offset> <dev> <inode> <path>", and a
+  // nonzero inode means the range is backed by a file.
+  static std::vector<std::pair<uintptr_t, uintptr_t>> Ranges = [] {
+    std::vector<std::pair<uintptr_t, uintptr_t>> V;
+    auto MBOrErr = MemoryBuffer::getFileAsStream("/proc/self/maps");
+    if (!MBOrErr)
+      return V;
+    SmallVector<StringRef, 0> Lines;
+    (*MBOrErr)->getBuffer().split(Lines, '\n');
+    for (StringRef Line : Lines) {
+      StringRef Range, Field;
+      std::tie(Range, Line) = Line.split(' ');
+      StringRef BeginStr, EndStr;
+      std::tie(BeginStr, EndStr) = Range.split('-');
+      uintptr_t Begin, End;
+      if (BeginStr.getAsInteger(16, Begin) || EndStr.getAsInteger(16, End))
+        continue;
+      // Skip the permissions, offset and device fields.
+      for (int I = 0; I < 3; ++I)
+        std::tie(Field, Line) = Line.split(' ');
+      uint64_t Inode;
+      std::tie(Field, Line) = Line.split(' ');
+      if (!Field.getAsInteger(10, Inode) && Inode != 0)
+        V.push_back({Begin, End});
+    }
+    return V;
+  }();
+
+  uintptr_t Begin = reinterpret_cast<uintptr_t>(MB.getBufferStart());
+  uintptr_t End = reinterpret_cast<uintptr_t>(MB.getBufferEnd());
+  for (std::pair<uintptr_t, uintptr_t> R : Ranges)
+    if (R.first <= Begin && End <= R.second)
+      return true;
+  return false;
+#else
+  (void)MB;
+  return false;
+#endif
+}
+
 static bool isBitcode(MemoryBufferRef MB) {
   using namespace sys::fs;
   return identify_magic(MB.getBuffer()) == file_magic::bitcode;
@@ -864,8 +1172,25 @@ MemoryBufferRef LazyObjectFile::getBuffer() {
   return MB;
 }
 
+// Extracts the defined symbol names ahead of time. This is called from
+// the driver's parallel pre-parse loop: extraction only reads the
+// file's own symbol table, so all lazy objects can be scanned at once
+// while symbol resolution stays serial. Bitcode files are skipped here
+// because their extraction interns names through the shared Saver,
+// which is not thread-safe; they are handled lazily in parse().
+void LazyObjectFile::preParse() {
+  if (isBitcode(this->MB))
+    return;
+  SymbolNames = getSymbols();
+  Extracted = true;
+}
+
 template <class ELFT> void LazyObjectFile::parse() {
-  for (StringRef Sym : getSymbols())
+  if (!Extracted) {
+    SymbolNames = getSymbols();
+    Extracted = true;
+  }
+  for (StringRef Sym : SymbolNames)
     Symtab<ELFT>::X->addLazyObject(Sym, *this);
 }
 
@@ -892,11 +1217,18 @@ template <class ELFT> std::vector<StringRef> LazyObjectFile::getElfSymbols() {
 }
 
 std::vector<StringRef> LazyObjectFile::getBitcodeSymbols() {
+  // With --incremental a previous run may have recorded this file's
+  // names, validated by content hash, which saves constructing an
+  // lto::InputFile just to enumerate them.
+  if (Optional<std::vector<StringRef>> V = lookupBitcodeSymbols(this->MB))
+    return std::move(*V);
+
   std::unique_ptr<lto::InputFile> Obj = check(lto::InputFile::create(this->MB));
   std::vector<StringRef> V;
   for (const lto::InputFile::Symbol &Sym : Obj->symbols())
     if (!(Sym.getFlags() & BasicSymbolRef::SF_Undefined))
       V.push_back(Saver.save(Sym.getName()));
+  addBitcodeSymbols(this->MB, V);
   return V;
 }
 
@@ -25,7 +25,9 @@
 #include "llvm/Object/ELF.h"
 #include "llvm/Object/IRObjectFile.h"
 
+#include <atomic>
 #include <map>
+#include <mutex>
 
 namespace llvm {
 class DWARFDebugLine;
@@ -77,6 +79,18 @@ public:
   uint16_t EMachine = llvm::ELF::EM_NONE;
   uint8_t OSABI = 0;
 
+  // Number of copy tasks that still read this file's buffer. The
+  // writer primes this before the copy phase for files whose buffer
+  // is a file-backed mapping (see Writer::writeSections), so that
+  // when the parallel copy retires the file's last section the
+  // buffer's pages can be returned to the OS instead of staying
+  // resident next to the whole output. Zero means untracked.
+  std::atomic<uint32_t> PendingSections{0};
+
+  // Called by the section copy code after one section of this file
+  // has been copied to the output.
+  void sectionCopied();
+
 protected:
   InputFile(Kind K, MemoryBufferRef M) : MB(M), FileKind(K) {}
 
@@ -143,6 +157,7 @@ public:
   ArrayRef<SymbolBody *> getNonLocalSymbols();
 
   explicit ObjectFile(MemoryBufferRef M);
+  void preParse();
   void parse(llvm::DenseSet<llvm::CachedHashStringRef> &ComdatGroups);
 
   ArrayRef<InputSectionBase<ELFT> *> getSections() const { return Sections; }
@@ -164,6 +179,12 @@ public:
   // If no information is available, returns "".
   std::string getLineInfo(InputSectionBase<ELFT> *S, uintX_t Offset);
 
+  // Returns the function symbol enclosing the given section offset,
+  // or null. Used as a fallback for diagnostic locations when there
+  // is no line information.
+  DefinedRegular<ELFT> *getEnclosingFunction(InputSectionBase<ELFT> *S,
+                                             uintX_t Offset);
+
   // MIPS GP0 value defined by this file. This value represents the gp value
   // used to create the relocatable object and required to support
   // R_MIPS_GPREL16 / R_MIPS_GPREL32 relocations.
@@ -190,6 +211,33 @@ private:
   bool shouldMerge(const Elf_Shdr &Sec);
   SymbolBody *createSymbolBody(const Elf_Sym *Sym);
 
+  // Local symbol bodies are not in the symbol table, so they are owned
+  // by this file. They are placement-new'ed into one contiguous array
+  // instead of allocated one by one: the resolution and output-symtab
+  // loops walk them in index order, and with individual allocations
+  // every field access was a cache miss to a scattered heap location.
+  typedef llvm::AlignedCharArrayUnion<DefinedRegular<ELFT>, Undefined>
+      LocalBodySlot;
+  LocalBodySlot *LocalBodies = nullptr;
+  size_t NumLocalBodies = 0;
+
+  void *nextLocalSlot() {
+    if (NumLocalBodies == this->FirstNonLocal)
+      fatal(toString(this) + ": invalid sh_info in symbol table");
+    return &LocalBodies[NumLocalBodies++];
+  }
+
+  // Section header table and section name string table. They are read
+  // ahead of time by preParse() so that the per-file part of parsing
+  // can run in parallel for all inputs.
+  ArrayRef<Elf_Shdr> ELFSections;
+  StringRef SectionStringTable;
+
+  // Signatures of this file's comdat groups with their hashes, keyed
+  // by section index. They are computed by preParse() so that the
+  // serial resolution pass only has to do the dedup-set insertions.
+  std::vector<std::pair<unsigned, llvm::CachedHashStringRef>> ComdatSignatures;
+
   // List of all sections defined by this file.
   std::vector<InputSectionBase<ELFT> *> Sections;
 
@@ -199,8 +247,22 @@ private:
   // Debugging information to retrieve source file and line for error
   // reporting. Linker may find reasonable number of errors in a
   // single object file, so we cache debugging information in order to
-  // parse it only once for each object file we link.
+  // parse it only once for each object file we link. The once-flag
+  // makes the lazy parse safe when diagnostics are raised from the
+  // parallel relocation pass, and resolved locations are memoized so
+  // an error flood against one file pays for each address only once.
   std::unique_ptr<llvm::DWARFDebugLine> DwarfLine;
+  std::once_flag DwarfLineInit;
+  llvm::DenseMap<uint64_t, std::string> LineInfoCache;
+  std::mutex LineInfoMu;
+
+  // Per-section index of function symbols sorted by value, built once
+  // on the first diagnostic that needs it. Without it every location
+  // fallback scanned the whole symbol table.
+  llvm::DenseMap<InputSectionBase<ELFT> *,
+                 std::vector<DefinedRegular<ELFT> *>>
+      FuncSymIndex;
+  std::once_flag FuncSymIndexInit;
 };
 
 // LazyObjectFile is analogous to ArchiveFile in the sense that
@@ -219,6 +281,7 @@ public:
   }
 
   template <class ELFT> void parse();
+  void preParse();
   MemoryBufferRef getBuffer();
 
 private:
@@ -226,6 +289,8 @@ private:
   template <class ELFT> std::vector<StringRef> getElfSymbols();
   std::vector<StringRef> getBitcodeSymbols();
 
+  std::vector<StringRef> SymbolNames;
+  bool Extracted = false;
   bool Seen = false;
 };
 
@@ -234,6 +299,12 @@ class ArchiveFile : public InputFile {
 public:
   explicit ArchiveFile(MemoryBufferRef M) : InputFile(ArchiveKind, M) {}
   static bool classof(const InputFile *F) { return F->kind() == ArchiveKind; }
+
+  // Parses the archive headers and the symbol index. This depends only
+  // on the file contents, so it can run in parallel for all archives
+  // before the serial symbol resolution in parse() needs the result.
+  void preParse();
+
   template <class ELFT> void parse();
 
   // Returns a memory buffer for a given symbol and the offset in the archive
@@ -242,9 +313,28 @@ public:
   // (So that we don't instantiate same members more than once.)
   std::pair<MemoryBufferRef, uint64_t> getMember(const Archive::Symbol *Sym);
 
+  // Speculative member pre-parse, driven by the member history the
+  // previous link recorded (--incremental). preParse() resolves the
+  // predicted offsets to member buffers; the driver then creates the
+  // files with createSpeculativeMembers and pre-parses them ahead of
+  // symbol resolution. The lazy-fetch path picks them up through
+  // createMemberFile; a mispredicted member is simply never fetched.
+  void createSpeculativeMembers(std::vector<InputFile *> &Out);
+
+  // Returns the file for the member at Offset, reusing the
+  // speculatively pre-parsed one if the history predicted it.
+  InputFile *createMemberFile(MemoryBufferRef MB, uint64_t Offset);
+
 private:
   std::unique_ptr<Archive> File;
   llvm::DenseSet<uint64_t> Seen;
+
+  // Content hash of the archive, keying its member history. Zero for
+  // thin archives and links without --incremental, which record no
+  // history.
+  uint64_t Hash = 0;
+  std::vector<std::pair<MemoryBufferRef, uint64_t>> Predicted;
+  llvm::DenseMap<uint64_t, InputFile *> Speculated;
 };
 
 class BitcodeFile : public InputFile {
@@ -253,10 +343,14 @@ public:
   static bool classof(const InputFile *F) { return F->kind() == BitcodeKind; }
   template <class ELFT>
   void parse(llvm::DenseSet<llvm::CachedHashStringRef> &ComdatGroups);
+  void preParse();
   ArrayRef<Symbol *> getSymbols() { return Symbols; }
   std::unique_ptr<llvm::lto::InputFile> Obj;
 
 private:
+  // The buffer identifier handed to the LTO library, composed by
+  // preParse(); it must outlive Obj.
+  std::string LTOName;
   std::vector<Symbol *> Symbols;
 };
 
@@ -277,17 +371,40 @@ template <class ELFT> class SharedFile : public ELFFileBase<ELFT> {
   const Elf_Shdr *VersymSec = nullptr;
   const Elf_Shdr *VerdefSec = nullptr;
 
+  // Precomputed by preParse(): the name, symbol and version definition
+  // of every defined default-version dynamic symbol, so that parseRest()
+  // only has to do the symbol table insertions.
+  struct DynSym {
+    StringRef Name;
+    const Elf_Sym *Sym;
+    const Elf_Verdef *Verdef;
+  };
+  std::vector<DynSym> DynSyms;
+  bool SoNameParsed = false;
+  bool PreParsed = false;
+
+  // Lazily built by getSymbolsAt(): the defined dynamic symbols sorted
+  // by (section, value), so that alias lookups for copy relocations
+  // are a binary search instead of a scan of the whole symbol table.
+  std::vector<const Elf_Sym *> SymbolsByValue;
+  bool SymbolsByValueBuilt = false;
+
 public:
   StringRef getSoName() const { return SoName; }
   const Elf_Shdr *getSection(const Elf_Sym &Sym) const;
   llvm::ArrayRef<StringRef> getUndefinedSymbols() { return Undefs; }
 
+  // Returns the defined dynamic symbols located at the given section
+  // and value, i.e. the aliases a copy relocation has to interpose.
+  llvm::ArrayRef<const Elf_Sym *> getSymbolsAt(uintX_t Shndx, uintX_t Value);
+
   static bool classof(const InputFile *F) {
     return F->kind() == Base::SharedKind;
   }
 
   explicit SharedFile(MemoryBufferRef M);
 
+  void preParse();
   void parseSoName();
   void parseRest();
   std::vector<const Elf_Verdef *> parseVerdefs(const Elf_Versym *&Versym);
@@ -325,6 +442,12 @@ InputFile *createObjectFile(MemoryBufferRef MB, StringRef ArchiveName = "",
                             uint64_t OffsetInArchive = 0);
 InputFile *createSharedFile(MemoryBufferRef MB);
 
+// Returns true if the buffer lies entirely within file-backed memory
+// mappings of this process, i.e. its pages can be dropped and faulted
+// back in from the file. False on non-Linux hosts and for buffers that
+// were read into heap memory, whose contents dropping would destroy.
+bool isBufferFileBacked(MemoryBufferRef MB);
+
 } // namespace elf
 } // namespace lld
 
@@ -32,6 +32,18 @@ using namespace llvm::support::endian;
 using namespace lld;
 using namespace lld::elf;
 
+// Doubles the capacity of a relocation list that was not handed an
+// arena slice up front. The arena never frees, so the abandoned old
+// storage is a small, bounded waste: only synthetic sections take
+// this path and their lists are short.
+void elf::RelocationList::grow() {
+  uint32_t NewCap = Cap ? Cap * 2 : 4;
+  Relocation *New = BAlloc.Allocate<Relocation>(NewCap);
+  std::copy(Recs, Recs + Size, New);
+  Recs = New;
+  Cap = NewCap;
+}
+
 // Returns a string to construct an error message.
 template <class ELFT>
 std::string elf::toString(const InputSectionBase<ELFT> *Sec) {
@@ -106,6 +118,8 @@ template <class ELFT> size_t InputSectionBase<ELFT>::getSize() const {
     if (D->getThunksSize() > 0)
       return D->getThunkOff() + D->getThunksSize();
 
+  if (UncompressedSize != (uint64_t)-1)
+    return UncompressedSize;
   return Data.size();
 }
 
@@ -167,25 +181,30 @@ InputSectionBase<ELFT>::getRawCompressedData(ArrayRef<uint8_t> Data) {
   return {Data.slice(sizeof(*Hdr)), read64be(Hdr->Size)};
 }
 
-// Uncompress section contents. Note that this function is called
-// from parallel_for_each, so it must be thread-safe.
-template <class ELFT> void InputSectionBase<ELFT>::uncompress() {
+// Returns the compressed payload of this section and its size when
+// uncompressed. Ideally, all compressed sections have SHF_COMPRESSED
+// bit and their contents start with headers of Elf_Chdr type. However,
+// sections whose names start with ".zdebug_" don't have the bit and
+// contains a raw ZLIB-compressed data (which is a bad thing because
+// section names shouldn't be significant in ELF.) We need to be able
+// to read both.
+template <class ELFT>
+std::pair<ArrayRef<uint8_t>, uint64_t>
+InputSectionBase<ELFT>::getCompressedData() {
   if (!zlib::isAvailable())
     fatal(toString(this) +
           ": build lld with zlib to enable compressed sections support");
+  if (Flags & SHF_COMPRESSED)
+    return getElfCompressedData(Data);
+  return getRawCompressedData(Data);
+}
 
-  // This section is compressed. Here we decompress it. Ideally, all
-  // compressed sections have SHF_COMPRESSED bit and their contents
-  // start with headers of Elf_Chdr type. However, sections whose
-  // names start with ".zdebug_" don't have the bit and contains a raw
-  // ZLIB-compressed data (which is a bad thing because section names
-  // shouldn't be significant in ELF.) We need to be able to read both.
+// Uncompress section contents. Note that this function is called
+// from parallel_for_each, so it must be thread-safe.
+template <class ELFT> void InputSectionBase<ELFT>::uncompress() {
   ArrayRef<uint8_t> Buf; // Compressed data
   size_t Size;           // Uncompressed size
-  if (Flags & SHF_COMPRESSED)
-    std::tie(Buf, Size) = getElfCompressedData(Data);
-  else
-    std::tie(Buf, Size) = getRawCompressedData(Data);
+  std::tie(Buf, Size) = getCompressedData();
 
   // Uncompress Buf.
   char *OutputBuf;
@@ -199,6 +218,19 @@ template <class ELFT> void InputSectionBase<ELFT>::uncompress() {
   Data = ArrayRef<uint8_t>((uint8_t *)OutputBuf, Size);
 }
 
+template <class ELFT> void InputSectionBase<ELFT>::deferUncompress() {
+  UncompressedSize = getCompressedData().second;
+}
+
+template <class ELFT>
+void InputSectionBase<ELFT>::uncompressInto(uint8_t *Out) {
+  ArrayRef<uint8_t> Buf; // Compressed data
+  size_t Size;           // Uncompressed size
+  std::tie(Buf, Size) = getCompressedData();
+  if (zlib::uncompress(toStringRef(Buf), (char *)Out, Size) != zlib::StatusOK)
+    fatal(toString(this) + ": error while uncompressing section");
+}
+
 template <class ELFT>
 typename ELFT::uint
 InputSectionBase<ELFT>::getOffset(const DefinedRegular<ELFT> &Sym) const {
@@ -227,11 +259,8 @@ std::string InputSectionBase<ELFT>::getLocation(typename ELFT::uint Offset) {
     SrcFile = toString(File);
 
   // Find a function symbol that encloses a given location.
-  for (SymbolBody *B : File->getSymbols())
-    if (auto *D = dyn_cast<DefinedRegular<ELFT>>(B))
-      if (D->Section == this && D->Type == STT_FUNC)
-        if (D->Value <= Offset && Offset < D->Value + D->Size)
-          return SrcFile + ":(function " + toString(*D) + ")";
+  if (DefinedRegular<ELFT> *D = File->getEnclosingFunction(this, Offset))
+    return SrcFile + ":(function " + toString(*D) + ")";
 
   // If there's no symbol, print out the offset in the section.
   return (SrcFile + ":(" + Name + "+0x" + utohexstr(Offset) + ")").str();
@@ -287,18 +316,29 @@ template <class ELFT>
 template <class RelTy>
 void InputSection<ELFT>::copyRelocations(uint8_t *Buf, ArrayRef<RelTy> Rels) {
   InputSectionBase<ELFT> *RelocatedSection = getRelocatedSection();
+  bool IsMips64EL = Config->Mips64EL;
+  bool IsRela = Config->Rela;
+
+  // Relocations almost always apply to a regular section, for which
+  // the input-to-output offset translation is a constant add. Resolve
+  // the section kind once here so the loop below does not redo the
+  // dispatch in getOffset for every relocation.
+  bool IsRegular = RelocatedSection->kind() == InputSectionData::Regular;
+  uintX_t RegularDelta =
+      IsRegular ? cast<InputSection<ELFT>>(RelocatedSection)->OutSecOff : 0;
 
   for (const RelTy &Rel : Rels) {
-    uint32_t Type = Rel.getType(Config->Mips64EL);
+    uint32_t Type = Rel.getType(IsMips64EL);
     SymbolBody &Body = this->File->getRelocTargetSym(Rel);
 
     Elf_Rela *P = reinterpret_cast<Elf_Rela *>(Buf);
     Buf += sizeof(RelTy);
 
-    if (Config->Rela)
+    if (IsRela)
       P->r_addend = getAddend<ELFT>(Rel);
-    P->r_offset = RelocatedSection->getOffset(Rel.r_offset);
-    P->setSymbolAndType(Body.DynsymIndex, Type, Config->Mips64EL);
+    P->r_offset = IsRegular ? RegularDelta + Rel.r_offset
+                            : RelocatedSection->getOffset(Rel.r_offset);
+    P->setSymbolAndType(Body.DynsymIndex, Type, IsMips64EL);
   }
 }
 
@@ -512,13 +552,28 @@ static typename ELFT::uint getSymVA(uint32_t Type, typename ELFT::uint A,
 template <class ELFT>
 template <class RelTy>
 void InputSection<ELFT>::relocateNonAlloc(uint8_t *Buf, ArrayRef<RelTy> Rels) {
+  // For REL-style relocations the addend lives in the section contents
+  // we just copied. Read them all in one pass up front: the reads then
+  // stream through the freshly-copied bytes while they are still in
+  // cache instead of alternating with the stores of the apply loop.
+  std::vector<uintX_t> ImplicitAddends;
+  if (!RelTy::IsRela) {
+    ImplicitAddends.reserve(Rels.size());
+    for (const RelTy &Rel : Rels)
+      ImplicitAddends.push_back(
+          Target->getImplicitAddend(Buf + this->getOffset(Rel.r_offset),
+                                    Rel.getType(Config->Mips64EL)));
+  }
+
+  size_t I = 0;
   for (const RelTy &Rel : Rels) {
     uint32_t Type = Rel.getType(Config->Mips64EL);
     uintX_t Offset = this->getOffset(Rel.r_offset);
     uint8_t *BufLoc = Buf + Offset;
     uintX_t Addend = getAddend<ELFT>(Rel);
     if (!RelTy::IsRela)
-      Addend += Target->getImplicitAddend(BufLoc, Type);
+      Addend += ImplicitAddends[I];
+    ++I;
 
     SymbolBody &Sym = this->File->getRelocTargetSym(Rel);
     if (Target->getRelExpr(Type, Sym) != R_ABS) {
@@ -535,6 +590,28 @@ void InputSection<ELFT>::relocateNonAlloc(uint8_t *Buf, ArrayRef<RelTy> Rels) {
   }
 }
 
+// Returns true for the relocation expressions that need more than a
+// plain Target->relocateOne() call to apply: instruction relaxation and
+// the PPC64 nop-after-call patch.
+static bool needsSpecialApply(RelExpr Expr) {
+  switch (Expr) {
+  case R_RELAX_GOT_PC:
+  case R_RELAX_GOT_PC_NOPIC:
+  case R_RELAX_TLS_IE_TO_LE:
+  case R_RELAX_TLS_LD_TO_LE:
+  case R_RELAX_TLS_GD_TO_LE:
+  case R_RELAX_TLS_GD_TO_LE_NEG:
+  case R_RELAX_TLS_GD_TO_IE:
+  case R_RELAX_TLS_GD_TO_IE_ABS:
+  case R_RELAX_TLS_GD_TO_IE_PAGE_PC:
+  case R_RELAX_TLS_GD_TO_IE_END:
+  case R_PPC_PLT_OPD:
+    return true;
+  default:
+    return false;
+  }
+}
+
 template <class ELFT>
 void InputSectionBase<ELFT>::relocate(uint8_t *Buf, uint8_t *BufEnd) {
   // scanReloc function in Writer.cpp constructs Relocations
@@ -550,6 +627,30 @@ void InputSectionBase<ELFT>::relocate(uint8_t *Buf, uint8_t *BufEnd) {
   }
 
   const unsigned Bits = sizeof(uintX_t) * 8;
+
+  // Almost all sections contain only relocations that go straight to
+  // relocateOne; the relaxation and PPC64 cases are rare. Classify the
+  // section once so the common case runs as a tight loop with no
+  // per-relocation expression dispatch.
+  bool AllPlain = true;
+  for (const Relocation &Rel : Relocations) {
+    if (needsSpecialApply(Rel.Expr)) {
+      AllPlain = false;
+      break;
+    }
+  }
+  if (AllPlain) {
+    for (const Relocation &Rel : Relocations) {
+      uintX_t Offset = getOffset(Rel.Offset);
+      uint8_t *BufLoc = Buf + Offset;
+      uintX_t AddrLoc = OutSec->Addr + Offset;
+      uint64_t SymVA = SignExtend64<Bits>(
+          getSymVA<ELFT>(Rel.Type, Rel.Addend, AddrLoc, *Rel.Sym, Rel.Expr));
+      Target->relocateOne(BufLoc, Rel.Type, SymVA);
+    }
+    return;
+  }
+
   for (const Relocation &Rel : Relocations) {
     uintX_t Offset = getOffset(Rel.Offset);
     uint8_t *BufLoc = Buf + Offset;
@@ -614,11 +715,19 @@ template <class ELFT> void InputSection<ELFT>::writeTo(uint8_t *Buf) {
   }
 
   // Copy section contents from source object file to output file.
-  ArrayRef<uint8_t> Data = this->Data;
-  memcpy(Buf + OutSecOff, Data.data(), Data.size());
+  // If decompression of a compressed section was deferred to this
+  // point, inflate it directly into the output mapping instead of
+  // going through a temporary buffer.
+  size_t Size = this->Data.size();
+  if (this->UncompressedSize != (uint64_t)-1) {
+    Size = this->UncompressedSize;
+    this->uncompressInto(Buf + OutSecOff);
+  } else {
+    memcpy(Buf + OutSecOff, this->Data.data(), Size);
+  }
 
   // Iterate over all relocation sections that apply to this section.
-  uint8_t *BufEnd = Buf + OutSecOff + Data.size();
+  uint8_t *BufEnd = Buf + OutSecOff + Size;
   this->relocate(Buf, BufEnd);
 
   // The section might have a data/code generated by the linker and need
@@ -633,6 +742,11 @@ template <class ELFT> void InputSection<ELFT>::writeTo(uint8_t *Buf) {
       Buf += T->size();
     }
   }
+
+  // This may have been the last copy task reading this file's buffer,
+  // in which case its pages can be returned to the OS.
+  if (elf::ObjectFile<ELFT> *File = this->getFile())
+    File->sectionCopied();
 }
 
 template <class ELFT>
@@ -775,6 +889,14 @@ template <class ELFT> void MergeInputSection<ELFT>::splitIntoPieces() {
   else
     splitNonStrings(Data, EntSize);
 
+  // Build the offset-to-piece index here rather than lazily at the
+  // first getOffset call: this function runs for all merge sections in
+  // parallel, while a lazy build would serialize the hot relocation
+  // threads on a once-flag.
+  OffsetMap.reserve(Pieces.size());
+  for (size_t I = 0, E = Pieces.size(); I != E; ++I)
+    OffsetMap[Pieces[I].InputOff] = I;
+
   if (Config->GcSections && (this->Flags & SHF_ALLOC))
     for (uintX_t Off : LiveOffsets)
       this->getSectionPiece(Off)->Live = true;
@@ -825,17 +947,10 @@ MergeInputSection<ELFT>::getSectionPiece(uintX_t Offset) const {
 // it is not just an addition to a base output offset.
 template <class ELFT>
 typename ELFT::uint MergeInputSection<ELFT>::getOffset(uintX_t Offset) const {
-  // Initialize OffsetMap lazily.
-  std::call_once(InitOffsetMap, [&] {
-    OffsetMap.reserve(Pieces.size());
-    for (const SectionPiece &Piece : Pieces)
-      OffsetMap[Piece.InputOff] = Piece.OutputOff;
-  });
-
   // Find a string starting at a given offset.
   auto It = OffsetMap.find(Offset);
   if (It != OffsetMap.end())
-    return It->second;
+    return Pieces[It->second].OutputOff;
 
   if (!this->Live)
     return 0;
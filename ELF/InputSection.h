@@ -17,7 +17,6 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Object/ELF.h"
-#include <mutex>
 
 namespace lld {
 namespace elf {
@@ -26,6 +25,43 @@ class DefinedCommon;
 class SymbolBody;
 struct SectionPiece;
 
+// Storage for the relocation records a section will apply when it is
+// written out. The relocation scan gives every scanned section a
+// fixed-capacity slice of one large arena slab up front, so records
+// are contiguous, appended without reallocation, and walked by the
+// writer in application order. Sections that were not pre-sized --
+// synthetic sections create records during finalization -- grow by
+// doubling into the arena instead. Records are only ever appended
+// from serial code (the arena is not thread-safe).
+class RelocationList {
+public:
+  void push_back(const Relocation &R) {
+    if (Size == Cap)
+      grow();
+    Recs[Size++] = R;
+  }
+
+  const Relocation *begin() const { return Recs; }
+  const Relocation *end() const { return Recs + Size; }
+  size_t size() const { return Size; }
+  bool empty() const { return Size == 0; }
+
+  // Points this list at an uninitialized arena slice with room for C
+  // records. Called at most once, before anything is appended.
+  void reserveSlice(Relocation *Slice, uint32_t C) {
+    assert(!Recs && "relocation list already has storage");
+    Recs = Slice;
+    Cap = C;
+  }
+
+private:
+  void grow();
+
+  Relocation *Recs = nullptr;
+  uint32_t Size = 0;
+  uint32_t Cap = 0;
+};
+
 template <class ELFT> class DefinedRegular;
 template <class ELFT> class ObjectFile;
 template <class ELFT> class OutputSection;
@@ -67,7 +103,7 @@ public:
     return llvm::makeArrayRef<T>((const T *)Data.data(), S / sizeof(T));
   }
 
-  std::vector<Relocation> Relocations;
+  RelocationList Relocations;
 };
 
 // This corresponds to a section of an input file.
@@ -121,6 +157,13 @@ public:
                               NumRelocations);
   }
 
+  // Targets of this section's relocations, one entry per relocation,
+  // resolved once after symbol resolution (see buildRelocTargetIndex).
+  // Garbage collection, ICF, the thunk scan and the relocation scan
+  // all iterate every relocation; sharing one resolved index pays the
+  // per-edge symbol lookup once instead of once per pass.
+  SymbolBody **RelocTargets = nullptr;
+
   // This pointer points to the "real" instance of this instance.
   // Usually Repl == this. However, if ICF merges two sections,
   // Repl pointer of one section points to another section. So,
@@ -141,12 +184,28 @@ public:
 
   void uncompress();
 
+  // Records the decompressed size of this section without actually
+  // decompressing it. Layout can then proceed as usual and writeTo
+  // inflates the contents straight into the output file mapping,
+  // which avoids keeping a whole decompressed copy in memory.
+  void deferUncompress();
+
+  // Like uncompress, but inflates the contents into Out, which must
+  // have room for UncompressedSize bytes.
+  void uncompressInto(uint8_t *Out);
+
+  // The size of the decompressed contents if decompression was
+  // deferred by deferUncompress, or -1 otherwise.
+  uint64_t UncompressedSize = -1;
+
   // Returns a source location string. Used to construct an error message.
   std::string getLocation(uintX_t Offset);
 
   void relocate(uint8_t *Buf, uint8_t *BufEnd);
 
 private:
+  std::pair<ArrayRef<uint8_t>, uint64_t> getCompressedData();
+
   std::pair<ArrayRef<uint8_t>, uint64_t>
   getElfCompressedData(ArrayRef<uint8_t> Data);
 
@@ -220,8 +279,10 @@ private:
 
   std::vector<uint32_t> Hashes;
 
-  mutable llvm::DenseMap<uintX_t, uintX_t> OffsetMap;
-  mutable std::once_flag InitOffsetMap;
+  // Maps the input offset of each piece to its index in Pieces. Built
+  // by splitIntoPieces() so that getOffset() is a single hash lookup;
+  // the split stage already runs for all merge sections in parallel.
+  llvm::DenseMap<uintX_t, uint32_t> OffsetMap;
 
   llvm::DenseSet<uintX_t> LiveOffsets;
 };
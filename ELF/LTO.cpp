@@ -18,6 +18,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/LTO/Config.h"
 #include "llvm/LTO/LTO.h"
 #include "llvm/Object/SymbolicFile.h"
@@ -27,6 +28,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cstddef>
 #include <memory>
@@ -86,8 +88,16 @@ static std::unique_ptr<lto::LTO> createLTO() {
                                  /*UseInputModulePath*/ true));
 
   lto::ThinBackend Backend;
-  if (Config->ThinLTOJobs != -1u)
+  if (Config->ThinLTOIndexOnly) {
+    // Instead of running the backends in this process, write each
+    // module's summary index (and optionally its import list) next to
+    // the module so the backend compiles can run elsewhere.
+    Backend = lto::createWriteIndexesThinBackend(
+        Config->ThinLTOPrefixReplaceOld, Config->ThinLTOPrefixReplaceNew,
+        Config->ThinLTOEmitImportsFiles, Config->ThinLTOIndexOnlyObjectsFile);
+  } else if (Config->ThinLTOJobs != -1u) {
     Backend = lto::createInProcessThinBackend(Config->ThinLTOJobs);
+  }
   return llvm::make_unique<lto::LTO>(std::move(Conf), Backend,
                                      Config->LTOPartitions);
 }
@@ -129,9 +139,102 @@ void BitcodeCompiler::add(BitcodeFile &F,
     if (R.Prevailing)
       undefine(Sym);
   }
+
+  // Fold everything that influences the code generated for this
+  // module into the cache key data: the bitcode contents and the
+  // symbol resolutions, which depend on the rest of the link. Modules
+  // are appended in link order, so the order is part of the key too.
+  if (!Config->ThinLTOCacheDir.empty()) {
+    CacheKeyData += utohexstr(xxHash64(F.MB.getBuffer()));
+    for (const lto::SymbolResolution &R : Resols)
+      CacheKeyData +=
+          char('0' + (R.Prevailing ? 2 : 0) + (R.VisibleToRegularObj ? 1 : 0));
+    CacheKeyData += ';';
+  }
+
   checkError(LTOObj->add(std::move(F.Obj), Resols, HanafudaPatches));
 }
 
+// Returns a string that changes whenever anything that could affect
+// the generated native code does.
+static std::string computeCacheKey(StringRef ModuleData) {
+  std::string S = ModuleData;
+  S += Config->Pic ? "pic;" : "static;";
+  S += utostr(Config->LTOO) + ";" + utostr(Config->LTOPartitions) + ";";
+  S += Config->LTONewPmPasses;
+  S += ';';
+  S += Config->LTOAAPipeline;
+  S += ';';
+  return utohexstr(xxHash64(S));
+}
+
+// Returns true and fills Ret with object files from a previous run if
+// the cache contains output for the given key.
+bool BitcodeCompiler::loadCache(StringRef Key,
+                                std::vector<InputFile *> &Ret) {
+  // The manifest is written only after all object files, so its
+  // presence means the cache entry is complete.
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Manifest = MemoryBuffer::getFile(
+      Config->ThinLTOCacheDir + "/" + Key + ".idx");
+  if (!Manifest)
+    return false;
+
+  SmallVector<StringRef, 8> Names;
+  (*Manifest)->getBuffer().split(Names, '\n', /*MaxSplit=*/-1,
+                                 /*KeepEmpty=*/false);
+
+  std::vector<std::unique_ptr<MemoryBuffer>> Objs;
+  for (StringRef Name : Names) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> MB =
+        MemoryBuffer::getFile(Config->ThinLTOCacheDir + "/" + Name);
+    if (!MB)
+      return false;
+    Objs.push_back(std::move(*MB));
+  }
+
+  for (std::unique_ptr<MemoryBuffer> &MB : Objs)
+    Ret.push_back(createObjectFile(MB->getMemBufferRef()));
+  CachedObjs = std::move(Objs);
+  return true;
+}
+
+// Stores the native objects produced by this run under the given key.
+// Cache failures only cost the next link a recompile, so they are
+// reported as warnings, not errors.
+void BitcodeCompiler::saveCache(StringRef Key) {
+  if (std::error_code EC = sys::fs::create_directories(
+          Config->ThinLTOCacheDir)) {
+    warn("cannot create LTO cache directory " + Config->ThinLTOCacheDir +
+         ": " + EC.message());
+    return;
+  }
+
+  std::string Index;
+  for (unsigned I = 0; I != Buff.size(); ++I) {
+    if (Buff[I].empty())
+      continue;
+    std::string Name = (Key + "." + Twine(I) + ".o").str();
+    std::error_code EC;
+    raw_fd_ostream OS((Config->ThinLTOCacheDir + "/" + Name).str(), EC,
+                      sys::fs::OpenFlags::F_None);
+    if (EC) {
+      warn("cannot write LTO cache file " + Name + ": " + EC.message());
+      return;
+    }
+    OS << Buff[I];
+    Index += Name + "\n";
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS((Config->ThinLTOCacheDir + "/" + Key + ".idx").str(), EC,
+                    sys::fs::OpenFlags::F_None);
+  if (EC) {
+    warn("cannot write LTO cache manifest: " + EC.message());
+    return;
+  }
+  OS << Index;
+}
+
 // Merge all the bitcode files we have seen, codegen the result
 // and return the resulting ObjectFile(s).
 std::vector<InputFile *> BitcodeCompiler::compile() {
@@ -139,11 +242,27 @@ std::vector<InputFile *> BitcodeCompiler::compile() {
   unsigned MaxTasks = LTOObj->getMaxTasks();
   Buff.resize(MaxTasks);
 
+  // With --thinlto-cache-dir, reuse the native objects from a previous
+  // run if the bitcode, the symbol resolutions and the codegen options
+  // are all unchanged.
+  std::string Key;
+  if (!Config->ThinLTOIndexOnly && !Config->ThinLTOCacheDir.empty()) {
+    Key = computeCacheKey(CacheKeyData);
+    if (loadCache(Key, Ret))
+      return Ret;
+  }
+
   checkError(LTOObj->run([&](size_t Task) {
     return llvm::make_unique<lto::NativeObjectStream>(
         llvm::make_unique<raw_svector_ostream>(Buff[Task]));
   }));
 
+  // In index-only mode the run above performed only the thin-link and
+  // wrote the index files; the backends run elsewhere and there is
+  // nothing to feed back into this link.
+  if (Config->ThinLTOIndexOnly)
+    return Ret;
+
   for (unsigned I = 0; I != MaxTasks; ++I) {
     if (Buff[I].empty())
       continue;
@@ -156,5 +275,8 @@ std::vector<InputFile *> BitcodeCompiler::compile() {
     InputFile *Obj = createObjectFile(MemoryBufferRef(Buff[I], "lto.tmp"));
     Ret.push_back(Obj);
   }
+
+  if (!Key.empty() && !ErrorCount)
+    saveCache(Key);
   return Ret;
 }
@@ -23,7 +23,9 @@
 
 #include "lld/Core/LLVM.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace llvm {
@@ -47,8 +49,17 @@ public:
   std::vector<InputFile *> compile();
 
 private:
+  bool loadCache(StringRef Key, std::vector<InputFile *> &Ret);
+  void saveCache(StringRef Key);
+
   std::unique_ptr<llvm::lto::LTO> LTOObj;
   std::vector<SmallString<0>> Buff;
+
+  // Used by --thinlto-cache-dir. CacheKeyData accumulates, in link
+  // order, everything module-specific that influences the generated
+  // code; CachedObjs owns native objects read back from the cache.
+  std::string CacheKeyData;
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> CachedObjs;
 };
 }
 }
@@ -0,0 +1,98 @@
+//===- LinkContext.cpp ----------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "LinkContext.h"
+#include "Config.h"
+#include "Driver.h"
+#include "Error.h"
+#include "LinkerScript.h"
+#include "OutputSections.h"
+#include "SymbolTable.h"
+#include "SyntheticSections.h"
+#include "Target.h"
+
+#include <mutex>
+
+using namespace llvm;
+using namespace llvm::object;
+
+using namespace lld;
+using namespace lld::elf;
+
+// One link at a time per process; see the header comment.
+static std::mutex Mu;
+
+template <class ELFT> static void resetPerELFT() {
+  Symtab<ELFT>::X = nullptr;
+  Script<ELFT>::X = nullptr;
+
+  Out<ELFT>::EhFrame = nullptr;
+  Out<ELFT>::Bss = nullptr;
+  Out<ELFT>::Opd = nullptr;
+  Out<ELFT>::OpdBuf = nullptr;
+  Out<ELFT>::TlsPhdr = nullptr;
+  Out<ELFT>::DebugInfo = nullptr;
+  Out<ELFT>::ElfHeader = nullptr;
+  Out<ELFT>::ProgramHeaders = nullptr;
+  Out<ELFT>::PreinitArray = nullptr;
+  Out<ELFT>::InitArray = nullptr;
+  Out<ELFT>::FiniArray = nullptr;
+
+  In<ELFT>::BuildId = nullptr;
+  In<ELFT>::Common = nullptr;
+  In<ELFT>::Dynamic = nullptr;
+  In<ELFT>::DynStrTab = nullptr;
+  In<ELFT>::DynSymTab = nullptr;
+  In<ELFT>::EhFrameHdr = nullptr;
+  In<ELFT>::GnuHashTab = nullptr;
+  In<ELFT>::GdbIndex = nullptr;
+  In<ELFT>::Got = nullptr;
+  In<ELFT>::MipsGot = nullptr;
+  In<ELFT>::GotPlt = nullptr;
+  In<ELFT>::IgotPlt = nullptr;
+  In<ELFT>::HashTab = nullptr;
+  In<ELFT>::Interp = nullptr;
+  In<ELFT>::MipsRldMap = nullptr;
+  In<ELFT>::Plt = nullptr;
+  In<ELFT>::Iplt = nullptr;
+  In<ELFT>::RelaDyn = nullptr;
+  In<ELFT>::RelrDyn = nullptr;
+  In<ELFT>::RelaPlt = nullptr;
+  In<ELFT>::RelaIplt = nullptr;
+  In<ELFT>::ShStrTab = nullptr;
+  In<ELFT>::StrTab = nullptr;
+  In<ELFT>::SymTab = nullptr;
+  In<ELFT>::VerDef = nullptr;
+  In<ELFT>::VerSym = nullptr;
+  In<ELFT>::VerNeed = nullptr;
+}
+
+static void resetGlobals() {
+  Config = nullptr;
+  Driver = nullptr;
+  Target = nullptr;
+  ScriptBase = nullptr;
+  ScriptConfig = nullptr;
+  resetDirectoryListings();
+
+  resetPerELFT<ELF32LE>();
+  resetPerELFT<ELF32BE>();
+  resetPerELFT<ELF64LE>();
+  resetPerELFT<ELF64BE>();
+}
+
+ScopedLinkContext::ScopedLinkContext() {
+  Mu.lock();
+  resetGlobals();
+}
+
+ScopedLinkContext::~ScopedLinkContext() {
+  resetGlobals();
+  Mu.unlock();
+}
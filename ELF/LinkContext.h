@@ -0,0 +1,46 @@
+//===- LinkContext.h --------------------------------------*- C++ -*------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Per-link lifetime management for the linker's global state.
+//
+// The ELF and Hanafuda ports keep link state in globals: Config, Driver,
+// Target, ScriptConfig, ScriptBase and the per-ELFT singletons
+// Symtab<ELFT>::X, Script<ELFT>::X, Out<ELFT> and In<ELFT>. That makes a
+// second link in the same process start from whatever the previous link
+// (or a link that died mid-way) left behind, with many of those pointers
+// dangling into the freed arena.
+//
+// ScopedLinkContext brackets one link: it serializes whole links on a
+// process-wide mutex and clears every per-link global on entry and on
+// exit, so callers such as the daemon client fallback can run links back
+// to back in one process safely. Running links concurrently would
+// additionally require threading this state through as a context object
+// instead of globals; until then the mutex makes the constraint explicit.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_LINK_CONTEXT_H
+#define LLD_ELF_LINK_CONTEXT_H
+
+namespace lld {
+namespace elf {
+
+class ScopedLinkContext {
+public:
+  ScopedLinkContext();
+  ~ScopedLinkContext();
+
+  ScopedLinkContext(const ScopedLinkContext &) = delete;
+  ScopedLinkContext &operator=(const ScopedLinkContext &) = delete;
+};
+
+} // namespace elf
+} // namespace lld
+
+#endif
@@ -0,0 +1,178 @@
+//===- LinkProfile.cpp ----------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// When --link-profile is given, the driver writes a profile file next
+// to the incremental cache after every successful link and consults it
+// on startup. The profile is a text file of the following form:
+//
+//   LLD link profile v1
+//   pass <name> <wall-us>
+//   ...
+//   shard <pass> <count> <max-us> <mean-us>
+//   ...
+//
+// Each "pass" line records the wall time of one timed pass (the same
+// passes --stats reports). Each "shard" line summarizes the per-shard
+// wall times of one sharded parallel pass.
+//
+// Two decisions are derived from it on the next run:
+//
+//  - Whether to use threads at all. For a link whose passes together
+//    took a few milliseconds, starting the thread pool and fanning
+//    work out costs more than it saves, so such targets default to
+//    the serial paths. An explicit --threads/--no-threads wins.
+//
+//  - How many shards to split ICF's class traversal into. A dominant
+//    shard means the equivalence classes cluster, and splitting finer
+//    spreads them over the pool; shards that each finish in the noise
+//    mean the split is finer than the work, so it is coarsened.
+//
+// A profile describes the run that wrote it, so after the inputs
+// change substantially the first link is tuned from stale data. That
+// is acceptable: every rule here only moves a parameter within its
+// safe range, and the following run re-records.
+//
+//===----------------------------------------------------------------------===//
+
+#include "LinkProfile.h"
+#include "Config.h"
+#include "Error.h"
+#include "Timer.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+using namespace llvm;
+
+using namespace lld;
+using namespace lld::elf;
+
+// Links whose timed passes together stayed under this bound are run
+// serially: the measured pool startup and fan-out overhead is on the
+// order of milliseconds, a noticeable fraction of such a link.
+static const uint64_t MinParallelUs = 100000;
+
+// Bounds for the retuned ICF shard count. The lower bound keeps every
+// pool thread busy on typical machines; the upper bound keeps the
+// per-shard bookkeeping negligible.
+static const size_t MinICFShards = 64;
+static const size_t MaxICFShards = 4096;
+
+static std::string getProfilePath() {
+  return (Config->OutputFile + ".lldprofile").str();
+}
+
+namespace {
+struct ShardRecord {
+  StringRef Pass;
+  size_t Count;
+  uint64_t MaxUs;
+  uint64_t MeanUs;
+};
+}
+
+// Shard summaries recorded by this run, written out at the end.
+// Passes record serially after their loops finish, so no locking.
+static std::vector<ShardRecord> ShardRecords;
+
+void elf::recordShardTimes(StringRef Pass, ArrayRef<uint64_t> Micros) {
+  if (!Config->LinkProfile || Micros.empty())
+    return;
+  uint64_t Max = 0;
+  uint64_t Total = 0;
+  for (uint64_t V : Micros) {
+    Max = std::max(Max, V);
+    Total += V;
+  }
+  ShardRecords.push_back({Pass, Micros.size(), Max, Total / Micros.size()});
+}
+
+void elf::loadLinkProfile(bool ThreadsExplicit) {
+  if (!Config->LinkProfile)
+    return;
+  auto MBOrErr = MemoryBuffer::getFile(getProfilePath());
+  if (!MBOrErr)
+    return;
+  SmallVector<StringRef, 0> Lines;
+  (*MBOrErr)->getBuffer().split(Lines, '\n');
+
+  size_t I = 0;
+  auto Next = [&]() -> StringRef {
+    return I < Lines.size() ? Lines[I++].trim() : StringRef();
+  };
+
+  if (Next() != "LLD link profile v1")
+    return;
+
+  uint64_t TotalUs = 0;
+  size_t IcfShards = 0;
+  uint64_t IcfMaxUs = 0;
+  uint64_t IcfMeanUs = 0;
+  for (StringRef Line = Next(); !Line.empty(); Line = Next()) {
+    if (Line.consume_front("pass ")) {
+      uint64_t Us;
+      if (Line.split(' ').second.getAsInteger(10, Us))
+        return;
+      TotalUs += Us;
+      continue;
+    }
+    if (Line.consume_front("shard ")) {
+      StringRef Pass, S;
+      std::tie(Pass, Line) = Line.split(' ');
+      uint64_t Count, Max, Mean;
+      std::tie(S, Line) = Line.split(' ');
+      if (S.getAsInteger(10, Count))
+        return;
+      std::tie(S, Line) = Line.split(' ');
+      if (S.getAsInteger(10, Max) || Line.getAsInteger(10, Mean))
+        return;
+      if (Pass == "icf") {
+        IcfShards = Count;
+        IcfMaxUs = Max;
+        IcfMeanUs = Mean;
+      }
+      continue;
+    }
+    // A line kind from a newer version; tune from what we understand.
+  }
+
+  if (!ThreadsExplicit && TotalUs < MinParallelUs)
+    Config->Threads = false;
+
+  if (IcfShards) {
+    if (IcfMaxUs > 4 * std::max<uint64_t>(IcfMeanUs, 1))
+      Config->ICFShards = std::min(IcfShards * 2, MaxICFShards);
+    else if (IcfMaxUs < 500)
+      Config->ICFShards = std::max(IcfShards / 2, MinICFShards);
+    else
+      Config->ICFShards = IcfShards;
+  }
+}
+
+void elf::writeLinkProfile() {
+  if (!Config->LinkProfile || ErrorCount)
+    return;
+  std::error_code EC;
+  raw_fd_ostream OS(getProfilePath(), EC, sys::fs::F_None);
+  if (EC) {
+    warn("--link-profile: cannot write " + getProfilePath() + ": " +
+         EC.message());
+    return;
+  }
+
+  OS << "LLD link profile v1\n";
+  forEachPassTime([&](StringRef Name, double Millis) {
+    OS << "pass " << Name << " " << (uint64_t)(Millis * 1000) << "\n";
+  });
+  for (ShardRecord &R : ShardRecords)
+    OS << "shard " << R.Pass << " " << R.Count << " " << R.MaxUs << " "
+       << R.MeanUs << "\n";
+}
@@ -0,0 +1,48 @@
+//===- LinkProfile.h --------------------------------------------*- C++ -*-===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// With --link-profile, the driver persists the pass timings of each
+// link next to the incremental cache and consults them on the next
+// link of the same output to pick parallelism parameters. Link sizes
+// span orders of magnitude, so no static default of Threads.h is
+// right for all of them; the previous run of the same target is the
+// best predictor we have. See LinkProfile.cpp for the file format and
+// the tuning rules.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_LINK_PROFILE_H
+#define LLD_ELF_LINK_PROFILE_H
+
+#include "lld/Core/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+
+namespace lld {
+namespace elf {
+
+// Reads the profile written by the previous link of this output, if
+// any, and adjusts the parallelism defaults for this run. Must be
+// called before the first parallel pass starts the process-wide
+// thread pool. ThreadsExplicit says whether the command line chose a
+// threading mode itself; an explicit choice is never overridden.
+void loadLinkProfile(bool ThreadsExplicit);
+
+// Records the per-shard wall times (in microseconds) of one sharded
+// pass so that the next run can correct for imbalance. Call once per
+// pass, after its parallel loops have finished.
+void recordShardTimes(StringRef Pass, ArrayRef<uint64_t> Micros);
+
+// Writes the profile for this run. Called when the link is about to
+// finish; a no-op without --link-profile or after errors.
+void writeLinkProfile();
+
+} // namespace elf
+} // namespace lld
+
+#endif
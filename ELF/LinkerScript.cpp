@@ -24,6 +24,7 @@
 #include "Target.h"
 #include "Writer.h"
 #include "lld/Support/Memory.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
@@ -56,32 +57,6 @@ using namespace lld::elf;
 LinkerScriptBase *elf::ScriptBase;
 ScriptConfiguration *elf::ScriptConfig;
 
-template <class ELFT> static void addRegular(SymbolAssignment *Cmd) {
-  uint8_t Visibility = Cmd->Hidden ? STV_HIDDEN : STV_DEFAULT;
-  Symbol *Sym = Symtab<ELFT>::X->addRegular(Cmd->Name, Visibility, STT_NOTYPE,
-                                            0, 0, STB_GLOBAL, nullptr, nullptr);
-  Cmd->Sym = Sym->body();
-
-  // If we have no SECTIONS then we don't have '.' and don't call
-  // assignAddresses(). We calculate symbol value immediately in this case.
-  if (!ScriptConfig->HasSections)
-    cast<DefinedRegular<ELFT>>(Cmd->Sym)->Value = Cmd->Expression(0);
-}
-
-template <class ELFT> static void addSynthetic(SymbolAssignment *Cmd) {
-  // If we have SECTIONS block then output sections haven't been created yet.
-  const OutputSectionBase *Sec =
-      ScriptConfig->HasSections ? nullptr : Cmd->Expression.Section();
-  Symbol *Sym = Symtab<ELFT>::X->addSynthetic(
-      Cmd->Name, Sec, 0, Cmd->Hidden ? STV_HIDDEN : STV_DEFAULT);
-  Cmd->Sym = Sym->body();
-
-  // If we already know section then we can calculate symbol value immediately.
-  if (Sec)
-    cast<DefinedSynthetic<ELFT>>(Cmd->Sym)->Value =
-        Cmd->Expression(0) - Sec->Addr;
-}
-
 static bool isUnderSysroot(StringRef Path) {
   if (Config->Sysroot == "")
     return false;
@@ -91,21 +66,37 @@ static bool isUnderSysroot(StringRef Path) {
   return false;
 }
 
+// Defines a symbol assignment or PROVIDE. The symbol table resolves
+// the name with a single probe and drops a PROVIDE whose symbol is
+// not a live undefined.
 template <class ELFT> static void addSymbol(SymbolAssignment *Cmd) {
-  if (Cmd->Expression.IsAbsolute())
-    addRegular<ELFT>(Cmd);
-  else
-    addSynthetic<ELFT>(Cmd);
-}
-// If a symbol was in PROVIDE(), we need to define it only when
-// it is an undefined symbol.
-template <class ELFT> static bool shouldDefine(SymbolAssignment *Cmd) {
   if (Cmd->Name == ".")
-    return false;
-  if (!Cmd->Provide)
-    return true;
-  SymbolBody *B = Symtab<ELFT>::X->find(Cmd->Name);
-  return B && B->isUndefined();
+    return;
+
+  bool IsAbsolute = Cmd->Expression.IsAbsolute();
+  // If we have SECTIONS block then output sections haven't been created yet.
+  const OutputSectionBase *Sec =
+      IsAbsolute || ScriptConfig->HasSections ? nullptr
+                                              : Cmd->Expression.Section();
+  Symbol *Sym =
+      Symtab<ELFT>::X->addScripted(Cmd->Name, Cmd->Provide, IsAbsolute, Sec,
+                                   Cmd->Hidden ? STV_HIDDEN : STV_DEFAULT);
+  if (!Sym)
+    return;
+  Cmd->Sym = Sym->body();
+
+  // If we have no SECTIONS then we don't have '.' and don't call
+  // assignAddresses(). We calculate symbol value immediately in this case.
+  if (IsAbsolute) {
+    if (!ScriptConfig->HasSections)
+      cast<DefinedRegular<ELFT>>(Cmd->Sym)->Value = Cmd->Expression(0);
+    return;
+  }
+
+  // If we already know section then we can calculate symbol value immediately.
+  if (Sec)
+    cast<DefinedSynthetic<ELFT>>(Cmd->Sym)->Value =
+        Cmd->Expression(0) - Sec->Addr;
 }
 
 bool SymbolAssignment::classof(const BaseCommand *C) {
@@ -314,8 +305,7 @@ void LinkerScript<ELFT>::processCommands(OutputSectionFactory<ELFT> &Factory) {
 
     // Handle symbol assignments outside of any output section.
     if (auto *Cmd = dyn_cast<SymbolAssignment>(Base1.get())) {
-      if (shouldDefine<ELFT>(Cmd))
-        addSymbol<ELFT>(Cmd);
+      addSymbol<ELFT>(Cmd);
       continue;
     }
 
@@ -357,8 +347,7 @@ void LinkerScript<ELFT>::processCommands(OutputSectionFactory<ELFT> &Factory) {
       // ".foo : { ...; bar = .; }". Handle them.
       for (const std::unique_ptr<BaseCommand> &Base : Cmd->Commands)
         if (auto *OutCmd = dyn_cast<SymbolAssignment>(Base.get()))
-          if (shouldDefine<ELFT>(OutCmd))
-            addSymbol<ELFT>(OutCmd);
+          addSymbol<ELFT>(OutCmd);
 
       // Handle subalign (e.g. ".foo : SUBALIGN(32) { ... }"). If subalign
       // is given, input sections are aligned to that value, whether the
@@ -656,9 +645,16 @@ static bool shouldSkip(const BaseCommand &Cmd) {
 template <class ELFT>
 void LinkerScript<ELFT>::placeOrphanSections() {
   // The OutputSections are already in the correct order.
-  // This loops creates or moves commands as needed so that they are in the
+  // This creates or moves commands as needed so that they are in the
   // correct order.
-  int CmdIndex = 0;
+  //
+  // With a partial script most sections are orphans, and searching the
+  // command list for each one and inserting into the middle of the
+  // vector both rescan work already done, going quadratic on big
+  // links. Instead, the position of every OutputSectionCommand is
+  // indexed once and the command list is rebuilt in a single pass,
+  // moving each command exactly once.
+  size_t CmdIndex = 0;
 
   // As a horrible special case, skip the first . assignment if it is before any
   // section. We do this because it is common to set a load address by starting
@@ -680,33 +676,52 @@ void LinkerScript<ELFT>::placeOrphanSections() {
       ++CmdIndex;
   }
 
+  // Index the position of every OutputSectionCommand in the script.
+  // A lookup never matches a command the cursor has already passed, so
+  // each per-name position list is consulted with a lower bound on the
+  // cursor instead of rescanning the command list.
+  llvm::DenseMap<StringRef, std::vector<size_t>> CmdPositions;
+  for (size_t I = 0, E = Opt.Commands.size(); I != E; ++I)
+    if (auto *Cmd = dyn_cast<OutputSectionCommand>(Opt.Commands[I].get()))
+      CmdPositions[Cmd->Name].push_back(I);
+
+  std::vector<std::unique_ptr<BaseCommand>> Result;
+  Result.reserve(Opt.Commands.size() + OutputSections->size());
+  size_t Next = 0;
+  auto MoveUpTo = [&](size_t End) {
+    for (; Next < End; ++Next)
+      Result.push_back(std::move(Opt.Commands[Next]));
+  };
+  MoveUpTo(CmdIndex);
+
   for (OutputSectionBase *Sec : *OutputSections) {
     StringRef Name = Sec->getName();
 
     // Find the last spot where we can insert a command and still get the
     // correct result.
-    auto CmdIter = Opt.Commands.begin() + CmdIndex;
-    auto E = Opt.Commands.end();
-    while (CmdIter != E && shouldSkip(**CmdIter)) {
-      ++CmdIter;
-      ++CmdIndex;
+    while (Next != Opt.Commands.size() && shouldSkip(*Opt.Commands[Next]))
+      Result.push_back(std::move(Opt.Commands[Next++]));
+
+    // Find the first matching command at or after the cursor.
+    size_t Pos = SIZE_MAX;
+    auto It = CmdPositions.find(Name);
+    if (It != CmdPositions.end()) {
+      std::vector<size_t> &V = It->second;
+      auto PI = std::lower_bound(V.begin(), V.end(), Next);
+      if (PI != V.end())
+        Pos = *PI;
     }
-
-    auto Pos =
-        std::find_if(CmdIter, E, [&](const std::unique_ptr<BaseCommand> &Base) {
-          auto *Cmd = dyn_cast<OutputSectionCommand>(Base.get());
-          return Cmd && Cmd->Name == Name;
-        });
-    if (Pos == E) {
-      Opt.Commands.insert(CmdIter,
-                          llvm::make_unique<OutputSectionCommand>(Name));
-      ++CmdIndex;
+    if (Pos == SIZE_MAX) {
+      Result.push_back(llvm::make_unique<OutputSectionCommand>(Name));
       continue;
     }
 
-    // Continue from where we found it.
-    CmdIndex = (Pos - Opt.Commands.begin()) + 1;
+    // Move everything up to and including the match, and continue
+    // from there.
+    MoveUpTo(Pos + 1);
   }
+  MoveUpTo(Opt.Commands.size());
+  Opt.Commands = std::move(Result);
 }
 
 template <class ELFT>
@@ -1561,7 +1576,7 @@ SymbolAssignment *ScriptParser::readAssignment(StringRef Name) {
 // script expression.
 Expr ScriptParser::readExpr() { return readExpr1(readPrimary(), 0); }
 
-static Expr combine(StringRef Op, Expr L, Expr R) {
+static Expr combine1(StringRef Op, Expr L, Expr R) {
   if (Op == "*")
     return [=](uint64_t Dot) { return L(Dot) * R(Dot); };
   if (Op == "/") {
@@ -1606,6 +1621,17 @@ static Expr combine(StringRef Op, Expr L, Expr R) {
   llvm_unreachable("invalid operator");
 }
 
+static Expr combine(StringRef Op, Expr L, Expr R) {
+  Expr E = combine1(Op, L, R);
+  // If both operands are parse-time constants, the result is too.
+  // Evaluate it once now rather than every time the expression is
+  // used. (A division by zero between constants gets reported here
+  // instead of at the first evaluation, which is just as well.)
+  if (L.IsConstant && R.IsConstant)
+    return Expr::constant(E(0));
+  return E;
+}
+
 // This is a part of the operator-precedence parser. This function
 // assumes that the remaining token stream starts with an operator.
 Expr ScriptParser::readExpr1(Expr Lhs, int MinPrec) {
@@ -1707,10 +1733,14 @@ Expr ScriptParser::readPrimary() {
 
   if (Tok == "~") {
     Expr E = readPrimary();
+    if (E.IsConstant)
+      return Expr::constant(~E(0));
     return [=](uint64_t Dot) { return ~E(Dot); };
   }
   if (Tok == "-") {
     Expr E = readPrimary();
+    if (E.IsConstant)
+      return Expr::constant(-E(0));
     return [=](uint64_t Dot) { return -E(Dot); };
   }
 
@@ -1793,7 +1823,7 @@ Expr ScriptParser::readPrimary() {
   // Tok is a literal number.
   uint64_t V;
   if (readInteger(Tok, V))
-    return [=](uint64_t Dot) { return V; };
+    return Expr::constant(V);
 
   // Tok is a symbol name.
   if (Tok != "." && !isValidCIdentifier(Tok))
@@ -1807,6 +1837,8 @@ Expr ScriptParser::readTernary(Expr Cond) {
   Expr L = readExpr();
   expect(":");
   Expr R = readExpr();
+  if (Cond.IsConstant && L.IsConstant && R.IsConstant)
+    return Expr::constant(Cond(0) ? L(0) : R(0));
   return [=](uint64_t Dot) { return Cond(Dot) ? L(Dot) : R(Dot); };
 }
 
@@ -48,6 +48,14 @@ struct Expr {
   // to get the output section pointer.
   std::function<const OutputSectionBase *()> Section;
 
+  // True if the value of this expression is already known at parse
+  // time: it depends neither on "." nor on any symbol or section.
+  // Operations on such expressions are folded when the expression tree
+  // is built, so a subtree consisting of literals collapses into a
+  // single cheap closure instead of a chain of indirect calls that
+  // assignAddresses would otherwise re-evaluate on every iteration.
+  bool IsConstant = false;
+
   uint64_t operator()(uint64_t Dot) const { return Val(Dot); }
   operator bool() const { return (bool)Val; }
 
@@ -57,6 +65,12 @@ struct Expr {
   template <typename T>
   Expr(T V) : Expr(V, [] { return true; }, [] { return nullptr; }) {}
   Expr() : Expr(nullptr) {}
+
+  static Expr constant(uint64_t V) {
+    Expr E = [=](uint64_t) { return V; };
+    E.IsConstant = true;
+    return E;
+  }
 };
 
 // Parses a linker script. Calling this function updates
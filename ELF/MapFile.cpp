@@ -0,0 +1,235 @@
+//===- MapFile.cpp --------------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the -Map option. It shows lists in order and
+// hierarchically the output sections, input sections, input files and
+// symbol:
+//
+//   Address  Size     Align Out     In      Symbol
+//   00201000 00000015     4 .text
+//   00201000 0000000e     4         test.o:(.text)
+//   0020100e 00000000     0                 local
+//   00201005 00000000     0                 f(int)
+//
+// Each output section's block is formatted independently, so with
+// --threads the formatting runs in parallel and the blocks are streamed
+// to the sink in section order afterwards.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MapFile.h"
+#include "Config.h"
+#include "Error.h"
+#include "InputFiles.h"
+#include "SymbolTable.h"
+#include "Symbols.h"
+#include "Threads.h"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace llvm::object;
+
+using namespace lld;
+using namespace lld::elf;
+
+static void writeOutSecLine(raw_ostream &OS, int Width, uint64_t Address,
+                            uint64_t Size, uint64_t Align, StringRef Name) {
+  OS << format("%0*llx %0*llx %5lld ", Width, Address, Width, Size, Align)
+     << left_justify(Name, 7);
+}
+
+static void writeInSecLine(raw_ostream &OS, int Width, uint64_t Address,
+                           uint64_t Size, uint64_t Align, StringRef Name) {
+  // Pass an empty name to align the text to the correct column.
+  writeOutSecLine(OS, Width, Address, Size, Align, "");
+  OS << ' ' << left_justify(Name, 7);
+}
+
+static void writeFileLine(raw_ostream &OS, int Width, uint64_t Address,
+                          uint64_t Size, uint64_t Align, StringRef Name) {
+  writeInSecLine(OS, Width, Address, Size, Align, "");
+  OS << ' ' << left_justify(Name, 7);
+}
+
+static void writeSymbolLine(raw_ostream &OS, int Width, uint64_t Address,
+                            uint64_t Size, StringRef Name) {
+  writeFileLine(OS, Width, Address, Size, 0, "");
+  OS << ' ' << left_justify(Name, 7);
+}
+
+namespace {
+// Maps an input section to the symbols defined in it, so that the inner
+// loop below does not rescan the symbol table per section.
+template <class ELFT>
+using SectionSymMap = DenseMap<InputSectionBase<ELFT> *,
+                               SmallVector<DefinedRegular<ELFT> *, 4>>;
+}
+
+template <class ELFT>
+static void writeInputSection(raw_ostream &OS, InputSection<ELFT> *Sec,
+                              const SectionSymMap<ELFT> &SectionSyms,
+                              StringRef &PrevName) {
+  int Width = ELFT::Is64Bits ? 16 : 8;
+  StringRef Name = Sec->Name;
+  if (Name != PrevName) {
+    writeInSecLine(OS, Width, Sec->OutSec->Addr + Sec->OutSecOff,
+                   Sec->getSize(), Sec->Alignment, Name);
+    OS << '\n';
+    PrevName = Name;
+  }
+
+  elf::ObjectFile<ELFT> *File = Sec->getFile();
+  if (!File)
+    return;
+  writeFileLine(OS, Width, Sec->OutSec->Addr + Sec->OutSecOff, Sec->getSize(),
+                Sec->Alignment, toString(File));
+  OS << '\n';
+
+  auto It = SectionSyms.find(Sec);
+  if (It == SectionSyms.end())
+    return;
+  for (DefinedRegular<ELFT> *Sym : It->second) {
+    writeSymbolLine(OS, Width, Sym->template getVA<ELFT>(), Sym->Size,
+                    toString(*Sym));
+    OS << '\n';
+  }
+}
+
+template <class ELFT>
+static void writeMapFileBody(raw_ostream &OS,
+                             ArrayRef<OutputSectionBase *> OutputSections) {
+  int Width = ELFT::Is64Bits ? 16 : 8;
+
+  // Collect the defined symbols per input section up front. This is a
+  // read-only index for the parallel formatting loop below.
+  SectionSymMap<ELFT> SectionSyms;
+  for (elf::ObjectFile<ELFT> *File : Symtab<ELFT>::X->getObjectFiles())
+    for (SymbolBody *B : File->getSymbols())
+      if (auto *DR = dyn_cast<DefinedRegular<ELFT>>(B))
+        if (DR->Section)
+          SectionSyms[DR->Section].push_back(DR);
+  for (auto &It : SectionSyms)
+    std::stable_sort(It.second.begin(), It.second.end(),
+                     [](const DefinedRegular<ELFT> *A,
+                        const DefinedRegular<ELFT> *B) {
+                       return A->template getVA<ELFT>() <
+                              B->template getVA<ELFT>();
+                     });
+
+  // Format each output section's block into its own string so the
+  // blocks can be produced in parallel and emitted in order.
+  std::vector<std::string> Blocks(OutputSections.size());
+  forLoop(0, OutputSections.size(), [&](size_t I) {
+    OutputSectionBase *Sec = OutputSections[I];
+    raw_string_ostream SOS(Blocks[I]);
+    writeOutSecLine(SOS, Width, Sec->Addr, Sec->Size, Sec->Addralign,
+                    Sec->getName());
+    SOS << '\n';
+    if (auto *OutSec = dyn_cast<OutputSection<ELFT>>(Sec)) {
+      StringRef PrevName = "";
+      for (InputSection<ELFT> *IS : OutSec->Sections)
+        writeInputSection(SOS, IS, SectionSyms, PrevName);
+    }
+    SOS.flush();
+  });
+
+  OS << left_justify("Address", Width) << ' ' << left_justify("Size", Width)
+     << " Align Out     In      File    Symbol\n";
+  for (const std::string &Block : Blocks)
+    OS << Block;
+}
+
+template <class ELFT>
+void elf::writeMapFile(ArrayRef<OutputSectionBase *> OutputSections) {
+  if (Config->MapFile.empty())
+    return;
+  if (Config->MapFile == "-") {
+    writeMapFileBody<ELFT>(outs(), OutputSections);
+    return;
+  }
+  std::error_code EC;
+  raw_fd_ostream OS(Config->MapFile, EC, sys::fs::F_None);
+  if (EC) {
+    error("cannot open " + Config->MapFile + ": " + EC.message());
+    return;
+  }
+  writeMapFileBody<ELFT>(OS, OutputSections);
+}
+
+template void elf::writeMapFile<ELF32LE>(ArrayRef<OutputSectionBase *>);
+template void elf::writeMapFile<ELF32BE>(ArrayRef<OutputSectionBase *>);
+template void elf::writeMapFile<ELF64LE>(ArrayRef<OutputSectionBase *>);
+template void elf::writeMapFile<ELF64BE>(ArrayRef<OutputSectionBase *>);
+
+// --layout-only emits the final layout -- the output sections and the
+// defined global symbols -- as JSON, so build tooling can query would-be
+// addresses without paying for writing the output file.
+
+static void writeQuoted(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (char C : S) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if ((unsigned char)C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+template <class ELFT>
+static void writeLayoutBody(raw_ostream &OS,
+                            ArrayRef<OutputSectionBase *> OutputSections) {
+  OS << "{\n  \"sections\": [";
+  const char *Sep = "\n";
+  for (OutputSectionBase *Sec : OutputSections) {
+    OS << Sep << "    {\"name\": ";
+    writeQuoted(OS, Sec->getName());
+    OS << ", \"address\": " << Sec->Addr << ", \"size\": " << Sec->Size
+       << ", \"align\": " << Sec->Addralign << "}";
+    Sep = ",\n";
+  }
+  OS << "\n  ],\n  \"symbols\": [";
+  Sep = "\n";
+  for (Symbol *S : Symtab<ELFT>::X->getSymbols()) {
+    auto *DR = dyn_cast<DefinedRegular<ELFT>>(S->body());
+    if (!DR)
+      continue;
+    OS << Sep << "    {\"name\": ";
+    writeQuoted(OS, DR->getName());
+    OS << ", \"value\": " << DR->template getVA<ELFT>()
+       << ", \"size\": " << DR->Size << "}";
+    Sep = ",\n";
+  }
+  OS << "\n  ]\n}\n";
+}
+
+template <class ELFT>
+void elf::writeLayoutFile(ArrayRef<OutputSectionBase *> OutputSections) {
+  if (Config->LayoutOnly == "-") {
+    writeLayoutBody<ELFT>(outs(), OutputSections);
+    return;
+  }
+  std::error_code EC;
+  raw_fd_ostream OS(Config->LayoutOnly, EC, sys::fs::F_None);
+  if (EC) {
+    error("cannot open " + Config->LayoutOnly + ": " + EC.message());
+    return;
+  }
+  writeLayoutBody<ELFT>(OS, OutputSections);
+}
+
+template void elf::writeLayoutFile<ELF32LE>(ArrayRef<OutputSectionBase *>);
+template void elf::writeLayoutFile<ELF32BE>(ArrayRef<OutputSectionBase *>);
+template void elf::writeLayoutFile<ELF64LE>(ArrayRef<OutputSectionBase *>);
+template void elf::writeLayoutFile<ELF64BE>(ArrayRef<OutputSectionBase *>);
@@ -0,0 +1,30 @@
+//===- MapFile.h ------------------------------------------------*- C++ -*-===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_MAPFILE_H
+#define LLD_ELF_MAPFILE_H
+
+#include "OutputSections.h"
+#include "llvm/ADT/ArrayRef.h"
+
+namespace lld {
+namespace elf {
+
+// Write a link map to Config->MapFile ("-" means stdout).
+template <class ELFT>
+void writeMapFile(llvm::ArrayRef<OutputSectionBase *> OutputSections);
+
+// Write the layout as JSON to Config->LayoutOnly ("-" means stdout).
+template <class ELFT>
+void writeLayoutFile(llvm::ArrayRef<OutputSectionBase *> OutputSections);
+
+} // namespace elf
+} // namespace lld
+
+#endif
@@ -27,6 +27,7 @@
 #include "SymbolTable.h"
 #include "Symbols.h"
 #include "Target.h"
+#include "Threads.h"
 #include "Writer.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Object/ELF.h"
@@ -63,10 +64,11 @@ static typename ELFT::uint getAddend(InputSectionBase<ELFT> &Sec,
   return Rel.r_addend;
 }
 
+// B is the relocation's target, taken from the shared RelocTargets
+// index so the symbol lookup is not repeated here.
 template <class ELFT, class RelT>
-static ResolvedReloc<ELFT> resolveReloc(InputSectionBase<ELFT> &Sec,
-                                        RelT &Rel) {
-  SymbolBody &B = Sec.getFile()->getRelocTargetSym(Rel);
+static ResolvedReloc<ELFT> resolveReloc(InputSectionBase<ELFT> &Sec, RelT &Rel,
+                                        SymbolBody &B) {
   auto *D = dyn_cast<DefinedRegular<ELFT>>(&B);
   if (!D || !D->Section)
     return {nullptr, 0};
@@ -81,11 +83,13 @@ template <class ELFT>
 static void forEachSuccessor(InputSection<ELFT> &Sec,
                              std::function<void(ResolvedReloc<ELFT>)> Fn) {
   if (Sec.AreRelocsRela) {
-    for (const typename ELFT::Rela &Rel : Sec.relas())
-      Fn(resolveReloc(Sec, Rel));
+    ArrayRef<typename ELFT::Rela> Rels = Sec.relas();
+    for (size_t I = 0, E = Rels.size(); I != E; ++I)
+      Fn(resolveReloc(Sec, Rels[I], *Sec.RelocTargets[I]));
   } else {
-    for (const typename ELFT::Rel &Rel : Sec.rels())
-      Fn(resolveReloc(Sec, Rel));
+    ArrayRef<typename ELFT::Rel> Rels = Sec.rels();
+    for (size_t I = 0, E = Rels.size(); I != E; ++I)
+      Fn(resolveReloc(Sec, Rels[I], *Sec.RelocTargets[I]));
   }
   if (Sec.DependentSection)
     Fn({Sec.DependentSection, 0});
@@ -118,7 +122,7 @@ scanEhFrameSection(EhInputSection<ELFT> &EH, ArrayRef<RelTy> Rels,
     if (read32<E>(Piece.data().data() + 4) == 0) {
       // This is a CIE, we only need to worry about the first relocation. It is
       // known to point to the personality function.
-      Enqueue(resolveReloc(EH, Rels[FirstRelI]));
+      Enqueue(resolveReloc(EH, Rels[FirstRelI], *EH.RelocTargets[FirstRelI]));
       continue;
     }
     // This is a FDE. The relocations point to the described function or to
@@ -129,7 +133,7 @@ scanEhFrameSection(EhInputSection<ELFT> &EH, ArrayRef<RelTy> Rels,
       const RelTy &Rel = Rels[I2];
       if (Rel.r_offset >= PieceEnd)
         break;
-      ResolvedReloc<ELFT> R = resolveReloc(EH, Rels[I2]);
+      ResolvedReloc<ELFT> R = resolveReloc(EH, Rels[I2], *EH.RelocTargets[I2]);
       if (!R.Sec || R.Sec == &InputSection<ELFT>::Discarded)
         continue;
       if (R.Sec->Flags & SHF_EXECINSTR)
@@ -244,9 +248,29 @@ template <class ELFT> void elf::markLive() {
       Enqueue({Sec, 0});
   }
 
-  // Mark all reachable sections.
-  while (!Q.empty())
-    forEachSuccessor<ELFT>(*Q.pop_back_val(), Enqueue);
+  // Mark all reachable sections. We traverse the graph one frontier at
+  // a time. Resolving the relocations of the frontier sections is
+  // read-only work and is done in parallel; the resulting marks are
+  // then committed serially, so the Live bits and the liveness offsets
+  // of merge sections are never touched from two threads, and the
+  // traversal stays deterministic.
+  std::vector<InputSection<ELFT> *> Frontier(Q.begin(), Q.end());
+  Q.clear();
+  while (!Frontier.empty()) {
+    std::vector<std::vector<ResolvedReloc<ELFT>>> Succs(Frontier.size());
+    forLoop(0, Frontier.size(), [&](size_t I) {
+      forEachSuccessor<ELFT>(*Frontier[I], [&](ResolvedReloc<ELFT> R) {
+        Succs[I].push_back(R);
+      });
+    });
+
+    for (std::vector<ResolvedReloc<ELFT>> &V : Succs)
+      for (ResolvedReloc<ELFT> &R : V)
+        Enqueue(R);
+
+    Frontier.assign(Q.begin(), Q.end());
+    Q.clear();
+  }
 }
 
 template void elf::markLive<ELF32LE>();
@@ -17,6 +17,8 @@
 #include "Target.h"
 #include "Threads.h"
 #include "lld/Support/Memory.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/MathExtras.h"
@@ -240,27 +242,127 @@ template <class ELFT> void OutputSection<ELFT>::sortCtorsDtors() {
 // Fill [Buf, Buf + Size) with Filler. Filler is written in big
 // endian order. This is used for linker script "=fillexp" command.
 void fill(uint8_t *Buf, size_t Size, uint32_t Filler) {
+  if (Size == 0)
+    return;
+
+  // The output buffer is a freshly created file mapping, so zero fill
+  // is already there; don't dirty megabytes of padding pages writing
+  // it again.
+  if (Filler == 0)
+    return;
+
+  // Stamp the pattern by doubling: write one copy, then repeatedly
+  // copy the run written so far to the bytes that follow it. Each run
+  // is a multiple of the pattern size, so periodicity is preserved,
+  // and most of the area is covered by a few large memcpys that the
+  // libc implementation vectorizes, instead of a 4-byte loop.
   uint8_t V[4];
   write32be(V, Filler);
-  size_t I = 0;
-  for (; I + 4 < Size; I += 4)
-    memcpy(Buf + I, V, 4);
-  memcpy(Buf + I, V, Size - I);
+  memcpy(Buf, V, std::min<size_t>(Size, 4));
+  for (size_t I = 4; I < Size; I *= 2)
+    memcpy(Buf + I, Buf, std::min(I, Size - I));
+}
+
+// Helpers for --compress-debug-sections, shared by the section kinds
+// that can hold debug contents. The contents have to be final before
+// they are deflated, so WriteContents renders the section (relocated)
+// into a temporary buffer; the write phase then only emits the
+// Elf_Chdr header and the compressed bytes. Compression happens once
+// symbol values are final and before file offsets are assigned, since
+// the section shrinks; sections compress independently of each other,
+// in parallel.
+template <class ELFT>
+static void
+compressSection(OutputSectionBase *Sec,
+                llvm::function_ref<void(uint8_t *)> WriteContents) {
+  if (!Sec->Name.startswith(".debug_") || Sec->Size == 0)
+    return;
+
+  std::vector<uint8_t> Uncompressed(Sec->Size);
+  WriteContents(Uncompressed.data());
+
+  if (zlib::compress(
+          StringRef((const char *)Uncompressed.data(), Uncompressed.size()),
+          Sec->CompressedData) != zlib::StatusOK) {
+    error("failed to compress section " + Sec->Name);
+    return;
+  }
+
+  Sec->UncompressedSize = Sec->Size;
+  Sec->UncompressedAlign = Sec->Addralign;
+  Sec->Flags |= SHF_COMPRESSED;
+  Sec->Addralign = sizeof(typename ELFT::uint);
+  Sec->Size = sizeof(typename ELFT::Chdr) + Sec->CompressedData.size();
+}
+
+template <class ELFT>
+static void writeCompressed(OutputSectionBase *Sec, uint8_t *Buf) {
+  auto *Chdr = reinterpret_cast<typename ELFT::Chdr *>(Buf);
+  Chdr->ch_type = ELFCOMPRESS_ZLIB;
+  Chdr->ch_size = Sec->UncompressedSize;
+  Chdr->ch_addralign = Sec->UncompressedAlign;
+  memcpy(Buf + sizeof(typename ELFT::Chdr), Sec->CompressedData.data(),
+         Sec->CompressedData.size());
+}
+
+template <class ELFT> void OutputSection<ELFT>::maybeCompress() {
+  compressSection<ELFT>(this, [&](uint8_t *Buf) {
+    if (uint32_t Filler = Script<ELFT>::X->getFiller(this->Name))
+      fill(Buf, this->Size, Filler);
+    ScopedDiagnosticBuffer DiagBuffer;
+    for (InputSection<ELFT> *IS : Sections)
+      IS->writeTo(Buf);
+  });
 }
 
 template <class ELFT> void OutputSection<ELFT>::writeTo(uint8_t *Buf) {
   Loc = Buf;
+  if (!this->CompressedData.empty()) {
+    writeCompressed<ELFT>(this, Buf);
+    return;
+  }
   if (uint32_t Filler = Script<ELFT>::X->getFiller(this->Name))
     fill(Buf, this->Size, Filler);
 
   auto Fn = [=](InputSection<ELFT> *IS) { IS->writeTo(Buf); };
-  forEach(Sections.begin(), Sections.end(), Fn);
+  {
+    // See Writer::writeSections: buffer relocation diagnostics per
+    // worker instead of taking the diagnostics lock per message.
+    ScopedDiagnosticBuffer DiagBuffer;
+    forEach(Sections.begin(), Sections.end(), Fn);
+  }
 
   // Linker scripts may have BYTE()-family commands with which you
   // can write arbitrary bytes to the output. Process them if any.
   Script<ELFT>::X->writeDataBytes(this->Name, Buf);
 }
 
+template <class ELFT>
+void OutputSection<ELFT>::writeTasks(uint8_t *Buf,
+                                     std::vector<std::function<void()>> &Tasks) {
+  Loc = Buf;
+  if (!this->CompressedData.empty()) {
+    Tasks.push_back([=] { writeCompressed<ELFT>(this, Buf); });
+    return;
+  }
+  if (uint32_t Filler = Script<ELFT>::X->getFiller(this->Name))
+    fill(Buf, this->Size, Filler);
+
+  // Each input section is copied and relocated independently, so each
+  // becomes one task. Synthetic sections get a chance to decompose
+  // further: a big PLT, for example, is written as several ranges of
+  // entries. The caller is responsible for running BYTE()-family
+  // linker script commands after all tasks have finished.
+  for (InputSection<ELFT> *IS : Sections) {
+    if (auto *S = dyn_cast<SyntheticSection<ELFT>>(IS)) {
+      if (S->Type != SHT_NOBITS)
+        S->writeTasks(Buf + S->OutSecOff, Tasks);
+      continue;
+    }
+    Tasks.push_back([=] { IS->writeTo(Buf); });
+  }
+}
+
 template <class ELFT>
 EhOutputSection<ELFT>::EhOutputSection()
     : OutputSectionBase(".eh_frame", SHT_PROGBITS, SHF_ALLOC) {}
@@ -467,11 +569,27 @@ template <class ELFT> void EhOutputSection<ELFT>::writeTo(uint8_t *Buf) {
 template <class ELFT>
 MergeOutputSection<ELFT>::MergeOutputSection(StringRef Name, uint32_t Type,
                                              uintX_t Flags, uintX_t Alignment)
-    : OutputSectionBase(Name, Type, Flags),
-      Builder(StringTableBuilder::RAW, Alignment) {}
+    : OutputSectionBase(Name, Type, Flags) {
+  this->updateAlignment(Alignment);
+}
 
 template <class ELFT> void MergeOutputSection<ELFT>::writeTo(uint8_t *Buf) {
-  Builder.write(Buf);
+  if (!this->CompressedData.empty()) {
+    writeCompressed<ELFT>(this, Buf);
+    return;
+  }
+  if (!Sharded) {
+    Builder->write(Buf);
+    return;
+  }
+  for (size_t I = 0; I != NumShards; ++I)
+    Shards[I].write(Buf + ShardOffsets[I]);
+}
+
+// .debug_str is a merge section; compress it like the regular debug
+// sections.
+template <class ELFT> void MergeOutputSection<ELFT>::maybeCompress() {
+  compressSection<ELFT>(this, [&](uint8_t *Buf) { writeTo(Buf); });
 }
 
 template <class ELFT>
@@ -488,16 +606,19 @@ template <class ELFT> bool MergeOutputSection<ELFT>::shouldTailMerge() const {
 }
 
 template <class ELFT> void MergeOutputSection<ELFT>::finalizeTailMerge() {
+  Builder.reset(new StringTableBuilder(StringTableBuilder::RAW,
+                                       this->Addralign));
+
   // Add all string pieces to the string table builder to create section
   // contents.
   for (MergeInputSection<ELFT> *Sec : Sections)
     for (size_t I = 0, E = Sec->Pieces.size(); I != E; ++I)
       if (Sec->Pieces[I].Live)
-        Builder.add(Sec->getData(I));
+        Builder->add(Sec->getData(I));
 
   // Fix the string table content. After this, the contents will never change.
-  Builder.finalize();
-  this->Size = Builder.getSize();
+  Builder->finalize();
+  this->Size = Builder->getSize();
 
   // finalize() fixed tail-optimized strings, so we can now get
   // offsets of strings. Get an offset for each string and save it
@@ -505,10 +626,13 @@ template <class ELFT> void MergeOutputSection<ELFT>::finalizeTailMerge() {
   for (MergeInputSection<ELFT> *Sec : Sections)
     for (size_t I = 0, E = Sec->Pieces.size(); I != E; ++I)
       if (Sec->Pieces[I].Live)
-        Sec->Pieces[I].OutputOff = Builder.getOffset(Sec->getData(I));
+        Sec->Pieces[I].OutputOff = Builder->getOffset(Sec->getData(I));
 }
 
 template <class ELFT> void MergeOutputSection<ELFT>::finalizeNoTailMerge() {
+  Builder.reset(new StringTableBuilder(StringTableBuilder::RAW,
+                                       this->Addralign));
+
   // Add all string pieces to the string table builder to create section
   // contents. Because we are not tail-optimizing, offsets of strings are
   // fixed when they are added to the builder (string table builder contains
@@ -516,15 +640,119 @@ template <class ELFT> void MergeOutputSection<ELFT>::finalizeNoTailMerge() {
   for (MergeInputSection<ELFT> *Sec : Sections)
     for (size_t I = 0, E = Sec->Pieces.size(); I != E; ++I)
       if (Sec->Pieces[I].Live)
-        Sec->Pieces[I].OutputOff = Builder.add(Sec->getData(I));
+        Sec->Pieces[I].OutputOff = Builder->add(Sec->getData(I));
+
+  Builder->finalizeInOrder();
+  this->Size = Builder->getSize();
+}
+
+// A single-threaded merge funnels tens of millions of pieces through
+// one hash table on debug-heavy links. Instead, distribute the pieces
+// over NumShards buckets by their hash and build one string table per
+// bucket concurrently. Pieces with identical contents have identical
+// hashes and therefore land in the same bucket, so deduplication
+// within a bucket is complete. Concatenating the bucket outputs is
+// free; we only have to rebase each piece offset by its bucket's
+// start afterwards.
+template <class ELFT> void MergeOutputSection<ELFT>::finalizeShardedMerge() {
+  Sharded = true;
+  for (size_t I = 0; I != NumShards; ++I)
+    Shards.emplace_back(StringTableBuilder::RAW, this->Addralign);
+
+  // Map: add each piece to the string table of the bucket it hashes to.
+  // Each worker visits every piece but only touches its own bucket, so
+  // no synchronization is needed.
+  forLoop(0, NumShards, [&](size_t ShardId) {
+    StringTableBuilder &Shard = Shards[ShardId];
+    for (MergeInputSection<ELFT> *Sec : Sections)
+      for (size_t I = 0, E = Sec->Pieces.size(); I != E; ++I)
+        if (Sec->Pieces[I].Live &&
+            getShardId(Sec->getData(I).hash()) == ShardId)
+          Sec->Pieces[I].OutputOff = Shard.add(Sec->getData(I));
+  });
+
+  // Reduce: fix the bucket contents and lay the buckets out one after
+  // another.
+  size_t Off = 0;
+  for (size_t I = 0; I != NumShards; ++I) {
+    Shards[I].finalizeInOrder();
+    if (this->Addralign)
+      Off = alignTo(Off, this->Addralign);
+    ShardOffsets[I] = Off;
+    Off += Shards[I].getSize();
+  }
+  this->Size = Off;
+
+  // Piece offsets are relative to the bucket the piece lives in;
+  // rebase them to the start of the output section.
+  forEach(Sections.begin(), Sections.end(), [&](MergeInputSection<ELFT> *Sec) {
+    for (size_t I = 0, E = Sec->Pieces.size(); I != E; ++I)
+      if (Sec->Pieces[I].Live)
+        Sec->Pieces[I].OutputOff +=
+            ShardOffsets[getShardId(Sec->getData(I).hash())];
+  });
+}
+
+// The sharded counterpart of finalizeTailMerge. Tail merging is
+// dominated by StringTableBuilder::finalize sorting every string, so
+// distribute the pieces over buckets keyed by their terminal bytes
+// (see getTailShardId) and let the buckets sort concurrently. A suffix
+// relationship implies identical trailing bytes, so the chains that
+// tail merging exploits stay within one bucket and intra-bucket
+// deduplication is as good as the global one, modulo strings shorter
+// than the key window.
+template <class ELFT>
+void MergeOutputSection<ELFT>::finalizeShardedTailMerge() {
+  Sharded = true;
+  for (size_t I = 0; I != NumShards; ++I)
+    Shards.emplace_back(StringTableBuilder::RAW, this->Addralign);
+
+  // Map: add each piece to its bucket's builder, then fix the bucket's
+  // contents. finalize() is the sort and runs inside the parallel
+  // region on purpose.
+  forLoop(0, NumShards, [&](size_t ShardId) {
+    StringTableBuilder &Shard = Shards[ShardId];
+    for (MergeInputSection<ELFT> *Sec : Sections)
+      for (size_t I = 0, E = Sec->Pieces.size(); I != E; ++I)
+        if (Sec->Pieces[I].Live &&
+            getTailShardId(Sec->getData(I).val()) == ShardId)
+          Shard.add(Sec->getData(I));
+    Shard.finalize();
+  });
+
+  // Reduce: lay the buckets out one after another.
+  size_t Off = 0;
+  for (size_t I = 0; I != NumShards; ++I) {
+    if (this->Addralign)
+      Off = alignTo(Off, this->Addralign);
+    ShardOffsets[I] = Off;
+    Off += Shards[I].getSize();
+  }
+  this->Size = Off;
 
-  Builder.finalizeInOrder();
-  this->Size = Builder.getSize();
+  // Now that the bucket contents are fixed, piece offsets are known;
+  // rebase them by their bucket's start.
+  forEach(Sections.begin(), Sections.end(), [&](MergeInputSection<ELFT> *Sec) {
+    for (size_t I = 0, E = Sec->Pieces.size(); I != E; ++I)
+      if (Sec->Pieces[I].Live) {
+        size_t ShardId = getTailShardId(Sec->getData(I).val());
+        Sec->Pieces[I].OutputOff =
+            Shards[ShardId].getOffset(Sec->getData(I)) +
+            ShardOffsets[ShardId];
+      }
+  });
 }
 
 template <class ELFT> void MergeOutputSection<ELFT>::finalize() {
-  if (shouldTailMerge())
-    finalizeTailMerge();
+  if (shouldTailMerge()) {
+    if (Config->Threads)
+      finalizeShardedTailMerge();
+    else
+      finalizeTailMerge();
+    return;
+  }
+  if (Config->Threads)
+    finalizeShardedMerge();
   else
     finalizeNoTailMerge();
 }
@@ -535,8 +763,9 @@ static typename ELFT::uint getOutFlags(InputSectionBase<ELFT> *S) {
 }
 
 template <class ELFT>
-static SectionKey<ELFT::Is64Bits> createKey(InputSectionBase<ELFT> *C,
-                                            StringRef OutsecName) {
+SectionKey<ELFT::Is64Bits>
+OutputSectionFactory<ELFT>::createKey(InputSectionBase<ELFT> *C,
+                                      StringRef OutsecName) {
   typedef typename ELFT::uint uintX_t;
   uintX_t Flags = getOutFlags(C);
 
@@ -551,6 +780,15 @@ static SectionKey<ELFT::Is64Bits> createKey(InputSectionBase<ELFT> *C,
       (Config->Relocatable && (C->Flags & SHF_MERGE)))
     Alignment = std::max<uintX_t>(C->Alignment, C->Entsize);
 
+  // At -O3 we merge mergeable string sections across alignment classes:
+  // identical strings from, say, .rodata.str1.1 and .rodata.str1.8 are
+  // deduplicated into one output section whose alignment is the maximum of
+  // its members'. Entsize stays in the key so that single-byte and wide
+  // strings are never mixed.
+  if (Config->Optimize >= 3 && !Config->Relocatable &&
+      isa<MergeInputSection<ELFT>>(C) && (C->Flags & SHF_STRINGS))
+    Alignment = C->Entsize;
+
   return SectionKey<ELFT::Is64Bits>{OutsecName, C->Type, Flags, Alignment};
 }
 
@@ -14,8 +14,11 @@
 #include "Relocations.h"
 
 #include "lld/Core/LLVM.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/MC/StringTableBuilder.h"
 #include "llvm/Object/ELF.h"
+#include <memory>
 
 namespace lld {
 namespace elf {
@@ -82,6 +85,27 @@ public:
   virtual void finalize() {}
   virtual void assignOffsets() {}
   virtual void writeTo(uint8_t *Buf) {}
+
+  // Like writeTo, but instead of copying contents immediately, appends
+  // independently-runnable copy tasks to Tasks so that the writer can
+  // execute the tasks of all output sections with one parallel loop.
+  // Sections with no parallel decomposition append a single task that
+  // just calls writeTo.
+  virtual void writeTasks(uint8_t *Buf,
+                          std::vector<std::function<void()>> &Tasks) {
+    Tasks.push_back([=] { writeTo(Buf); });
+  }
+
+  // Replaces the section contents with a compressed image if
+  // --compress-debug-sections makes this section a candidate.
+  virtual void maybeCompress() {}
+
+  // Filled by maybeCompress: the deflated contents and the
+  // pre-compression size and alignment recorded in the Elf_Chdr.
+  llvm::SmallVector<char, 0> CompressedData;
+  uint64_t UncompressedSize = 0;
+  uint64_t UncompressedAlign = 0;
+
   virtual ~OutputSectionBase() = default;
 
   StringRef Name;
@@ -98,6 +122,11 @@ public:
   uint32_t Type = 0;
   uint32_t Info = 0;
   uint32_t Link = 0;
+
+  // Layout rank encoding all sorting criteria into one integer, filled
+  // in by the writer before sorting so comparisons don't re-derive the
+  // classification. See getSectionRank in Writer.cpp.
+  uint32_t SortRank = 0;
 };
 
 template <class ELFT> class OutputSection final : public OutputSectionBase {
@@ -114,8 +143,11 @@ public:
   void sortInitFini();
   void sortCtorsDtors();
   void writeTo(uint8_t *Buf) override;
+  void writeTasks(uint8_t *Buf,
+                  std::vector<std::function<void()>> &Tasks) override;
   void finalize() override;
   void assignOffsets() override;
+  void maybeCompress() override;
   Kind getKind() const override { return Regular; }
   static bool classof(const OutputSectionBase *B) {
     return B->getKind() == Regular;
@@ -136,6 +168,7 @@ public:
   void addSection(InputSectionData *S) override;
   void writeTo(uint8_t *Buf) override;
   void finalize() override;
+  void maybeCompress() override;
   bool shouldTailMerge() const;
   Kind getKind() const override { return Merge; }
   static bool classof(const OutputSectionBase *B) {
@@ -145,8 +178,32 @@ public:
 private:
   void finalizeTailMerge();
   void finalizeNoTailMerge();
+  void finalizeShardedMerge();
+  void finalizeShardedTailMerge();
+
+  // For multi-threaded merges, pieces are distributed over this many
+  // buckets by string hash, and one string table is built per bucket.
+  enum : unsigned { ShardBits = 5, NumShards = 1 << ShardBits };
+  static unsigned getShardId(uint32_t Hash) { return Hash >> (32 - ShardBits); }
+
+  // Bucket selector for the sharded tail merge. A string can only be
+  // tail-merged into one whose terminal bytes are identical, so
+  // hashing a fixed window of trailing bytes keeps suffix chains
+  // within one bucket. Strings shorter than the window may miss a
+  // cross-bucket merge opportunity, which costs a few output bytes but
+  // never correctness.
+  static unsigned getTailShardId(StringRef Data) {
+    return getShardId((uint32_t)llvm::hash_value(Data.take_back(4)));
+  }
 
-  llvm::StringTableBuilder Builder;
+  // Created at finalization rather than construction: with -O3 string
+  // sections of several alignment classes feed one output section, so
+  // the builder's alignment is only known once every member has been
+  // added and Addralign reflects their maximum.
+  std::unique_ptr<llvm::StringTableBuilder> Builder;
+  std::vector<llvm::StringTableBuilder> Shards;
+  size_t ShardOffsets[NumShards];
+  bool Sharded = false;
   std::vector<MergeInputSection<ELFT> *> Sections;
 };
 
@@ -234,6 +291,11 @@ template <class ELFT> class OutputSectionFactory {
   typedef typename elf::SectionKey<ELFT::Is64Bits> Key;
 
 public:
+  // Computes the key a section would be binned under. This only reads
+  // the input section, so callers may evaluate it for many sections in
+  // parallel and feed the results to the serial create() loop.
+  static Key createKey(InputSectionBase<ELFT> *C, StringRef OutsecName);
+
   std::pair<OutputSectionBase *, bool> create(InputSectionBase<ELFT> *C,
                                               StringRef OutsecName);
   std::pair<OutputSectionBase *, bool>
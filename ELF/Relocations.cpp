@@ -48,7 +48,9 @@
 #include "SymbolTable.h"
 #include "SyntheticSections.h"
 #include "Target.h"
+#include "Threads.h"
 #include "Thunks.h"
+#include "lld/Support/Memory.h"
 
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/raw_ostream.h"
@@ -415,14 +417,12 @@ template <class ELFT> static void addCopyRelSymbol(SharedSymbol<ELFT> *SS) {
   Out<ELFT>::Bss->updateAlignment(Alignment);
   uintX_t Shndx = SS->Sym.st_shndx;
   uintX_t Value = SS->Sym.st_value;
-  // Look through the DSO's dynamic symbol table for aliases and create a
+  // Look up the aliases of the copied symbol in the DSO and create a
   // dynamic symbol for each one. This causes the copy relocation to correctly
   // interpose any aliases.
-  for (const Elf_Sym &S : SS->file()->getGlobalSymbols()) {
-    if (S.st_shndx != Shndx || S.st_value != Value)
-      continue;
+  for (const Elf_Sym *S : SS->file()->getSymbolsAt(Shndx, Value)) {
     auto *Alias = dyn_cast_or_null<SharedSymbol<ELFT>>(
-        Symtab<ELFT>::X->find(check(S.getName(SS->file()->getStringTable()))));
+        Symtab<ELFT>::X->find(check(S->getName(SS->file()->getStringTable()))));
     if (!Alias)
       continue;
     Alias->OffsetInBss = Off;
@@ -582,8 +582,37 @@ mergeMipsN32RelTypes(uint32_t Type, uint32_t Offset, RelTy *I, RelTy *E) {
 // sections. Given that it is ro, we will need an extra PT_LOAD. This
 // complicates things for the dynamic linker and means we would have to reserve
 // space for the extra PT_LOAD even if we end up not using it.
+// Computes the RelExpr classification of every relocation in Rels.
+// This is pure per-relocation computation with no side effects, so the
+// driver can run it for many sections in parallel; the stateful part
+// of the scan consumes the precomputed expressions afterwards. The
+// result vector is indexed by relocation number. For MIPS N32, entries
+// of relocations that get merged into their predecessor are unused.
 template <class ELFT, class RelTy>
-static void scanRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels) {
+static void classifyRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels,
+                           std::vector<RelExpr> &Exprs) {
+  Exprs.resize(Rels.size());
+
+  for (size_t I = 0, E = Rels.size(); I != E; ++I) {
+    const RelTy &RI = Rels[I];
+    SymbolBody &Body = *C.RelocTargets[I];
+    uint32_t Type = RI.getType(Config->Mips64EL);
+
+    if (Config->MipsN32Abi) {
+      uint32_t Processed;
+      std::tie(Type, Processed) = mergeMipsN32RelTypes(
+          Type, RI.r_offset, Rels.begin() + I + 1, Rels.end());
+      Exprs[I] = Target->getRelExpr(Type, Body);
+      I += Processed;
+      continue;
+    }
+    Exprs[I] = Target->getRelExpr(Type, Body);
+  }
+}
+
+template <class ELFT, class RelTy>
+static void scanRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels,
+                       ArrayRef<RelExpr> Exprs) {
   typedef typename ELFT::uint uintX_t;
 
   bool IsWrite = C.Flags & SHF_WRITE;
@@ -605,7 +634,10 @@ static void scanRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels) {
 
   for (auto I = Rels.begin(), E = Rels.end(); I != E; ++I) {
     const RelTy &RI = *I;
-    SymbolBody &Body = File->getRelocTargetSym(RI);
+    // The classification was computed before any MIPS N32 merging, so
+    // index it with the position of the first relocation of a series.
+    RelExpr Expr = Exprs[I - Rels.begin()];
+    SymbolBody &Body = *C.RelocTargets[I - Rels.begin()];
     uint32_t Type = RI.getType(Config->Mips64EL);
 
     if (Config->MipsN32Abi) {
@@ -620,7 +652,6 @@ static void scanRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels) {
     if (!Body.isLocal() && Body.isUndefined() && !Body.symbol()->isWeak())
       reportUndefined(Body, C, RI.r_offset);
 
-    RelExpr Expr = Target->getRelExpr(Type, Body);
     bool Preemptible = isPreemptible(Body, Type);
     Expr = adjustExpr(*File, Body, IsWrite, Expr, Type, Buf + RI.r_offset, C,
                       RI.r_offset);
@@ -653,10 +684,15 @@ static void scanRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels) {
 
     uintX_t Addend = computeAddend(*File, Buf, E, RI, Expr, Body);
 
-    if (unsigned Processed =
-            handleTlsRelocation<ELFT>(Type, Body, C, Offset, Addend, Expr)) {
-      I += (Processed - 1);
-      continue;
+    // Only TLS symbols can take the TLS handling path; gating here keeps
+    // the call and its decision cascade entirely off the scan loop for
+    // ordinary relocations.
+    if (Body.isTls()) {
+      if (unsigned Processed =
+              handleTlsRelocation<ELFT>(Type, Body, C, Offset, Addend, Expr)) {
+        I += (Processed - 1);
+        continue;
+      }
     }
 
     // Ignore "hint" and TLS Descriptor call relocation because they are
@@ -676,13 +712,26 @@ static void scanRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels) {
       // dynamic linker. We can however do better than just copying the incoming
       // relocation. We can process some of it and and just ask the dynamic
       // linker to add the load address.
-      if (!Constant)
-        AddDyn({Target->RelativeRel, &C, Offset, true, &Body, Addend});
+      bool UseRelr = false;
+      if (!Constant) {
+        // With --pack-dyn-relocs=relr, word-sized and word-aligned
+        // absolute words go to the compact .relr.dyn section. RELR
+        // entries carry no addend: the loader adds the load bias to
+        // whatever the word contains, so the link-time value must be
+        // written below as if the relocation were a constant.
+        if (In<ELFT>::RelrDyn && Expr == R_ABS &&
+            C.Alignment >= sizeof(uintX_t) && Offset % sizeof(uintX_t) == 0) {
+          In<ELFT>::RelrDyn->addReloc(&C, Offset);
+          UseRelr = true;
+        } else {
+          AddDyn({Target->RelativeRel, &C, Offset, true, &Body, Addend});
+        }
+      }
 
       // If the produced value is a constant, we just remember to write it
       // when outputting this section. We also have to do it if the format
       // uses Elf_Rel, since in that case the written value is the addend.
-      if (Constant || !RelTy::IsRela)
+      if (Constant || !RelTy::IsRela || UseRelr)
         C.Relocations.push_back({Expr, Type, Offset, Addend, &Body});
     } else {
       // We don't know anything about the finaly symbol. Just ask the dynamic
@@ -778,18 +827,113 @@ static void scanRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels) {
   }
 }
 
+// Resolves the target symbol of every relocation of every input
+// section into InputSectionBase::RelocTargets. markLive, ICF, the
+// thunk scan and the relocation scan all iterate the full edge set;
+// resolving each edge here, once and in parallel, lets the passes
+// share the result instead of re-deriving it per pass. One slab sized
+// up front backs all the per-section arrays, keeping the (serial)
+// arena out of the parallel loop.
+template <class ELFT, class RelTy>
+static void resolveRelocTargets(InputSectionBase<ELFT> *S,
+                                ArrayRef<RelTy> Rels) {
+  const elf::ObjectFile<ELFT> *File = S->getFile();
+  for (size_t I = 0, E = Rels.size(); I != E; ++I)
+    S->RelocTargets[I] = &File->getRelocTargetSym(Rels[I]);
+}
+
+template <class ELFT> void buildRelocTargetIndex() {
+  std::vector<InputSectionBase<ELFT> *> &Sections = Symtab<ELFT>::X->Sections;
+  size_t NumEdges = 0;
+  for (InputSectionBase<ELFT> *S : Sections)
+    NumEdges += S->NumRelocations;
+  SymbolBody **Slab = BAlloc.Allocate<SymbolBody *>(NumEdges);
+  for (InputSectionBase<ELFT> *S : Sections) {
+    S->RelocTargets = Slab;
+    Slab += S->NumRelocations;
+  }
+  forEach(Sections.begin(), Sections.end(), [](InputSectionBase<ELFT> *S) {
+    if (!S->NumRelocations)
+      return;
+    if (S->AreRelocsRela)
+      resolveRelocTargets(S, S->relas());
+    else
+      resolveRelocTargets(S, S->rels());
+  });
+}
+
+template <class ELFT>
+static void classifyRelocations(InputSectionBase<ELFT> &S,
+                                std::vector<RelExpr> &Exprs) {
+  if (S.AreRelocsRela)
+    classifyRelocs(S, S.relas(), Exprs);
+  else
+    classifyRelocs(S, S.rels(), Exprs);
+}
+
 template <class ELFT> void scanRelocations(InputSectionBase<ELFT> &S) {
+  std::vector<RelExpr> Exprs;
+  classifyRelocations(S, Exprs);
   if (S.AreRelocsRela)
-    scanRelocs(S, S.relas());
+    scanRelocs(S, S.relas(), Exprs);
   else
-    scanRelocs(S, S.rels());
+    scanRelocs(S, S.rels(), Exprs);
 }
 
+// Scans the relocations of the given sections in two phases: a
+// parallel classification phase that computes the RelExpr of every
+// relocation, and a serial commit phase that allocates GOT and PLT
+// entries and emits dynamic relocations in a deterministic order.
+// The classification is the bulk of the per-relocation work, so this
+// removes most of the pass from the critical path.
+template <class ELFT>
+void scanRelocations(ArrayRef<InputSectionBase<ELFT> *> Sections) {
+  // Hand every section its relocation record storage as one slice of
+  // a single arena slab before the scan starts. A section's relocation
+  // count is an exact upper bound on the records the scan emits for it
+  // (each input relocation produces at most one), so the commit phase
+  // below appends without ever reallocating; the slack left by
+  // relocations that end up purely dynamic or relaxed away stays in
+  // the arena, which never frees anyway.
+  size_t NumRecords = 0;
+  for (InputSectionBase<ELFT> *S : Sections)
+    NumRecords += S->NumRelocations;
+  Relocation *Slab = BAlloc.Allocate<Relocation>(NumRecords);
+  for (InputSectionBase<ELFT> *S : Sections) {
+    S->Relocations.reserveSlice(Slab, S->NumRelocations);
+    Slab += S->NumRelocations;
+  }
+
+  std::vector<std::vector<RelExpr>> Exprs(Sections.size());
+  forLoop(0, Sections.size(),
+          [&](size_t I) { classifyRelocations(*Sections[I], Exprs[I]); });
+
+  // Once the error budget trips, forLoop skips the remaining classify
+  // tasks and leaves their Exprs entries empty. The commit loop below
+  // indexes Exprs one-to-one with the relocations of each section, so
+  // it must not run on a cancelled link.
+  if (linkCancelled())
+    return;
+
+  for (size_t I = 0, E = Sections.size(); I != E; ++I) {
+    InputSectionBase<ELFT> &S = *Sections[I];
+    if (S.AreRelocsRela)
+      scanRelocs(S, S.relas(), Exprs[I]);
+    else
+      scanRelocs(S, S.rels(), Exprs[I]);
+  }
+}
+
+// Finds the relocations of C that need a thunk. This only reads the
+// section and the symbol table, so it is safe to run in parallel for
+// many sections.
 template <class ELFT, class RelTy>
-static void createThunks(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels) {
+static void findThunkRelocs(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels,
+                            std::vector<std::pair<uint32_t, SymbolBody *>> &V) {
   const elf::ObjectFile<ELFT> *File = C.getFile();
-  for (const RelTy &Rel : Rels) {
-    SymbolBody &Body = File->getRelocTargetSym(Rel);
+  for (size_t I = 0, E = Rels.size(); I != E; ++I) {
+    const RelTy &Rel = Rels[I];
+    SymbolBody &Body = *C.RelocTargets[I];
     uint32_t Type = Rel.getType(Config->Mips64EL);
     RelExpr Expr = Target->getRelExpr(Type, Body);
     if (!isPreemptible(Body, Type) && needsPlt(Expr))
@@ -798,28 +942,67 @@ static void createThunks(InputSectionBase<ELFT> &C, ArrayRef<RelTy> Rels) {
     // Some targets might require creation of thunks for relocations.
     // Now we support only MIPS which requires LA25 thunk to call PIC
     // code from non-PIC one, and ARM which requires interworking.
-    if (Expr == R_THUNK_ABS || Expr == R_THUNK_PC || Expr == R_THUNK_PLT_PC) {
-      auto *Sec = cast<InputSection<ELFT>>(&C);
-      addThunk<ELFT>(Type, Body, *Sec);
-    }
+    if (Expr == R_THUNK_ABS || Expr == R_THUNK_PC || Expr == R_THUNK_PLT_PC)
+      V.push_back({Type, &Body});
   }
 }
 
 template <class ELFT> void createThunks(InputSectionBase<ELFT> &S) {
+  std::vector<std::pair<uint32_t, SymbolBody *>> V;
   if (S.AreRelocsRela)
-    createThunks(S, S.relas());
+    findThunkRelocs(S, S.relas(), V);
   else
-    createThunks(S, S.rels());
+    findThunkRelocs(S, S.rels(), V);
+  for (std::pair<uint32_t, SymbolBody *> &P : V)
+    addThunk<ELFT>(P.first, *P.second, *cast<InputSection<ELFT>>(&S));
 }
 
+// Creates thunks for the given sections in two phases, like
+// scanRelocations above: scanning the relocations for thunk
+// candidates runs in parallel, and the thunks themselves are created
+// serially so that thunk offsets are assigned in a deterministic
+// order.
+template <class ELFT>
+void createThunks(ArrayRef<InputSectionBase<ELFT> *> Sections) {
+  std::vector<std::vector<std::pair<uint32_t, SymbolBody *>>> Thunks(
+      Sections.size());
+  forLoop(0, Sections.size(), [&](size_t I) {
+    InputSectionBase<ELFT> &S = *Sections[I];
+    if (S.AreRelocsRela)
+      findThunkRelocs(S, S.relas(), Thunks[I]);
+    else
+      findThunkRelocs(S, S.rels(), Thunks[I]);
+  });
+
+  for (size_t I = 0, E = Sections.size(); I != E; ++I)
+    for (std::pair<uint32_t, SymbolBody *> &P : Thunks[I])
+      addThunk<ELFT>(P.first, *P.second,
+                     *cast<InputSection<ELFT>>(Sections[I]));
+}
+
+template void buildRelocTargetIndex<ELF32LE>();
+template void buildRelocTargetIndex<ELF32BE>();
+template void buildRelocTargetIndex<ELF64LE>();
+template void buildRelocTargetIndex<ELF64BE>();
+
 template void scanRelocations<ELF32LE>(InputSectionBase<ELF32LE> &);
 template void scanRelocations<ELF32BE>(InputSectionBase<ELF32BE> &);
 template void scanRelocations<ELF64LE>(InputSectionBase<ELF64LE> &);
 template void scanRelocations<ELF64BE>(InputSectionBase<ELF64BE> &);
 
+template void scanRelocations<ELF32LE>(ArrayRef<InputSectionBase<ELF32LE> *>);
+template void scanRelocations<ELF32BE>(ArrayRef<InputSectionBase<ELF32BE> *>);
+template void scanRelocations<ELF64LE>(ArrayRef<InputSectionBase<ELF64LE> *>);
+template void scanRelocations<ELF64BE>(ArrayRef<InputSectionBase<ELF64BE> *>);
+
 template void createThunks<ELF32LE>(InputSectionBase<ELF32LE> &);
 template void createThunks<ELF32BE>(InputSectionBase<ELF32BE> &);
 template void createThunks<ELF64LE>(InputSectionBase<ELF64LE> &);
 template void createThunks<ELF64BE>(InputSectionBase<ELF64BE> &);
+
+template void createThunks<ELF32LE>(ArrayRef<InputSectionBase<ELF32LE> *>);
+template void createThunks<ELF32BE>(ArrayRef<InputSectionBase<ELF32BE> *>);
+template void createThunks<ELF64LE>(ArrayRef<InputSectionBase<ELF64LE> *>);
+template void createThunks<ELF64BE>(ArrayRef<InputSectionBase<ELF64BE> *>);
 }
 }
@@ -112,9 +112,19 @@ struct Relocation {
   SymbolBody *Sym;
 };
 
+// Resolves the target symbol of every relocation of every input
+// section into the arena-backed InputSectionBase::RelocTargets index.
+// Must run after symbol resolution and before markLive/doIcf/
+// scanRelocations, which consume the index.
+template <class ELFT> void buildRelocTargetIndex();
+
 template <class ELFT> void scanRelocations(InputSectionBase<ELFT> &);
+template <class ELFT>
+void scanRelocations(ArrayRef<InputSectionBase<ELFT> *> Sections);
 
 template <class ELFT> void createThunks(InputSectionBase<ELFT> &);
+template <class ELFT>
+void createThunks(ArrayRef<InputSectionBase<ELFT> *> Sections);
 
 template <class ELFT>
 static inline typename ELFT::uint getAddend(const typename ELFT::Rel &Rel) {
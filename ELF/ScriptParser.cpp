@@ -15,6 +15,7 @@
 #include "ScriptParser.h"
 #include "Error.h"
 #include "llvm/ADT/Twine.h"
+#include <array>
 
 using namespace llvm;
 using namespace lld;
@@ -70,6 +71,29 @@ void ScriptParserBase::setError(const Twine &Msg) {
   error(S + std::string(getColumnNumber(), ' ') + "^");
 }
 
+// Characters that can appear in an unquoted token. This is more
+// relaxed than tokens in C-like language, so that you can write
+// "file-name.cpp" as one bare token, for example. Classifying through
+// a byte-indexed table keeps the scan to one load per character;
+// find_first_not_of would rebuild a 256-bit set per token, which is
+// what multi-megabyte generated SECTIONS scripts spend their time on.
+static bool isWordChar(unsigned char C) {
+  static const std::array<bool, 256> Table = [] {
+    std::array<bool, 256> T = {};
+    for (unsigned char WC : StringRef(
+             "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+             "0123456789_.$/\\~=+[]*?-:!<>^"))
+      T[WC] = true;
+    return T;
+  }();
+  return Table[C];
+}
+
+static bool isSpaceChar(char C) {
+  return C == ' ' || C == '\t' || C == '\n' || C == '\v' || C == '\f' ||
+         C == '\r';
+}
+
 // Split S into linker script tokens.
 void ScriptParserBase::tokenize(MemoryBufferRef MB) {
   std::vector<StringRef> Vec;
@@ -77,6 +101,10 @@ void ScriptParserBase::tokenize(MemoryBufferRef MB) {
   StringRef S = MB.getBuffer();
   StringRef Begin = S;
 
+  // A generated script averages a handful of bytes per token;
+  // preallocate so the push_backs below never reallocate mid-scan.
+  Vec.reserve(S.size() / 8);
+
   for (;;) {
     S = skipSpace(S);
     if (S.empty())
@@ -100,11 +128,11 @@ void ScriptParserBase::tokenize(MemoryBufferRef MB) {
       continue;
     }
 
-    // Unquoted token. This is more relaxed than tokens in C-like language,
-    // so that you can write "file-name.cpp" as one bare token, for example.
-    size_t Pos = S.find_first_not_of(
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
-        "0123456789_.$/\\~=+[]*?-:!<>^");
+    // Unquoted token.
+    size_t Pos = 0;
+    size_t End = S.size();
+    while (Pos != End && isWordChar(S[Pos]))
+      ++Pos;
 
     // A character that cannot start a word (which is usually a
     // punctuation) forms a single character token.
@@ -136,10 +164,15 @@ StringRef ScriptParserBase::skipSpace(StringRef S) {
       S = S.substr(E + 1);
       continue;
     }
-    size_t Size = S.size();
-    S = S.ltrim();
-    if (S.size() == Size)
+    // Whitespace run. ltrim would rebuild its character set per call;
+    // see isWordChar above.
+    size_t I = 0;
+    size_t E = S.size();
+    while (I != E && isSpaceChar(S[I]))
+      ++I;
+    if (I == 0)
       return S;
+    S = S.substr(I);
   }
 }
 
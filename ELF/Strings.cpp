@@ -10,13 +10,17 @@
 #include "Strings.h"
 #include "Config.h"
 #include "Error.h"
+#include "lld/Support/Memory.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Config/config.h"
 #include "llvm/Demangle/Demangle.h"
 #include <algorithm>
 #include <cstring>
+#include <mutex>
 
 using namespace llvm;
 using namespace lld;
@@ -147,11 +151,17 @@ bool GlobPattern::matchOne(ArrayRef<BitVector> Pats, StringRef S) const {
 }
 
 StringMatcher::StringMatcher(const std::vector<StringRef> &Pat) {
-  for (StringRef S : Pat)
-    Patterns.push_back(GlobPattern(S));
+  for (StringRef S : Pat) {
+    if (!hasWildcard(S))
+      Exact.insert(CachedHashStringRef(S));
+    else
+      Patterns.push_back(GlobPattern(S));
+  }
 }
 
 bool StringMatcher::match(StringRef S) const {
+  if (!Exact.empty() && Exact.count(CachedHashStringRef(S)))
+    return true;
   for (const GlobPattern &Pat : Patterns)
     if (Pat.match(S))
       return true;
@@ -210,6 +220,13 @@ bool elf::isValidCIdentifier(StringRef S) {
 }
 
 // Returns the demangled C++ symbol name for Name.
+//
+// Demangling is fairly expensive, and diagnostics and the "extern C++"
+// version script matcher tend to ask for the same names over and over,
+// so we memoize the results. Demangled names are saved in the arena
+// allocator; they are small compared to the inputs and would live
+// until the end of the process anyway. Failures are remembered too, as
+// entries with a null string.
 Optional<std::string> elf::demangle(StringRef Name) {
   // __cxa_demangle can be used to demangle strings other than symbol
   // names which do not necessarily start with "_Z". Name can be
@@ -219,10 +236,34 @@ Optional<std::string> elf::demangle(StringRef Name) {
   if (!Name.startswith("_Z"))
     return None;
 
+  // Diagnostics can be produced from parallel passes, so the cache is
+  // guarded by a mutex. The demangler itself runs outside the lock so
+  // that distinct names can be demangled concurrently.
+  static std::mutex Mu;
+  static DenseMap<CachedHashStringRef, StringRef> Cache;
+
+  CachedHashStringRef Key(Name);
+  {
+    std::lock_guard<std::mutex> Lock(Mu);
+    auto It = Cache.find(Key);
+    if (It != Cache.end()) {
+      if (!It->second.data())
+        return None;
+      return It->second.str();
+    }
+  }
+
   char *Buf = itaniumDemangle(Name.str().c_str(), nullptr, nullptr, nullptr);
-  if (!Buf)
+
+  std::lock_guard<std::mutex> Lock(Mu);
+  StringRef S;
+  if (Buf) {
+    // The arena allocator is not thread-safe, so save under the lock.
+    S = Saver.save(StringRef(Buf));
+    free(Buf);
+  }
+  Cache.insert({Key, S});
+  if (!S.data())
     return None;
-  std::string S(Buf);
-  free(Buf);
-  return S;
+  return S.str();
 }
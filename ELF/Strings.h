@@ -13,6 +13,8 @@
 #include "lld/Core/LLVM.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringRef.h"
 #include <vector>
@@ -89,6 +91,12 @@ public:
   bool match(StringRef S) const;
 
 private:
+  // Patterns that contain no wildcard are kept in a hash set, so a
+  // list of literal section names costs one lookup to match no matter
+  // how long it is. Only real glob patterns have to be tried one by
+  // one. Generated linker scripts often consist mostly of literals, so
+  // this matters for the patterns-times-sections matching loop.
+  llvm::DenseSet<llvm::CachedHashStringRef> Exact;
   std::vector<GlobPattern> Patterns;
 };
 
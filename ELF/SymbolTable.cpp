@@ -19,8 +19,10 @@
 #include "Error.h"
 #include "LinkerScript.h"
 #include "Symbols.h"
+#include "Threads.h"
 #include "lld/Support/Memory.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/xxhash.h"
 
 using namespace llvm;
 using namespace llvm::object;
@@ -51,6 +53,18 @@ template <class ELFT> static bool isCompatible(InputFile *F) {
 }
 
 // Add symbols in File to the symbol table.
+// Presize the name-to-symbol map shards and the symbol vector so
+// resolution never grows them by rehash-and-copy; with millions of
+// symbols the rehashing alone copies hundreds of megabytes. The
+// estimate is an upper bound -- the same name is counted once per
+// file that mentions it -- so some bucket overshoot is traded for
+// never rehashing.
+template <class ELFT> void SymbolTable<ELFT>::reserve(size_t EstimatedGlobals) {
+  for (Shard &S : Shards)
+    S.Map.reserve(EstimatedGlobals / NumShards + 1);
+  SymVector.reserve(EstimatedGlobals);
+}
+
 template <class ELFT> void SymbolTable<ELFT>::addFile(InputFile *File) {
   if (!isCompatible<ELFT>(File))
     return;
@@ -148,7 +162,10 @@ DefinedRegular<ELFT> *SymbolTable<ELFT>::addIgnored(StringRef Name,
 // Set a flag for --trace-symbol so that we can print out a log message
 // if a new symbol with the same name is inserted into the symbol table.
 template <class ELFT> void SymbolTable<ELFT>::trace(StringRef Name) {
-  Symtab.insert({CachedHashStringRef(Name), {-1, true}});
+  SymName CachedName(Name);
+  Shard &Sh = getShard(CachedName);
+  std::lock_guard<std::mutex> Lock(Sh.Mu);
+  Sh.Map.insert({CachedName, {-1, true}});
 }
 
 // Rename SYM as __wrap_SYM. The original symbol is preserved as __real_SYM.
@@ -177,20 +194,28 @@ static uint8_t getMinVisibility(uint8_t VA, uint8_t VB) {
 }
 
 // Find an existing symbol or create and insert a new one.
+// Only the shard the name hashes to is locked, so concurrent callers
+// working on different names rarely serialize against each other.
 template <class ELFT>
 std::pair<Symbol *, bool> SymbolTable<ELFT>::insert(StringRef Name) {
-  auto P = Symtab.insert(
-      {CachedHashStringRef(Name), SymIndex((int)SymVector.size(), false)});
+  SymName CachedName(Name);
+  Shard &Sh = getShard(CachedName);
+  std::lock_guard<std::mutex> Lock(Sh.Mu);
+
+  auto P = Sh.Map.insert({CachedName, SymIndex(-2, false)});
   SymIndex &V = P.first->second;
   bool IsNew = P.second;
 
-  if (V.Idx == -1) {
+  // An Idx of -1 means the name was registered by trace() and no
+  // symbol has been created for it yet.
+  if (V.Idx == -1)
     IsNew = true;
-    V = SymIndex((int)SymVector.size(), true);
-  }
 
   Symbol *Sym;
   if (IsNew) {
+    // BAlloc is not thread-safe, so the allocation has to happen
+    // under the same lock as the vector push.
+    std::lock_guard<std::mutex> VecLock(SymVectorMu);
     Sym = new (BAlloc) Symbol;
     Sym->InVersionScript = false;
     Sym->Binding = STB_WEAK;
@@ -199,6 +224,7 @@ std::pair<Symbol *, bool> SymbolTable<ELFT>::insert(StringRef Name) {
     Sym->ExportDynamic = false;
     Sym->Traced = V.Traced;
     Sym->VersionId = Config->DefaultSymbolVersion;
+    V.Idx = (int)SymVector.size();
     SymVector.push_back(Sym);
   } else {
     Sym = SymVector[V.Idx];
@@ -255,6 +281,8 @@ Symbol *SymbolTable<ELFT>::addUndefined(StringRef Name, bool IsLocal,
   if (WasInserted) {
     S->Binding = Binding;
     replaceBody<Undefined>(S, Name, IsLocal, StOther, Type, File);
+    if (Binding != STB_WEAK)
+      fetchLazyRoute(Name);
     return S;
   }
   if (Binding != STB_WEAK) {
@@ -270,6 +298,10 @@ Symbol *SymbolTable<ELFT>::addUndefined(StringRef Name, bool IsLocal,
       L->Type = Type;
     else if (InputFile *F = L->fetch())
       addFile(F);
+  } else if (Binding != STB_WEAK && S->body()->isUndefined()) {
+    // A strong undefined meeting an existing weak undefined: an
+    // archive may have parked an entry for the name in the meantime.
+    fetchLazyRoute(Name);
   }
   return S;
 }
@@ -412,6 +444,61 @@ Symbol *SymbolTable<ELFT>::addSynthetic(StringRef N,
   return S;
 }
 
+// Defines a symbol assignment or PROVIDE from the linker script.
+// Scripts for embedded targets carry PROVIDE lists a thousand entries
+// long, so a PROVIDE pays for exactly one probe of the table: the
+// lookup that decides whether it takes effect hands back the entry the
+// definition then replaces in place. The old find-then-add pattern
+// probed twice per PROVIDE.
+template <typename ELFT>
+Symbol *SymbolTable<ELFT>::addScripted(StringRef Name, bool Provide,
+                                       bool IsAbsolute,
+                                       const OutputSectionBase *Section,
+                                       uint8_t StOther) {
+  Symbol *S = nullptr;
+  bool WasInserted = false;
+  if (Provide) {
+    // A PROVIDE for a name the link never mentions must not create an
+    // entry, so this is a plain probe whose result is reused below.
+    SymName CachedName(Name);
+    Shard &Sh = getShard(CachedName);
+    {
+      std::lock_guard<std::mutex> Lock(Sh.Mu);
+      auto It = Sh.Map.find(CachedName);
+      if (It == Sh.Map.end() || It->second.Idx < 0)
+        return nullptr;
+      S = SymVector[It->second.Idx];
+    }
+    if (!S->body()->isUndefined())
+      return nullptr;
+  } else {
+    std::tie(S, WasInserted) = insert(Name);
+  }
+
+  // The same attribute merging insert() performs for a definition
+  // coming from a regular object.
+  S->Visibility = getMinVisibility(S->Visibility, StOther & 3);
+  if (Config->Shared || Config->ExportDynamic)
+    S->ExportDynamic = true;
+  S->IsUsedInRegularObj = true;
+  if (!WasInserted && S->body()->Type != SymbolBody::UnknownType &&
+      S->body()->isTls())
+    error("TLS attribute mismatch for symbol " + conflictMsg(S->body(), nullptr));
+
+  int Cmp = compareDefinedNonCommon<ELFT>(S, WasInserted, STB_GLOBAL,
+                                          IsAbsolute, /*Value*/ 0);
+  if (Cmp > 0) {
+    if (IsAbsolute)
+      replaceBody<DefinedRegular<ELFT>>(S, Name, /*IsLocal=*/false, StOther,
+                                        STT_NOTYPE, 0, 0, nullptr, nullptr);
+    else
+      replaceBody<DefinedSynthetic<ELFT>>(S, Name, 0, Section);
+  } else if (Cmp == 0) {
+    reportDuplicate(S->body(), nullptr);
+  }
+  return S;
+}
+
 template <typename ELFT>
 void SymbolTable<ELFT>::addShared(SharedFile<ELFT> *F, StringRef Name,
                                   const Elf_Sym &Sym,
@@ -430,6 +517,16 @@ void SymbolTable<ELFT>::addShared(SharedFile<ELFT> *F, StringRef Name,
     if (S->VersionId == VER_NDX_LOCAL)
       S->VersionId = VER_NDX_GLOBAL;
   }
+  // An archive registered this name before the DSO. Keep the archive
+  // entry as a lazy symbol so a later strong undefined still prefers
+  // the archive member over the DSO definition, as it did when every
+  // archive index entry became a lazy symbol.
+  if (WasInserted) {
+    if (ArchiveRoute *R = findLazyRoute(Name)) {
+      replaceBody<LazyArchive>(S, *R->File, R->Sym, SymbolBody::UnknownType);
+      return;
+    }
+  }
   if (WasInserted || isa<Undefined>(S->body())) {
     replaceBody<SharedSymbol<ELFT>>(S, F, Name, Sym, Verdef);
     if (!S->isWeak())
@@ -456,8 +553,11 @@ Symbol *SymbolTable<ELFT>::addBitcode(StringRef Name, uint8_t Binding,
 }
 
 template <class ELFT> SymbolBody *SymbolTable<ELFT>::find(StringRef Name) {
-  auto It = Symtab.find(CachedHashStringRef(Name));
-  if (It == Symtab.end())
+  SymName CachedName(Name);
+  Shard &Sh = getShard(CachedName);
+  std::lock_guard<std::mutex> Lock(Sh.Mu);
+  auto It = Sh.Map.find(CachedName);
+  if (It == Sh.Map.end())
     return nullptr;
   SymIndex V = It->second;
   if (V.Idx == -1)
@@ -465,34 +565,107 @@ template <class ELFT> SymbolBody *SymbolTable<ELFT>::find(StringRef Name) {
   return SymVector[V.Idx]->body();
 }
 
+// The two probe positions of the Bloom filter over the routing table
+// keys are both derived from the 64-bit name hash.
+static void bloomAdd(std::vector<uint64_t> &Bits, uint64_t Hash) {
+  uint64_t Mask = Bits.size() * 64 - 1;
+  Bits[(Hash & Mask) / 64] |= uint64_t(1) << (Hash & 63);
+  uint64_t H2 = Hash * 0x9E3779B97F4A7C15ULL;
+  Bits[(H2 & Mask) / 64] |= uint64_t(1) << (H2 & 63);
+}
+
+static bool bloomTest(const std::vector<uint64_t> &Bits, uint64_t Hash) {
+  if (Bits.empty())
+    return false;
+  uint64_t Mask = Bits.size() * 64 - 1;
+  if (!(Bits[(Hash & Mask) / 64] & (uint64_t(1) << (Hash & 63))))
+    return false;
+  uint64_t H2 = Hash * 0x9E3779B97F4A7C15ULL;
+  return Bits[(H2 & Mask) / 64] & (uint64_t(1) << (H2 & 63));
+}
+
+// Parks an archive index entry for later. Called for names the symbol
+// table has not seen yet; fetchLazyRoute pulls the entry in when an
+// undefined of the same name appears. The first archive to register a
+// name wins, as it does for lazy symbols.
+template <class ELFT>
+void SymbolTable<ELFT>::routeLazyArchive(ArchiveFile *F,
+                                         const object::Archive::Symbol &Sym,
+                                         StringRef Name) {
+  uint64_t Hash = xxHash64(Name);
+  llvm::SmallVector<ArchiveRoute, 1> &Bucket = LazyRoutes[Hash];
+  for (ArchiveRoute &R : Bucket)
+    if (R.Sym.getName() == Name)
+      return;
+  Bucket.push_back({F, Sym});
+
+  // Keep the filter at about 16 bits per parked name. It can be
+  // rebuilt from the map keys when it gets too dense.
+  if (LazyRoutes.size() * 16 > LazyBloom.size() * 64) {
+    LazyBloom.assign(std::max<size_t>(1024, LazyBloom.size() * 2), 0);
+    for (const auto &P : LazyRoutes)
+      bloomAdd(LazyBloom, P.first);
+  } else {
+    bloomAdd(LazyBloom, Hash);
+  }
+}
+
+template <class ELFT>
+typename SymbolTable<ELFT>::ArchiveRoute *
+SymbolTable<ELFT>::findLazyRoute(StringRef Name) {
+  if (LazyRoutes.empty())
+    return nullptr;
+  uint64_t Hash = xxHash64(Name);
+  if (!bloomTest(LazyBloom, Hash))
+    return nullptr;
+  auto It = LazyRoutes.find(Hash);
+  if (It == LazyRoutes.end())
+    return nullptr;
+  for (ArchiveRoute &R : It->second)
+    if (R.Sym.getName() == Name)
+      return &R;
+  return nullptr;
+}
+
+// If an archive parked an entry for Name, link the defining member,
+// like an undefined symbol meeting a lazy one. Returns false if no
+// archive routes Name.
+template <class ELFT> bool SymbolTable<ELFT>::fetchLazyRoute(StringRef Name) {
+  ArchiveRoute *R = findLazyRoute(Name);
+  if (!R)
+    return false;
+  // Copy out of the table; linking the member can add more routes and
+  // invalidate R.
+  ArchiveFile *F = R->File;
+  object::Archive::Symbol Sym = R->Sym;
+  std::pair<MemoryBufferRef, uint64_t> MBInfo = F->getMember(&Sym);
+  if (!MBInfo.first.getBuffer().empty())
+    addFile(F->createMemberFile(MBInfo.first, MBInfo.second));
+  return true;
+}
+
 template <class ELFT>
 void SymbolTable<ELFT>::addLazyArchive(ArchiveFile *F,
                                        const object::Archive::Symbol Sym) {
-  Symbol *S;
-  bool WasInserted;
   StringRef Name = Sym.getName();
-  std::tie(S, WasInserted) = insert(Name);
-  if (WasInserted) {
-    replaceBody<LazyArchive>(S, *F, Sym, SymbolBody::UnknownType);
+  SymbolBody *B = find(Name);
+
+  // The overwhelming majority of archive index entries name symbols
+  // nothing in the link references. Those go to the routing table
+  // instead of the symbol table, as do weak undefineds: a weak
+  // undefined must not fetch the member, but a strong undefined
+  // arriving later pulls the parked entry in (see addUndefined).
+  if (!B || (B->isUndefined() && B->symbol()->isWeak())) {
+    routeLazyArchive(F, Sym, Name);
     return;
   }
-  if (!S->body()->isUndefined())
+  if (!B->isUndefined())
     return;
 
-  // Weak undefined symbols should not fetch members from archives. If we were
-  // to keep old symbol we would not know that an archive member was available
-  // if a strong undefined symbol shows up afterwards in the link. If a strong
-  // undefined symbol never shows up, this lazy symbol will get to the end of
-  // the link and must be treated as the weak undefined one. We already marked
-  // this symbol as used when we added it to the symbol table, but we also need
-  // to preserve its type. FIXME: Move the Type field to Symbol.
-  if (S->isWeak()) {
-    replaceBody<LazyArchive>(S, *F, Sym, S->body()->Type);
-    return;
-  }
+  // A strong undefined is already waiting for this name.
   std::pair<MemoryBufferRef, uint64_t> MBInfo = F->getMember(&Sym);
   if (!MBInfo.first.getBuffer().empty())
-    addFile(createObjectFile(MBInfo.first, F->getName(), MBInfo.second));
+    addFile(F->createMemberFile(MBInfo.first, MBInfo.second));
 }
 
 template <class ELFT>
@@ -501,7 +674,12 @@ void SymbolTable<ELFT>::addLazyObject(StringRef Name, LazyObjectFile &Obj) {
   bool WasInserted;
   std::tie(S, WasInserted) = insert(Name);
   if (WasInserted) {
-    replaceBody<LazyObject>(S, Name, Obj, SymbolBody::UnknownType);
+    // If an archive registered this name first, it keeps precedence:
+    // materialize the parked entry as the lazy symbol instead.
+    if (ArchiveRoute *R = findLazyRoute(Name))
+      replaceBody<LazyArchive>(S, *R->File, R->Sym, SymbolBody::UnknownType);
+    else
+      replaceBody<LazyObject>(S, Name, Obj, SymbolBody::UnknownType);
     return;
   }
   if (!S->body()->isUndefined())
@@ -519,10 +697,14 @@ void SymbolTable<ELFT>::addLazyObject(StringRef Name, LazyObjectFile &Obj) {
 
 // Process undefined (-u) flags by loading lazy symbols named by those flags.
 template <class ELFT> void SymbolTable<ELFT>::scanUndefinedFlags() {
-  for (StringRef S : Config->Undefined)
-    if (auto *L = dyn_cast_or_null<Lazy>(find(S)))
+  for (StringRef S : Config->Undefined) {
+    if (auto *L = dyn_cast_or_null<Lazy>(find(S))) {
       if (InputFile *File = L->fetch())
         addFile(File);
+    } else {
+      fetchLazyRoute(S);
+    }
+  }
 }
 
 // This function takes care of the case in which shared libraries depend on
@@ -559,13 +741,20 @@ void SymbolTable<ELFT>::initDemangledSyms() {
     return;
   DemangledSyms.emplace();
 
-  for (Symbol *Sym : SymVector) {
-    SymbolBody *B = Sym->body();
+  // Demangling is the expensive part and every name is independent,
+  // so compute the demangled names in parallel, then build the map
+  // serially.
+  std::vector<std::string> Names(SymVector.size());
+  forLoop(0, SymVector.size(), [&](size_t I) {
+    SymbolBody *B = SymVector[I]->body();
     if (Optional<std::string> S = demangle(B->getName()))
-      (*DemangledSyms)[*S].push_back(B);
+      Names[I] = std::move(*S);
     else
-      (*DemangledSyms)[B->getName()].push_back(B);
-  }
+      Names[I] = B->getName();
+  });
+
+  for (size_t I = 0, E = SymVector.size(); I != E; ++I)
+    (*DemangledSyms)[Names[I]].push_back(SymVector[I]->body());
 }
 
 template <class ELFT>
@@ -668,6 +857,45 @@ void SymbolTable<ELFT>::assignWildcardVersion(SymbolVersion Ver,
       B->symbol()->VersionId = VersionId;
 }
 
+// Assigns versions to symbols matching a batch of wildcard patterns,
+// given in precedence order. Instead of walking the entire symbol
+// table once per pattern (patterns times symbols glob interpretations
+// on an ABI-managed library), this makes a single pass over the table,
+// sharded with --threads, and stops at the first matching pattern per
+// symbol. Each pattern is compiled into a StringMatcher once up front.
+// This is safe to run in parallel because each iteration only writes
+// to its own Symbol.
+template <class ELFT>
+void SymbolTable<ELFT>::assignWildcardVersions(
+    ArrayRef<std::pair<SymbolVersion, uint16_t>> Patterns) {
+  if (Patterns.empty())
+    return;
+
+  std::vector<std::pair<StringMatcher, uint16_t>> Matchers;
+  Matchers.reserve(Patterns.size());
+  for (const std::pair<SymbolVersion, uint16_t> &P : Patterns)
+    Matchers.push_back({StringMatcher({P.first.Name}), P.second});
+
+  forLoop(0, SymVector.size(), [&](size_t I) {
+    Symbol *Sym = SymVector[I];
+    // Exact matching takes precedence over fuzzy matching, and among
+    // fuzzy matches the first pattern in precedence order wins, so a
+    // symbol that already has a version keeps it.
+    if (Sym->VersionId != Config->DefaultSymbolVersion)
+      return;
+    SymbolBody *B = Sym->body();
+    if (B->isUndefined())
+      return;
+    StringRef Name = B->getName();
+    for (const std::pair<StringMatcher, uint16_t> &M : Matchers) {
+      if (M.first.match(Name)) {
+        Sym->VersionId = M.second;
+        break;
+      }
+    }
+  });
+}
+
 // This function processes version scripts by updating VersionId
 // member of symbols.
 template <class ELFT> void SymbolTable<ELFT>::scanVersionScript() {
@@ -703,11 +931,30 @@ template <class ELFT> void SymbolTable<ELFT>::scanVersionScript() {
   // i.e. version definitions containing glob meta-characters.
   // Note that because the last match takes precedence over previous matches,
   // we iterate over the definitions in the reverse order.
+  //
+  // Plain patterns are batched up in precedence order and applied in
+  // one pass over the symbol table by assignWildcardVersions. "extern
+  // C++" patterns match against demangled names and keep the
+  // per-pattern path; the batch is flushed before one runs so that the
+  // application order still follows the precedence order.
+  std::vector<std::pair<SymbolVersion, uint16_t>> Batch;
+  auto AddWildcard = [&](SymbolVersion &Ver, uint16_t VersionId) {
+    if (!Ver.HasWildcard)
+      return;
+    if (Ver.IsExternCpp) {
+      assignWildcardVersions(Batch);
+      Batch.clear();
+      assignWildcardVersion(Ver, VersionId);
+      return;
+    }
+    Batch.push_back({Ver, VersionId});
+  };
   for (SymbolVersion &Ver : Config->VersionScriptLocals)
-    assignWildcardVersion(Ver, VER_NDX_LOCAL);
+    AddWildcard(Ver, VER_NDX_LOCAL);
   for (VersionDefinition &V : llvm::reverse(Config->VersionDefinitions))
     for (SymbolVersion &Ver : V.Globals)
-      assignWildcardVersion(Ver, V.Id);
+      AddWildcard(Ver, V.Id);
+  assignWildcardVersions(Batch);
 }
 
 template class elf::SymbolTable<ELF32LE>;
@@ -16,6 +16,8 @@
 #include "llvm/ADT/CachedHashString.h"
 #include "llvm/ADT/DenseMap.h"
 
+#include <mutex>
+
 namespace lld {
 namespace elf {
 class Lazy;
@@ -43,6 +45,7 @@ template <class ELFT> class SymbolTable {
 public:
   void addFile(InputFile *File);
   void addCombinedLTOObject();
+  void reserve(size_t EstimatedGlobals);
 
   ArrayRef<Symbol *> getSymbols() const { return SymVector; }
   ArrayRef<ObjectFile<ELFT> *> getObjectFiles() const { return ObjectFiles; }
@@ -67,6 +70,13 @@ public:
   Symbol *addSynthetic(StringRef N, const OutputSectionBase *Section,
                        uintX_t Value, uint8_t StOther);
 
+  // Defines a symbol assignment from the linker script. A PROVIDE
+  // takes effect only over an existing undefined symbol and is
+  // otherwise dropped, returning null; deciding that and performing
+  // the insertion share a single hash probe.
+  Symbol *addScripted(StringRef Name, bool Provide, bool IsAbsolute,
+                      const OutputSectionBase *Section, uint8_t StOther);
+
   void addShared(SharedFile<ELFT> *F, StringRef Name, const Elf_Sym &Sym,
                  const typename ELFT::Verdef *Verdef);
 
@@ -107,6 +117,8 @@ private:
   void assignExactVersion(SymbolVersion Ver, uint16_t VersionId,
                           StringRef VersionName);
   void assignWildcardVersion(SymbolVersion Ver, uint16_t VersionId);
+  void assignWildcardVersions(
+      llvm::ArrayRef<std::pair<SymbolVersion, uint16_t>> Patterns);
 
   struct SymIndex {
     SymIndex(int Idx, bool Traced) : Idx(Idx), Traced(Traced) {}
@@ -114,6 +126,32 @@ private:
     unsigned Traced : 1;
   };
 
+  // Most names in archive symbol indices are never referenced by the
+  // link. Instead of creating a symbol table entry for each of them up
+  // front, addLazyArchive parks unreferenced entries here, keyed by a
+  // hash of the name, and addUndefined pulls them in when a matching
+  // undefined first appears. A Bloom filter over the parked hashes
+  // rejects most lookups without touching the map.
+  struct ArchiveRoute {
+    ArchiveFile *File;
+    llvm::object::Archive::Symbol Sym;
+  };
+  void routeLazyArchive(ArchiveFile *F,
+                        const llvm::object::Archive::Symbol &Sym,
+                        StringRef Name);
+  ArchiveRoute *findLazyRoute(StringRef Name);
+  bool fetchLazyRoute(StringRef Name);
+  llvm::DenseMap<uint64_t, llvm::SmallVector<ArchiveRoute, 1>> LazyRoutes;
+  std::vector<uint64_t> LazyBloom;
+
+  // The name-to-symbol map is sharded by the hash of the symbol name.
+  // That serves two purposes. A parallel parse stage can insert into
+  // different shards without contending on one big map, as each shard
+  // is guarded by its own mutex (the locks are uncontended when the
+  // table is used from the main thread only). And no single DenseMap
+  // ever grows to millions of entries; rehashing one huge map is the
+  // hottest operation in links with very large symbol counts.
+  //
   // The order the global symbols are in is not defined. We can use an arbitrary
   // order, but it has to be reproducible. That is true even when cross linking.
   // The default hashing of StringRef produces different results on 32 and 64
@@ -121,7 +159,15 @@ private:
   // but a bit inefficient.
   // FIXME: Experiment with passing in a custom hashing or sorting the symbols
   // once symbol resolution is finished.
-  llvm::DenseMap<SymName, SymIndex> Symtab;
+  enum { NumShards = 16 };
+  struct Shard {
+    llvm::DenseMap<SymName, SymIndex> Map;
+    std::mutex Mu;
+  };
+  Shard &getShard(SymName Name) { return Shards[Name.hash() % NumShards]; }
+  Shard Shards[NumShards];
+
+  std::mutex SymVectorMu;
   std::vector<Symbol *> SymVector;
 
   // Comdat groups define "link once" sections. If two comdat groups have the
@@ -276,7 +276,7 @@ InputFile *LazyArchive::fetch() {
   // read from the library.
   if (MBInfo.first.getBuffer().empty())
     return nullptr;
-  return createObjectFile(MBInfo.first, file()->getName(), MBInfo.second);
+  return file()->createMemberFile(MBInfo.first, MBInfo.second);
 }
 
 InputFile *LazyObject::fetch() {
@@ -24,16 +24,21 @@
 #include "SymbolTable.h"
 #include "Target.h"
 #include "Threads.h"
+#include "Timer.h"
 #include "Writer.h"
 #include "lld/Config/Version.h"
 #include "lld/Support/Memory.h"
 #include "llvm/Support/Dwarf.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/LEB128.h"
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/RandomNumberGenerator.h"
 #include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/xxhash.h"
 #include <cstdlib>
+#include <memory>
+#include <thread>
 
 using namespace llvm;
 using namespace llvm::dwarf;
@@ -45,6 +50,25 @@ using namespace llvm::support::endian;
 using namespace lld;
 using namespace lld::elf;
 
+// Section types, dynamic tags and group flags for the Android packed
+// relocation format. These are not in our llvm/Support/ELF.h yet.
+enum {
+  SHT_ANDROID_REL = 0x60000001,
+  SHT_ANDROID_RELA = 0x60000002,
+  SHT_RELR = 19,
+  DT_RELRSZ = 0x23,
+  DT_RELR = 0x24,
+  DT_RELRENT = 0x25,
+  DT_ANDROID_REL = 0x6000000f,
+  DT_ANDROID_RELSZ = 0x60000010,
+  DT_ANDROID_RELA = 0x60000011,
+  DT_ANDROID_RELASZ = 0x60000012,
+  RELOCATION_GROUPED_BY_INFO_FLAG = 1,
+  RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG = 2,
+  RELOCATION_GROUPED_BY_ADDEND_FLAG = 4,
+  RELOCATION_GROUP_HAS_ADDEND_FLAG = 8,
+};
+
 template <class ELFT> static std::vector<DefinedCommon *> getCommonSymbols() {
   std::vector<DefinedCommon *> V;
   for (Symbol *S : Symtab<ELFT>::X->getSymbols())
@@ -323,14 +347,22 @@ static std::vector<ArrayRef<uint8_t>> split(ArrayRef<uint8_t> Arr,
 }
 
 // Computes a hash value of Data using a given hash function.
-// In order to utilize multiple cores, we first split data into 1MB
-// chunks, compute a hash for each chunk, and then compute a hash value
-// of the hash values.
+// In order to utilize multiple cores, we first split data into chunks,
+// compute a hash for each chunk, and then compute a hash value of the
+// hash values.
 template <class ELFT>
 void BuildIdSection<ELFT>::computeHash(
     llvm::ArrayRef<uint8_t> Data,
     std::function<void(uint8_t *Dest, ArrayRef<uint8_t> Arr)> HashFn) {
-  std::vector<ArrayRef<uint8_t>> Chunks = split(Data, 1024 * 1024);
+  // 1MB chunks keep the per-chunk overhead negligible for large
+  // outputs, but an output smaller than NumCores megabytes would leave
+  // most cores idle, so shrink the chunk size in that case (with a
+  // 64KB floor).
+  size_t Cores = poolConcurrency();
+  size_t ChunkSize = std::min<size_t>(
+      1024 * 1024, std::max<size_t>(Data.size() / (Cores * 4), 64 * 1024));
+
+  std::vector<ArrayRef<uint8_t>> Chunks = split(Data, ChunkSize);
   std::vector<uint8_t> Hashes(Chunks.size() * HashSize);
 
   // Compute hash values.
@@ -602,6 +634,16 @@ template <class ELFT> void MipsGotSection<ELFT>::finalize() {
   }
   Size = (getLocalEntriesNum() + GlobalEntries.size() + TlsEntries.size()) *
          sizeof(uintX_t);
+
+  // Surface GOT pressure under --stats: entries accessed via a 16-bit
+  // index overflow past 64K slots, so the breakdown shows how close the
+  // link is to that cliff.
+  addStat("mips_got_page_entries", PageEntriesNum);
+  addStat("mips_got_local_entries", LocalEntries.size());
+  addStat("mips_got_local32_entries", LocalEntries32.size());
+  addStat("mips_got_global_entries", GlobalEntries.size());
+  addStat("mips_got_tls_entries", TlsEntries.size());
+  addStat("mips_got_total_entries", Size / sizeof(uintX_t));
 }
 
 template <class ELFT> bool MipsGotSection<ELFT>::empty() const {
@@ -756,11 +798,43 @@ unsigned StringTableSection<ELFT>::addString(StringRef S, bool HashIt) {
 }
 
 template <class ELFT> void StringTableSection<ELFT>::writeTo(uint8_t *Buf) {
-  // ELF string tables start with NUL byte, so advance the pointer by one.
-  ++Buf;
+  // The NUL terminators need not be written because the output buffer
+  // is zero-initialized. This must stay serial: writeTo runs inside a
+  // pool task, and the pool does not steal work, so a nested parallel
+  // loop here can park the last free workers and deadlock small pools.
+  unsigned Off = 1; // ELF string tables start with a NUL byte.
   for (StringRef S : Strings) {
-    memcpy(Buf, S.data(), S.size());
-    Buf += S.size() + 1;
+    memcpy(Buf + Off, S.data(), S.size());
+    Off += S.size() + 1;
+  }
+}
+
+template <class ELFT>
+void StringTableSection<ELFT>::writeTasks(
+    uint8_t *Buf, std::vector<std::function<void()>> &Tasks) {
+  // Small tables keep the default single task.
+  if (Strings.size() < 4096) {
+    SyntheticSection<ELFT>::writeTasks(Buf, Tasks);
+    return;
+  }
+
+  // The offset of each string is the running sum of the sizes before
+  // it, so compute all offsets up front and emit ranges of independent
+  // memcpys as separate tasks.
+  auto Offsets = std::make_shared<std::vector<unsigned>>(Strings.size());
+  unsigned Off = 1; // ELF string tables start with a NUL byte.
+  for (size_t I = 0, E = Strings.size(); I != E; ++I) {
+    (*Offsets)[I] = Off;
+    Off += Strings[I].size() + 1;
+  }
+
+  const size_t PerTask = 1 << 14;
+  for (size_t I = 0, E = Strings.size(); I < E; I += PerTask) {
+    size_t End = std::min(E, I + PerTask);
+    Tasks.push_back([=] {
+      for (size_t J = I; J != End; ++J)
+        memcpy(Buf + (*Offsets)[J], Strings[J].data(), Strings[J].size());
+    });
   }
 }
 
@@ -832,20 +906,34 @@ template <class ELFT> void DynamicSection<ELFT>::finalize() {
   this->Link = In<ELFT>::DynStrTab->OutSec->SectionIndex;
   if (In<ELFT>::RelaDyn->OutSec->Size > 0) {
     bool IsRela = Config->Rela;
-    add({IsRela ? DT_RELA : DT_REL, In<ELFT>::RelaDyn});
-    add({IsRela ? DT_RELASZ : DT_RELSZ, In<ELFT>::RelaDyn->OutSec->Size});
-    add({IsRela ? DT_RELAENT : DT_RELENT,
-         uintX_t(IsRela ? sizeof(Elf_Rela) : sizeof(Elf_Rel))});
-
-    // MIPS dynamic loader does not support RELCOUNT tag.
-    // The problem is in the tight relation between dynamic
-    // relocations and GOT. So do not emit this tag on MIPS.
-    if (Config->EMachine != EM_MIPS) {
-      size_t NumRelativeRels = In<ELFT>::RelaDyn->getRelativeRelocCount();
-      if (Config->ZCombreloc && NumRelativeRels)
-        add({IsRela ? DT_RELACOUNT : DT_RELCOUNT, NumRelativeRels});
+    if (Config->AndroidPackDynRelocs) {
+      // The packed section's size is not final until the writer's
+      // re-encoding loop has converged, so let the size tag track the
+      // output section instead of recording the current value.
+      add({IsRela ? DT_ANDROID_RELA : DT_ANDROID_REL, In<ELFT>::RelaDyn});
+      add({IsRela ? DT_ANDROID_RELASZ : DT_ANDROID_RELSZ,
+           In<ELFT>::RelaDyn->OutSec, Entry::SecSize});
+    } else {
+      add({IsRela ? DT_RELA : DT_REL, In<ELFT>::RelaDyn});
+      add({IsRela ? DT_RELASZ : DT_RELSZ, In<ELFT>::RelaDyn->OutSec->Size});
+      add({IsRela ? DT_RELAENT : DT_RELENT,
+           uintX_t(IsRela ? sizeof(Elf_Rela) : sizeof(Elf_Rel))});
+
+      // MIPS dynamic loader does not support RELCOUNT tag.
+      // The problem is in the tight relation between dynamic
+      // relocations and GOT. So do not emit this tag on MIPS.
+      if (Config->EMachine != EM_MIPS) {
+        size_t NumRelativeRels = In<ELFT>::RelaDyn->getRelativeRelocCount();
+        if (Config->ZCombreloc && NumRelativeRels)
+          add({IsRela ? DT_RELACOUNT : DT_RELCOUNT, NumRelativeRels});
+      }
     }
   }
+  if (In<ELFT>::RelrDyn && !In<ELFT>::RelrDyn->empty()) {
+    add({DT_RELR, In<ELFT>::RelrDyn});
+    add({DT_RELRSZ, In<ELFT>::RelrDyn->OutSec, Entry::SecSize});
+    add({DT_RELRENT, uintX_t(sizeof(uintX_t))});
+  }
   if (In<ELFT>::RelaPlt->OutSec->Size > 0) {
     add({DT_JMPREL, In<ELFT>::RelaPlt});
     add({DT_PLTRELSZ, In<ELFT>::RelaPlt->OutSec->Size});
@@ -986,21 +1074,26 @@ static bool compRelocations(const RelTy &A, const RelTy &B) {
   return A.getSymbol(Config->Mips64EL) < B.getSymbol(Config->Mips64EL);
 }
 
+template <class ELFT>
+void RelocationSection<ELFT>::writeOne(uint8_t *Buf,
+                                       const DynamicReloc<ELFT> &Rel) {
+  auto *P = reinterpret_cast<Elf_Rela *>(Buf);
+  if (Config->Rela)
+    P->r_addend = Rel.getAddend();
+  P->r_offset = Rel.getOffset();
+  if (Config->EMachine == EM_MIPS && Rel.getInputSec() == In<ELFT>::MipsGot)
+    // Dynamic relocation against MIPS GOT section make deal TLS entries
+    // allocated in the end of the GOT. We need to adjust the offset to take
+    // in account 'local' and 'global' GOT entries.
+    P->r_offset += In<ELFT>::MipsGot->getTlsOffset();
+  P->setSymbolAndType(Rel.getSymIndex(), Rel.Type, Config->Mips64EL);
+}
+
 template <class ELFT> void RelocationSection<ELFT>::writeTo(uint8_t *Buf) {
   uint8_t *BufBegin = Buf;
   for (const DynamicReloc<ELFT> &Rel : Relocs) {
-    auto *P = reinterpret_cast<Elf_Rela *>(Buf);
+    writeOne(Buf, Rel);
     Buf += Config->Rela ? sizeof(Elf_Rela) : sizeof(Elf_Rel);
-
-    if (Config->Rela)
-      P->r_addend = Rel.getAddend();
-    P->r_offset = Rel.getOffset();
-    if (Config->EMachine == EM_MIPS && Rel.getInputSec() == In<ELFT>::MipsGot)
-      // Dynamic relocation against MIPS GOT section make deal TLS entries
-      // allocated in the end of the GOT. We need to adjust the offset to take
-      // in account 'local' and 'global' GOT entries.
-      P->r_offset += In<ELFT>::MipsGot->getTlsOffset();
-    P->setSymbolAndType(Rel.getSymIndex(), Rel.Type, Config->Mips64EL);
   }
 
   if (Sort) {
@@ -1014,6 +1107,48 @@ template <class ELFT> void RelocationSection<ELFT>::writeTo(uint8_t *Buf) {
   }
 }
 
+template <class ELFT>
+void RelocationSection<ELFT>::writeTasks(
+    uint8_t *Buf, std::vector<std::function<void()>> &Tasks) {
+  // Sections that do not need sorting, and small sorted sections where
+  // the task overhead would dominate, keep the default single task.
+  if (!Sort || Relocs.size() < 4096) {
+    SyntheticSection<ELFT>::writeTasks(Buf, Tasks);
+    return;
+  }
+
+  // -z combreloc with many relocations. Rather than encoding all the
+  // records in one task and stable_sort'ing them in place, sort
+  // (IsRelative, SymIndex, Offset) keys here -- addresses are final by
+  // the time the writer builds its task list, and the key sort itself
+  // runs parallel -- and then emit ranges of records as independent
+  // tasks. Relative relocations still come first for DT_RELACOUNT and
+  // the rest stay grouped by symbol; ties are now in offset order
+  // (stable_sort kept insertion order), which gives the loader
+  // sequential accesses within each group.
+  typedef std::pair<std::pair<uint64_t, uint64_t>, uint32_t> SortKey;
+  auto Keys = std::make_shared<std::vector<SortKey>>(Relocs.size());
+  forLoop(0, Relocs.size(), [&](size_t I) {
+    const DynamicReloc<ELFT> &Rel = Relocs[I];
+    uint64_t Group = Rel.Type == Target->RelativeRel ? 0 : 1;
+    (*Keys)[I] = {{(Group << 32) | Rel.getSymIndex(), Rel.getOffset()}, I};
+  });
+  sortParallel(Keys->begin(), Keys->end(),
+               [](const SortKey &A, const SortKey &B) {
+                 return A.first < B.first;
+               });
+
+  size_t EntSize = Config->Rela ? sizeof(Elf_Rela) : sizeof(Elf_Rel);
+  const size_t PerTask = 1 << 16;
+  for (size_t I = 0, E = Relocs.size(); I < E; I += PerTask) {
+    size_t End = std::min(E, I + PerTask);
+    Tasks.push_back([=] {
+      for (size_t J = I; J != End; ++J)
+        writeOne(Buf + J * EntSize, Relocs[(*Keys)[J].second]);
+    });
+  }
+}
+
 template <class ELFT> unsigned RelocationSection<ELFT>::getRelocOffset() {
   return this->Entsize * Relocs.size();
 }
@@ -1027,6 +1162,186 @@ template <class ELFT> void RelocationSection<ELFT>::finalize() {
   this->OutSec->Entsize = this->Entsize;
 }
 
+template <class ELFT>
+AndroidPackedRelocationSection<ELFT>::AndroidPackedRelocationSection(
+    StringRef Name)
+    : RelocationSection<ELFT>(Name, false /*Sort*/) {
+  this->Type = Config->Rela ? SHT_ANDROID_RELA : SHT_ANDROID_REL;
+  this->Entsize = 1;
+}
+
+template <class ELFT> void AndroidPackedRelocationSection<ELFT>::finalize() {
+  RelocationSection<ELFT>::finalize();
+
+  // Produce a first encoding so that the section has a plausible size
+  // before addresses are assigned. The writer re-encodes once the
+  // layout is known.
+  updateAllocSize();
+}
+
+template <class ELFT>
+bool AndroidPackedRelocationSection<ELFT>::updateAllocSize() {
+  // Materialize the final relocation records first; the encoder below
+  // works on their absolute values.
+  std::vector<Elf_Rela> Relatives, NonRelatives;
+  for (const DynamicReloc<ELFT> &Rel : this->Relocs) {
+    Elf_Rela R;
+    R.r_offset = Rel.getOffset();
+    if (Config->EMachine == EM_MIPS && Rel.getInputSec() == In<ELFT>::MipsGot)
+      R.r_offset += In<ELFT>::MipsGot->getTlsOffset();
+    R.setSymbolAndType(Rel.getSymIndex(), Rel.Type, Config->Mips64EL);
+    R.r_addend = Config->Rela ? Rel.getAddend() : 0;
+    if (Rel.Type == Target->RelativeRel)
+      Relatives.push_back(R);
+    else
+      NonRelatives.push_back(R);
+  }
+
+  auto CompareByOffset = [](const Elf_Rela &A, const Elf_Rela &B) {
+    return A.r_offset < B.r_offset;
+  };
+  std::sort(Relatives.begin(), Relatives.end(), CompareByOffset);
+  std::sort(NonRelatives.begin(), NonRelatives.end(), CompareByOffset);
+
+  SmallVector<char, 0> Data;
+  raw_svector_ostream OS(Data);
+  OS << "APS2";
+  encodeSLEB128(static_cast<int64_t>(this->Relocs.size()), OS);
+  encodeSLEB128(0, OS); // Initial r_offset.
+
+  uint64_t HasAddend =
+      Config->Rela ? uint64_t(RELOCATION_GROUP_HAS_ADDEND_FLAG) : 0;
+  uint64_t Offset = 0;
+  int64_t Addend = 0;
+
+  // A group whose members all advance r_offset by the same delta and
+  // share one r_info value costs a few header bytes plus, for RELA
+  // targets, one addend delta per member.
+  auto AddGrouped = [&](ArrayRef<Elf_Rela> Group, uint64_t Delta) {
+    encodeSLEB128(static_cast<int64_t>(Group.size()), OS);
+    encodeSLEB128(static_cast<int64_t>(RELOCATION_GROUPED_BY_OFFSET_DELTA_FLAG |
+                                       RELOCATION_GROUPED_BY_INFO_FLAG |
+                                       HasAddend),
+                  OS);
+    encodeSLEB128(static_cast<int64_t>(Delta), OS);
+    encodeSLEB128(static_cast<int64_t>(Group[0].r_info), OS);
+    if (HasAddend) {
+      for (const Elf_Rela &R : Group) {
+        encodeSLEB128(static_cast<int64_t>(R.r_addend) - Addend, OS);
+        Addend = R.r_addend;
+      }
+    }
+    Offset = Group.back().r_offset;
+  };
+
+  // A group with per-member offset deltas and infos.
+  auto AddUngrouped = [&](ArrayRef<Elf_Rela> Group) {
+    if (Group.empty())
+      return;
+    encodeSLEB128(static_cast<int64_t>(Group.size()), OS);
+    encodeSLEB128(static_cast<int64_t>(HasAddend), OS);
+    for (const Elf_Rela &R : Group) {
+      encodeSLEB128(static_cast<int64_t>(uint64_t(R.r_offset)) -
+                        static_cast<int64_t>(Offset),
+                    OS);
+      Offset = R.r_offset;
+      encodeSLEB128(static_cast<int64_t>(R.r_info), OS);
+      if (HasAddend) {
+        encodeSLEB128(static_cast<int64_t>(R.r_addend) - Addend, OS);
+        Addend = R.r_addend;
+      }
+    }
+  };
+
+  // Walk the relative relocations looking for runs whose offsets
+  // advance by one word. The first member of a run is emitted with an
+  // explicit offset so that the rest of the run can use a pure
+  // constant delta; short runs are not worth the group header.
+  std::vector<Elf_Rela> Pending;
+  for (size_t I = 0, E = Relatives.size(); I != E;) {
+    size_t RunEnd = I + 1;
+    while (RunEnd != E && Relatives[RunEnd].r_info == Relatives[I].r_info &&
+           Relatives[RunEnd].r_offset - Relatives[RunEnd - 1].r_offset ==
+               sizeof(uintX_t))
+      ++RunEnd;
+    if (RunEnd - I >= 4) {
+      Pending.push_back(Relatives[I]);
+      AddUngrouped(Pending);
+      Pending.clear();
+      AddGrouped(makeArrayRef(Relatives).slice(I + 1, RunEnd - I - 1),
+                 sizeof(uintX_t));
+    } else {
+      Pending.insert(Pending.end(), Relatives.begin() + I,
+                     Relatives.begin() + RunEnd);
+    }
+    I = RunEnd;
+  }
+  AddUngrouped(Pending);
+  AddUngrouped(NonRelatives);
+
+  bool Changed = RelocData.size() != Data.size();
+  RelocData = std::move(Data);
+  return Changed;
+}
+
+template <class ELFT>
+void AndroidPackedRelocationSection<ELFT>::writeTo(uint8_t *Buf) {
+  memcpy(Buf, RelocData.data(), RelocData.size());
+}
+
+template <class ELFT>
+RelrSection<ELFT>::RelrSection()
+    : SyntheticSection<ELFT>(SHF_ALLOC, SHT_RELR, sizeof(uintX_t),
+                             ".relr.dyn") {
+  this->Entsize = sizeof(uintX_t);
+}
+
+template <class ELFT> bool RelrSection<ELFT>::updateAllocSize() {
+  std::vector<uintX_t> Offsets;
+  Offsets.reserve(Relocs.size());
+  for (const std::pair<const InputSectionBase<ELFT> *, uintX_t> &P : Relocs)
+    Offsets.push_back(P.first->OutSec->Addr + P.first->getOffset(P.second));
+  std::sort(Offsets.begin(), Offsets.end());
+
+  const size_t Wordsize = sizeof(uintX_t);
+  const size_t NBits = 8 * Wordsize - 1;
+
+  std::vector<uintX_t> Data;
+  for (size_t I = 0, E = Offsets.size(); I != E;) {
+    // Start a run with an explicit address entry, which also covers
+    // the word it points at.
+    uintX_t Base = Offsets[I] + Wordsize;
+    Data.push_back(Offsets[I]);
+    ++I;
+
+    // Follow with bitmap entries, each covering the next NBits words.
+    for (;;) {
+      uintX_t Bitmap = 0;
+      for (; I != E; ++I) {
+        uintX_t Delta = Offsets[I] - Base;
+        if (Delta >= NBits * Wordsize || Delta % Wordsize)
+          break;
+        Bitmap |= uintX_t(1) << (Delta / Wordsize + 1);
+      }
+      if (!Bitmap)
+        break;
+      Data.push_back(Bitmap | 1);
+      Base += NBits * Wordsize;
+    }
+  }
+
+  bool Changed = RelrData.size() != Data.size();
+  RelrData = std::move(Data);
+  return Changed;
+}
+
+template <class ELFT> void RelrSection<ELFT>::writeTo(uint8_t *Buf) {
+  for (uintX_t Word : RelrData) {
+    write<uintX_t, ELFT::TargetEndianness, sizeof(uintX_t)>(Buf, Word);
+    Buf += sizeof(uintX_t);
+  }
+}
+
 template <class ELFT>
 SymbolTableSection<ELFT>::SymbolTableSection(
     StringTableSection<ELFT> &StrTabSec)
@@ -1107,54 +1422,93 @@ template <class ELFT> void SymbolTableSection<ELFT>::writeTo(uint8_t *Buf) {
 
   // All symbols with STB_LOCAL binding precede the weak and global symbols.
   // .dynsym only contains global symbols.
-  if (Config->Discard != DiscardPolicy::All && !StrTabSec.isDynamic())
-    writeLocalSymbols(Buf);
-
-  writeGlobalSymbols(Buf);
-}
-
-template <class ELFT>
-void SymbolTableSection<ELFT>::writeLocalSymbols(uint8_t *&Buf) {
-  // Iterate over all input object files to copy their local symbols
-  // to the output symbol table pointed by Buf.
-  for (ObjectFile<ELFT> *File : Symtab<ELFT>::X->getObjectFiles()) {
-    for (const std::pair<const DefinedRegular<ELFT> *, size_t> &P :
-         File->KeptLocalSyms) {
-      const DefinedRegular<ELFT> &Body = *P.first;
-      InputSectionBase<ELFT> *Section = Body.Section;
-      auto *ESym = reinterpret_cast<Elf_Sym *>(Buf);
-
-      if (!Section) {
-        ESym->st_shndx = SHN_ABS;
-        ESym->st_value = Body.Value;
-      } else {
-        const OutputSectionBase *OutSec = Section->OutSec;
-        ESym->st_shndx = OutSec->SectionIndex;
-        ESym->st_value = OutSec->Addr + Section->getOffset(Body);
-      }
-      ESym->st_name = P.second;
-      ESym->st_size = Body.template getSize<ELFT>();
-      ESym->setBindingAndType(STB_LOCAL, Body.Type);
-      Buf += sizeof(*ESym);
+  if (Config->Discard != DiscardPolicy::All && !StrTabSec.isDynamic()) {
+    std::vector<const LocalSymbol *> Locals = getLocalSymbols();
+    writeLocalSymbols(Buf, Locals, 0, Locals.size());
+    Buf += Locals.size() * sizeof(Elf_Sym);
+  }
+
+  writeGlobalSymbols(Buf, 0, Symbols.size());
+}
+
+template <class ELFT>
+void SymbolTableSection<ELFT>::writeTasks(
+    uint8_t *Buf, std::vector<std::function<void()>> &Tasks) {
+  // Symbol table entries are fixed size and each one is computed from
+  // state that is final by the time the writer builds its task list, so
+  // carve the table into ranges written by independent tasks. writeTo
+  // itself must stay serial: it runs inside a pool task, and a nested
+  // parallel loop there can park the last free workers and deadlock
+  // small pools.
+  const size_t PerTask = 4096;
+  Buf += sizeof(Elf_Sym);
+
+  if (Config->Discard != DiscardPolicy::All && !StrTabSec.isDynamic()) {
+    auto Locals =
+        std::make_shared<std::vector<const LocalSymbol *>>(getLocalSymbols());
+    for (size_t I = 0, E = Locals->size(); I < E; I += PerTask) {
+      size_t End = std::min(E, I + PerTask);
+      Tasks.push_back([=] { writeLocalSymbols(Buf, *Locals, I, End); });
     }
+    Buf += Locals->size() * sizeof(Elf_Sym);
+  }
+
+  for (size_t I = 0, E = Symbols.size(); I < E; I += PerTask) {
+    size_t End = std::min(E, I + PerTask);
+    Tasks.push_back([=] { writeGlobalSymbols(Buf, I, End); });
   }
 }
 
 template <class ELFT>
-void SymbolTableSection<ELFT>::writeGlobalSymbols(uint8_t *Buf) {
+std::vector<const typename SymbolTableSection<ELFT>::LocalSymbol *>
+SymbolTableSection<ELFT>::getLocalSymbols() {
+  // Gather the local symbols of all input object files into one flat
+  // list so that any range of the fixed-size entries can be written
+  // independently.
+  std::vector<const LocalSymbol *> Locals;
+  for (ObjectFile<ELFT> *File : Symtab<ELFT>::X->getObjectFiles())
+    for (const LocalSymbol &P : File->KeptLocalSyms)
+      Locals.push_back(&P);
+  return Locals;
+}
+
+template <class ELFT>
+void SymbolTableSection<ELFT>::writeLocalSymbols(
+    uint8_t *Buf, ArrayRef<const LocalSymbol *> Locals, size_t Begin,
+    size_t End) {
+  auto *ESyms = reinterpret_cast<Elf_Sym *>(Buf);
+  for (size_t I = Begin; I != End; ++I) {
+    const DefinedRegular<ELFT> &Body = *Locals[I]->first;
+    InputSectionBase<ELFT> *Section = Body.Section;
+    Elf_Sym *ESym = ESyms + I;
+
+    if (!Section) {
+      ESym->st_shndx = SHN_ABS;
+      ESym->st_value = Body.Value;
+    } else {
+      const OutputSectionBase *OutSec = Section->OutSec;
+      ESym->st_shndx = OutSec->SectionIndex;
+      ESym->st_value = OutSec->Addr + Section->getOffset(Body);
+    }
+    ESym->st_name = Locals[I]->second;
+    ESym->st_size = Body.template getSize<ELFT>();
+    ESym->setBindingAndType(STB_LOCAL, Body.Type);
+  }
+}
+
+template <class ELFT>
+void SymbolTableSection<ELFT>::writeGlobalSymbols(uint8_t *Buf, size_t Begin,
+                                                  size_t End) {
   // Write the internal symbol table contents to the output symbol table
-  // pointed by Buf.
-  auto *ESym = reinterpret_cast<Elf_Sym *>(Buf);
-  for (const SymbolTableEntry &S : Symbols) {
-    SymbolBody *Body = S.Symbol;
-    size_t StrOff = S.StrTabOffset;
-
-    uint8_t Type = Body->Type;
-    uintX_t Size = Body->getSize<ELFT>();
-
-    ESym->setBindingAndType(getSymbolBinding(Body), Type);
-    ESym->st_size = Size;
-    ESym->st_name = StrOff;
+  // pointed by Buf. All addresses and sizes are fixed by this point.
+  auto *ESyms = reinterpret_cast<Elf_Sym *>(Buf);
+  for (size_t I = Begin; I != End; ++I) {
+    SymbolBody *Body = Symbols[I].Symbol;
+    Elf_Sym *ESym = ESyms + I;
+
+    ESym->setBindingAndType(getSymbolBinding(Body), Body->Type);
+    ESym->st_size = Body->getSize<ELFT>();
+    ESym->st_name = Symbols[I].StrTabOffset;
     ESym->setVisibility(Body->symbol()->Visibility);
     ESym->st_value = Body->getVA<ELFT>();
 
@@ -1176,7 +1530,6 @@ void SymbolTableSection<ELFT>::writeGlobalSymbols(uint8_t *Buf) {
           ESym->st_other |= STO_MIPS_PIC;
       }
     }
-    ++ESym;
   }
 }
 
@@ -1337,17 +1690,27 @@ void GnuHashTableSection<ELFT>::addSymbols(std::vector<SymbolTableEntry> &V) {
       });
   if (Mid == V.end())
     return;
-  for (auto I = Mid, E = V.end(); I != E; ++I) {
-    SymbolBody *B = I->Symbol;
-    size_t StrOff = I->StrTabOffset;
-    Symbols.push_back({B, StrOff, hashGnu(B->getName())});
-  }
 
+  // Computing the hash of every exported symbol name is the expensive
+  // part and is independent per symbol, so do it in parallel.
+  size_t N = V.end() - Mid;
+  Symbols.resize(N);
+  forLoop(0, N, [&](size_t I) {
+    SymbolBody *B = Mid[I].Symbol;
+    Symbols[I] = {B, Mid[I].StrTabOffset, hashGnu(B->getName())};
+  });
+
+  // Sort the symbols by bucket. The dynamic string table offset is
+  // unique per symbol, so using it to break ties within a bucket makes
+  // the order total; the sort then doesn't have to be stable to stay
+  // deterministic and can run in parallel.
   unsigned NBuckets = calcNBuckets(Symbols.size());
-  std::stable_sort(Symbols.begin(), Symbols.end(),
-                   [&](const SymbolData &L, const SymbolData &R) {
-                     return L.Hash % NBuckets < R.Hash % NBuckets;
-                   });
+  sortParallel(Symbols.begin(), Symbols.end(),
+               [&](const SymbolData &L, const SymbolData &R) {
+                 uint32_t LB = L.Hash % NBuckets;
+                 uint32_t RB = R.Hash % NBuckets;
+                 return LB != RB ? LB < RB : L.STName < R.STName;
+               });
 
   V.erase(Mid, V.end());
   for (const SymbolData &Sym : Symbols)
@@ -1374,6 +1737,18 @@ template <class ELFT> void HashTableSection<ELFT>::finalize() {
   this->Size = NumEntries * sizeof(Elf_Word);
 }
 
+template <class ELFT> void HashTableSection<ELFT>::computeHashes() {
+  // Hashing each name is independent work; do it in parallel so writeTo
+  // on the serial output path only builds the chains. (The hash
+  // function is fixed by the ABI, so the hash cannot be shared with
+  // .gnu.hash or the resolver's name map.)
+  ArrayRef<SymbolTableEntry> Syms = In<ELFT>::DynSymTab->getSymbols();
+  Hashes.resize(Syms.size());
+  forLoop(0, Syms.size(), [&](size_t I) {
+    Hashes[I] = hashSysV(Syms[I].Symbol->getName());
+  });
+}
+
 template <class ELFT> void HashTableSection<ELFT>::writeTo(uint8_t *Buf) {
   unsigned NumSymbols = In<ELFT>::DynSymTab->getNumSymbols();
   auto *P = reinterpret_cast<Elf_Word *>(Buf);
@@ -1383,11 +1758,10 @@ template <class ELFT> void HashTableSection<ELFT>::writeTo(uint8_t *Buf) {
   Elf_Word *Buckets = P;
   Elf_Word *Chains = P + NumSymbols;
 
-  for (const SymbolTableEntry &S : In<ELFT>::DynSymTab->getSymbols()) {
-    SymbolBody *Body = S.Symbol;
-    StringRef Name = Body->getName();
-    unsigned I = Body->DynsymIndex;
-    uint32_t Hash = hashSysV(Name) % NumSymbols;
+  ArrayRef<SymbolTableEntry> Syms = In<ELFT>::DynSymTab->getSymbols();
+  for (size_t J = 0, E = Syms.size(); J != E; ++J) {
+    unsigned I = Syms[J].Symbol->DynsymIndex;
+    uint32_t Hash = Hashes[J] % NumSymbols;
     Chains[I] = Buckets[Hash];
     Buckets[Hash] = I;
   }
@@ -1402,15 +1776,34 @@ template <class ELFT> void PltSection<ELFT>::writeTo(uint8_t *Buf) {
   // At beginning of PLT, we have code to call the dynamic linker
   // to resolve dynsyms at runtime. Write such code.
   Target->writePltHeader(Buf);
-  size_t Off = Target->PltHeaderSize;
+  writeEntries(Buf, 0, Entries.size());
+}
 
-  for (auto &I : Entries) {
-    const SymbolBody *B = I.first;
-    unsigned RelOff = I.second;
-    uint64_t Got = B->getGotPltVA<ELFT>();
-    uint64_t Plt = this->getVA() + Off;
-    Target->writePlt(Buf + Off, Got, Plt, B->PltIndex, RelOff);
-    Off += Target->PltEntrySize;
+template <class ELFT>
+void PltSection<ELFT>::writeEntries(uint8_t *Buf, size_t Begin, size_t End) {
+  uint64_t VA = this->getVA();
+  size_t EntrySize = Target->PltEntrySize;
+  size_t Off = Target->PltHeaderSize + Begin * EntrySize;
+  for (size_t I = Begin; I != End; ++I, Off += EntrySize) {
+    const SymbolBody *B = Entries[I].first;
+    Target->writePlt(Buf + Off, B->getGotPltVA<ELFT>(), VA + Off, B->PltIndex,
+                     Entries[I].second);
+  }
+}
+
+template <class ELFT>
+void PltSection<ELFT>::writeTasks(uint8_t *Buf,
+                                  std::vector<std::function<void()>> &Tasks) {
+  // The header and every entry are written independently (writePlt
+  // stamps the target's entry template and patches in the addresses),
+  // so a big PLT is carved into ranges of entries that run as separate
+  // tasks alongside the rest of the output. The range size only has to
+  // amortize the task scheduling overhead.
+  const size_t PerTask = 4096;
+  Tasks.push_back([=] { Target->writePltHeader(Buf); });
+  for (size_t I = 0, E = Entries.size(); I < E; I += PerTask) {
+    size_t End = std::min(E, I + PerTask);
+    Tasks.push_back([=] { writeEntries(Buf, I, End); });
   }
 }
 
@@ -1462,19 +1855,18 @@ template <class ELFT> void GdbIndexSection<ELFT>::parseDebugSections() {
   std::vector<InputSection<ELFT> *> &IS =
       static_cast<OutputSection<ELFT> *>(Out<ELFT>::DebugInfo)->Sections;
 
-  for (InputSection<ELFT> *I : IS)
-    readDwarf(I);
-}
+  // Creating a DWARF context and scanning the CU headers is independent
+  // work for each object file, so do it in parallel and concatenate the
+  // results afterwards in input order to keep the CU list deterministic.
+  std::vector<std::vector<std::pair<uintX_t, uintX_t>>> CuLists(IS.size());
+  forLoop(0, IS.size(), [&](size_t I) { CuLists[I] = readCuList(IS[I]); });
 
-template <class ELFT>
-void GdbIndexSection<ELFT>::readDwarf(InputSection<ELFT> *I) {
-  std::vector<std::pair<uintX_t, uintX_t>> CuList = readCuList(I);
-  CompilationUnits.insert(CompilationUnits.end(), CuList.begin(), CuList.end());
+  for (std::vector<std::pair<uintX_t, uintX_t>> &CuList : CuLists)
+    CompilationUnits.insert(CompilationUnits.end(), CuList.begin(),
+                            CuList.end());
 }
 
 template <class ELFT> void GdbIndexSection<ELFT>::finalize() {
-  parseDebugSections();
-
   // GdbIndex header consist from version fields
   // and 5 more fields with different kinds of offsets.
   CuTypesOffset = CuListOffset + CompilationUnits.size() * CompilationUnitSize;
@@ -1515,8 +1907,13 @@ template <class ELFT> void EhFrameHeader<ELFT>::writeTo(uint8_t *Buf) {
   // Sort the FDE list by their PC and uniqueify. Usually there is only
   // one FDE for a PC (i.e. function), but if ICF merges two functions
   // into one, there can be more than one FDEs pointing to the address.
-  auto Less = [](const FdeData &A, const FdeData &B) { return A.Pc < B.Pc; };
-  std::stable_sort(Fdes.begin(), Fdes.end(), Less);
+  // FdeVA breaks ties so that the order is total and the sort doesn't
+  // have to be stable to stay deterministic, which lets it run in
+  // parallel.
+  auto Less = [](const FdeData &A, const FdeData &B) {
+    return A.Pc != B.Pc ? A.Pc < B.Pc : A.FdeVA < B.FdeVA;
+  };
+  sortParallel(Fdes.begin(), Fdes.end(), Less);
   auto Eq = [](const FdeData &A, const FdeData &B) { return A.Pc == B.Pc; };
   Fdes.erase(std::unique(Fdes.begin(), Fdes.end(), Eq), Fdes.end());
 
@@ -1824,6 +2221,16 @@ template class elf::RelocationSection<ELF32BE>;
 template class elf::RelocationSection<ELF64LE>;
 template class elf::RelocationSection<ELF64BE>;
 
+template class elf::AndroidPackedRelocationSection<ELF32LE>;
+template class elf::AndroidPackedRelocationSection<ELF32BE>;
+template class elf::AndroidPackedRelocationSection<ELF64LE>;
+template class elf::AndroidPackedRelocationSection<ELF64BE>;
+
+template class elf::RelrSection<ELF32LE>;
+template class elf::RelrSection<ELF32BE>;
+template class elf::RelrSection<ELF64LE>;
+template class elf::RelrSection<ELF64BE>;
+
 template class elf::SymbolTableSection<ELF32LE>;
 template class elf::SymbolTableSection<ELF32BE>;
 template class elf::SymbolTableSection<ELF64LE>;
@@ -13,6 +13,7 @@
 #include "GdbIndex.h"
 #include "InputSection.h"
 #include "llvm/ADT/MapVector.h"
+#include <functional>
 
 namespace lld {
 namespace elf {
@@ -30,6 +31,15 @@ public:
 
   virtual ~SyntheticSection() = default;
   virtual void writeTo(uint8_t *Buf) = 0;
+
+  // Like OutputSectionBase::writeTasks: large synthetic sections whose
+  // contents decompose into independent pieces can override this to
+  // write themselves as several parallel tasks. By default the whole
+  // section is one task.
+  virtual void writeTasks(uint8_t *Buf,
+                          std::vector<std::function<void()>> &Tasks) {
+    Tasks.push_back([=] { writeTo(Buf); });
+  }
   virtual size_t getSize() const = 0;
   virtual void finalize() {}
   virtual bool empty() const { return false; }
@@ -232,6 +242,8 @@ public:
   StringTableSection(StringRef Name, bool Dynamic);
   unsigned addString(StringRef S, bool HashIt = true);
   void writeTo(uint8_t *Buf) override;
+  void writeTasks(uint8_t *Buf,
+                  std::vector<std::function<void()>> &Tasks) override;
   size_t getSize() const override { return Size; }
   bool isDynamic() const { return Dynamic; }
 
@@ -327,7 +339,7 @@ private:
 };
 
 template <class ELFT>
-class RelocationSection final : public SyntheticSection<ELFT> {
+class RelocationSection : public SyntheticSection<ELFT> {
   typedef typename ELFT::Rel Elf_Rel;
   typedef typename ELFT::Rela Elf_Rela;
   typedef typename ELFT::uint uintX_t;
@@ -338,14 +350,76 @@ public:
   unsigned getRelocOffset();
   void finalize() override;
   void writeTo(uint8_t *Buf) override;
+  void writeTasks(uint8_t *Buf,
+                  std::vector<std::function<void()>> &Tasks) override;
   bool empty() const override { return Relocs.empty(); }
   size_t getSize() const override { return Relocs.size() * this->Entsize; }
   size_t getRelativeRelocCount() const { return NumRelativeRelocs; }
 
+protected:
+  std::vector<DynamicReloc<ELFT>> Relocs;
+
 private:
+  void writeOne(uint8_t *Buf, const DynamicReloc<ELFT> &Rel);
+
   bool Sort;
   size_t NumRelativeRelocs = 0;
-  std::vector<DynamicReloc<ELFT>> Relocs;
+};
+
+// .rel[a].dyn compressed with the Android packed relocation format
+// (APS2). Runs of relative relocations delta-encode to a few bytes
+// per entry, which shrinks the section by an order of magnitude on
+// PIC-heavy images. Enabled by --pack-dyn-relocs=android.
+template <class ELFT>
+class AndroidPackedRelocationSection final : public RelocationSection<ELFT> {
+  typedef typename ELFT::Rela Elf_Rela;
+  typedef typename ELFT::uint uintX_t;
+
+public:
+  AndroidPackedRelocationSection(StringRef Name);
+  void finalize() override;
+  void writeTo(uint8_t *Buf) override;
+  size_t getSize() const override { return RelocData.size(); }
+
+  // Re-encodes the relocations with the current addresses and returns
+  // true if the encoded size changed. The encoding depends on the
+  // layout and vice versa, so the writer re-runs address assignment
+  // and calls this again until the sizes converge.
+  bool updateAllocSize();
+
+private:
+  llvm::SmallVector<char, 0> RelocData;
+};
+
+// .relr.dyn, enabled by --pack-dyn-relocs=relr. SHT_RELR encodes only
+// the locations of relative relocations: an even word starts a run at
+// that address, and odd words are bitmaps covering the following
+// wordsize-1 words. Densely packed relative relocations cost about
+// one bit each, roughly a 20x reduction over raw Elf_Rela records.
+// The relocated words must contain their link-time values because the
+// loader just adds the load bias to them, so the routing code in
+// scanRelocs also emits the static relocation.
+template <class ELFT> class RelrSection final : public SyntheticSection<ELFT> {
+  typedef typename ELFT::uint uintX_t;
+
+public:
+  RelrSection();
+  void addReloc(const InputSectionBase<ELFT> *Sec, uintX_t OffsetInSec) {
+    Relocs.push_back({Sec, OffsetInSec});
+  }
+  void finalize() override { updateAllocSize(); }
+  void writeTo(uint8_t *Buf) override;
+  bool empty() const override { return Relocs.empty(); }
+  size_t getSize() const override { return RelrData.size() * sizeof(uintX_t); }
+
+  // Same convergence protocol as AndroidPackedRelocationSection: the
+  // writer re-encodes with the current addresses until the size is
+  // stable.
+  bool updateAllocSize();
+
+private:
+  std::vector<std::pair<const InputSectionBase<ELFT> *, uintX_t>> Relocs;
+  std::vector<uintX_t> RelrData;
 };
 
 struct SymbolTableEntry {
@@ -364,6 +438,8 @@ public:
 
   void finalize() override;
   void writeTo(uint8_t *Buf) override;
+  void writeTasks(uint8_t *Buf,
+                  std::vector<std::function<void()>> &Tasks) override;
   size_t getSize() const override { return getNumSymbols() * sizeof(Elf_Sym); }
   void addSymbol(SymbolBody *Body);
   StringTableSection<ELFT> &getStrTabSec() const { return StrTabSec; }
@@ -375,8 +451,12 @@ public:
   StringTableSection<ELFT> &StrTabSec;
 
 private:
-  void writeLocalSymbols(uint8_t *&Buf);
-  void writeGlobalSymbols(uint8_t *Buf);
+  typedef std::pair<const DefinedRegular<ELFT> *, size_t> LocalSymbol;
+
+  std::vector<const LocalSymbol *> getLocalSymbols();
+  void writeLocalSymbols(uint8_t *Buf, ArrayRef<const LocalSymbol *> Locals,
+                         size_t Begin, size_t End);
+  void writeGlobalSymbols(uint8_t *Buf, size_t Begin, size_t End);
 
   const OutputSectionBase *getOutputSection(SymbolBody *Sym);
 
@@ -434,7 +514,17 @@ public:
   void writeTo(uint8_t *Buf) override;
   size_t getSize() const override { return this->Size; }
 
+  // Hashes the dynamic symbol names in parallel so that writeTo, which
+  // runs on the serial output path, only builds the bucket chains. Must
+  // be called from the main thread after DynSymTab is finalized, not
+  // from finalize: the finalize chains are drained on the thread pool
+  // and a nested parallel loop there can deadlock small pools.
+  void computeHashes();
+
 private:
+  // Sysv hashes of the dynamic symbol names, indexed by dynsym index.
+  std::vector<uint32_t> Hashes;
+
   size_t Size = 0;
 };
 
@@ -442,11 +532,15 @@ template <class ELFT> class PltSection final : public SyntheticSection<ELFT> {
 public:
   PltSection();
   void writeTo(uint8_t *Buf) override;
+  void writeTasks(uint8_t *Buf,
+                  std::vector<std::function<void()>> &Tasks) override;
   size_t getSize() const override;
   void addEntry(SymbolBody &Sym);
   bool empty() const override { return Entries.empty(); }
 
 private:
+  void writeEntries(uint8_t *Buf, size_t Begin, size_t End);
+
   std::vector<std::pair<const SymbolBody *, unsigned>> Entries;
 };
 
@@ -482,13 +576,16 @@ public:
   size_t getSize() const override { return CuTypesOffset; }
   bool empty() const override;
 
+  // Scans the CU headers of all debug info sections in parallel. Must
+  // be called from the main thread before the finalize chains are
+  // drained on the thread pool; a nested parallel loop there can
+  // deadlock small pools.
+  void parseDebugSections();
+
   // Pairs of [CU Offset, CU length].
   std::vector<std::pair<uintX_t, uintX_t>> CompilationUnits;
 
 private:
-  void parseDebugSections();
-  void readDwarf(InputSection<ELFT> *I);
-
   uint32_t CuTypesOffset;
 };
 
@@ -685,6 +782,7 @@ template <class ELFT> struct In {
   static PltSection<ELFT> *Plt;
   static IpltSection<ELFT> *Iplt;
   static RelocationSection<ELFT> *RelaDyn;
+  static RelrSection<ELFT> *RelrDyn;
   static RelocationSection<ELFT> *RelaPlt;
   static RelocationSection<ELFT> *RelaIplt;
   static StringTableSection<ELFT> *ShStrTab;
@@ -713,6 +811,7 @@ template <class ELFT> MipsRldMapSection<ELFT> *In<ELFT>::MipsRldMap;
 template <class ELFT> PltSection<ELFT> *In<ELFT>::Plt;
 template <class ELFT> IpltSection<ELFT> *In<ELFT>::Iplt;
 template <class ELFT> RelocationSection<ELFT> *In<ELFT>::RelaDyn;
+template <class ELFT> RelrSection<ELFT> *In<ELFT>::RelrDyn;
 template <class ELFT> RelocationSection<ELFT> *In<ELFT>::RelaPlt;
 template <class ELFT> RelocationSection<ELFT> *In<ELFT>::RelaIplt;
 template <class ELFT> StringTableSection<ELFT> *In<ELFT>::ShStrTab;
@@ -30,13 +30,16 @@
 #include "OutputSections.h"
 #include "Symbols.h"
 #include "SyntheticSections.h"
+#include "Threads.h"
 #include "Thunks.h"
 #include "Writer.h"
 #include "lld/Support/Memory.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Object/ELF.h"
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
 using namespace llvm::object;
@@ -1580,6 +1583,135 @@ void AArch64TargetInfo::relaxTlsIeToLe(uint8_t *Loc, uint32_t Type,
   llvm_unreachable("invalid relocation for TLS IE to LE relaxation");
 }
 
+// Cortex-A53 erratum 843419. Under rare microarchitectural conditions
+// the sequence
+//   adrp x<n>, ...       (in one of the last two words of a 4KiB page)
+//   load or store
+//   [one optional intervening instruction]
+//   load or store using x<n> as the base register
+// can write the wrong value to x<n>. The linker workaround, as in
+// binutils' --fix-cortex-a53-843419, moves the final load/store into a
+// veneer after the section and replaces it with a branch there.
+//
+// The decoders below only look at opcode and register fields, which no
+// relocation touches, so the scan runs on unrelocated section data.
+// Matching is deliberately conservative: patching a sequence that
+// would not actually trigger the erratum is harmless, because the
+// moved instruction (an unsigned-immediate load/store, never a
+// PC-relative literal load) behaves identically at the veneer.
+
+static bool isADRP(uint32_t Insn) { return (Insn & 0x9f000000) == 0x90000000; }
+
+// Any instruction in the load/store encoding class.
+static bool isLoadStoreClass(uint32_t Insn) {
+  return (Insn & 0x0a000000) == 0x08000000;
+}
+
+// Load/store register (unsigned immediate), excluding PC-relative
+// literal loads. This is the only encoding the offending access can
+// use, and the only one that is safe to move into a veneer.
+static bool isLoadStoreUnsignedImm(uint32_t Insn) {
+  return (Insn & 0x3b000000) == 0x39000000;
+}
+
+static uint32_t getRd(uint32_t Insn) { return Insn & 0x1f; }
+static uint32_t getRnField(uint32_t Insn) { return (Insn >> 5) & 0x1f; }
+
+// Scans one executable section and appends the section offsets of
+// offending load/stores to Offsets.
+template <class ELFT>
+static void scanA53Errata843419Section(InputSection<ELFT> *IS,
+                                       std::vector<uint64_t> &Offsets) {
+  ArrayRef<uint8_t> Data = IS->Data;
+  uint64_t VA = IS->OutSec->Addr + IS->OutSecOff;
+  uint64_t Size = Data.size() & ~uint64_t(3);
+
+  auto ReadInsn = [&](uint64_t Off) { return read32le(Data.data() + Off); };
+
+  // The sequence only triggers when the adrp sits in one of the last
+  // two words of a 4KiB page, so only those two offsets in every page
+  // the section spans need to be examined.
+  for (uint64_t PageVA = VA & ~uint64_t(0xfff); PageVA < VA + Size;
+       PageVA += 0x1000) {
+    for (uint64_t AdrpVA : {PageVA + 0xff8, PageVA + 0xffc}) {
+      if (AdrpVA < VA || AdrpVA + 12 > VA + Size)
+        continue;
+      uint64_t Off = AdrpVA - VA;
+      uint32_t Adrp = ReadInsn(Off);
+      if (!isADRP(Adrp))
+        continue;
+      uint32_t Rn = getRd(Adrp);
+      if (!isLoadStoreClass(ReadInsn(Off + 4)))
+        continue;
+      // The offending access is either the next instruction or the
+      // one after a single intervening instruction.
+      for (uint64_t PatchOff : {Off + 8, Off + 12}) {
+        if (PatchOff + 4 > Size)
+          break;
+        uint32_t Insn = ReadInsn(PatchOff);
+        if (isLoadStoreUnsignedImm(Insn) && getRnField(Insn) == Rn) {
+          Offsets.push_back(PatchOff);
+          break;
+        }
+      }
+    }
+  }
+}
+
+template <class ELFT>
+bool createA53Errata843419Fixes(
+    ArrayRef<OutputSectionBase *> OutputSections,
+    std::vector<std::pair<InputSection<ELFT> *, uint64_t>> &Patched) {
+  std::vector<InputSection<ELFT> *> Sections;
+  for (OutputSectionBase *Base : OutputSections)
+    if (Base->Flags & SHF_EXECINSTR)
+      if (auto *Sec = dyn_cast<OutputSection<ELFT>>(Base))
+        Sections.insert(Sections.end(), Sec->Sections.begin(),
+                        Sec->Sections.end());
+
+  // The sections are scanned in parallel into per-section hit lists;
+  // the patches are then attached serially below, so the result does
+  // not depend on scheduling.
+  std::vector<std::vector<uint64_t>> Hits(Sections.size());
+  forLoop(0, Sections.size(),
+          [&](size_t I) { scanA53Errata843419Section(Sections[I], Hits[I]); });
+
+  // A site stays patched across re-scans even if relayout moved its
+  // adrp off the page boundary: the veneer is computed at write time
+  // and remains correct, it is merely no longer needed.
+  DenseSet<std::pair<InputSection<ELFT> *, uint64_t>> Known;
+  for (const std::pair<InputSection<ELFT> *, uint64_t> &P : Patched)
+    Known.insert(P);
+
+  bool Added = false;
+  for (size_t I = 0, E = Sections.size(); I != E; ++I) {
+    for (uint64_t Off : Hits[I]) {
+      if (!Known.insert({Sections[I], Off}).second)
+        continue;
+      addA53Erratum843419Patch(*Sections[I], Off);
+      Patched.emplace_back(Sections[I], Off);
+      Added = true;
+    }
+  }
+  if (Config->Verbose && !Patched.empty())
+    outs() << "Patched " << Patched.size()
+           << " Cortex-A53 843419 erratum sequences\n";
+  return Added;
+}
+
+template bool createA53Errata843419Fixes<ELF32LE>(
+    ArrayRef<OutputSectionBase *>,
+    std::vector<std::pair<InputSection<ELF32LE> *, uint64_t>> &);
+template bool createA53Errata843419Fixes<ELF32BE>(
+    ArrayRef<OutputSectionBase *>,
+    std::vector<std::pair<InputSection<ELF32BE> *, uint64_t>> &);
+template bool createA53Errata843419Fixes<ELF64LE>(
+    ArrayRef<OutputSectionBase *>,
+    std::vector<std::pair<InputSection<ELF64LE> *, uint64_t>> &);
+template bool createA53Errata843419Fixes<ELF64BE>(
+    ArrayRef<OutputSectionBase *>,
+    std::vector<std::pair<InputSection<ELF64BE> *, uint64_t>> &);
+
 AMDGPUTargetInfo::AMDGPUTargetInfo() {
   RelativeRel = R_AMDGPU_REL64;
   GotRel = R_AMDGPU_ABS64;
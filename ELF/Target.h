@@ -11,6 +11,7 @@
 #define LLD_ELF_TARGET_H
 
 #include "InputSection.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Object/ELF.h"
 
@@ -106,6 +107,19 @@ public:
 
 std::string toString(uint32_t RelType);
 
+class OutputSectionBase;
+
+// Scans executable sections for the Cortex-A53 erratum 843419 sequence
+// and attaches patch veneers to the affected input sections
+// (--fix-cortex-a53-843419). Returns true if new patches were added,
+// in which case addresses must be re-assigned and the scan re-run.
+// Patched accumulates the sites across calls so a re-scan never
+// patches a site twice.
+template <class ELFT>
+bool createA53Errata843419Fixes(
+    llvm::ArrayRef<OutputSectionBase *> OutputSections,
+    std::vector<std::pair<InputSection<ELFT> *, uint64_t>> &Patched);
+
 template <class ELFT>
 uint64_t getPPC64TocBase();
 uint64_t getAArch64Page(uint64_t Expr);
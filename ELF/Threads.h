@@ -60,28 +60,57 @@
 #define LLD_ELF_THREADS_H
 
 #include "Config.h"
+#include "Error.h"
 
 #include "lld/Core/Parallel.h"
 #include <algorithm>
 #include <functional>
+#include <utility>
 
 namespace lld {
 namespace elf {
 
+// Once the error budget (--error-budget) is exhausted the link's
+// outcome is already decided, so the remaining tasks of a pass degrade
+// to no-ops and the pass drains in microseconds; the ErrorCount checks
+// the callers already do then exit. The tasks that did run left
+// consistent per-task results, which is all cancellation needs here
+// because nothing reads the output of a failed link.
+template <class FuncTy> struct CancellableTask {
+  FuncTy Fn;
+  template <class T> void operator()(T &&V) {
+    if (!linkCancelled())
+      Fn(std::forward<T>(V));
+  }
+};
+
 template <class IterTy, class FuncTy>
 void forEach(IterTy Begin, IterTy End, FuncTy Fn) {
+  CancellableTask<FuncTy> Task{std::move(Fn)};
+  if (Config->Threads)
+    parallel_for_each(Begin, End, Task);
+  else
+    std::for_each(Begin, End, Task);
+}
+
+template <class IterTy, class Comp>
+void sortParallel(IterTy Begin, IterTy End, Comp Fn) {
   if (Config->Threads)
-    parallel_for_each(Begin, End, Fn);
+    parallel_sort(Begin, End, Fn);
   else
-    std::for_each(Begin, End, Fn);
+    std::sort(Begin, End, Fn);
 }
 
 inline void forLoop(size_t Begin, size_t End, std::function<void(size_t)> Fn) {
+  auto Task = [&Fn](size_t I) {
+    if (!linkCancelled())
+      Fn(I);
+  };
   if (Config->Threads) {
-    parallel_for(Begin, End, Fn);
+    parallel_for(Begin, End, Task);
   } else {
     for (size_t I = Begin; I < End; ++I)
-      Fn(I);
+      Task(I);
   }
 }
 }
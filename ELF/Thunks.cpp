@@ -101,6 +101,25 @@ public:
   void writeTo(uint8_t *Buf) const override;
 };
 
+// Veneer for the Cortex-A53 erratum 843419 workaround. The offending
+// load/store is moved into the veneer and the site is overwritten
+// with a branch here; the veneer executes the moved instruction and
+// branches back to the instruction after the site. Both rewrites
+// happen at write time, after the owning section's relocations have
+// been applied, so the moved instruction carries its final immediate.
+template <class ELFT>
+class A53Erratum843419Patch final : public Thunk<ELFT> {
+public:
+  A53Erratum843419Patch(const InputSection<ELFT> &Owner, uint64_t PatchOff)
+      : Thunk<ELFT>(Owner), PatchOff(PatchOff) {}
+
+  uint32_t size() const override { return 8; }
+  void writeTo(uint8_t *Buf) const override;
+
+private:
+  uint64_t PatchOff;
+};
+
 } // end anonymous namespace
 
 // ARM Target Thunks
@@ -116,7 +135,7 @@ void ARMToThumbV7ABSLongThunk<ELFT>::writeTo(uint8_t *Buf) const {
       0x00, 0xc0, 0x40, 0xe3, // movt         ip,:upper16:S
       0x1c, 0xff, 0x2f, 0xe1, // bx   ip
   };
-  uint64_t S = getARMThunkDestVA<ELFT>(this->Destination);
+  uint64_t S = getARMThunkDestVA<ELFT>(*this->Destination);
   memcpy(Buf, Data, sizeof(Data));
   Target->relocateOne(Buf, R_ARM_MOVW_ABS_NC, S);
   Target->relocateOne(Buf + 4, R_ARM_MOVT_ABS, S);
@@ -129,7 +148,7 @@ void ThumbToARMV7ABSLongThunk<ELFT>::writeTo(uint8_t *Buf) const {
       0xc0, 0xf2, 0x00, 0x0c, // movt         ip, :upper16:S
       0x60, 0x47,             // bx   ip
   };
-  uint64_t S = getARMThunkDestVA<ELFT>(this->Destination);
+  uint64_t S = getARMThunkDestVA<ELFT>(*this->Destination);
   memcpy(Buf, Data, sizeof(Data));
   Target->relocateOne(Buf, R_ARM_THM_MOVW_ABS_NC, S);
   Target->relocateOne(Buf + 4, R_ARM_THM_MOVT_ABS, S);
@@ -143,7 +162,7 @@ void ARMToThumbV7PILongThunk<ELFT>::writeTo(uint8_t *Buf) const {
       0x0f, 0xc0, 0x8c, 0xe0, // L1: add ip, ip, pc
       0x1c, 0xff, 0x2f, 0xe1, //     bx r12
   };
-  uint64_t S = getARMThunkDestVA<ELFT>(this->Destination);
+  uint64_t S = getARMThunkDestVA<ELFT>(*this->Destination);
   uint64_t P = this->getVA();
   memcpy(Buf, Data, sizeof(Data));
   Target->relocateOne(Buf, R_ARM_MOVW_PREL_NC, S - P - 16);
@@ -158,7 +177,7 @@ void ThumbToARMV7PILongThunk<ELFT>::writeTo(uint8_t *Buf) const {
       0xfc, 0x44,             // L1: add  r12, pc
       0x60, 0x47,             //     bx   r12
   };
-  uint64_t S = getARMThunkDestVA<ELFT>(this->Destination);
+  uint64_t S = getARMThunkDestVA<ELFT>(*this->Destination);
   uint64_t P = this->getVA();
   memcpy(Buf, Data, sizeof(Data));
   Target->relocateOne(Buf, R_ARM_THM_MOVW_PREL_NC, S - P - 12);
@@ -169,7 +188,7 @@ void ThumbToARMV7PILongThunk<ELFT>::writeTo(uint8_t *Buf) const {
 template <class ELFT> void MipsThunk<ELFT>::writeTo(uint8_t *Buf) const {
   const endianness E = ELFT::TargetEndianness;
 
-  uint64_t S = this->Destination.template getVA<ELFT>();
+  uint64_t S = this->Destination->template getVA<ELFT>();
   write32<E>(Buf, 0x3c190000);                // lui   $25, %hi(func)
   write32<E>(Buf + 4, 0x08000000 | (S >> 2)); // j     func
   write32<E>(Buf + 8, 0x27390000);            // addiu $25, $25, %lo(func)
@@ -178,9 +197,37 @@ template <class ELFT> void MipsThunk<ELFT>::writeTo(uint8_t *Buf) const {
   Target->relocateOne(Buf + 8, R_MIPS_LO16, S);
 }
 
+// Writes the veneer and redirects the patched site to it. The offsets
+// within the owning section are final at this point, and the veneer
+// runs after InputSection::relocate for the same section, so the
+// relocated instruction can be read straight out of the output buffer.
+template <class ELFT>
+void A53Erratum843419Patch<ELFT>::writeTo(uint8_t *Buf) const {
+  // Buf points at this veneer; the owning section's relocated content
+  // starts Offset bytes earlier in the same output buffer.
+  uint8_t *PatchSite = Buf - this->Offset + PatchOff;
+  uint64_t SiteVA =
+      this->Owner.OutSec->Addr + this->Owner.OutSecOff + PatchOff;
+  uint64_t VA = this->getVA();
+
+  // Move the already-relocated load/store into the veneer and branch
+  // back to the instruction after the site.
+  write32le(Buf, read32le(PatchSite));
+  write32le(Buf + 4,
+            0x14000000 | (((SiteVA + 4 - (VA + 4)) >> 2) & 0x03ffffff));
+
+  // Replace the site with a branch to the veneer.
+  write32le(PatchSite, 0x14000000 | (((VA - SiteVA) >> 2) & 0x03ffffff));
+}
+
 template <class ELFT>
 Thunk<ELFT>::Thunk(const SymbolBody &D, const InputSection<ELFT> &O)
-    : Destination(D), Owner(O), Offset(O.getThunkOff() + O.getThunksSize()) {}
+    : Destination(&D), Owner(O), Offset(O.getThunkOff() + O.getThunksSize()) {}
+
+template <class ELFT>
+Thunk<ELFT>::Thunk(const InputSection<ELFT> &O)
+    : Destination(nullptr), Owner(O),
+      Offset(O.getThunkOff() + O.getThunksSize()) {}
 
 template <class ELFT> typename ELFT::uint Thunk<ELFT>::getVA() const {
   return Owner.OutSec->Addr + Owner.OutSecOff + Offset;
@@ -255,6 +302,11 @@ void addThunk(uint32_t RelocType, SymbolBody &S, InputSection<ELFT> &IS) {
     llvm_unreachable("add Thunk only supported for ARM and Mips");
 }
 
+template <class ELFT>
+void addA53Erratum843419Patch(InputSection<ELFT> &IS, uint64_t PatchOff) {
+  IS.addThunk(new (BAlloc) A53Erratum843419Patch<ELFT>(IS, PatchOff));
+}
+
 template void addThunk<ELF32LE>(uint32_t, SymbolBody &,
                                 InputSection<ELF32LE> &);
 template void addThunk<ELF32BE>(uint32_t, SymbolBody &,
@@ -264,6 +316,15 @@ template void addThunk<ELF64LE>(uint32_t, SymbolBody &,
 template void addThunk<ELF64BE>(uint32_t, SymbolBody &,
                                 InputSection<ELF64BE> &);
 
+template void addA53Erratum843419Patch<ELF32LE>(InputSection<ELF32LE> &,
+                                                uint64_t);
+template void addA53Erratum843419Patch<ELF32BE>(InputSection<ELF32BE> &,
+                                                uint64_t);
+template void addA53Erratum843419Patch<ELF64LE>(InputSection<ELF64LE> &,
+                                                uint64_t);
+template void addA53Erratum843419Patch<ELF64BE>(InputSection<ELF64BE> &,
+                                                uint64_t);
+
 template class Thunk<ELF32LE>;
 template class Thunk<ELF32BE>;
 template class Thunk<ELF64LE>;
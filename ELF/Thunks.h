@@ -32,6 +32,9 @@ template <class ELFT> class Thunk {
 
 public:
   Thunk(const SymbolBody &Destination, const InputSection<ELFT> &Owner);
+  // For code the linker inserts on its own behalf, such as erratum
+  // patch veneers, which have no destination symbol.
+  explicit Thunk(const InputSection<ELFT> &Owner);
   virtual ~Thunk();
 
   virtual uint32_t size() const { return 0; }
@@ -39,7 +42,7 @@ public:
   uintX_t getVA() const;
 
 protected:
-  const SymbolBody &Destination;
+  const SymbolBody *Destination;
   const InputSection<ELFT> &Owner;
   uint64_t Offset;
 };
@@ -50,6 +53,12 @@ protected:
 template <class ELFT>
 void addThunk(uint32_t RelocType, SymbolBody &S, InputSection<ELFT> &Src);
 
+// Appends a Cortex-A53 erratum 843419 patch veneer to IS. PatchOff is
+// the section offset of the offending load/store, which the veneer
+// replaces with a branch at write time (--fix-cortex-a53-843419).
+template <class ELFT>
+void addA53Erratum843419Patch(InputSection<ELFT> &IS, uint64_t PatchOff);
+
 } // namespace elf
 } // namespace lld
 
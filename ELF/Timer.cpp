@@ -0,0 +1,110 @@
+//===- Timer.cpp ----------------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Timer.h"
+#include "Config.h"
+#include "Error.h"
+#include "lld/Core/TimeTrace.h"
+#include "lld/Support/Memory.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+using namespace llvm;
+
+using namespace lld;
+using namespace lld::elf;
+
+namespace {
+struct TimerRecord {
+  StringRef Name;
+  double Millis;
+};
+}
+
+// Timers and counters are recorded on the main thread only, so no
+// locking is needed here.
+static std::vector<TimerRecord> Records;
+static std::vector<std::pair<StringRef, uint64_t>> Counters;
+
+ScopedTimer::ScopedTimer(StringRef Name) : Name(Name) {
+  if (Config->Stats || Config->LinkProfile)
+    Start = std::chrono::steady_clock::now();
+  if (timeTraceEnabled())
+    TraceStartUs = lld::internal::traceNow();
+}
+
+void ScopedTimer::stop() {
+  if (Stopped)
+    return;
+  Stopped = true;
+  if (Config->Stats || Config->LinkProfile) {
+    std::chrono::duration<double, std::milli> D =
+        std::chrono::steady_clock::now() - Start;
+    Records.push_back({Name, D.count()});
+  }
+  if (timeTraceEnabled())
+    lld::internal::localTraceBuffer().Events.push_back(
+        {Name, TraceStartUs, lld::internal::traceNow() - TraceStartUs});
+}
+
+ScopedTimer::~ScopedTimer() { stop(); }
+
+void lld::elf::addStat(StringRef Name, uint64_t Value) {
+  if (Config->Stats)
+    Counters.push_back({Name, Value});
+}
+
+void lld::elf::printTimingStats() {
+  if (!Config->Stats)
+    return;
+
+  // One JSON object on stderr so that wrapper scripts can pick it up
+  // without interfering with -M or --verbose output on stdout.
+  raw_ostream &OS = errs();
+  OS << "{\"passes\":[";
+  for (size_t I = 0, E = Records.size(); I != E; ++I) {
+    if (I)
+      OS << ",";
+    OS << "{\"name\":\"" << Records[I].Name << "\",\"wall_ms\":"
+       << format("%.3f", Records[I].Millis) << "}";
+  }
+  OS << "],\"counters\":{";
+  for (size_t I = 0, E = Counters.size(); I != E; ++I) {
+    if (I)
+      OS << ",";
+    OS << "\"" << Counters[I].first << "\":" << Counters[I].second;
+  }
+  OS << "},\"arena_bytes\":" << BAlloc.getBytesAllocated()
+     << ",\"malloc_bytes\":" << sys::Process::GetMallocUsage() << "}\n";
+}
+
+void lld::elf::forEachPassTime(
+    llvm::function_ref<void(StringRef, double)> Fn) {
+  for (TimerRecord &R : Records)
+    Fn(R.Name, R.Millis);
+}
+
+void lld::elf::writeTimeTraceFile() {
+  if (!timeTraceEnabled())
+    return;
+
+  std::string Path = Config->TimeTraceFile.empty()
+                         ? (Config->OutputFile + ".time-trace").str()
+                         : Config->TimeTraceFile;
+  std::error_code EC;
+  raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+  if (EC) {
+    error(EC, "--time-trace: cannot open " + Path);
+    return;
+  }
+  writeTimeTrace(OS);
+}
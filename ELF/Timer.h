@@ -0,0 +1,69 @@
+//===- Timer.h --------------------------------------------------*- C++ -*-===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file provides lightweight per-pass timing for --stats.
+// Wrap a pass in a ScopedTimer and its wall time is recorded; the
+// collected records are printed as JSON at the end of the link so
+// that build telemetry can ingest them without parsing free text.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_ELF_TIMER_H
+#define LLD_ELF_TIMER_H
+
+#include "lld/Core/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include <chrono>
+
+namespace lld {
+namespace elf {
+
+// Records the wall time between construction and destruction under a
+// given pass name. Timing is collected when --stats, --link-profile
+// or --time-trace is given; otherwise both constructor and destructor
+// are no-ops.
+// With --time-trace the pass additionally becomes a main-thread span
+// in the trace, framing the worker spans it spawned.
+class ScopedTimer {
+public:
+  explicit ScopedTimer(StringRef Name);
+  ~ScopedTimer();
+
+  // Ends the timer early, before it goes out of scope. This avoids
+  // having to introduce a block just to bound a pass.
+  void stop();
+
+private:
+  StringRef Name;
+  std::chrono::steady_clock::time_point Start;
+  uint64_t TraceStartUs = 0;
+  bool Stopped = false;
+};
+
+// Records a named counter, such as the number of input sections or
+// symbols, for inclusion in the report. No-op without --stats.
+void addStat(StringRef Name, uint64_t Value);
+
+// Prints all recorded timers and memory counters as one JSON object
+// to stderr. Called once when the link is about to finish.
+void printTimingStats();
+
+// Invokes Fn once per recorded pass with its name and wall time in
+// milliseconds, in recording order. Used by the link profile writer.
+void forEachPassTime(llvm::function_ref<void(StringRef, double)> Fn);
+
+// Writes the spans recorded for --time-trace as Chrome trace-event
+// JSON, to --time-trace=<file> or <output>.time-trace. Called at the
+// same point as printTimingStats; no-op without --time-trace.
+void writeTimeTraceFile();
+
+} // namespace elf
+} // namespace lld
+
+#endif
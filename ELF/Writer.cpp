@@ -10,19 +10,29 @@
 #include "Writer.h"
 #include "Config.h"
 #include "LinkerScript.h"
+#include "MapFile.h"
 #include "OutputSections.h"
 #include "Relocations.h"
 #include "Strings.h"
 #include "SymbolTable.h"
 #include "SyntheticSections.h"
 #include "Target.h"
+#include "Threads.h"
+#include "Timer.h"
 #include "lld/Support/Memory.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JamCRC.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Support/raw_ostream.h"
 #include <climits>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 using namespace llvm;
@@ -35,6 +45,31 @@ using namespace lld;
 using namespace lld::elf;
 
 namespace {
+// .gnu_debuglink in the format objcopy --add-gnu-debuglink creates it:
+// the name of the separate debug file, null-terminated and padded to a
+// four byte boundary, followed by the CRC32 of that file's contents.
+template <class ELFT>
+class GnuDebugLinkSection final : public OutputSectionBase {
+public:
+  GnuDebugLinkSection(StringRef Filename)
+      : OutputSectionBase(".gnu_debuglink", llvm::ELF::SHT_PROGBITS, 0),
+        Filename(Filename) {
+    this->Size = alignTo(Filename.size() + 1, 4) + 4;
+    this->Addralign = 4;
+  }
+
+  void writeTo(uint8_t *Buf) override {
+    memcpy(Buf, Filename.data(), Filename.size());
+    write32<ELFT::TargetEndianness>(Buf + this->Size - 4, CRC);
+  }
+
+  // Filled in by Writer::writeDebugFile once the debug image exists.
+  uint32_t CRC = 0;
+
+private:
+  StringRef Filename;
+};
+
 // The writer writes a SymbolTable result to a file.
 template <class ELFT> class Writer {
 public:
@@ -46,6 +81,14 @@ public:
   typedef typename ELFT::SymRange Elf_Sym_Range;
   typedef typename ELFT::Rela Elf_Rela;
   void run();
+  ~Writer() {
+    if (StreamThread.joinable())
+      finishStreaming();
+    if (OldReader.joinable())
+      OldReader.join();
+    if (DebugFileWriter.joinable())
+      DebugFileWriter.join();
+  }
 
 private:
   typedef PhdrEntry<ELFT> Phdr;
@@ -67,20 +110,55 @@ private:
   void assignFileOffsets();
   void assignFileOffsetsBinary();
   void setPhdrs();
+  void compressDebugSections();
+  void splitDebugSections();
+  void writeDebugFile();
   void fixHeaders();
   void fixSectionAlignments();
   void fixAbsoluteSymbols();
   void openFile();
+  void commitBuffer();
   void writeHeader();
   void writeSections();
+  void writeSectionsStreamed(OutputSectionBase *EhFrameHdr);
   void writeSectionsBinary();
+  void writeSectionDigests();
   void writeBuildId();
 
+  void startStreaming();
+  void advanceStream(uint64_t Offset);
+  void finishStreaming();
+
+  // The output image under construction. With the default mmap engine
+  // BufferStart points into Buffer; with --no-mmap-output-file it
+  // points at anonymous memory and Buffer stays null.
   std::unique_ptr<FileOutputBuffer> Buffer;
+  uint8_t *BufferStart = nullptr;
 
   std::vector<OutputSectionBase *> OutputSections;
   OutputSectionFactory<ELFT> Factory;
 
+  // For --separate-debug-file: the output sections routed to the debug
+  // file, the .gnu_debuglink stub left in the main image, and the
+  // thread flushing the debug file while the main image is written.
+  std::vector<OutputSectionBase *> DebugSections;
+  GnuDebugLinkSection<ELFT> *DebugLink = nullptr;
+  std::string DebugFilePath;
+  std::thread DebugFileWriter;
+
+  // For the no-op relink check: the previous output, read in the
+  // background while the new image is composed.
+  ErrorOr<std::unique_ptr<MemoryBuffer>> OldBuffer = std::error_code();
+  std::thread OldReader;
+
+  // For --stream-output: the thread piping finished byte ranges to
+  // stdout and the watermark below which the image is final.
+  std::thread StreamThread;
+  std::mutex StreamMutex;
+  std::condition_variable StreamCV;
+  uint64_t StreamWatermark = 0;
+  bool StreamDone = false;
+
   void addRelIpltSymbols();
   void addStartEndSymbols();
   void addStartStopSymbols(OutputSectionBase *Sec);
@@ -149,6 +227,8 @@ template <class ELFT> void Writer<ELFT>::removeEmptyPTLoad() {
 
 // The main function of the writer.
 template <class ELFT> void Writer<ELFT>::run() {
+  ScopedTimer LayoutTimer("layout");
+
   // Create linker-synthesized sections such as .got or .plt.
   // Such sections are of type input section.
   createSyntheticSections();
@@ -160,8 +240,11 @@ template <class ELFT> void Writer<ELFT>::run() {
   // Some architectures use small displacements for jump instructions.
   // It is linker's responsibility to create thunks containing long
   // jump instructions if jump targets are too far. Create thunks.
-  if (Target->NeedsThunks)
-    forEachRelSec(createThunks<ELFT>);
+  if (Target->NeedsThunks) {
+    std::vector<InputSectionBase<ELFT> *> RelSections;
+    forEachRelSec([&](InputSectionBase<ELFT> &S) { RelSections.push_back(&S); });
+    createThunks<ELFT>(RelSections);
+  }
 
   // Create output sections.
   Script<ELFT>::X->OutputSections = &OutputSections;
@@ -184,15 +267,26 @@ template <class ELFT> void Writer<ELFT>::run() {
   if (Config->Discard != DiscardPolicy::All)
     copyLocalSymbols();
 
+  // --separate-debug-file routes the debug sections to their own file,
+  // so take them out before the main image's layout is fixed.
+  splitDebugSections();
+
   // Now that we have a complete set of output sections. This function
   // completes section contents. For example, we need to add strings
   // to the string table, and add entries to .got and .plt.
   // finalizeSections does that.
-  finalizeSections();
+  LayoutTimer.stop();
+  {
+    ScopedTimer T("finalize-sections");
+    finalizeSections();
+  }
   if (ErrorCount)
     return;
 
+  ScopedTimer AddrTimer("assign-addresses");
+
   if (Config->Relocatable) {
+    compressDebugSections();
     assignFileOffsets();
   } else {
     // Binary output does not have PHDRS.
@@ -211,11 +305,72 @@ template <class ELFT> void Writer<ELFT>::run() {
       assignAddresses();
     }
 
+    // Packed relocation data delta-encodes the addresses we just
+    // assigned, so the sizes of .rel[a].dyn and .relr.dyn now depend
+    // on the layout and vice versa. Re-encode and re-assign until the
+    // sizes settle; this converges within a few passes in practice.
+    if (Config->AndroidPackDynRelocs || Config->RelrPackDynRelocs) {
+      auto *Packed = Config->AndroidPackDynRelocs
+                         ? static_cast<AndroidPackedRelocationSection<ELFT> *>(
+                               In<ELFT>::RelaDyn)
+                         : nullptr;
+      auto Resize = [](SyntheticSection<ELFT> *Sec) {
+        Sec->OutSec->Size = 0;
+        cast<OutputSection<ELFT>>(Sec->OutSec)->assignOffsets();
+      };
+      for (unsigned Pass = 0; Pass != 10; ++Pass) {
+        bool Changed = false;
+        if (Packed && Packed->OutSec && !Packed->empty() &&
+            Packed->updateAllocSize()) {
+          Resize(Packed);
+          Changed = true;
+        }
+        if (In<ELFT>::RelrDyn && In<ELFT>::RelrDyn->OutSec &&
+            !In<ELFT>::RelrDyn->empty() &&
+            In<ELFT>::RelrDyn->updateAllocSize()) {
+          Resize(In<ELFT>::RelrDyn);
+          Changed = true;
+        }
+        if (!Changed)
+          break;
+        if (ScriptConfig->HasSections)
+          Script<ELFT>::X->assignAddresses(Phdrs);
+        else
+          assignAddresses();
+      }
+    }
+
+    // The Cortex-A53 843419 erratum scan keys on the final page offset
+    // of every adrp, and each patch veneer it attaches grows a section,
+    // which can move later code onto a new page boundary. Scan and
+    // re-assign addresses until no new sequence appears; one extra pass
+    // suffices in the common case.
+    if (Config->FixCortexA53Errata843419 &&
+        Config->EMachine == EM_AARCH64 && !Config->Relocatable) {
+      std::vector<std::pair<InputSection<ELFT> *, uint64_t>> Patched;
+      while (createA53Errata843419Fixes<ELFT>(OutputSections, Patched)) {
+        // The veneers grew their sections, so input section offsets
+        // and sizes must be recomputed before re-assigning addresses.
+        for (OutputSectionBase *Base : OutputSections)
+          if (Base->Flags & SHF_EXECINSTR)
+            if (auto *Sec = dyn_cast<OutputSection<ELFT>>(Base)) {
+              Sec->Size = 0;
+              Sec->assignOffsets();
+            }
+        if (ScriptConfig->HasSections)
+          Script<ELFT>::X->assignAddresses(Phdrs);
+        else
+          assignAddresses();
+      }
+    }
+
     // Remove empty PT_LOAD to avoid causing the dynamic linker to try to mmap a
     // 0 sized region. This has to be done late since only after assignAddresses
     // we know the size of the sections.
     removeEmptyPTLoad();
 
+    compressDebugSections();
+
     if (!Config->OFormatBinary)
       assignFileOffsets();
     else
@@ -225,17 +380,43 @@ template <class ELFT> void Writer<ELFT>::run() {
     fixAbsoluteSymbols();
   }
 
+  AddrTimer.stop();
+  addStat("output-sections", OutputSections.size());
+
+  // Addresses are final now, so the map file can be written.
+  if (!ErrorCount)
+    writeMapFile<ELFT>(OutputSections);
+
+  // --layout-only: the layout is fully decided at this point, so emit
+  // it and return before the output file is even created.
+  if (!Config->LayoutOnly.empty()) {
+    if (!ErrorCount)
+      writeLayoutFile<ELFT>(OutputSections);
+    return;
+  }
+
+  // Compose the separate debug file. This must happen before the main
+  // image is written because .gnu_debuglink in the main image carries
+  // the CRC of the debug file; the disk write itself proceeds on a
+  // background thread, overlapped with the relocation and copy work
+  // below.
+  if (!ErrorCount)
+    writeDebugFile();
+
   // Write the result down to a file.
+  ScopedTimer WriteTimer("write-output");
   openFile();
   if (ErrorCount)
     return;
   if (Config->OPreWrite) {
-    Config->OPreWrite(Buffer->getBufferStart(), OutputSections);
+    Config->OPreWrite(BufferStart, OutputSections);
     if (ErrorCount)
       return;
   }
   if (!Config->OFormatBinary) {
-    writeHeader();
+    // writeSections also writes the file header: the header is filled
+    // in by one of the parallel copy tasks rather than serially up
+    // front.
     writeSections();
   } else {
     writeSectionsBinary();
@@ -247,14 +428,25 @@ template <class ELFT> void Writer<ELFT>::run() {
   if (ErrorCount)
     return;
 
-  if (auto EC = Buffer->commit())
-    error(EC, "failed to write to the output file");
+  writeSectionDigests();
+  if (ErrorCount)
+    return;
+
+  commitBuffer();
+  if (DebugFileWriter.joinable())
+    DebugFileWriter.join();
+  WriteTimer.stop();
 
   // Flush the output streams and exit immediately. A full shutdown
   // is a good test that we are keeping track of all allocated memory,
   // but actually freeing it is a waste of time in a regular linker run.
-  if (Config->ExitEarly)
+  // With --exit-early the driver never regains control, so the timing
+  // report has to be printed here.
+  if (Config->ExitEarly) {
+    writeTimeTraceFile();
+    printTimingStats();
     exitLld(0);
+  }
 }
 
 // Initialize Out<ELFT> members.
@@ -269,8 +461,14 @@ template <class ELFT> void Writer<ELFT>::createSyntheticSections() {
   In<ELFT>::DynStrTab = make<StringTableSection<ELFT>>(".dynstr", true);
   In<ELFT>::Dynamic = make<DynamicSection<ELFT>>();
   Out<ELFT>::EhFrame = make<EhOutputSection<ELFT>>();
-  In<ELFT>::RelaDyn = make<RelocationSection<ELFT>>(
-      Config->Rela ? ".rela.dyn" : ".rel.dyn", Config->ZCombreloc);
+  StringRef RelaDynName = Config->Rela ? ".rela.dyn" : ".rel.dyn";
+  if (Config->AndroidPackDynRelocs)
+    In<ELFT>::RelaDyn = make<AndroidPackedRelocationSection<ELFT>>(RelaDynName);
+  else
+    In<ELFT>::RelaDyn =
+        make<RelocationSection<ELFT>>(RelaDynName, Config->ZCombreloc);
+  if (Config->RelrPackDynRelocs)
+    In<ELFT>::RelrDyn = make<RelrSection<ELFT>>();
   In<ELFT>::ShStrTab = make<StringTableSection<ELFT>>(".shstrtab", false);
 
   Out<ELFT>::ElfHeader = make<OutputSectionBase>("", 0, SHF_ALLOC);
@@ -347,6 +545,8 @@ template <class ELFT> void Writer<ELFT>::createSyntheticSections() {
     Symtab<ELFT>::X->Sections.push_back(In<ELFT>::Dynamic);
     Symtab<ELFT>::X->Sections.push_back(In<ELFT>::DynStrTab);
     Symtab<ELFT>::X->Sections.push_back(In<ELFT>::RelaDyn);
+    if (In<ELFT>::RelrDyn)
+      Symtab<ELFT>::X->Sections.push_back(In<ELFT>::RelrDyn);
   }
 
   // Add .got. MIPS' .got is so different from the other archs,
@@ -447,11 +647,21 @@ template <class ELFT> static bool includeInSymtab(const SymbolBody &B) {
 template <class ELFT> void Writer<ELFT>::copyLocalSymbols() {
   if (!In<ELFT>::SymTab)
     return;
-  for (elf::ObjectFile<ELFT> *F : Symtab<ELFT>::X->getObjectFiles()) {
-    for (SymbolBody *B : F->getLocalSymbols()) {
-      if (!B->IsLocal)
-        fatal(toString(F) +
-              ": broken object: getLocalSymbols returns a non-local symbol");
+
+  // Deciding whether a local stays in .symtab only reads the symbol
+  // and its section, but with -g it happens millions of times, so the
+  // filtering runs parallel per file into per-file vectors. The string
+  // table and counter updates below are serial and splice the results
+  // in file order, so the output is identical to a serial scan.
+  ArrayRef<elf::ObjectFile<ELFT> *> Files = Symtab<ELFT>::X->getObjectFiles();
+  std::vector<std::vector<DefinedRegular<ELFT> *>> Kept(Files.size());
+  std::vector<uint8_t> Broken(Files.size(), 0);
+  forLoop(0, Files.size(), [&](size_t I) {
+    for (SymbolBody *B : Files[I]->getLocalSymbols()) {
+      if (!B->IsLocal) {
+        Broken[I] = 1;
+        return;
+      }
       auto *DR = dyn_cast<DefinedRegular<ELFT>>(B);
 
       // No reason to keep local undefined symbol in symtab.
@@ -459,15 +669,24 @@ template <class ELFT> void Writer<ELFT>::copyLocalSymbols() {
         continue;
       if (!includeInSymtab<ELFT>(*B))
         continue;
-
-      InputSectionBase<ELFT> *Sec = DR->Section;
-      if (!shouldKeepInSymtab<ELFT>(Sec, B->getName(), *B))
+      if (!shouldKeepInSymtab<ELFT>(DR->Section, B->getName(), *B))
         continue;
+      Kept[I].push_back(DR);
+    }
+  });
+
+  for (size_t I = 0, E = Files.size(); I != E; ++I)
+    if (Broken[I])
+      fatal(toString(Files[I]) +
+            ": broken object: getLocalSymbols returns a non-local symbol");
+
+  for (size_t I = 0, E = Files.size(); I != E; ++I) {
+    for (DefinedRegular<ELFT> *DR : Kept[I]) {
       ++In<ELFT>::SymTab->NumLocals;
       if (Config->Relocatable)
-        B->DynsymIndex = In<ELFT>::SymTab->NumLocals;
-      F->KeptLocalSyms.push_back(std::make_pair(
-          DR, In<ELFT>::SymTab->StrTabSec.addString(B->getName())));
+        DR->DynsymIndex = In<ELFT>::SymTab->NumLocals;
+      Files[I]->KeptLocalSyms.push_back(std::make_pair(
+          DR, In<ELFT>::SymTab->StrTabSec.addString(DR->getName())));
     }
   }
 }
@@ -513,81 +732,76 @@ template <class ELFT> bool elf::isRelroSection(const OutputSectionBase *Sec) {
          S == ".eh_frame";
 }
 
+// Encodes all layout criteria for an output section into one integer
+// so that the sort below compares precomputed ranks instead of
+// re-deriving the classification (including the name-based relro
+// checks) on every comparison. The most significant criterion lives in
+// the highest bits; sorting by rank ascending reproduces the old
+// pairwise comparison exactly. Sections with equal ranks keep their
+// relative order, which is why non-allocatable sections return early
+// with no lower bits set.
 template <class ELFT>
-static bool compareSectionsNonScript(const OutputSectionBase *A,
-                                     const OutputSectionBase *B) {
+static uint32_t getSectionRank(const OutputSectionBase *Sec) {
+  uint32_t Rank = 0;
+
   // Put .interp first because some loaders want to see that section
   // on the first page of the executable file when loaded into memory.
-  bool AIsInterp = A->getName() == ".interp";
-  bool BIsInterp = B->getName() == ".interp";
-  if (AIsInterp != BIsInterp)
-    return AIsInterp;
+  if (Sec->getName() != ".interp")
+    Rank |= 1 << 30;
 
   // Allocatable sections go first to reduce the total PT_LOAD size and
-  // so debug info doesn't change addresses in actual code.
-  bool AIsAlloc = A->Flags & SHF_ALLOC;
-  bool BIsAlloc = B->Flags & SHF_ALLOC;
-  if (AIsAlloc != BIsAlloc)
-    return AIsAlloc;
-
-  // We don't have any special requirements for the relative order of two non
+  // so debug info doesn't change addresses in actual code. We don't
+  // have any special requirements for the relative order of two non
   // allocatable sections.
-  if (!AIsAlloc)
-    return false;
+  if (!(Sec->Flags & SHF_ALLOC))
+    return Rank | (1 << 29);
 
   // We want the read only sections first so that they go in the PT_LOAD
   // covering the program headers at the start of the file.
-  bool AIsWritable = A->Flags & SHF_WRITE;
-  bool BIsWritable = B->Flags & SHF_WRITE;
-  if (AIsWritable != BIsWritable)
-    return BIsWritable;
+  if (Sec->Flags & SHF_WRITE)
+    Rank |= 1 << 28;
 
-  if (!Config->SingleRoRx) {
-    // For a corresponding reason, put non exec sections first (the program
-    // header PT_LOAD is not executable).
-    // We only do that if we are not using linker scripts, since with linker
-    // scripts ro and rx sections are in the same PT_LOAD, so their relative
-    // order is not important. The same applies for -no-rosegment.
-    bool AIsExec = A->Flags & SHF_EXECINSTR;
-    bool BIsExec = B->Flags & SHF_EXECINSTR;
-    if (AIsExec != BIsExec)
-      return BIsExec;
-  }
+  // For a corresponding reason, put non exec sections first (the program
+  // header PT_LOAD is not executable).
+  // We only do that if we are not using linker scripts, since with linker
+  // scripts ro and rx sections are in the same PT_LOAD, so their relative
+  // order is not important. The same applies for -no-rosegment.
+  if (!Config->SingleRoRx && (Sec->Flags & SHF_EXECINSTR))
+    Rank |= 1 << 27;
 
-  // If we got here we know that both A and B are in the same PT_LOAD.
+  // From here on sections with the same bits so far share a PT_LOAD.
 
   // The TLS initialization block needs to be a single contiguous block in a R/W
   // PT_LOAD, so stick TLS sections directly before R/W sections. The TLS NOBITS
   // sections are placed here as they don't take up virtual address space in the
   // PT_LOAD.
-  bool AIsTls = A->Flags & SHF_TLS;
-  bool BIsTls = B->Flags & SHF_TLS;
-  if (AIsTls != BIsTls)
-    return AIsTls;
+  if (!(Sec->Flags & SHF_TLS))
+    Rank |= 1 << 26;
 
   // The next requirement we have is to put nobits sections last. The
   // reason is that the only thing the dynamic linker will see about
   // them is a p_memsz that is larger than p_filesz. Seeing that it
   // zeros the end of the PT_LOAD, so that has to correspond to the
   // nobits sections.
-  bool AIsNoBits = A->Type == SHT_NOBITS;
-  bool BIsNoBits = B->Type == SHT_NOBITS;
-  if (AIsNoBits != BIsNoBits)
-    return BIsNoBits;
+  if (Sec->Type == SHT_NOBITS)
+    Rank |= 1 << 25;
 
   // We place RelRo section before plain r/w ones.
-  bool AIsRelRo = isRelroSection<ELFT>(A);
-  bool BIsRelRo = isRelroSection<ELFT>(B);
-  if (AIsRelRo != BIsRelRo)
-    return AIsRelRo;
+  if (!isRelroSection<ELFT>(Sec))
+    Rank |= 1 << 24;
 
   // Some architectures have additional ordering restrictions for sections
   // within the same PT_LOAD.
   if (Config->EMachine == EM_PPC64)
-    return getPPC64SectionRank(A->getName()) <
-           getPPC64SectionRank(B->getName());
+    Rank |= getPPC64SectionRank(Sec->getName());
 
-  return false;
+  return Rank;
+}
+
+template <class ELFT>
+static bool compareSectionsNonScript(const OutputSectionBase *A,
+                                     const OutputSectionBase *B) {
+  return A->SortRank < B->SortRank;
 }
 
 // Output section ordering is determined by this function.
@@ -847,8 +1061,68 @@ void Writer<ELFT>::addInputSec(InputSectionBase<ELFT> *IS) {
 }
 
 template <class ELFT> void Writer<ELFT>::createSections() {
-  for (InputSectionBase<ELFT> *IS : Symtab<ELFT>::X->Sections)
-    addInputSec(IS);
+  // Splitting .eh_frame sections into CIE/FDE pieces only looks at the
+  // section's own contents and relocations, so do it for all inputs in
+  // parallel before the serial loop below deduplicates CIEs. split()
+  // is idempotent; sections already split by --gc-sections are
+  // skipped. This takes the record scanning, the bulk of the .eh_frame
+  // work in exception-heavy links, off the critical path.
+  forEach(Symtab<ELFT>::X->Sections.begin(), Symtab<ELFT>::X->Sections.end(),
+          [](InputSectionBase<ELFT> *S) {
+            if (auto *EH = dyn_cast<EhInputSection<ELFT>>(S))
+              if (EH->Live)
+                EH->split();
+          });
+
+  // Binning input sections into output sections is two halves: deciding
+  // which output section a section belongs to (mapping the name through
+  // getOutputSectionName and building the factory key), and appending it
+  // (which mutates the factory map, the output section and the input
+  // section). The first half is pure reads and dominates the loop on big
+  // links, so compute all keys in parallel, then run the appends serially
+  // in input order so the output section order and member order are
+  // exactly what the sequential loop produced.
+  std::vector<InputSectionBase<ELFT> *> &Input = Symtab<ELFT>::X->Sections;
+  std::vector<SectionKey<ELFT::Is64Bits>> Keys(Input.size());
+  forLoop(0, Input.size(), [&](size_t I) {
+    InputSectionBase<ELFT> *IS = Input[I];
+    if (IS && IS->Live)
+      Keys[I] = OutputSectionFactory<ELFT>::createKey(
+          IS, getOutputSectionName(IS->Name));
+  });
+
+  for (size_t I = 0, E = Input.size(); I != E; ++I) {
+    InputSectionBase<ELFT> *IS = Input[I];
+    if (!IS)
+      continue;
+    if (!IS->Live) {
+      reportDiscarded(IS);
+      continue;
+    }
+    OutputSectionBase *Sec;
+    bool IsNew;
+    std::tie(Sec, IsNew) = Factory.create(Keys[I], IS);
+    if (IsNew)
+      OutputSections.push_back(Sec);
+    Sec->addSection(IS);
+  }
+
+  // --sort-section=alignment also applies without SECTIONS commands:
+  // ordering the members of each output section by descending alignment
+  // minimizes the padding assignOffsets inserts between mixed-alignment
+  // inputs. The sort is stable within an alignment class, and the
+  // symbol-ordering and init/fini sorts below are stable too, so their
+  // keys still dominate where they apply. Output sections are
+  // independent, so they are sorted in parallel.
+  if (Config->SortSection == SortSectionPolicy::Alignment &&
+      !ScriptConfig->HasSections)
+    forEach(OutputSections.begin(), OutputSections.end(),
+            [](OutputSectionBase *Base) {
+              if (auto *Sec = dyn_cast<OutputSection<ELFT>>(Base))
+                Sec->sort([](InputSection<ELFT> *S) {
+                  return 64 - llvm::Log2_64(S->Alignment);
+                });
+            });
 
   sortBySymbolsOrder<ELFT>(OutputSections);
   sortInitFini<ELFT>(findSection(".init_array"));
@@ -881,6 +1155,12 @@ template <class ELFT> void Writer<ELFT>::sortSections() {
   // relative order for SHF_LINK_ORDER sections.
   if (Config->Relocatable)
     return;
+
+  // Compute every section's layout rank once up front; the sorts and
+  // the insertion loop below only compare these integers.
+  for (OutputSectionBase *Sec : OutputSections)
+    Sec->SortRank = getSectionRank<ELFT>(Sec);
+
   if (!ScriptConfig->HasSections) {
     std::stable_sort(OutputSections.begin(), OutputSections.end(),
                      compareSectionsNonScript<ELFT>);
@@ -963,6 +1243,72 @@ finalizeSynthetic(const std::vector<SyntheticSection<ELFT> *> &Sections) {
     }
 }
 
+// Finalizes the linker-synthesized input sections as a small dependency
+// schedule instead of one long sequence. A stage is a set of chains; the
+// chains of a stage run in parallel on the thread pool and the sections
+// of a chain run in sequence. Sections share a chain when one feeds the
+// other (VerDef adds strings to DynStrTab) or when they can end up in
+// the same output section, whose offsets are reassigned after each
+// finalize (the .got/.got.plt family, the dynamic relocation sections,
+// Plt/Iplt).
+// This lets expensive independent finalizes -- gdb-index parsing, hash
+// table sizing, version sections -- overlap.
+template <class ELFT> static void finalizeSyntheticSections() {
+  typedef std::vector<SyntheticSection<ELFT> *> Chain;
+
+  // DynSymTab must be finalized first: doing so assigns the dynsym
+  // indices and, via the GNU hash table, sorts the dynamic symbols that
+  // the hash and version sections read.
+  Chain First = {In<ELFT>::DynSymTab};
+  std::vector<Chain> Middle = {
+      {In<ELFT>::GnuHashTab},
+      {In<ELFT>::HashTab},
+      {In<ELFT>::SymTab},
+      {In<ELFT>::ShStrTab},
+      {In<ELFT>::StrTab},
+      {In<ELFT>::VerDef, In<ELFT>::DynStrTab},
+      {In<ELFT>::GdbIndex},
+      {In<ELFT>::Got, In<ELFT>::MipsGot, In<ELFT>::IgotPlt,
+       In<ELFT>::GotPlt},
+      {In<ELFT>::RelaDyn, In<ELFT>::RelaIplt, In<ELFT>::RelaPlt},
+      {In<ELFT>::RelrDyn},
+      {In<ELFT>::Plt, In<ELFT>::Iplt},
+      {In<ELFT>::EhFrameHdr},
+      {In<ELFT>::VerSym},
+      {In<ELFT>::VerNeed}};
+  // The dynamic section must be the last one because some tags like
+  // RELSZ depend on the result of finalizing other sections.
+  Chain Last = {In<ELFT>::Dynamic};
+
+  finalizeSynthetic<ELFT>(First);
+
+  // Two finalizes in the Middle stage contain parallel loops of their
+  // own: the SysV hash table hashes the dynamic symbol names and the
+  // gdb-index section scans the CU headers. The pool does not steal
+  // work, so a parallel loop started from inside the chain drain would
+  // park its worker waiting for tasks behind it in the queue and can
+  // deadlock small pools. Run those loops here, at the top level, and
+  // leave only serial work in the chain bodies.
+  if (In<ELFT>::HashTab && In<ELFT>::HashTab->OutSec &&
+      !In<ELFT>::HashTab->empty())
+    In<ELFT>::HashTab->computeHashes();
+  if (In<ELFT>::GdbIndex && In<ELFT>::GdbIndex->OutSec &&
+      !In<ELFT>::GdbIndex->empty())
+    In<ELFT>::GdbIndex->parseDebugSections();
+
+  // A SECTIONS command can place any two synthetic sections into one
+  // output section, which would break the chain independence assumption,
+  // so fall back to finalizing the chains in sequence.
+  if (ScriptConfig->HasSections)
+    for (Chain &C : Middle)
+      finalizeSynthetic<ELFT>(C);
+  else
+    forEach(Middle.begin(), Middle.end(),
+            [](Chain &C) { finalizeSynthetic<ELFT>(C); });
+
+  finalizeSynthetic<ELFT>(Last);
+}
+
 // We need to add input synthetic sections early in createSyntheticSections()
 // to make them visible from linkescript side. But not all sections are always
 // required to be in output. For example we don't need dynamic section content
@@ -1019,8 +1365,15 @@ template <class ELFT> void Writer<ELFT>::finalizeSections() {
   }
 
   // Scan relocations. This must be done after every symbol is declared so that
-  // we can correctly decide if a dynamic relocation is needed.
-  forEachRelSec(scanRelocations<ELFT>);
+  // we can correctly decide if a dynamic relocation is needed. The
+  // classification half of the scan runs in parallel over all sections.
+  {
+    ScopedTimer T("scan-relocations");
+    std::vector<InputSectionBase<ELFT> *> RelSections;
+    forEachRelSec(
+        [&](InputSectionBase<ELFT> &S) { RelSections.push_back(&S); });
+    scanRelocations<ELFT>(RelSections);
+  }
 
   // Now that we have defined all possible symbols including linker-
   // synthesized ones. Visit all symbols to give the finishing touches.
@@ -1063,17 +1416,7 @@ template <class ELFT> void Writer<ELFT>::finalizeSections() {
   for (OutputSectionBase *Sec : OutputSections)
     Sec->finalize();
 
-  // Dynamic section must be the last one in this list and dynamic
-  // symbol table section (DynSymTab) must be the first one.
-  finalizeSynthetic<ELFT>(
-      {In<ELFT>::DynSymTab, In<ELFT>::GnuHashTab, In<ELFT>::HashTab,
-       In<ELFT>::SymTab,    In<ELFT>::ShStrTab,   In<ELFT>::StrTab,
-       In<ELFT>::VerDef,    In<ELFT>::DynStrTab,  In<ELFT>::GdbIndex,
-       In<ELFT>::Got,       In<ELFT>::MipsGot,    In<ELFT>::IgotPlt,
-       In<ELFT>::GotPlt,    In<ELFT>::RelaDyn,    In<ELFT>::RelaIplt,
-       In<ELFT>::RelaPlt,   In<ELFT>::Plt,        In<ELFT>::Iplt,
-       In<ELFT>::Plt,       In<ELFT>::EhFrameHdr, In<ELFT>::VerSym,
-       In<ELFT>::VerNeed,   In<ELFT>::Dynamic});
+  finalizeSyntheticSections<ELFT>();
 }
 
 template <class ELFT> void Writer<ELFT>::addPredefinedSections() {
@@ -1087,6 +1430,9 @@ template <class ELFT> void Writer<ELFT>::addPredefinedSections() {
   addInputSec(In<ELFT>::SymTab);
   addInputSec(In<ELFT>::ShStrTab);
   addInputSec(In<ELFT>::StrTab);
+
+  if (DebugLink)
+    OutputSections.push_back(DebugLink);
 }
 
 // The linker is expected to define SECNAME_start and SECNAME_end
@@ -1551,7 +1897,7 @@ template <class ELFT> void Writer<ELFT>::fixAbsoluteSymbols() {
 }
 
 template <class ELFT> void Writer<ELFT>::writeHeader() {
-  uint8_t *Buf = Buffer->getBufferStart();
+  uint8_t *Buf = BufferStart;
   memcpy(Buf, "\177ELF", 4);
 
   // Write the ELF header.
@@ -1595,6 +1941,160 @@ template <class ELFT> void Writer<ELFT>::writeHeader() {
     Sec->writeHeaderTo<ELFT>(++SHdrs);
 }
 
+// Compress output .debug_* sections for --compress-debug-sections.
+// This runs once symbol values are final, because compressing a
+// section bakes in its relocated contents, and before file offsets
+// are assigned, because the sections shrink. Sections compress
+// independently of each other, in parallel.
+template <class ELFT> void Writer<ELFT>::compressDebugSections() {
+  if (!Config->CompressDebugSections)
+    return;
+  ScopedTimer T("compress-debug-sections");
+  forEach(OutputSections.begin(), OutputSections.end(),
+          [](OutputSectionBase *Sec) { Sec->maybeCompress(); });
+  forEach(DebugSections.begin(), DebugSections.end(),
+          [](OutputSectionBase *Sec) { Sec->maybeCompress(); });
+}
+
+// For --separate-debug-file, move the non-alloc .debug_* output
+// sections out of the main image's section list and plant a
+// .gnu_debuglink stub in their place. This runs before
+// finalizeSections so the debug sections never receive main-image
+// section indices or .shstrtab entries; the debug file gets its own
+// string table in writeDebugFile.
+template <class ELFT> void Writer<ELFT>::splitDebugSections() {
+  if (!Config->SeparateDebugFile || Config->Relocatable ||
+      Config->OFormatBinary)
+    return;
+
+  auto Mid = std::stable_partition(
+      OutputSections.begin(), OutputSections.end(), [](OutputSectionBase *S) {
+        return (S->Flags & SHF_ALLOC) || !S->Name.startswith(".debug_");
+      });
+  DebugSections.assign(Mid, OutputSections.end());
+  OutputSections.erase(Mid, OutputSections.end());
+  if (DebugSections.empty())
+    return;
+
+  // finalizeSections no longer reaches these sections, so finalize
+  // them here; merge sections compute their size in finalize().
+  for (OutputSectionBase *Sec : DebugSections)
+    Sec->finalize();
+
+  DebugFilePath = Config->SeparateDebugFilename.empty()
+                      ? (Config->OutputFile + ".debug").str()
+                      : Config->SeparateDebugFilename;
+  DebugLink =
+      make<GnuDebugLinkSection<ELFT>>(sys::path::filename(DebugFilePath));
+}
+
+// Compose the separate debug file in memory and start writing it out
+// on a background thread. The file is a minimal ELF image: header,
+// section contents, a local .shstrtab and the section header table.
+// No program headers; this file is only ever read by debuggers.
+template <class ELFT> void Writer<ELFT>::writeDebugFile() {
+  if (DebugSections.empty())
+    return;
+  ScopedTimer T("write-debug-file");
+
+  std::string ShStrTab("\0", 1);
+  std::vector<uint32_t> NameOff;
+  for (OutputSectionBase *Sec : DebugSections) {
+    NameOff.push_back(ShStrTab.size());
+    ShStrTab += Sec->Name;
+    ShStrTab += '\0';
+  }
+  uint32_t ShStrTabNameOff = ShStrTab.size();
+  ShStrTab += ".shstrtab";
+  ShStrTab += '\0';
+
+  uint64_t Off = sizeof(Elf_Ehdr);
+  std::vector<uint64_t> Offsets;
+  for (OutputSectionBase *Sec : DebugSections) {
+    Off = alignTo(Off, std::max<uint64_t>(Sec->Addralign, 1));
+    Offsets.push_back(Off);
+    Off += Sec->Size;
+  }
+  uint64_t ShStrTabOff = Off;
+  uint64_t SHOff = alignTo(ShStrTabOff + ShStrTab.size(), sizeof(uintX_t));
+  size_t NumSections = DebugSections.size() + 2; // null entry + .shstrtab
+  uint64_t DebugFileSize = SHOff + NumSections * sizeof(Elf_Shdr);
+
+  auto Image = std::make_shared<std::vector<uint8_t>>(DebugFileSize);
+  uint8_t *Buf = Image->data();
+
+  // The ELF header carries the same identity as the main image but
+  // describes only the section table.
+  memcpy(Buf, "\177ELF", 4);
+  auto *EHdr = reinterpret_cast<Elf_Ehdr *>(Buf);
+  EHdr->e_ident[EI_CLASS] = ELFT::Is64Bits ? ELFCLASS64 : ELFCLASS32;
+  EHdr->e_ident[EI_DATA] = getELFEncoding<ELFT>();
+  EHdr->e_ident[EI_VERSION] = EV_CURRENT;
+  EHdr->e_ident[EI_OSABI] = Config->OSABI;
+  EHdr->e_type = getELFType();
+  EHdr->e_machine = Config->EMachine;
+  EHdr->e_version = EV_CURRENT;
+  EHdr->e_shoff = SHOff;
+  EHdr->e_ehsize = sizeof(Elf_Ehdr);
+  EHdr->e_shentsize = sizeof(Elf_Shdr);
+  EHdr->e_shnum = NumSections;
+  EHdr->e_shstrndx = NumSections - 1;
+
+  // Copy the section contents with the same parallel task drain as
+  // writeSections, just over the debug sections. This runs before the
+  // main image's drain, not nested inside it.
+  std::vector<std::function<void()>> Tasks;
+  for (size_t I = 0, E = DebugSections.size(); I != E; ++I)
+    DebugSections[I]->writeTasks(Buf + Offsets[I], Tasks);
+  {
+    ScopedDiagnosticBuffer DiagBuffer;
+    forEach(Tasks.begin(), Tasks.end(),
+            [](const std::function<void()> &Fn) { Fn(); });
+  }
+  memcpy(Buf + ShStrTabOff, ShStrTab.data(), ShStrTab.size());
+
+  // The section header table. The first entry is null.
+  auto *SHdr = reinterpret_cast<Elf_Shdr *>(Buf + SHOff) + 1;
+  for (size_t I = 0, E = DebugSections.size(); I != E; ++I) {
+    OutputSectionBase *Sec = DebugSections[I];
+    SHdr->sh_name = NameOff[I];
+    SHdr->sh_type = Sec->Type;
+    SHdr->sh_flags = Sec->Flags;
+    SHdr->sh_offset = Offsets[I];
+    SHdr->sh_size = Sec->Size;
+    SHdr->sh_addralign = Sec->Addralign;
+    SHdr->sh_entsize = Sec->Entsize;
+    ++SHdr;
+  }
+  SHdr->sh_name = ShStrTabNameOff;
+  SHdr->sh_type = SHT_STRTAB;
+  SHdr->sh_offset = ShStrTabOff;
+  SHdr->sh_size = ShStrTab.size();
+  SHdr->sh_addralign = 1;
+
+  // .gnu_debuglink carries the standard CRC32 of the debug file, which
+  // is the complement of what JamCRC computes.
+  JamCRC CRC;
+  CRC.update(makeArrayRef(reinterpret_cast<char *>(Buf), DebugFileSize));
+  DebugLink->CRC = ~CRC.getCRC();
+
+  // Flush in the background while the main image is being written.
+  // run() joins this thread after committing the main image.
+  std::string Path = DebugFilePath;
+  DebugFileWriter = std::thread([=] {
+    int FD;
+    if (auto EC = sys::fs::openFileForWrite(Path, FD, sys::fs::F_None)) {
+      error(EC, "failed to open " + Path);
+      return;
+    }
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS.write(reinterpret_cast<const char *>(Image->data()), Image->size());
+    OS.close();
+    if (OS.has_error())
+      error(OS.error(), "failed to write to " + Path);
+  });
+}
+
 // Removes a given file asynchronously. This is a performance hack,
 // so remove this when operating systems are improved.
 //
@@ -1630,27 +2130,211 @@ static void unlinkAsync(StringRef Path) {
 
 // Open a result file.
 template <class ELFT> void Writer<ELFT>::openFile() {
-  unlinkAsync(Config->OutputFile);
+  // --stream-output never touches the filesystem; the image goes to
+  // stdout from the in-memory buffer below.
+  if (!Config->StreamOutput) {
+    if (!Config->MmapOutputFile && sys::fs::exists(Config->OutputFile)) {
+      // Read the current output in the background while the new image
+      // is composed. If the relink turns out to be a no-op, commitBuffer
+      // skips the write and keeps the old file, so its mtime does not
+      // move and mtime-based build systems stop rebuilding downstream.
+      // Only the in-memory engine can decide before touching the file,
+      // so the mmap engine keeps the unlink-and-rewrite path.
+      OldReader = std::thread([this] {
+        OldBuffer = MemoryBuffer::getFile(Config->OutputFile, -1,
+                                          /*RequiresNullTerminator=*/false);
+      });
+    } else {
+      unlinkAsync(Config->OutputFile);
+    }
+  }
+
+  if (!Config->MmapOutputFile) {
+    // Compose the image in anonymous memory instead of a shared file
+    // mapping. On filesystems where mmap writeback is slow (NFS,
+    // overlayfs) dirtying the page cache through a mapping makes
+    // commit() dominate the link; a plain buffer flushed with one
+    // sequential write avoids that. The huge page arena hands out
+    // fresh mmap'ed (zeroed) slabs for anything of at least slab
+    // size, which the zero-fill assumptions in the section writers
+    // rely on; only a small image can land in a recycled slab tail,
+    // so clear that case explicitly.
+    BufferStart = reinterpret_cast<uint8_t *>(BAlloc.Allocate(FileSize, 4096));
+    if (FileSize < HugePageSize)
+      memset(BufferStart, 0, FileSize);
+    return;
+  }
+
   ErrorOr<std::unique_ptr<FileOutputBuffer>> BufferOrErr =
       FileOutputBuffer::create(Config->OutputFile, FileSize,
                                FileOutputBuffer::F_executable);
 
-  if (auto EC = BufferOrErr.getError())
+  if (auto EC = BufferOrErr.getError()) {
     error(EC, "failed to open " + Config->OutputFile);
-  else
-    Buffer = std::move(*BufferOrErr);
+    return;
+  }
+  Buffer = std::move(*BufferOrErr);
+  BufferStart = Buffer->getBufferStart();
+}
+
+// Flush the composed image to disk. The mmap engine just commits the
+// file mapping. The in-memory engine writes the buffer out in a single
+// sequential pass; raw_fd_ostream issues it as maximally sized write(2)
+// calls, which is the streaming pattern slow-writeback filesystems
+// optimize for.
+template <class ELFT> void Writer<ELFT>::commitBuffer() {
+  if (Config->StreamOutput) {
+    // The streaming thread has been writing finished ranges to stdout
+    // since the copy phase started; release the tail of the file (the
+    // section header table lives past the last section) and wait for
+    // it to drain. When the layout was not streamable the thread was
+    // never started and the whole image goes out here in one pass.
+    if (StreamThread.joinable()) {
+      finishStreaming();
+      return;
+    }
+    raw_fd_ostream OS(1 /*stdout*/, /*shouldClose=*/false);
+    OS.write(reinterpret_cast<char *>(BufferStart), FileSize);
+    OS.flush();
+    if (OS.has_error())
+      error(OS.error(), "failed to write to stdout");
+    return;
+  }
+
+  if (Buffer) {
+    if (auto EC = Buffer->commit())
+      error(EC, "failed to write to the output file");
+    return;
+  }
+
+  // If the composed image is byte-identical to what is already on
+  // disk, keep the old file (see openFile): no write bandwidth is
+  // spent and the unchanged mtime turns downstream rebuilds into
+  // no-ops too.
+  if (OldReader.joinable()) {
+    OldReader.join();
+    if (OldBuffer && (*OldBuffer)->getBufferSize() == FileSize &&
+        memcmp((*OldBuffer)->getBufferStart(), BufferStart, FileSize) == 0)
+      return;
+    // The old output differs, so it is stale. Unlink it before opening
+    // for write: rewriting the existing file in place fails with
+    // ETXTBSY when it is a running executable, and would mutate the
+    // old inode under any hard links to it. unlinkAsync needs the
+    // thread pool, so fall back to a plain remove without it.
+    if (Config->Threads)
+      unlinkAsync(Config->OutputFile);
+    else
+      sys::fs::remove(Config->OutputFile);
+  }
+
+  int FD;
+  if (auto EC = sys::fs::openFileForWrite(Config->OutputFile, FD,
+                                          sys::fs::F_None, 0775)) {
+    error(EC, "failed to open " + Config->OutputFile);
+    return;
+  }
+  raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  OS.write(reinterpret_cast<char *>(BufferStart), FileSize);
+  OS.close();
+  if (OS.has_error())
+    error(OS.error(), "failed to write to the output file");
 }
 
 template <class ELFT> void Writer<ELFT>::writeSectionsBinary() {
-  uint8_t *Buf = Buffer->getBufferStart();
+  uint8_t *Buf = BufferStart;
+
+  // Flatten the work of all output sections into one task list and
+  // drain it with a single parallel loop, the same way writeSections
+  // does; writing one output section at a time limits parallelism to
+  // the input sections of that single section.
+  std::vector<std::function<void()>> Tasks;
   for (OutputSectionBase *Sec : OutputSections)
     if (Sec->Flags & SHF_ALLOC)
-      Sec->writeTo(Buf + Sec->Offset);
+      Sec->writeTasks(Buf + Sec->Offset, Tasks);
+  {
+    ScopedDiagnosticBuffer DiagBuffer;
+    forEach(Tasks.begin(), Tasks.end(),
+            [](const std::function<void()> &Fn) { Fn(); });
+  }
+
+  // BYTE()-family linker script commands may overwrite section
+  // contents, so they run after all copy tasks have finished.
+  for (OutputSectionBase *Sec : OutputSections)
+    if ((Sec->Flags & SHF_ALLOC) &&
+        Sec->getKind() == OutputSectionBase::Regular)
+      Script<ELFT>::X->writeDataBytes(Sec->Name, Buf + Sec->Offset);
+}
+
+// Write a manifest of per-output-section content digests for
+// --section-digests. Build systems that content-address link outputs
+// section by section for artifact dedup and incremental upload would
+// otherwise re-read the finished binary; hashing here is nearly free
+// because the copy loops have just written the bytes and they are
+// still in cache. Each line is "<xxHash64> <size> <name>".
+template <class ELFT> void Writer<ELFT>::writeSectionDigests() {
+  if (Config->SectionDigestsFile.empty())
+    return;
+
+  std::vector<OutputSectionBase *> Secs;
+  for (OutputSectionBase *Sec : OutputSections)
+    if (Sec->Size && Sec->Type != SHT_NOBITS &&
+        (!Config->OFormatBinary || (Sec->Flags & SHF_ALLOC)))
+      Secs.push_back(Sec);
+
+  std::vector<uint64_t> Hashes(Secs.size());
+  forLoop(0, Secs.size(), [&](size_t I) {
+    Hashes[I] = xxHash64(
+        StringRef(reinterpret_cast<const char *>(BufferStart + Secs[I]->Offset),
+                  Secs[I]->Size));
+  });
+
+  std::error_code EC;
+  raw_fd_ostream OS(Config->SectionDigestsFile, EC, sys::fs::F_None);
+  if (EC) {
+    error("cannot open " + Config->SectionDigestsFile + ": " + EC.message());
+    return;
+  }
+  for (size_t I = 0, E = Secs.size(); I != E; ++I)
+    OS << format("%016llx %10llu ", (unsigned long long)Hashes[I],
+                 (unsigned long long)Secs[I]->Size)
+       << Secs[I]->Name << "\n";
 }
 
 // Write section contents to a mmap'ed file.
 template <class ELFT> void Writer<ELFT>::writeSections() {
-  uint8_t *Buf = Buffer->getBufferStart();
+  uint8_t *Buf = BufferStart;
+
+  // During the copy phase every input and the whole output are
+  // resident at once, which is the memory peak of the link. Count the
+  // copy tasks that will read each input file so that the task
+  // retiring a file's last section can return the file's pages to the
+  // OS (InputFile::sectionCopied). Only file-backed buffers are
+  // tracked: their dropped pages fault back in from the file if a
+  // later writer still touches them, for example the string table
+  // copying symbol names, or the .eh_frame writer. With --incremental
+  // the cache writer rehashes every input buffer after the link, which
+  // would fault everything straight back from disk, so buffers are
+  // kept resident in that mode.
+  if (!Config->Incremental) {
+    DenseMap<InputFile *, uint32_t> Pending;
+    for (OutputSectionBase *Sec : OutputSections) {
+      // Compressed sections are written from their deflated image, not
+      // by per-input-section copy tasks.
+      if (Sec->getKind() != OutputSectionBase::Regular ||
+          !Sec->CompressedData.empty())
+        continue;
+      for (InputSection<ELFT> *IS : cast<OutputSection<ELFT>>(Sec)->Sections) {
+        if (isa<SyntheticSection<ELFT>>(IS) || IS->Type == SHT_NOBITS ||
+            IS->Type == SHT_REL || IS->Type == SHT_RELA)
+          continue;
+        if (elf::ObjectFile<ELFT> *File = IS->getFile())
+          ++Pending[File];
+      }
+    }
+    for (std::pair<InputFile *const, uint32_t> &P : Pending)
+      if (isBufferFileBacked(P.first->MB))
+        P.first->PendingSections = P.second;
+  }
 
   // PPC64 needs to process relocations in the .opd section
   // before processing relocations in code-containing sections.
@@ -1662,9 +2346,51 @@ template <class ELFT> void Writer<ELFT>::writeSections() {
 
   OutputSectionBase *EhFrameHdr =
       In<ELFT>::EhFrameHdr ? In<ELFT>::EhFrameHdr->OutSec : nullptr;
+
+  // With --stream-output the image is piped out while it is still
+  // being composed. The build-id and BYTE()-family script commands
+  // patch the image after the copy phase, so those configurations
+  // compose fully here and stream everything at commit instead.
+  if (Config->StreamOutput && !ScriptConfig->HasSections &&
+      !(In<ELFT>::BuildId && In<ELFT>::BuildId->OutSec)) {
+    writeSectionsStreamed(EhFrameHdr);
+    return;
+  }
+
+  // All remaining sections can be copied to their final positions
+  // independently because the output file is mmap'ed. Writing one
+  // output section at a time limits parallelism to the input sections
+  // of that single section, so instead flatten the work of all output
+  // sections into one task list and drain it with a single parallel
+  // loop. This keeps all cores busy even when the output consists of
+  // many small sections.
+  std::vector<std::function<void()>> Tasks;
+
+  // The ELF header, program headers and the section header table
+  // occupy buffer regions disjoint from all section contents, so
+  // filling them in is just another task.
+  if (!Config->OFormatBinary)
+    Tasks.push_back([this] { writeHeader(); });
+
   for (OutputSectionBase *Sec : OutputSections)
     if (Sec != Out<ELFT>::Opd && Sec != EhFrameHdr)
-      Sec->writeTo(Buf + Sec->Offset);
+      Sec->writeTasks(Buf + Sec->Offset, Tasks);
+  {
+    // Relocation overflow checks can fire thousands of errors at once;
+    // buffer them per worker so the tasks don't serialize on the
+    // diagnostics lock.
+    ScopedDiagnosticBuffer DiagBuffer;
+    forEach(Tasks.begin(), Tasks.end(),
+            [](const std::function<void()> &Fn) { Fn(); });
+  }
+
+  // Linker scripts may have BYTE()-family commands with which you
+  // can write arbitrary bytes to the output. They have to run after
+  // the content copy above because they may overwrite section contents.
+  for (OutputSectionBase *Sec : OutputSections)
+    if (Sec->getKind() == OutputSectionBase::Regular && Sec != Out<ELFT>::Opd &&
+        Sec != EhFrameHdr)
+      Script<ELFT>::X->writeDataBytes(Sec->Name, Buf + Sec->Offset);
 
   // The .eh_frame_hdr depends on .eh_frame section contents, therefore
   // it should be written after .eh_frame is written.
@@ -1672,12 +2398,126 @@ template <class ELFT> void Writer<ELFT>::writeSections() {
     EhFrameHdr->writeTo(Buf + EhFrameHdr->Offset);
 }
 
+// --stream-output: write the image to stdout while it is still being
+// composed. The layout is fixed once file offsets are assigned, but
+// the parallel copy tasks finish in arbitrary order; to hand bytes to
+// the consumer strictly in order, the sections are partitioned by
+// file offset into a few waves, each wave is drained with the usual
+// parallel loop, and a background thread trails behind writing
+// everything below the completed watermark. Consuming wave N thus
+// overlaps composing wave N+1, and no intermediate file is created.
+template <class ELFT>
+void Writer<ELFT>::writeSectionsStreamed(OutputSectionBase *EhFrameHdr) {
+  uint8_t *Buf = BufferStart;
+
+  // The header touches both ends of the file (ELF and program headers
+  // at the start, the section header table at the end), and
+  // .eh_frame_hdr depends on .eh_frame contents; write those serially
+  // up front so every byte below a wave boundary is final once the
+  // wave's tasks have run. The tail past the last section is released
+  // by commitBuffer.
+  writeHeader();
+  OutputSectionBase *EhFrame = nullptr;
+  if (EhFrameHdr && !Out<ELFT>::EhFrame->empty()) {
+    EhFrame = Out<ELFT>::EhFrame;
+    EhFrame->writeTo(Buf + EhFrame->Offset);
+    EhFrameHdr->writeTo(Buf + EhFrameHdr->Offset);
+  }
+
+  // Everything else is independent. Order the sections by file offset
+  // and split them into waves of roughly equal bytes; padding between
+  // sections is untouched zero fill, so a wave boundary is a valid
+  // watermark.
+  std::vector<OutputSectionBase *> Secs;
+  for (OutputSectionBase *Sec : OutputSections)
+    if (Sec != Out<ELFT>::Opd && Sec != EhFrame && Sec != EhFrameHdr &&
+        Sec->Type != SHT_NOBITS)
+      Secs.push_back(Sec);
+  std::sort(Secs.begin(), Secs.end(),
+            [](OutputSectionBase *A, OutputSectionBase *B) {
+              return A->Offset < B->Offset;
+            });
+
+  uint64_t Total = 0;
+  for (OutputSectionBase *Sec : Secs)
+    Total += Sec->Size;
+
+  startStreaming();
+
+  const size_t NumWaves = 8;
+  uint64_t Quota = Total / NumWaves + 1;
+  size_t I = 0;
+  for (size_t Wave = 0; I != Secs.size(); ++Wave) {
+    std::vector<std::function<void()>> Tasks;
+    uint64_t Taken = 0;
+    uint64_t WaveEnd = 0;
+    while (I != Secs.size() && (Taken < Quota || Wave + 1 == NumWaves)) {
+      OutputSectionBase *Sec = Secs[I++];
+      Sec->writeTasks(Buf + Sec->Offset, Tasks);
+      Taken += Sec->Size;
+      WaveEnd = Sec->Offset + Sec->Size;
+    }
+    {
+      ScopedDiagnosticBuffer DiagBuffer;
+      forEach(Tasks.begin(), Tasks.end(),
+              [](const std::function<void()> &Fn) { Fn(); });
+    }
+    advanceStream(WaveEnd);
+  }
+}
+
+// Starts the --stream-output writer thread. It trails the copy phase,
+// writing bytes to stdout as the watermark passes them.
+template <class ELFT> void Writer<ELFT>::startStreaming() {
+  StreamThread = std::thread([this] {
+    raw_fd_ostream OS(1 /*stdout*/, /*shouldClose=*/false);
+    uint64_t Written = 0;
+    for (;;) {
+      uint64_t Target;
+      {
+        std::unique_lock<std::mutex> Lock(StreamMutex);
+        StreamCV.wait(
+            Lock, [&] { return StreamDone || StreamWatermark > Written; });
+        if (StreamWatermark == Written)
+          break;
+        Target = StreamWatermark;
+      }
+      OS.write(reinterpret_cast<char *>(BufferStart) + Written,
+               Target - Written);
+      Written = Target;
+    }
+    OS.flush();
+    if (OS.has_error())
+      error(OS.error(), "failed to write to stdout");
+  });
+}
+
+template <class ELFT> void Writer<ELFT>::advanceStream(uint64_t Offset) {
+  std::lock_guard<std::mutex> Lock(StreamMutex);
+  if (Offset <= StreamWatermark)
+    return;
+  StreamWatermark = Offset;
+  StreamCV.notify_one();
+}
+
+// Releases the rest of the file and waits for the writer thread to
+// drain it.
+template <class ELFT> void Writer<ELFT>::finishStreaming() {
+  {
+    std::lock_guard<std::mutex> Lock(StreamMutex);
+    StreamWatermark = FileSize;
+    StreamDone = true;
+  }
+  StreamCV.notify_one();
+  StreamThread.join();
+}
+
 template <class ELFT> void Writer<ELFT>::writeBuildId() {
   if (!In<ELFT>::BuildId || !In<ELFT>::BuildId->OutSec)
     return;
 
   // Compute a hash of all sections of the output file.
-  uint8_t *Start = Buffer->getBufferStart();
+  uint8_t *Start = BufferStart;
   uint8_t *End = Start + FileSize;
   In<ELFT>::BuildId->writeBuildId({Start, End});
 }
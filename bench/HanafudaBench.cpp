@@ -0,0 +1,225 @@
+//===- HanafudaBench.cpp --------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Benchmarks for the Hanafuda patch pipeline. Each one models a phase
+// of HanafudaDriver.cpp on a synthetic corpus generated from a fixed
+// seed: scanning a base DOL's text for relocatable instruction
+// patterns, ingesting a symbol map, applying call-site patches, and
+// diffing a patched image against its base for the delta output. A
+// recorded game image cannot be checked into the tree, so the base
+// DOL is a deterministic instruction soup with the same opcode mix
+// the scanner cares about.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::support::endian;
+
+// From LinkerBench.cpp.
+extern volatile uint64_t BenchSink;
+
+namespace {
+// Same fixed-seed generator as LinkerBench.cpp so corpora are
+// identical from run to run.
+class Rng {
+public:
+  uint64_t next() {
+    State = State * 6364136223846793005ULL + 1442695040888963407ULL;
+    return State >> 11;
+  }
+  uint64_t next(uint64_t N) { return next() % N; }
+
+private:
+  uint64_t State = 20161114;
+};
+}
+
+// Builds a DOL-sized text section of big-endian PPC words with
+// roughly the opcode mix of a real base image: mostly ALU filler,
+// with lis/addi+lwz ha/lo pairs and bl/ba branches sprinkled in the
+// way the scanner has to find them.
+static std::vector<uint8_t> makeDolText(size_t Words) {
+  Rng R;
+  std::vector<uint8_t> Buf(Words * 4);
+  for (size_t I = 0; I != Words; ++I) {
+    uint32_t Inst;
+    switch (R.next(16)) {
+    case 0: // lis rD, imm  (addis rD, 0, imm)
+      Inst = (15u << 26) | ((uint32_t)R.next(32) << 21) |
+             ((uint32_t)R.next(0x8050));
+      break;
+    case 1: // addi rD, rA, imm
+      Inst = (14u << 26) | ((uint32_t)R.next(32) << 21) |
+             ((uint32_t)R.next(32) << 16) | ((uint32_t)R.next(0x10000));
+      break;
+    case 2: // lwz rD, d(rA)
+      Inst = (32u << 26) | ((uint32_t)R.next(32) << 21) |
+             ((uint32_t)R.next(32) << 16) | ((uint32_t)R.next(0x10000));
+      break;
+    case 3: // bl target
+      Inst = (18u << 26) | (((uint32_t)R.next(Words) * 4) & 0x03fffffc) | 1;
+      break;
+    default: // or rA, rS, rB and friends; the scanner skips these
+      Inst = (31u << 26) | (uint32_t)R.next(1u << 26);
+      break;
+    }
+    write32be(&Buf[I * 4], Inst);
+  }
+  return Buf;
+}
+
+// Models DOLFile::scanForRelocations: decode every word of the base
+// text, track lis targets per register, and index every call site by
+// its target address the way the patcher looks them up later.
+void benchHanafudaDolScan() {
+  const size_t Words = 6 * 1024 * 1024; // A 24 MiB text segment.
+  std::vector<uint8_t> Text = makeDolText(Words);
+  const uint32_t BaseAddr = 0x80003100;
+
+  uint32_t LisImm[32] = {};
+  std::unordered_multimap<uint32_t, uint32_t> CallAddrToOff;
+  CallAddrToOff.reserve(Words / 16);
+  uint64_t Pairs = 0;
+  for (size_t Off = 0; Off + 4 <= Text.size(); Off += 4) {
+    uint32_t Inst = read32be(&Text[Off]);
+    uint32_t Opc = Inst >> 26;
+    if (Opc == 15 && ((Inst >> 16) & 31) == 0) {
+      // lis: remember the high half loaded into rD.
+      LisImm[(Inst >> 21) & 31] = Inst & 0xffff;
+    } else if (Opc == 14 || Opc == 32) {
+      // addi/lwz: a low half whose base register holds a lis result
+      // completes a ha/lo pair.
+      if (LisImm[(Inst >> 16) & 31])
+        ++Pairs;
+    } else if (Opc == 18) {
+      // b/bl: index the call site by its absolute target.
+      uint32_t Target = BaseAddr + (Inst & 0x03fffffc);
+      CallAddrToOff.insert({Target, (uint32_t)Off});
+    }
+  }
+  BenchSink = Pairs + CallAddrToOff.size();
+}
+
+// Models SymbolListFile ingestion: parse "<hex-address> <name>" lines
+// for a map with hundreds of thousands of entries.
+void benchHanafudaSymbolList() {
+  Rng R;
+  std::string Map;
+  const size_t Syms = 400 * 1000;
+  Map.reserve(Syms * 24);
+  for (size_t I = 0; I != Syms; ++I) {
+    char Addr[16];
+    snprintf(Addr, sizeof(Addr), "%08x ", (unsigned)(0x80000000 + I * 4));
+    Map += Addr;
+    for (int K = 0, E = 6 + (int)R.next(18); K != E; ++K)
+      Map += (char)('a' + R.next(26));
+    Map += '\n';
+  }
+
+  std::vector<std::pair<uint32_t, StringRef>> List;
+  List.reserve(Syms);
+  StringRef Rest(Map);
+  while (!Rest.empty()) {
+    StringRef Line;
+    std::tie(Line, Rest) = Rest.split('\n');
+    StringRef AddrStr, Name;
+    std::tie(AddrStr, Name) = Line.split(' ');
+    uint32_t Addr;
+    if (!AddrStr.getAsInteger(16, Addr) && !Name.empty())
+      List.emplace_back(Addr, Name);
+  }
+  BenchSink = List.size();
+}
+
+// Models patchTargetAddressRelocations: for each redirected symbol,
+// look up its call sites and rewrite the branch displacement of each
+// one in the base image.
+void benchHanafudaPatchApply() {
+  const size_t Words = 6 * 1024 * 1024;
+  std::vector<uint8_t> Text = makeDolText(Words);
+  const uint32_t BaseAddr = 0x80003100;
+
+  Rng R;
+  std::unordered_multimap<uint32_t, uint32_t> CallAddrToOff;
+  for (size_t Off = 0; Off + 4 <= Text.size(); Off += 4) {
+    uint32_t Inst = read32be(&Text[Off]);
+    if ((Inst >> 26) == 18)
+      CallAddrToOff.insert({BaseAddr + (Inst & 0x03fffffc), (uint32_t)Off});
+  }
+
+  // Redirect a few thousand targets, like a large mod.
+  uint64_t Sites = 0;
+  for (size_t I = 0; I != 8000; ++I) {
+    uint32_t Old = BaseAddr + ((uint32_t)R.next(Words) * 4 & 0x03fffffc);
+    uint32_t New = BaseAddr + ((uint32_t)R.next(Words) * 4 & 0x03fffffc);
+    auto Range = CallAddrToOff.equal_range(Old);
+    for (auto It = Range.first; It != Range.second; ++It) {
+      uint32_t Inst = read32be(&Text[It->second]);
+      int32_t Delta = (int32_t)(New - (BaseAddr + It->second));
+      write32be(&Text[It->second],
+                (Inst & 0xfc000003) | ((uint32_t)Delta & 0x03fffffc));
+      ++Sites;
+    }
+  }
+  BenchSink = Sites;
+}
+
+// Models the delta-patch span collection: compare a patched image
+// against its base and merge changed bytes into spans, bridging runs
+// of fewer than 16 equal bytes the way writeDeltaPatch does.
+void benchHanafudaDeltaDiff() {
+  Rng R;
+  const size_t Size = 24 * 1024 * 1024;
+  std::vector<uint8_t> Old(Size), New(Size);
+  for (size_t I = 0; I != Size; ++I)
+    Old[I] = New[I] = (uint8_t)R.next();
+  // Sparse edits: a few thousand short runs, like a relinked mod.
+  for (size_t I = 0; I != 4000; ++I) {
+    size_t Off = R.next(Size - 64);
+    for (size_t K = 0, E = 4 + R.next(48); K != E; ++K)
+      New[Off + K] ^= 0x5a;
+  }
+
+  std::vector<std::pair<uint32_t, uint32_t>> Spans;
+  size_t SpanBegin = 0;
+  size_t EqualRun = 0;
+  bool InSpan = false;
+  for (size_t I = 0; I != Size; ++I) {
+    if (Old[I] == New[I]) {
+      if (InSpan && ++EqualRun >= 16) {
+        Spans.emplace_back((uint32_t)SpanBegin,
+                           (uint32_t)(I + 1 - EqualRun - SpanBegin));
+        InSpan = false;
+      }
+      continue;
+    }
+    if (!InSpan) {
+      SpanBegin = I;
+      InSpan = true;
+    }
+    EqualRun = 0;
+  }
+  if (InSpan)
+    Spans.emplace_back((uint32_t)SpanBegin,
+                       (uint32_t)(Size - EqualRun - SpanBegin));
+  uint64_t Bytes = 0;
+  for (auto &S : Spans)
+    Bytes += S.second;
+  BenchSink = Spans.size() + Bytes;
+}
@@ -0,0 +1,224 @@
+//===- LinkerBench.cpp ----------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Microbenchmarks for the linker's hot data structures, run on fixed
+// synthetic corpora so numbers are comparable across revisions. Each
+// benchmark models the inner loop of a real pass: symbol table
+// insertion, merge-section string splitting, section content hashing
+// (as in ICF), glob matching and the parallel loop primitives.
+//
+// Usage: lld-bench [name-substring]
+//
+// Every benchmark runs several times and the best wall time is
+// reported; the corpora are generated from a fixed seed, so two runs
+// of the same binary do the same work.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ELF/Strings.h"
+#include "lld/Core/Parallel.h"
+#include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Consumes a value so the compiler cannot discard the benchmarked
+// loop. Shared with the other bench translation units.
+volatile uint64_t BenchSink;
+static volatile uint64_t &Sink = BenchSink;
+
+// Hanafuda patch-pipeline benchmarks (HanafudaBench.cpp).
+void benchHanafudaDolScan();
+void benchHanafudaSymbolList();
+void benchHanafudaPatchApply();
+void benchHanafudaDeltaDiff();
+
+// A fixed-seed generator so corpora are identical from run to run.
+namespace {
+class Rng {
+public:
+  uint64_t next() {
+    State = State * 6364136223846793005ULL + 1442695040888963407ULL;
+    return State >> 11;
+  }
+  uint64_t next(uint64_t N) { return next() % N; }
+
+private:
+  uint64_t State = 19750527;
+};
+}
+
+// Returns Count mangled-looking symbol names. Roughly one in eight is
+// a duplicate, like the multiply-defined inline functions a real link
+// resolves over and over.
+static std::vector<std::string> makeSymbolNames(size_t Count) {
+  Rng R;
+  std::vector<std::string> Names;
+  Names.reserve(Count);
+  for (size_t I = 0; I != Count; ++I) {
+    if (I > 16 && R.next(8) == 0) {
+      Names.push_back(Names[R.next(I)]);
+      continue;
+    }
+    std::string S = "_ZN";
+    for (int J = 0, E = 1 + (int)R.next(3); J != E; ++J) {
+      std::string Word;
+      for (int K = 0, F = 3 + (int)R.next(12); K != F; ++K)
+        Word += (char)('a' + R.next(26));
+      S += std::to_string(Word.size()) + Word;
+    }
+    S += "Ev";
+    Names.push_back(std::move(S));
+  }
+  return Names;
+}
+
+// Models SymbolTable::addByName: one hash insert per name with the
+// existing-entry branch taken for duplicates.
+static void benchSymbolTableInsert() {
+  std::vector<std::string> Names = makeSymbolNames(1000 * 1000);
+  DenseMap<CachedHashStringRef, uint64_t> Map;
+  Map.reserve(Names.size());
+  uint64_t Found = 0;
+  for (size_t I = 0, E = Names.size(); I != E; ++I) {
+    auto P = Map.insert({CachedHashStringRef(Names[I]), I});
+    if (!P.second)
+      Found += P.first->second;
+  }
+  Sink = Found + Map.size();
+}
+
+// Models MergeInputSection::splitStrings: carve a big buffer of
+// NUL-terminated strings into StringRef pieces.
+static void benchSplitStrings() {
+  Rng R;
+  std::string Buf;
+  Buf.reserve(64 * 1024 * 1024);
+  while (Buf.size() < 64 * 1024 * 1024) {
+    for (int K = 0, F = 1 + (int)R.next(40); K != F; ++K)
+      Buf += (char)('!' + R.next(90));
+    Buf += '\0';
+  }
+  StringRef Data(Buf);
+  uint64_t Pieces = 0;
+  uint64_t Bytes = 0;
+  while (!Data.empty()) {
+    size_t End = Data.find(0);
+    if (End == StringRef::npos)
+      break;
+    ++Pieces;
+    Bytes += End + 1;
+    Data = Data.substr(End + 1);
+  }
+  Sink = Pieces + Bytes;
+}
+
+// Models the ICF equivalence-class hash: hash_combine_range over
+// section-sized chunks of bytes.
+static void benchContentHash() {
+  Rng R;
+  std::vector<uint8_t> Buf(64 * 1024 * 1024);
+  for (uint8_t &B : Buf)
+    B = (uint8_t)R.next();
+  uint64_t H = 0;
+  for (size_t Off = 0; Off + 256 <= Buf.size(); Off += 256)
+    H += hash_combine_range(Buf.begin() + Off, Buf.begin() + Off + 256);
+  Sink = H;
+}
+
+// Models version-script and linker-script matching: a mixed
+// literal/wildcard StringMatcher against many section names.
+static void benchGlobMatch() {
+  Rng R;
+  std::vector<StringRef> Patterns = {".text.*", ".rodata.*", "*_impl",
+                                     ".data", ".bss", ".tdata",
+                                     "llvm*", "*::create", ".ctors"};
+  lld::elf::StringMatcher M(Patterns);
+  std::vector<std::string> Names;
+  for (size_t I = 0; I != 200 * 1000; ++I) {
+    std::string S = R.next(2) ? ".text." : ".rodata.";
+    for (int K = 0, F = 4 + (int)R.next(20); K != F; ++K)
+      S += (char)('a' + R.next(26));
+    Names.push_back(std::move(S));
+  }
+  uint64_t Hits = 0;
+  for (const std::string &S : Names)
+    if (M.match(S))
+      ++Hits;
+  Sink = Hits;
+}
+
+// Measures the parallel loop primitive itself against the same work
+// run serially, so scheduling-overhead regressions show up directly.
+static void benchParallelFor() {
+  const size_t N = 32 * 1024 * 1024;
+  std::vector<uint32_t> V(N);
+  lld::parallel_for((size_t)0, N, [&](size_t I) {
+    uint32_t X = (uint32_t)I;
+    X ^= X >> 16;
+    X *= 0x85ebca6b;
+    X ^= X >> 13;
+    V[I] = X;
+  });
+  uint64_t Total = 0;
+  for (uint32_t X : V)
+    Total += X;
+  Sink = Total;
+}
+
+namespace {
+struct Benchmark {
+  const char *Name;
+  std::function<void()> Fn;
+};
+}
+
+int main(int Argc, char **Argv) {
+  StringRef Filter = Argc > 1 ? Argv[1] : "";
+  Benchmark Benchmarks[] = {
+      {"symbol-table-insert", benchSymbolTableInsert},
+      {"split-strings", benchSplitStrings},
+      {"content-hash", benchContentHash},
+      {"glob-match", benchGlobMatch},
+      {"parallel-for", benchParallelFor},
+      {"hanafuda-dol-scan", benchHanafudaDolScan},
+      {"hanafuda-symbol-list", benchHanafudaSymbolList},
+      {"hanafuda-patch-apply", benchHanafudaPatchApply},
+      {"hanafuda-delta-diff", benchHanafudaDeltaDiff},
+  };
+
+  const int Reps = 5;
+  for (const Benchmark &B : Benchmarks) {
+    if (StringRef(B.Name).find(Filter) == StringRef::npos)
+      continue;
+    double BestMs = 1e100;
+    for (int I = 0; I != Reps; ++I) {
+      auto Start = std::chrono::steady_clock::now();
+      B.Fn();
+      auto End = std::chrono::steady_clock::now();
+      double Ms =
+          std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
+              End - Start)
+              .count();
+      if (Ms < BestMs)
+        BestMs = Ms;
+    }
+    outs() << format("%-24s %10.2f ms\n", B.Name, BestMs);
+  }
+  return 0;
+}
@@ -12,6 +12,7 @@
 
 #include "lld/Core/Instrumentation.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/TimeTrace.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/thread.h"
 
@@ -20,13 +21,52 @@
 #include <condition_variable>
 #include <mutex>
 #include <stack>
+#include <type_traits>
+#include <vector>
 
 #if defined(_MSC_VER) && LLVM_ENABLE_THREADS
 #include <concrt.h>
 #include <ppl.h>
 #endif
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace lld {
+/// \brief Number of threads the process-wide pool uses.
+///
+/// Zero (the default) means one thread per hardware core. A driver may
+/// set this (e.g. from --threads=N) before the first parallel call;
+/// once the pool has started the value is latched.
+inline unsigned &poolThreadCount() {
+  static unsigned count = 0;
+  return count;
+}
+
+/// \brief Whether pool worker threads are pinned to cores.
+///
+/// On multi-socket machines the scheduler migrating workers between
+/// nodes costs memory bandwidth: a worker that faulted in its chunk's
+/// pages on one node keeps paying remote accesses after moving to the
+/// other. Pinning keeps each worker on one core for the whole link.
+/// Only honored on Linux; elsewhere it is accepted and ignored.
+inline bool &poolPinThreads() {
+  static bool pin = false;
+  return pin;
+}
+
+/// \brief The worker count the pool and the parallel loops should use.
+inline unsigned poolConcurrency() {
+  unsigned count = poolThreadCount();
+  if (count == 0)
+    count = std::thread::hardware_concurrency();
+  if (count == 0)
+    count = 1;
+  return count;
+}
+
 /// \brief Allows one or more threads to wait on a potentially unknown number of
 ///   events.
 ///
@@ -115,18 +155,17 @@ inline Executor *getDefaultExecutor() {
 ///   in filo order.
 class ThreadPoolExecutor : public Executor {
 public:
-  explicit ThreadPoolExecutor(unsigned threadCount =
-                                  std::thread::hardware_concurrency())
+  explicit ThreadPoolExecutor(unsigned threadCount = poolConcurrency())
       : _stop(false), _done(threadCount) {
     // Spawn all but one of the threads in another thread as spawning threads
     // can take a while.
     std::thread([&, threadCount] {
       for (size_t i = 1; i < threadCount; ++i) {
         std::thread([=] {
-          work();
+          work(i);
         }).detach();
       }
-      work();
+      work(0);
     }).detach();
   }
 
@@ -146,7 +185,26 @@ public:
   }
 
 private:
-  void work() {
+  // Bind the calling worker to one core, round-robin by worker index.
+  // Consecutive indices land on consecutive CPU ids, which on the usual
+  // Linux enumeration spreads the workers evenly across sockets.
+  static void pinToCore(size_t index) {
+#if defined(__linux__)
+    unsigned numCpus = std::thread::hardware_concurrency();
+    if (numCpus == 0)
+      return;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(index % numCpus, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+    (void)index;
+#endif
+  }
+
+  void work(size_t index) {
+    if (poolPinThreads())
+      pinToCore(index);
     while (true) {
       std::unique_lock<std::mutex> lock(_mutex);
       _cond.wait(lock, [&] {
@@ -186,6 +244,9 @@ public:
   void spawn(std::function<void()> f) {
     _latch.inc();
     internal::getDefaultExecutor()->add([&, f] {
+      // One span per executed task so that --time-trace shows how the
+      // executor spread the work across its threads.
+      ScopedTraceSpan Span("task");
       f();
       _latch.dec();
     });
@@ -269,6 +330,96 @@ template <class T> void parallel_sort(T *start, T *end) {
   parallel_sort(start, end, std::less<T>());
 }
 
+/// \brief Stable parallel LSD radix sort. \p Key must map an element to
+/// an unsigned integer; elements end up in ascending key order.
+///
+/// Unlike parallel_sort, whose quicksort leaves a serial tail for every
+/// partition that falls under the depth cutoff, each digit pass here
+/// splits the range into one fixed block per worker for both the
+/// histogram and the stable scatter, so the work stays evenly spread
+/// regardless of how the keys are distributed. Use it when a cheap
+/// integer key exists; keep parallel_sort for comparator-only orders.
+template <class T, class KeyFn>
+void parallel_radix_sort(T *Start, T *End, KeyFn Key) {
+  typedef typename std::decay<decltype(Key(*Start))>::type KeyTy;
+  size_t Len = End - Start;
+
+  // Small inputs are not worth the scratch buffer or the passes.
+  if (Len < 1024) {
+    std::stable_sort(Start, End,
+                     [&](const T &A, const T &B) { return Key(A) < Key(B); });
+    return;
+  }
+
+  unsigned NumWorkers = poolConcurrency();
+  size_t BlockSize = (Len + NumWorkers - 1) / NumWorkers;
+  auto BlockEnd = [&](unsigned W) {
+    return std::min(Len, (W + 1) * BlockSize);
+  };
+
+  // The highest key decides how many 8-bit digit passes are needed.
+  std::vector<KeyTy> MaxOfBlock(NumWorkers, 0);
+  {
+    TaskGroup Tg;
+    for (unsigned W = 0; W != NumWorkers; ++W)
+      Tg.spawn([=, &MaxOfBlock] {
+        KeyTy Max = 0;
+        for (size_t I = W * BlockSize, E = BlockEnd(W); I < E; ++I)
+          Max = std::max(Max, (KeyTy)Key(Start[I]));
+        MaxOfBlock[W] = Max;
+      });
+  }
+  KeyTy MaxKey = 0;
+  for (KeyTy K : MaxOfBlock)
+    MaxKey = std::max(MaxKey, K);
+
+  std::vector<T> Scratch(Len);
+  T *From = Start;
+  T *To = Scratch.data();
+  std::vector<size_t> Hist(NumWorkers * 256);
+
+  for (unsigned Shift = 0; Shift < sizeof(KeyTy) * 8 && (MaxKey >> Shift);
+       Shift += 8) {
+    // Per-worker counts of this pass's digit.
+    {
+      TaskGroup Tg;
+      for (unsigned W = 0; W != NumWorkers; ++W)
+        Tg.spawn([=, &Hist] {
+          size_t *Counts = &Hist[W * 256];
+          std::fill(Counts, Counts + 256, 0);
+          for (size_t I = W * BlockSize, E = BlockEnd(W); I < E; ++I)
+            ++Counts[(Key(From[I]) >> Shift) & 0xFF];
+        });
+    }
+
+    // An exclusive prefix sum in digit-major, worker-minor order gives
+    // each worker its start position per digit and keeps the scatter
+    // stable.
+    size_t Pos = 0;
+    for (unsigned Digit = 0; Digit != 256; ++Digit)
+      for (unsigned W = 0; W != NumWorkers; ++W) {
+        size_t C = Hist[W * 256 + Digit];
+        Hist[W * 256 + Digit] = Pos;
+        Pos += C;
+      }
+
+    {
+      TaskGroup Tg;
+      for (unsigned W = 0; W != NumWorkers; ++W)
+        Tg.spawn([=, &Hist] {
+          size_t *Offsets = &Hist[W * 256];
+          for (size_t I = W * BlockSize, E = BlockEnd(W); I < E; ++I)
+            To[Offsets[(Key(From[I]) >> Shift) & 0xFF]++] = From[I];
+        });
+    }
+    std::swap(From, To);
+  }
+
+  // An odd number of passes leaves the result in the scratch buffer.
+  if (From != Start)
+    std::copy(From, From + Len, Start);
+}
+
 #if !defined(LLVM_ENABLE_THREADS) || LLVM_ENABLE_THREADS == 0
 template <class IterTy, class FuncTy>
 void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
@@ -294,41 +445,65 @@ void parallel_for(IndexTy Begin, IndexTy End, FuncTy Fn) {
 #else
 template <class IterTy, class FuncTy>
 void parallel_for_each(IterTy Begin, IterTy End, FuncTy Fn) {
-  // TaskGroup has a relatively high overhead, so we want to reduce
-  // the number of spawn() calls. We'll create up to 1024 tasks here.
-  // (Note that 1024 is an arbitrary number. This code probably needs
-  // improving to take the number of available cores into account.)
-  ptrdiff_t TaskSize = std::distance(Begin, End) / 1024;
-  if (TaskSize == 0)
-    TaskSize = 1;
-
+  // Instead of statically splitting the range into one task per chunk
+  // up front, we spawn one long-lived task per core and let each of
+  // them repeatedly claim the next unprocessed chunk from a shared
+  // counter. With a static split, a single expensive element (such as
+  // one huge input section among thousands of small ones) leaves all
+  // but one core idle once the cheap tasks are drained; with dynamic
+  // claiming, the other cores keep pulling chunks until the whole
+  // range is done. This also reduces the number of spawn() calls,
+  // which have a relatively high overhead.
+  ptrdiff_t Len = std::distance(Begin, End);
+  ptrdiff_t ChunkSize = Len / 1024;
+  if (ChunkSize == 0)
+    ChunkSize = 1;
+
+  unsigned NumWorkers = poolConcurrency();
+
+  std::atomic<ptrdiff_t> Next(0);
   TaskGroup Tg;
-  while (TaskSize <= std::distance(Begin, End)) {
-    Tg.spawn([=, &Fn] { std::for_each(Begin, Begin + TaskSize, Fn); });
-    Begin += TaskSize;
-  }
-  Tg.spawn([=, &Fn] { std::for_each(Begin, End, Fn); });
+  for (unsigned I = 0; I != NumWorkers; ++I)
+    Tg.spawn([=, &Fn, &Next] {
+      for (;;) {
+        ptrdiff_t Idx = Next.fetch_add(ChunkSize);
+        if (Idx >= Len)
+          break;
+        // A span per claimed chunk makes a straggler chunk stand out
+        // in the --time-trace timeline instead of hiding in the
+        // aggregate pass time.
+        ScopedTraceSpan Span("chunk");
+        std::for_each(Begin + Idx, Begin + std::min(Idx + ChunkSize, Len), Fn);
+      }
+    });
 }
 
 template <class IndexTy, class FuncTy>
 void parallel_for(IndexTy Begin, IndexTy End, FuncTy Fn) {
-  ptrdiff_t TaskSize = (End - Begin) / 1024;
-  if (TaskSize == 0)
-    TaskSize = 1;
+  // See parallel_for_each above: one worker task per core, each
+  // claiming chunks dynamically so that expensive iterations don't
+  // serialize the tail of the loop.
+  ptrdiff_t Len = End - Begin;
+  ptrdiff_t ChunkSize = Len / 1024;
+  if (ChunkSize == 0)
+    ChunkSize = 1;
 
+  unsigned NumWorkers = poolConcurrency();
+
+  std::atomic<ptrdiff_t> Next(0);
   TaskGroup Tg;
-  IndexTy I = Begin;
-  for (; I < End; I += TaskSize) {
-    Tg.spawn([=, &Fn] {
-      for (IndexTy J = I, E = I + TaskSize; J != E; ++J)
-        Fn(J);
+  for (unsigned I = 0; I != NumWorkers; ++I)
+    Tg.spawn([=, &Fn, &Next] {
+      for (;;) {
+        ptrdiff_t Idx = Next.fetch_add(ChunkSize);
+        if (Idx >= Len)
+          break;
+        ScopedTraceSpan Span("chunk");
+        for (IndexTy J = Begin + Idx, E = Begin + std::min(Idx + ChunkSize, Len);
+             J != E; ++J)
+          Fn(J);
+      }
     });
-    Begin += TaskSize;
-  }
-  Tg.spawn([=, &Fn] {
-    for (IndexTy J = I; J < End; ++J)
-      Fn(J);
-  });
 }
 #endif
 } // end namespace lld
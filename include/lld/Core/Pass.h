@@ -33,6 +33,49 @@ public:
   /// Do the actual work of the Pass.
   virtual llvm::Error perform(SimpleFile &mergedFile) = 0;
 
+  /// Coarse resources of the merged file's atom graph, used to declare
+  /// pass footprints. A reference resource covers the reference fields
+  /// (kind and target), any decision derived from them, and the
+  /// references carried by atoms the pass itself synthesizes.
+  enum ResourceSet : uint32_t {
+    resourceNone = 0,
+    resourceBranchReferences = 1, ///< call and branch references
+    resourceGOTReferences = 2,    ///< GOT-access references
+    resourceTLVReferences = 4,    ///< thread-local access references
+    resourceUnwindInfo = 8,       ///< unwind atoms and their references
+    resourceAll = ~0u
+  };
+
+  /// A pass whose work is a read-only sweep over the atom graph
+  /// followed by a batch of graph edits may split perform() into
+  /// sweep() and commit(). sweep() may only read the resources
+  /// declared by reads() and record what to do (creating new atoms in
+  /// pass-local storage is fine); commit() performs the recorded
+  /// reference rewrites, which must stay within writes(), and adds the
+  /// created atoms to the merged file. PassManager runs the sweeps of
+  /// consecutive splittable passes concurrently when no declared read
+  /// depends on an earlier pass's writes; commits always run serially
+  /// in pass order, so the result is identical to a sequential run.
+  /// perform() of a splittable pass must be equivalent to sweep()
+  /// followed by commit().
+  virtual bool isSplittable() const { return false; }
+
+  /// Resources sweep() reads. Only meaningful for splittable passes.
+  virtual uint32_t reads() const { return resourceAll; }
+
+  /// Resources commit() writes. Only meaningful for splittable passes.
+  virtual uint32_t writes() const { return resourceAll; }
+
+  /// The read-only half of a splittable pass.
+  virtual llvm::Error sweep(SimpleFile &mergedFile) {
+    return llvm::Error::success();
+  }
+
+  /// The mutating half of a splittable pass.
+  virtual llvm::Error commit(SimpleFile &mergedFile) {
+    return llvm::Error::success();
+  }
+
 protected:
   // Only subclassess can be instantiated.
   Pass() = default;
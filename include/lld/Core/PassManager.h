@@ -14,6 +14,8 @@
 #include "lld/Core/Pass.h"
 #include "llvm/Support/Error.h"
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace lld {
@@ -22,10 +24,10 @@ class Pass;
 
 /// \brief Owns and runs a collection of passes.
 ///
-/// This class is currently just a container for passes and a way to run them.
-///
-/// In the future this should handle timing pass runs, running parallel passes,
-/// and validate/satisfy pass dependencies.
+/// Passes run in the order they were added, but consecutive passes
+/// that implement the sweep/commit protocol (see Pass.h) and whose
+/// declared read/write sets do not conflict get their graph sweeps
+/// overlapped, with the commits then applied serially in pass order.
 class PassManager {
 public:
   void add(std::unique_ptr<Pass> pass) {
@@ -33,9 +35,54 @@ public:
   }
 
   llvm::Error runOnFile(SimpleFile &file) {
-    for (std::unique_ptr<Pass> &pass : _passes)
-      if (llvm::Error EC = pass->perform(file))
-        return EC;
+    for (size_t i = 0, e = _passes.size(); i != e;) {
+      // Collect the longest run of consecutive splittable passes in
+      // which no pass reads a resource an earlier pass writes; such a
+      // sweep would observe edits that a sequential run would have
+      // applied before it started.
+      size_t j = i;
+      uint32_t written = 0;
+      while (j != e && _passes[j]->isSplittable() &&
+             !(written & _passes[j]->reads())) {
+        written |= _passes[j]->writes();
+        ++j;
+      }
+      if (j - i < 2) {
+        if (llvm::Error EC = _passes[i]->perform(file))
+          return EC;
+        ++i;
+        continue;
+      }
+
+      // Overlap the read-only sweeps, then commit serially in pass
+      // order so the output is the same as a sequential run. Each
+      // extra sweep gets its own thread rather than a pool task:
+      // sweeps may shard their scan with parallel_for, and the pool
+      // does not steal work, so a nested parallel loop inside a pool
+      // task would park its worker and can deadlock small pools.
+      // Results are folded into one accumulator under a mutex; a
+      // moved-from Error counts as checked, so the joins never trip
+      // the unchecked-error assertion.
+      std::mutex errMutex;
+      llvm::Error err = llvm::Error::success();
+      auto runSweep = [&](size_t k) {
+        llvm::Error e2 = _passes[k]->sweep(file);
+        std::lock_guard<std::mutex> lock(errMutex);
+        err = llvm::joinErrors(std::move(err), std::move(e2));
+      };
+      std::vector<std::thread> threads;
+      for (size_t k = i + 1; k != j; ++k)
+        threads.emplace_back([&runSweep, k] { runSweep(k); });
+      runSweep(i);
+      for (std::thread &t : threads)
+        t.join();
+      if (err)
+        return err;
+      for (size_t k = i; k != j; ++k)
+        if (llvm::Error EC = _passes[k]->commit(file))
+          return EC;
+      i = j;
+    }
     return llvm::Error::success();
   }
 
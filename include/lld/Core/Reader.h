@@ -12,11 +12,13 @@
 
 #include "lld/Core/LLVM.h"
 #include "lld/Core/Reference.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <memory>
+#include <mutex>
 #include <vector>
 
 using llvm::sys::fs::file_magic;
@@ -111,6 +113,7 @@ public:
   // as parameters to the addSupport*() method.
   void addSupportArchives(bool logLoading);
   void addSupportYamlFiles();
+  void addSupportBinarySnapshots();
   void addSupportMachOObjects(MachOLinkingContext &);
 
   /// To convert between kind values and names, the registry walks the list
@@ -140,6 +143,14 @@ private:
   std::vector<std::unique_ptr<Reader>>                       _readers;
   std::vector<std::unique_ptr<YamlIOTaggedDocumentHandler>>  _yamlHandlers;
   std::vector<KindEntry>                                     _kindEntries;
+
+  // Remembers which Reader last accepted each file magic, so runs with
+  // many same-kind inputs skip straight to the right Reader.  canParse()
+  // is still consulted (a Reader may reject based on buffer contents),
+  // so this is purely a dispatch hint.  Guarded by _readerCacheMutex
+  // since loadFile() may be called from multiple threads.
+  mutable llvm::DenseMap<unsigned, const Reader *> _readerForMagic;
+  mutable std::mutex _readerCacheMutex;
 };
 
 // Utilities for building a KindString table.  For instance:
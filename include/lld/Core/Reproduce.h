@@ -15,6 +15,10 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Error.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace llvm {
 
@@ -41,14 +45,28 @@ namespace lld {
 class CpioFile {
 public:
   static ErrorOr<CpioFile *> create(StringRef OutputPath);
+  ~CpioFile();
   void append(StringRef Path, StringRef Data);
 
 private:
   CpioFile(std::unique_ptr<llvm::raw_fd_ostream> OS, StringRef Basename);
+  void writerLoop();
 
   std::unique_ptr<llvm::raw_fd_ostream> OS;
   llvm::StringSet<> Seen;
   std::string Basename;
+
+  // Members are written to disk by a background thread so that copying
+  // inputs into the archive stays off the link's critical path.  The
+  // queue is bounded by byte size; append() blocks once too much data
+  // is in flight. The destructor drains the queue before returning.
+  std::deque<std::pair<std::string, std::string>> Queue;
+  size_t QueueBytes = 0;
+  bool Done = false;
+  std::mutex Mutex;
+  std::condition_variable Produced;
+  std::condition_variable Consumed;
+  std::thread Writer;
 };
 
 // Makes a given pathname an absolute path first, and then remove
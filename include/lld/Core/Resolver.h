@@ -15,6 +15,7 @@
 #include "lld/Core/SharedLibraryFile.h"
 #include "lld/Core/Simple.h"
 #include "lld/Core/SymbolTable.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/ErrorOr.h"
@@ -69,7 +70,11 @@ private:
   void removeCoalescedAwayAtoms();
   llvm::Expected<bool> forEachUndefines(File &file, UndefCallback callback);
 
-  void markLive(const Atom *atom);
+  void markLive(llvm::ArrayRef<const Atom *> roots);
+
+  /// \brief Drop resolved entries from _undefines and remap the saved
+  /// per-file start positions, so later scans only visit live symbols.
+  void compactUndefines();
 
   class MergedFile : public SimpleFile {
   public:
@@ -93,6 +98,11 @@ private:
   // List of undefined symbols.
   std::vector<StringRef> _undefines;
 
+  // Number of entries in _undefines that have been resolved and
+  // cleared. Once these dominate the vector it is compacted, so
+  // repeated archive scans do not degrade to rescanning tombstones.
+  size_t _undefineTombstones = 0;
+
   // Start position in _undefines for each archive/shared library file.
   // Symbols from index 0 to the start position are already searched before.
   // Searching them again would never succeed. When we look for undefined
@@ -0,0 +1,142 @@
+//===- lld/Core/TimeTrace.h - Chrome trace-event recording ------*- C++ -*-===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Lightweight recording of per-thread time spans for --time-trace.
+//
+// Aggregate pass timers show how long a parallel pass took, but not
+// why: when one straggler chunk serializes the tail of a loop, the
+// total looks merely "slow". Here every span carries the id of the
+// thread that ran it, so the dump can be opened in chrome://tracing
+// (or any trace-event viewer) and imbalance between workers is
+// directly visible on the timeline.
+//
+// Spans are buffered in thread-local vectors; the hot path takes no
+// lock except on a thread's first span. The parallel loops in
+// lld/Core/Parallel.h record one span per claimed chunk and one per
+// spawned task, and the drivers' pass timers provide the main-thread
+// spans that frame them.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLD_CORE_TIMETRACE_H
+#define LLD_CORE_TIMETRACE_H
+
+#include "lld/Core/LLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace lld {
+
+/// \brief Whether span recording is active. A driver sets this (from
+/// --time-trace) before the first parallel pass.
+inline bool &timeTraceEnabled() {
+  static bool Enabled = false;
+  return Enabled;
+}
+
+// Classes in this namespace are implementation details of this header.
+namespace internal {
+
+struct TraceEvent {
+  StringRef Name;
+  uint64_t StartUs;
+  uint64_t DurUs;
+};
+
+struct TraceBuffer {
+  unsigned Tid;
+  std::vector<TraceEvent> Events;
+};
+
+inline std::mutex &traceMutex() {
+  static std::mutex Mu;
+  return Mu;
+}
+
+inline std::vector<TraceBuffer *> &traceBuffers() {
+  static std::vector<TraceBuffer *> Buffers;
+  return Buffers;
+}
+
+/// \brief Microseconds since the first call in the process. All spans
+/// share this epoch, so cross-thread alignment in the viewer is exact.
+inline uint64_t traceNow() {
+  static std::chrono::steady_clock::time_point T0 =
+      std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - T0)
+      .count();
+}
+
+/// \brief The calling thread's span buffer, registered process-wide on
+/// first use. Buffers are intentionally leaked: pool workers outlive
+/// the report and there is no point tearing this down in a process
+/// that is about to exit.
+inline TraceBuffer &localTraceBuffer() {
+  static thread_local TraceBuffer *Buf = [] {
+    auto *B = new TraceBuffer;
+    std::lock_guard<std::mutex> Lock(traceMutex());
+    B->Tid = traceBuffers().size();
+    traceBuffers().push_back(B);
+    return B;
+  }();
+  return *Buf;
+}
+
+} // namespace internal
+
+/// \brief Records the wall time between construction and destruction
+/// as a span on the calling thread's timeline. No-op when recording is
+/// not active. The name must outlive the link (a string literal or
+/// saved string).
+class ScopedTraceSpan {
+public:
+  explicit ScopedTraceSpan(StringRef Name) : Name(Name) {
+    if (timeTraceEnabled())
+      StartUs = internal::traceNow();
+  }
+
+  ~ScopedTraceSpan() {
+    if (!timeTraceEnabled())
+      return;
+    uint64_t End = internal::traceNow();
+    internal::localTraceBuffer().Events.push_back(
+        {Name, StartUs, End - StartUs});
+  }
+
+private:
+  StringRef Name;
+  uint64_t StartUs = 0;
+};
+
+/// \brief Writes all recorded spans as one Chrome trace-event JSON
+/// object. Must be called after the last parallel pass has completed,
+/// when no worker is appending spans.
+inline void writeTimeTrace(llvm::raw_ostream &OS) {
+  std::lock_guard<std::mutex> Lock(internal::traceMutex());
+  OS << "{\"traceEvents\":[";
+  bool First = true;
+  for (internal::TraceBuffer *Buf : internal::traceBuffers()) {
+    for (const internal::TraceEvent &E : Buf->Events) {
+      if (!First)
+        OS << ",";
+      First = false;
+      OS << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << Buf->Tid
+         << ",\"ts\":" << E.StartUs << ",\"dur\":" << E.DurUs << ",\"name\":\""
+         << E.Name << "\"}";
+    }
+  }
+  OS << "]}\n";
+}
+
+} // end namespace lld
+
+#endif // LLD_CORE_TIMETRACE_H
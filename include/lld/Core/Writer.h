@@ -42,6 +42,7 @@ protected:
 
 std::unique_ptr<Writer> createWriterMachO(const MachOLinkingContext &);
 std::unique_ptr<Writer> createWriterYAML(const LinkingContext &);
+std::unique_ptr<Writer> createWriterBinary(const LinkingContext &);
 } // end namespace lld
 
 #endif
@@ -211,6 +211,13 @@ public:
   /// Like pathExists() but only used on files - not directories.
   bool fileExists(StringRef path) const;
 
+  /// Like fileExists(), but answered from a per-invocation listing of the
+  /// file's parent directory instead of a stat per candidate. Library and
+  /// framework search probes many name variants per search directory, so
+  /// reading each directory once saves thousands of syscalls on links with
+  /// long search paths (and on network filesystems, round-trips).
+  bool probeFileExists(StringRef path) const;
+
   /// \brief Adds any library search paths derived from the given base, possibly
   /// modified by -syslibroots.
   ///
@@ -368,6 +375,13 @@ public:
   // if a fat binary.
   ErrorOr<std::unique_ptr<MemoryBuffer>> getMemoryBuffer(StringRef path);
 
+  // Same, for a buffer that was already opened for path. The filelist
+  // prefetch opens entries in parallel ahead of the parse cursor and
+  // hands them in here, so dependency tracking and fat slicing still
+  // happen in command line order on one thread.
+  ErrorOr<std::unique_ptr<MemoryBuffer>>
+  getMemoryBuffer(StringRef path, std::unique_ptr<MemoryBuffer> mb);
+
   /// Used to find indirect dylibs. Instantiates a MachODylibFile if one
   /// has not already been made for the requested dylib.  Uses -L and -F
   /// search paths to allow indirect dylibs to be overridden.
@@ -416,6 +430,10 @@ public:
   bool customAtomOrderer(const DefinedAtom *left, const DefinedAtom *right,
                          bool &leftBeforeRight) const;
 
+  /// True if any -order_file entries were seen, i.e. customAtomOrderer()
+  /// can ever return anything but false.
+  bool hasOrderFileEntries() const { return _orderFileEntries != 0; }
+
   /// Return the 'flat namespace' file. This is the file that supplies
   /// atoms for otherwise undefined symbols when the -flat_namespace or
   /// -undefined dynamic_lookup options are used.
@@ -489,6 +507,9 @@ private:
   mutable std::unique_ptr<Writer> _writer;
   std::vector<SectionAlign> _sectAligns;
   mutable llvm::StringMap<mach_o::MachODylibFile*> _pathToDylibMap;
+  // Cache of directory listings backing probeFileExists(). A directory
+  // that doesn't exist or can't be read is cached as an empty listing.
+  mutable llvm::StringMap<llvm::StringSet<>> _dirListingCache;
   mutable std::vector<mach_o::MachODylibFile*> _allDylibs;
   mutable std::set<mach_o::MachODylibFile*> _upwardDylibs;
   mutable std::vector<std::unique_ptr<File>> _indirectDylibs;
@@ -35,6 +35,10 @@ struct YamlContext {
   File *_file = nullptr;
   NormalizedFile *_normalizeMachOFile = nullptr;
   StringRef _path;
+  /// Contents of the memory buffer being parsed, if the buffer outlives the
+  /// produced File.  Readers may return slices of it instead of copying
+  /// strings into per-file storage.
+  StringRef _backingStorage;
 };
 
 } // end namespace lld
@@ -23,21 +23,48 @@
 #define LLD_MEMORY_H
 
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/StringSaver.h"
 #include <vector>
 
 namespace lld {
 
+// Size of a transparent huge page on the architectures we care about.
+enum : size_t { HugePageSize = 2 * 1024 * 1024 };
+
+// A slab allocator that hands out 2 MB mappings the kernel can promote
+// to transparent huge pages. A big link keeps gigabytes of symbols and
+// section pieces in the arena and walks them repeatedly in the
+// resolution and merge passes; with 4 KB pages those walks are largely
+// dTLB misses. Small requests still go through malloc. On non-Linux
+// hosts this degrades to plain malloc.
+class HugePageAllocator : public llvm::AllocatorBase<HugePageAllocator> {
+public:
+  LLVM_ATTRIBUTE_RETURNS_NONNULL void *Allocate(size_t Size,
+                                                size_t Alignment);
+  using AllocatorBase<HugePageAllocator>::Allocate;
+
+  void Deallocate(const void *Ptr, size_t Size);
+  using AllocatorBase<HugePageAllocator>::Deallocate;
+};
+
+typedef llvm::BumpPtrAllocatorImpl<HugePageAllocator, HugePageSize>
+    HugePageArena;
+
 // Use this arena if your object doesn't have a destructor.
-extern llvm::BumpPtrAllocator BAlloc;
+extern HugePageArena BAlloc;
 extern llvm::StringSaver Saver;
 
 // These two classes are hack to keep track of all
 // SpecificBumpPtrAllocator instances.
 struct SpecificAllocBase {
-  SpecificAllocBase();
   virtual ~SpecificAllocBase() = default;
   virtual void reset() = 0;
+
+  // Registers an allocator so that freeArena() can find it. This is
+  // the only operation that touches state shared between threads.
+  static void add(SpecificAllocBase *Alloc);
+
   static std::vector<SpecificAllocBase *> Instances;
 };
 
@@ -48,11 +75,41 @@ template <class T> struct SpecificAlloc : public SpecificAllocBase {
 
 // Use this arena if your object has a destructor.
 // Your destructor will be invoked from freeArena().
+//
+// Each thread allocates from its own arena, so make<T> can be called
+// from parallel passes without a global lock. A thread's arena is
+// registered in the global list on first use (the only synchronized
+// step, taken once per type and thread), and all arenas are freed
+// together by freeArena(). The arena object itself is intentionally
+// never destroyed: pool worker threads outlive the passes that
+// allocate from them, and the objects they handed out live until
+// freeArena() anyway.
 template <typename T, typename... U> inline T *make(U &&... Args) {
-  static SpecificAlloc<T> Alloc;
-  return new (Alloc.Alloc.Allocate()) T(std::forward<U>(Args)...);
+  static LLVM_THREAD_LOCAL SpecificAlloc<T> *Alloc = nullptr;
+  if (!Alloc) {
+    Alloc = new SpecificAlloc<T>();
+    SpecificAllocBase::add(Alloc);
+  }
+  return new (Alloc->Alloc.Allocate()) T(std::forward<U>(Args)...);
 }
 
+// Per-epoch allocation statistics, reset by resetArenas().
+struct ArenaStats {
+  size_t BytesAllocated; // Bytes handed out from slabs this epoch.
+  size_t SlabsMapped;    // Slabs obtained with fresh mappings.
+  size_t SlabsReused;    // Slabs satisfied from the retained cache.
+};
+
+// Ends the current arena epoch: runs destructors, rewinds all arenas
+// and starts a new epoch. Unlike freeArena(), slab mappings are
+// retained in a cache and handed back out by subsequent allocations,
+// so a process that links repeatedly keeps its high-water slab
+// capacity and does not re-fault pages on every link.
+void resetArenas();
+
+// Returns the statistics for the current epoch.
+ArenaStats getArenaStats();
+
 void freeArena();
 }
 
@@ -35,10 +35,27 @@ Registry::loadFile(std::unique_ptr<MemoryBuffer> mb) const {
   StringRef content(mb->getBufferStart(), mb->getBufferSize());
   llvm::sys::fs::file_magic fileType = llvm::sys::fs::identify_magic(content);
 
+  // Try the reader that last accepted this magic before scanning the
+  // registration list; command lines are dominated by runs of same-kind
+  // inputs.
+  const Reader *hint = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(_readerCacheMutex);
+    auto pos = _readerForMagic.find((unsigned)fileType);
+    if (pos != _readerForMagic.end())
+      hint = pos->second;
+  }
+  if (hint && hint->canParse(fileType, mb->getMemBufferRef()))
+    return hint->loadFile(std::move(mb), *this);
+
   // Ask each registered reader if it can handle this file type or extension.
   for (const std::unique_ptr<Reader> &reader : _readers) {
     if (!reader->canParse(fileType, mb->getMemBufferRef()))
       continue;
+    {
+      std::lock_guard<std::mutex> lock(_readerCacheMutex);
+      _readerForMagic[(unsigned)fileType] = reader.get();
+    }
     return reader->loadFile(std::move(mb), *this);
   }
 
@@ -21,7 +21,18 @@ using namespace llvm;
 using namespace sys;
 
 CpioFile::CpioFile(std::unique_ptr<raw_fd_ostream> OS, StringRef S)
-    : OS(std::move(OS)), Basename(S) {}
+    : OS(std::move(OS)), Basename(S) {
+  Writer = std::thread([this] { writerLoop(); });
+}
+
+CpioFile::~CpioFile() {
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Done = true;
+  }
+  Produced.notify_all();
+  Writer.join();
+}
 
 ErrorOr<CpioFile *> CpioFile::create(StringRef OutputPath) {
   std::string Path = (OutputPath + ".cpio").str();
@@ -50,6 +61,11 @@ static void writeMember(raw_fd_ostream &OS, StringRef Path, StringRef Data) {
   OS << Data;                            // c_filedata
 }
 
+// Upper bound on the bytes held by not-yet-written members. Past this,
+// append() blocks until the writer thread catches up, so enabling
+// --reproduce cannot buffer an entire link's inputs in memory.
+static const size_t MaxQueuedBytes = 32 * 1024 * 1024;
+
 void CpioFile::append(StringRef Path, StringRef Data) {
   if (!Seen.insert(Path).second)
     return;
@@ -60,13 +76,36 @@ void CpioFile::append(StringRef Path, StringRef Data) {
   SmallString<128> Fullpath;
   path::append(Fullpath, Basename, Path);
 
-  writeMember(*OS, convertToUnixPathSeparator(Fullpath), Data);
+  // Hand the member to the writer thread. Data is copied because the
+  // caller's buffer may be freed before the background write happens.
+  std::unique_lock<std::mutex> Lock(Mutex);
+  Consumed.wait(Lock, [&] { return QueueBytes < MaxQueuedBytes; });
+  QueueBytes += Data.size();
+  Queue.emplace_back(convertToUnixPathSeparator(Fullpath), Data.str());
+  Lock.unlock();
+  Produced.notify_one();
+}
 
-  // Print the trailer and seek back.
-  // This way we have a valid archive if we crash.
-  uint64_t Pos = OS->tell();
-  writeMember(*OS, "TRAILER!!!", "");
-  OS->seek(Pos);
+void CpioFile::writerLoop() {
+  for (;;) {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    Produced.wait(Lock, [&] { return Done || !Queue.empty(); });
+    if (Queue.empty())
+      return;
+    std::pair<std::string, std::string> Member = std::move(Queue.front());
+    Queue.pop_front();
+    QueueBytes -= Member.second.size();
+    Lock.unlock();
+    Consumed.notify_one();
+
+    writeMember(*OS, Member.first, Member.second);
+
+    // Print the trailer and seek back.
+    // This way we have a valid archive if we crash.
+    uint64_t Pos = OS->tell();
+    writeMember(*OS, "TRAILER!!!", "");
+    OS->seek(Pos);
+  }
 }
 
 // Makes a given pathname an absolute path first, and then remove
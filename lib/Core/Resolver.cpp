@@ -13,6 +13,7 @@
 #include "lld/Core/Instrumentation.h"
 #include "lld/Core/LLVM.h"
 #include "lld/Core/LinkingContext.h"
+#include "lld/Core/Parallel.h"
 #include "lld/Core/Resolver.h"
 #include "lld/Core/SharedLibraryFile.h"
 #include "lld/Core/SymbolTable.h"
@@ -25,6 +26,8 @@
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -47,8 +50,36 @@ llvm::Expected<bool> Resolver::handleFile(File &file) {
   return undefAdded;
 }
 
+// Drop entries that have been cleared because the symbol got resolved.
+// Each file's start position is remapped to the compacted indices, and
+// the relative order of live entries is preserved, so archive member
+// selection is unaffected. Without this, every archive visit rescans
+// the tombstones of all previously resolved symbols, which becomes
+// quadratic on links with many undefines.
+void Resolver::compactUndefines() {
+  if (_undefineTombstones < 64 ||
+      _undefineTombstones * 2 < _undefines.size())
+    return;
+
+  // newIndex[i] is the number of live entries before position i.
+  std::vector<size_t> newIndex(_undefines.size() + 1);
+  size_t n = 0;
+  for (size_t i = 0, e = _undefines.size(); i != e; ++i) {
+    newIndex[i] = n;
+    if (!_undefines[i].empty())
+      _undefines[n++] = _undefines[i];
+  }
+  newIndex[_undefines.size()] = n;
+  _undefines.resize(n);
+
+  for (auto &it : _undefineIndex)
+    it.second = newIndex[it.second];
+  _undefineTombstones = 0;
+}
+
 llvm::Expected<bool> Resolver::forEachUndefines(File &file,
                                                 UndefCallback callback) {
+  compactUndefines();
   size_t i = _undefineIndex[&file];
   bool undefAdded = false;
   do {
@@ -60,6 +91,7 @@ llvm::Expected<bool> Resolver::forEachUndefines(File &file,
       if (!isa<UndefinedAtom>(atom) || _symbolTable.isCoalescedAway(atom)) {
         // The symbol was resolved by some other file. Cache the result.
         _undefines[i] = "";
+        ++_undefineTombstones;
         continue;
       }
       auto undefAddedOrError = callback(undefName);
@@ -216,10 +248,38 @@ bool Resolver::resolveUndefines() {
   ScopedTask task(getDefaultDomain(), "resolveUndefines");
   int index = 0;
   std::set<File *> seen;
+
+  // Parse input files in the background ahead of the resolution
+  // cursor. File::parse is locked and idempotent, so the resolver can
+  // touch a file whose prefetch is still in flight, and group
+  // iteration never resubmits a file because the high-water mark only
+  // moves forward. The window is bounded to keep memory in check on
+  // links with thousands of inputs.
+  std::vector<std::unique_ptr<Node>> &inputs = _ctx.getNodes();
+  const size_t parseAheadWindow = 8;
+  size_t parseAhead = 0;
+  TaskGroup parseGroup;
+  auto prefetch = [&](size_t upTo) {
+    upTo = std::min(upTo, inputs.size());
+    for (; parseAhead < upTo; ++parseAhead)
+      if (FileNode *node = dyn_cast<FileNode>(inputs[parseAhead].get())) {
+        File *f = node->getFile();
+        parseGroup.spawn([f] { f->parse(); });
+      }
+  };
+
+  // The task group must drain before its captures go out of scope,
+  // whichever way this function returns.
+  struct SyncOnExit {
+    TaskGroup &group;
+    ~SyncOnExit() { group.sync(); }
+  } sync{parseGroup};
+
   for (;;) {
     bool undefAdded = false;
     DEBUG_WITH_TYPE("resolver",
                     llvm::dbgs() << "Loading file #" << index << "\n");
+    prefetch((size_t)index + parseAheadWindow);
     File *file = getFile(index);
     if (!file)
       return true;
@@ -316,22 +376,78 @@ void Resolver::updateReferences() {
   }
 }
 
-// For dead code stripping, recursively mark atoms "live"
-void Resolver::markLive(const Atom *atom) {
-  // Mark the atom is live. If it's already marked live, then stop recursion.
-  auto exists = _liveAtoms.insert(atom);
-  if (!exists.second)
-    return;
-
-  // Mark all atoms it references as live
-  if (const DefinedAtom *defAtom = dyn_cast<DefinedAtom>(atom)) {
-    for (const Reference *ref : *defAtom)
-      markLive(ref->target());
-    for (auto &p : llvm::make_range(_reverseRef.equal_range(defAtom))) {
-      const Atom *target = p.second;
-      markLive(target);
+// For dead code stripping, mark all atoms reachable from the given
+// roots "live". The traversal is a breadth-first search: each round
+// expands the current frontier in parallel, with membership tested and
+// set through a sharded visited set so two workers reaching the same
+// atom agree on which of them queues it. The result is a set, so it is
+// identical to what the old recursive walk computed regardless of the
+// order in which workers visit atoms.
+void Resolver::markLive(llvm::ArrayRef<const Atom *> roots) {
+  enum : size_t { Shards = 64 };
+  std::mutex shardMutex[Shards];
+  llvm::DenseSet<const Atom *> visited[Shards];
+  auto tryMark = [&](const Atom *atom) -> bool {
+    size_t shard =
+        llvm::DenseMapInfo<const Atom *>::getHashValue(atom) % Shards;
+    std::lock_guard<std::mutex> lock(shardMutex[shard]);
+    return visited[shard].insert(atom).second;
+  };
+
+  // Mark the atoms the frontier slice references (forward edges and
+  // backref edges from the reverse map, which is read-only here) and
+  // collect the newly marked ones for the next round.
+  auto expand = [&](const Atom *const *begin, const Atom *const *end,
+                    std::vector<const Atom *> &out) {
+    for (const Atom *const *it = begin; it != end; ++it) {
+      const DefinedAtom *defAtom = dyn_cast<DefinedAtom>(*it);
+      if (!defAtom)
+        continue;
+      for (const Reference *ref : *defAtom)
+        if (tryMark(ref->target()))
+          out.push_back(ref->target());
+      for (auto &p : llvm::make_range(_reverseRef.equal_range(defAtom)))
+        if (tryMark(p.second))
+          out.push_back(p.second);
     }
+  };
+
+  std::vector<const Atom *> frontier;
+  for (const Atom *root : roots)
+    if (tryMark(root))
+      frontier.push_back(root);
+
+  size_t numWorkers =
+      std::max<size_t>(1, std::thread::hardware_concurrency());
+  while (!frontier.empty()) {
+    std::vector<std::vector<const Atom *>> next(numWorkers);
+    // Small frontiers are not worth fanning out.
+    if (numWorkers == 1 || frontier.size() < 1024) {
+      expand(frontier.data(), frontier.data() + frontier.size(), next[0]);
+    } else {
+      TaskGroup tg;
+      size_t chunk = (frontier.size() + numWorkers - 1) / numWorkers;
+      for (size_t w = 0; w != numWorkers; ++w) {
+        size_t begin = w * chunk;
+        size_t end = std::min(begin + chunk, frontier.size());
+        if (begin >= end)
+          break;
+        tg.spawn([&, begin, end, w] {
+          expand(frontier.data() + begin, frontier.data() + end, next[w]);
+        });
+      }
+      tg.sync();
+    }
+    frontier.clear();
+    for (std::vector<const Atom *> &v : next)
+      frontier.insert(frontier.end(), v.begin(), v.end());
   }
+
+  // Fold the shards into _liveAtoms for the membership queries the
+  // erase below and checkUndefines() make.
+  for (llvm::DenseSet<const Atom *> &shard : visited)
+    for (const Atom *atom : shard)
+      _liveAtoms.insert(atom);
 }
 
 static bool isBackref(const Reference *ref) {
@@ -351,16 +467,41 @@ void Resolver::deadStripOptimize() {
 
   // Some type of references prevent referring atoms to be dead-striped.
   // Make a reverse map of such references before traversing the graph.
-  // While traversing the list of atoms, mark AbsoluteAtoms as live
-  // in order to avoid reclaim.
-  for (const OwningAtomPtr<Atom> &atom : _atoms) {
-    if (const DefinedAtom *defAtom = dyn_cast<DefinedAtom>(atom.get()))
-      for (const Reference *ref : *defAtom)
-        if (isBackref(ref))
-          _reverseRef.insert(std::make_pair(ref->target(), atom.get()));
-    if (const AbsoluteAtom *absAtom = dyn_cast<AbsoluteAtom>(atom.get()))
-      markLive(absAtom);
+  // The scan over every atom's references is the expensive half, so it
+  // runs in parallel slices collecting per-worker edge lists; the map
+  // itself is filled serially from those lists. AbsoluteAtoms are
+  // seeded as roots to avoid reclaiming them.
+  std::vector<const Atom *> roots;
+  {
+    size_t numWorkers =
+        std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<std::vector<std::pair<const Atom *, const Atom *>>> backrefs(
+        numWorkers);
+    TaskGroup tg;
+    size_t chunk = (_atoms.size() + numWorkers - 1) / numWorkers;
+    for (size_t w = 0; w != numWorkers; ++w) {
+      size_t begin = w * chunk;
+      size_t end = std::min(begin + chunk, _atoms.size());
+      if (begin >= end)
+        break;
+      tg.spawn([&, begin, end, w] {
+        for (size_t i = begin; i != end; ++i)
+          if (const DefinedAtom *defAtom =
+                  dyn_cast<DefinedAtom>(_atoms[i].get()))
+            for (const Reference *ref : *defAtom)
+              if (isBackref(ref))
+                backrefs[w].push_back(
+                    std::make_pair(ref->target(), _atoms[i].get()));
+      });
+    }
+    tg.sync();
+    for (std::vector<std::pair<const Atom *, const Atom *>> &v : backrefs)
+      for (std::pair<const Atom *, const Atom *> &p : v)
+        _reverseRef.insert(p);
   }
+  for (const OwningAtomPtr<Atom> &atom : _atoms)
+    if (const AbsoluteAtom *absAtom = dyn_cast<AbsoluteAtom>(atom.get()))
+      roots.push_back(absAtom);
 
   // By default, shared libraries are built with all globals as dead strip roots
   if (_ctx.globalsAreDeadStripRoots())
@@ -376,9 +517,9 @@ void Resolver::deadStripOptimize() {
     _deadStripRoots.insert(symAtom);
   }
 
-  // mark all roots as live, and recursively all atoms they reference
-  for (const Atom *dsrAtom : _deadStripRoots)
-    markLive(dsrAtom);
+  // mark all roots as live, and transitively all atoms they reference
+  roots.insert(roots.end(), _deadStripRoots.begin(), _deadStripRoots.end());
+  markLive(roots);
 
   // now remove all non-live atoms from _atoms
   _atoms.erase(std::remove_if(_atoms.begin(), _atoms.end(),
@@ -115,12 +115,15 @@ static MergeResolution mergeSelect(DefinedAtom::Merge first,
 bool SymbolTable::addByName(const Atom &newAtom) {
   StringRef name = newAtom.name();
   assert(!name.empty());
-  const Atom *existing = findByName(name);
-  if (existing == nullptr) {
+  // Probe the name table once: either the name is new and this insert
+  // claims it, or we get the holding entry back for the collision logic
+  // below.  This halves the string hashing on the common paths.
+  auto ins = _nameTable.insert(std::make_pair(name, &newAtom));
+  if (ins.second) {
     // Name is not in symbol table yet, add it associate with this atom.
-    _nameTable[name] = &newAtom;
     return true;
   }
+  const Atom *existing = ins.first->second;
 
   // Do nothing if the same object is added more than once.
   if (existing == &newAtom)
@@ -200,8 +203,8 @@ bool SymbolTable::addByName(const Atom &newAtom) {
   }
 
   if (useNew) {
-    // Update name table to use new atom.
-    _nameTable[name] = &newAtom;
+    // Update name table to use new atom, reusing the entry found above.
+    ins.first->second = &newAtom;
     // Add existing atom to replacement table.
     _replacedAtoms[existing] = &newAtom;
   } else {
@@ -264,12 +267,21 @@ const Atom *SymbolTable::findByName(StringRef sym) {
 const Atom *SymbolTable::replacement(const Atom *atom) {
   // Find the replacement for a given atom. Atoms in _replacedAtoms
   // may be chained, so find the last one.
+  const Atom *last = atom;
   for (;;) {
-    AtomToAtom::iterator pos = _replacedAtoms.find(atom);
+    AtomToAtom::iterator pos = _replacedAtoms.find(last);
     if (pos == _replacedAtoms.end())
-      return atom;
+      break;
+    last = pos->second;
+  }
+  // Point every atom on the walked chain directly at the final
+  // replacement, so repeated queries resolve in a single lookup.
+  while (atom != last) {
+    AtomToAtom::iterator pos = _replacedAtoms.find(atom);
     atom = pos->second;
+    pos->second = last;
   }
+  return last;
 }
 
 bool SymbolTable::isCoalescedAway(const Atom *atom) {
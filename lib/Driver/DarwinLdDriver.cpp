@@ -19,6 +19,7 @@
 #include "lld/Core/Instrumentation.h"
 #include "lld/Core/LLVM.h"
 #include "lld/Core/Node.h"
+#include "lld/Core/Parallel.h"
 #include "lld/Core/PassManager.h"
 #include "lld/Core/Resolver.h"
 #include "lld/Core/SharedLibraryFile.h"
@@ -110,11 +111,14 @@ parseMemberFiles(std::unique_ptr<File> file) {
 
 std::vector<std::unique_ptr<File>>
 loadFile(MachOLinkingContext &ctx, StringRef path,
-         raw_ostream &diag, bool wholeArchive, bool upwardDylib) {
+         raw_ostream &diag, bool wholeArchive, bool upwardDylib,
+         std::unique_ptr<MemoryBuffer> prefetched = nullptr) {
   if (ctx.logInputFiles())
     diag << path << "\n";
 
-  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr = ctx.getMemoryBuffer(path);
+  ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
+      prefetched ? ctx.getMemoryBuffer(path, std::move(prefetched))
+                 : ctx.getMemoryBuffer(path);
   if (std::error_code ec = mbOrErr.getError())
     return makeErrorFile(path, ec);
   ErrorOr<std::unique_ptr<File>> fileOrErr =
@@ -154,9 +158,11 @@ static std::string canonicalizePath(StringRef path) {
 
 static void addFile(StringRef path, MachOLinkingContext &ctx,
                     bool loadWholeArchive,
-                    bool upwardDylib, raw_ostream &diag) {
+                    bool upwardDylib, raw_ostream &diag,
+                    std::unique_ptr<MemoryBuffer> prefetched = nullptr) {
   std::vector<std::unique_ptr<File>> files =
-      loadFile(ctx, path, diag, loadWholeArchive, upwardDylib);
+      loadFile(ctx, path, diag, loadWholeArchive, upwardDylib,
+               std::move(prefetched));
   for (std::unique_ptr<File> &file : files)
     ctx.getNodes().push_back(llvm::make_unique<FileNode>(std::move(file)));
 }
@@ -263,22 +269,48 @@ static llvm::Error loadFileList(StringRef fileListPath,
   if (std::error_code ec = mb.getError())
     return llvm::errorCodeToError(ec);
   StringRef buffer = mb->get()->getBuffer();
+
+  // Slice the mapped buffer into entries without copying the lines;
+  // paths are copied only to outlive the buffer (and to prepend <dir>).
+  std::vector<StringRef> paths;
   while (!buffer.empty()) {
     // Split off each line in the file.
     std::pair<StringRef, StringRef> lineAndRest = buffer.split('\n');
     StringRef line = lineAndRest.first;
-    StringRef path;
     if (!dirName.empty()) {
       // If there is a <dir> then prepend dir to each line.
       SmallString<256> fullPath;
       fullPath.assign(dirName);
       llvm::sys::path::append(fullPath, Twine(line));
-      path = ctx.copy(fullPath.str());
+      paths.push_back(ctx.copy(fullPath.str()));
     } else {
       // No <dir> use whole line as input file path.
-      path = ctx.copy(line);
+      paths.push_back(ctx.copy(line));
+    }
+    buffer = lineAndRest.second;
+  }
+
+  // Stat and open all entries in parallel ahead of the parse cursor.
+  // Xcode-generated filelists carry thousands of entries, and issuing
+  // the syscalls one at a time serializes the link prologue on I/O
+  // latency. The buffers are handed to the in-order loop below, so
+  // diagnostics, dependency tracking and node order are unchanged.
+  // (In file-usage test mode files are never opened from disk.)
+  std::vector<char> exists(paths.size());
+  std::vector<std::unique_ptr<MemoryBuffer>> buffers(paths.size());
+  parallel_for((size_t)0, paths.size(), [&](size_t i) {
+    exists[i] = ctx.pathExists(paths[i]);
+    if (exists[i] && !ctx.testingFileUsage()) {
+      ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
+          MemoryBuffer::getFileOrSTDIN(paths[i]);
+      if (!mbOrErr.getError())
+        buffers[i] = std::move(mbOrErr.get());
     }
-    if (!ctx.pathExists(path)) {
+  });
+
+  for (size_t i = 0, e = paths.size(); i != e; ++i) {
+    StringRef path = paths[i];
+    if (!exists[i]) {
       return llvm::make_error<GenericError>(Twine("File not found '")
                                             + path
                                             + "'");
@@ -286,8 +318,7 @@ static llvm::Error loadFileList(StringRef fileListPath,
     if (ctx.testingFileUsage()) {
       diagnostics << "Found filelist entry " << canonicalizePath(path) << '\n';
     }
-    addFile(path, ctx, forceLoad, false, diagnostics);
-    buffer = lineAndRest.second;
+    addFile(path, ctx, forceLoad, false, diagnostics, std::move(buffers[i]));
   }
   return llvm::Error::success();
 }
@@ -594,6 +625,7 @@ bool parse(llvm::ArrayRef<const char *> args, MachOLinkingContext &ctx,
     ctx.registry().addSupportMachOObjects(ctx);
     ctx.registry().addSupportArchives(ctx.logInputFiles());
     ctx.registry().addSupportYamlFiles();
+    ctx.registry().addSupportBinarySnapshots();
   }
 
   // Now construct the set of library search directories, following ld64's
@@ -1177,9 +1209,19 @@ bool link(llvm::ArrayRef<const char *> args, raw_ostream &diagnostics) {
   if (ctx.getNodes().empty())
     return false;
 
-  for (std::unique_ptr<Node> &ie : ctx.getNodes())
-    if (FileNode *node = dyn_cast<FileNode>(ie.get()))
-      node->getFile()->parse();
+  // Parse all input files in parallel; File::parse is locked and
+  // idempotent. For -g inputs the per-file front-end work (including
+  // the DWARF compile-unit walk) dominates, and each file's parse is
+  // independent of the others.
+  {
+    TaskGroup tg;
+    for (std::unique_ptr<Node> &ie : ctx.getNodes())
+      if (FileNode *node = dyn_cast<FileNode>(ie.get())) {
+        File *f = node->getFile();
+        tg.spawn([f] { f->parse(); });
+      }
+    tg.sync();
+  }
 
   createFiles(ctx, false /* Implicit */);
 
@@ -0,0 +1,651 @@
+//===- lib/ReaderWriter/Binary/ReaderWriterBinary.cpp ---------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A binary snapshot format for atom graphs.
+//
+// The YAML representation is convenient for hand-written test cases but
+// far too slow to use as a link-stage cache. This format stores the same
+// graph as flat little-endian tables: a header, one fixed-size record
+// per atom, one record per reference, a deduplicated string pool and a
+// raw content pool. Reading is allocation-light: atoms are thin proxy
+// objects whose accessors read their record in the (possibly mmap'ed)
+// buffer in place, and names and content are referenced in the buffer
+// rather than copied. References name their targets by a global atom
+// index, which makes them resolvable in one pass once all atoms exist.
+//
+// The format is versioned; readers reject files whose version they do
+// not know. It is a snapshot format, not an interchange format: there
+// is no cross-endian or cross-version compatibility promise beyond the
+// version check.
+//
+//===----------------------------------------------------------------------===//
+
+#include "lld/Core/AbsoluteAtom.h"
+#include "lld/Core/DefinedAtom.h"
+#include "lld/Core/Error.h"
+#include "lld/Core/File.h"
+#include "lld/Core/Reader.h"
+#include "lld/Core/Reference.h"
+#include "lld/Core/SharedLibraryAtom.h"
+#include "lld/Core/UndefinedAtom.h"
+#include "lld/Core/Writer.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileOutputBuffer.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using llvm::support::ulittle16_t;
+using llvm::support::ulittle32_t;
+using llvm::support::ulittle64_t;
+using llvm::support::little64_t;
+
+namespace lld {
+namespace binary {
+
+// The file starts with this magic so the Registry can sniff snapshots
+// without relying on a file extension.
+static const char Magic[4] = {'L', 'L', 'D', 'S'};
+static const uint32_t Version = 1;
+
+struct FileHeader {
+  char     magic[4];
+  ulittle32_t version;
+  ulittle32_t pathString;      // string pool offset of File::path()
+  ulittle32_t stringsOffset;   // string pool (first byte is always '\0')
+  ulittle32_t stringsSize;
+  ulittle32_t contentOffset;   // raw atom content pool
+  ulittle32_t contentSize;
+  ulittle32_t definedOffset;
+  ulittle32_t definedCount;
+  ulittle32_t referencesOffset;
+  ulittle32_t referencesCount;
+  ulittle32_t undefinedOffset;
+  ulittle32_t undefinedCount;
+  ulittle32_t sharedLibOffset;
+  ulittle32_t sharedLibCount;
+  ulittle32_t absoluteOffset;
+  ulittle32_t absoluteCount;
+};
+
+// Reference targets use a global atom index: defined atoms first, then
+// undefined, shared library and absolute atoms, in table order.
+// ~0 means the reference has no target.
+static const uint32_t NoTarget = ~0U;
+
+struct DefinedAtomRecord {
+  ulittle32_t name;            // string pool offset
+  ulittle32_t customSectionName;
+  ulittle64_t ordinal;
+  ulittle64_t size;
+  ulittle64_t sectionSize;
+  ulittle32_t contentOffset;   // content pool offset
+  ulittle32_t contentSize;
+  ulittle32_t referenceStart;  // index into the reference table
+  ulittle32_t referenceCount;
+  ulittle16_t alignmentValue;
+  ulittle16_t alignmentModulus;
+  uint8_t scope;
+  uint8_t interposable;
+  uint8_t merge;
+  uint8_t contentType;
+  uint8_t sectionChoice;
+  uint8_t deadStrip;
+  uint8_t dynamicExport;
+  uint8_t codeModel;
+  uint8_t permissions;
+  uint8_t pad[3];
+};
+
+struct ReferenceRecord {
+  ulittle64_t offsetInAtom;
+  little64_t  addend;
+  ulittle32_t target;          // global atom index or NoTarget
+  ulittle16_t kindValue;
+  uint8_t kindNamespace;
+  uint8_t kindArch;
+};
+
+struct UndefinedAtomRecord {
+  ulittle32_t name;
+  uint8_t canBeNull;
+  uint8_t pad[3];
+};
+
+struct SharedLibraryAtomRecord {
+  ulittle32_t name;
+  ulittle32_t loadName;
+  ulittle64_t size;
+  uint8_t type;
+  uint8_t canBeNullAtRuntime;
+  uint8_t pad[6];
+};
+
+struct AbsoluteAtomRecord {
+  ulittle32_t name;
+  ulittle32_t pad;
+  ulittle64_t value;
+  uint8_t scope;
+  uint8_t pad2[7];
+};
+
+class BinaryFile;
+
+// References are materialized because setTarget()/setAddend() must be
+// able to mutate them after loading.
+class BinaryReference : public Reference {
+public:
+  BinaryReference(KindNamespace ns, KindArch arch, KindValue value,
+                  uint64_t offset, const Atom *target, Addend addend)
+      : Reference(ns, arch, value), _target(target), _offsetInAtom(offset),
+        _addend(addend) {}
+
+  uint64_t offsetInAtom() const override { return _offsetInAtom; }
+  const Atom *target() const override { return _target; }
+  Addend addend() const override { return _addend; }
+  void setAddend(Addend a) override { _addend = a; }
+  void setTarget(const Atom *a) override { _target = a; }
+
+private:
+  const Atom *_target;
+  uint64_t _offsetInAtom;
+  Addend _addend;
+};
+
+// Proxy atoms. Each holds a pointer to its fixed-size record and reads
+// attributes out of the buffer on demand.
+class BinaryDefinedAtom : public DefinedAtom {
+public:
+  BinaryDefinedAtom(const BinaryFile &f, const DefinedAtomRecord *rec)
+      : _file(f), _rec(rec) {}
+
+  const lld::File &file() const override;
+  StringRef name() const override;
+  uint64_t ordinal() const override { return _rec->ordinal; }
+  uint64_t size() const override { return _rec->size; }
+  uint64_t sectionSize() const override { return _rec->sectionSize; }
+  Scope scope() const override { return (Scope)_rec->scope; }
+  Interposable interposable() const override {
+    return (Interposable)_rec->interposable;
+  }
+  Merge merge() const override { return (Merge)_rec->merge; }
+  ContentType contentType() const override {
+    return (ContentType)_rec->contentType;
+  }
+  Alignment alignment() const override {
+    return Alignment(_rec->alignmentValue, _rec->alignmentModulus);
+  }
+  SectionChoice sectionChoice() const override {
+    return (SectionChoice)_rec->sectionChoice;
+  }
+  StringRef customSectionName() const override;
+  DeadStripKind deadStrip() const override {
+    return (DeadStripKind)_rec->deadStrip;
+  }
+  DynamicExport dynamicExport() const override {
+    return (DynamicExport)_rec->dynamicExport;
+  }
+  CodeModel codeModel() const override { return (CodeModel)_rec->codeModel; }
+  ContentPermissions permissions() const override {
+    return (ContentPermissions)_rec->permissions;
+  }
+  ArrayRef<uint8_t> rawContent() const override;
+
+  reference_iterator begin() const override;
+  reference_iterator end() const override;
+
+private:
+  const Reference *derefIterator(const void *it) const override {
+    return reinterpret_cast<const BinaryReference *>(it);
+  }
+  void incrementIterator(const void *&it) const override {
+    it = reinterpret_cast<const BinaryReference *>(it) + 1;
+  }
+
+  const BinaryFile &_file;
+  const DefinedAtomRecord *_rec;
+};
+
+class BinaryUndefinedAtom : public UndefinedAtom {
+public:
+  BinaryUndefinedAtom(const BinaryFile &f, const UndefinedAtomRecord *rec)
+      : _file(f), _rec(rec) {}
+
+  const lld::File &file() const override;
+  StringRef name() const override;
+  CanBeNull canBeNull() const override { return (CanBeNull)_rec->canBeNull; }
+
+private:
+  const BinaryFile &_file;
+  const UndefinedAtomRecord *_rec;
+};
+
+class BinarySharedLibraryAtom : public SharedLibraryAtom {
+public:
+  BinarySharedLibraryAtom(const BinaryFile &f,
+                          const SharedLibraryAtomRecord *rec)
+      : _file(f), _rec(rec) {}
+
+  const lld::File &file() const override;
+  StringRef name() const override;
+  StringRef loadName() const override;
+  bool canBeNullAtRuntime() const override { return _rec->canBeNullAtRuntime; }
+  Type type() const override { return (Type)uint32_t(_rec->type); }
+  uint64_t size() const override { return _rec->size; }
+
+private:
+  const BinaryFile &_file;
+  const SharedLibraryAtomRecord *_rec;
+};
+
+class BinaryAbsoluteAtom : public AbsoluteAtom {
+public:
+  BinaryAbsoluteAtom(const BinaryFile &f, const AbsoluteAtomRecord *rec)
+      : _file(f), _rec(rec) {}
+
+  const lld::File &file() const override;
+  StringRef name() const override;
+  uint64_t value() const override { return _rec->value; }
+  Scope scope() const override { return (Scope)_rec->scope; }
+
+private:
+  const BinaryFile &_file;
+  const AbsoluteAtomRecord *_rec;
+};
+
+class BinaryFile : public lld::File {
+public:
+  explicit BinaryFile(std::unique_ptr<MemoryBuffer> mb)
+      : File(mb->getBufferIdentifier(), kindNormalizedObject),
+        _mb(std::move(mb)) {}
+
+  const AtomRange<DefinedAtom> defined() const override { return _defined; }
+  const AtomRange<UndefinedAtom> undefined() const override {
+    return _undefined;
+  }
+  const AtomRange<SharedLibraryAtom> sharedLibrary() const override {
+    return _sharedLibrary;
+  }
+  const AtomRange<AbsoluteAtom> absolute() const override { return _absolute; }
+
+  void clearAtoms() override {
+    _defined.clear();
+    _undefined.clear();
+    _sharedLibrary.clear();
+    _absolute.clear();
+  }
+
+  StringRef string(uint32_t offset) const {
+    assert(offset < _header->stringsSize && "corrupt string offset");
+    return StringRef(_strings + offset);
+  }
+
+  ArrayRef<uint8_t> content(uint32_t offset, uint32_t size) const {
+    return ArrayRef<uint8_t>(_content + offset, size);
+  }
+
+  const BinaryReference *referenceBegin(const DefinedAtomRecord *rec) const {
+    return &_references[rec->referenceStart];
+  }
+  const BinaryReference *referenceEnd(const DefinedAtomRecord *rec) const {
+    return &_references[rec->referenceStart] + rec->referenceCount;
+  }
+
+protected:
+  std::error_code doParse() override;
+
+private:
+  template <typename RecT>
+  std::error_code table(uint32_t offset, uint32_t count, const RecT *&out) {
+    uint64_t end = uint64_t(offset) + uint64_t(count) * sizeof(RecT);
+    if (end > _mb->getBufferSize())
+      return make_error_code(llvm::errc::executable_format_error);
+    out = reinterpret_cast<const RecT *>(_mb->getBufferStart() + offset);
+    return std::error_code();
+  }
+
+  const Atom *atomByIndex(uint32_t index) const;
+
+  std::unique_ptr<MemoryBuffer> _mb;
+  const FileHeader *_header = nullptr;
+  const char *_strings = nullptr;
+  const uint8_t *_content = nullptr;
+  std::vector<BinaryReference> _references;
+  AtomVector<DefinedAtom> _defined;
+  AtomVector<UndefinedAtom> _undefined;
+  AtomVector<SharedLibraryAtom> _sharedLibrary;
+  AtomVector<AbsoluteAtom> _absolute;
+};
+
+const lld::File &BinaryDefinedAtom::file() const { return _file; }
+StringRef BinaryDefinedAtom::name() const { return _file.string(_rec->name); }
+StringRef BinaryDefinedAtom::customSectionName() const {
+  return _file.string(_rec->customSectionName);
+}
+ArrayRef<uint8_t> BinaryDefinedAtom::rawContent() const {
+  return _file.content(_rec->contentOffset, _rec->contentSize);
+}
+DefinedAtom::reference_iterator BinaryDefinedAtom::begin() const {
+  return reference_iterator(*this, _file.referenceBegin(_rec));
+}
+DefinedAtom::reference_iterator BinaryDefinedAtom::end() const {
+  return reference_iterator(*this, _file.referenceEnd(_rec));
+}
+
+const lld::File &BinaryUndefinedAtom::file() const { return _file; }
+StringRef BinaryUndefinedAtom::name() const {
+  return _file.string(_rec->name);
+}
+
+const lld::File &BinarySharedLibraryAtom::file() const { return _file; }
+StringRef BinarySharedLibraryAtom::name() const {
+  return _file.string(_rec->name);
+}
+StringRef BinarySharedLibraryAtom::loadName() const {
+  return _file.string(_rec->loadName);
+}
+
+const lld::File &BinaryAbsoluteAtom::file() const { return _file; }
+StringRef BinaryAbsoluteAtom::name() const { return _file.string(_rec->name); }
+
+const Atom *BinaryFile::atomByIndex(uint32_t index) const {
+  if (index < _defined.size())
+    return _defined[index].get();
+  index -= _defined.size();
+  if (index < _undefined.size())
+    return _undefined[index].get();
+  index -= _undefined.size();
+  if (index < _sharedLibrary.size())
+    return _sharedLibrary[index].get();
+  index -= _sharedLibrary.size();
+  if (index < _absolute.size())
+    return _absolute[index].get();
+  return nullptr;
+}
+
+std::error_code BinaryFile::doParse() {
+  auto err = make_error_code(llvm::errc::executable_format_error);
+  if (_mb->getBufferSize() < sizeof(FileHeader))
+    return err;
+  _header = reinterpret_cast<const FileHeader *>(_mb->getBufferStart());
+  if (memcmp(_header->magic, Magic, sizeof(Magic)) != 0 ||
+      _header->version != Version)
+    return err;
+
+  const char *strings;
+  const uint8_t *content;
+  const DefinedAtomRecord *definedRecs;
+  const ReferenceRecord *refRecs;
+  const UndefinedAtomRecord *undefRecs;
+  const SharedLibraryAtomRecord *shlibRecs;
+  const AbsoluteAtomRecord *absRecs;
+  if (table(_header->stringsOffset, _header->stringsSize, strings) ||
+      table(_header->contentOffset, _header->contentSize, content) ||
+      table(_header->definedOffset, _header->definedCount, definedRecs) ||
+      table(_header->referencesOffset, _header->referencesCount, refRecs) ||
+      table(_header->undefinedOffset, _header->undefinedCount, undefRecs) ||
+      table(_header->sharedLibOffset, _header->sharedLibCount, shlibRecs) ||
+      table(_header->absoluteOffset, _header->absoluteCount, absRecs))
+    return err;
+  // The pool must be non-empty and end with a terminator so that
+  // string() cannot run off the buffer.
+  if (_header->stringsSize == 0 || strings[_header->stringsSize - 1] != '\0')
+    return err;
+  _strings = strings;
+  _content = content;
+
+  // Create atoms first so references can be resolved by index.
+  _defined.reserve(_header->definedCount);
+  for (uint32_t i = 0, e = _header->definedCount; i != e; ++i) {
+    const DefinedAtomRecord *rec = &definedRecs[i];
+    if (uint64_t(rec->contentOffset) + rec->contentSize >
+            _header->contentSize ||
+        uint64_t(rec->referenceStart) + rec->referenceCount >
+            _header->referencesCount)
+      return err;
+    _defined.push_back(new (allocator()) BinaryDefinedAtom(*this, rec));
+  }
+  _undefined.reserve(_header->undefinedCount);
+  for (uint32_t i = 0, e = _header->undefinedCount; i != e; ++i)
+    _undefined.push_back(new (allocator())
+                             BinaryUndefinedAtom(*this, &undefRecs[i]));
+  _sharedLibrary.reserve(_header->sharedLibCount);
+  for (uint32_t i = 0, e = _header->sharedLibCount; i != e; ++i)
+    _sharedLibrary.push_back(
+        new (allocator()) BinarySharedLibraryAtom(*this, &shlibRecs[i]));
+  _absolute.reserve(_header->absoluteCount);
+  for (uint32_t i = 0, e = _header->absoluteCount; i != e; ++i)
+    _absolute.push_back(new (allocator())
+                            BinaryAbsoluteAtom(*this, &absRecs[i]));
+
+  _references.reserve(_header->referencesCount);
+  for (uint32_t i = 0, e = _header->referencesCount; i != e; ++i) {
+    const ReferenceRecord &rec = refRecs[i];
+    const Atom *target = nullptr;
+    if (rec.target != NoTarget) {
+      target = atomByIndex(rec.target);
+      if (!target)
+        return err;
+    }
+    _references.emplace_back((Reference::KindNamespace)rec.kindNamespace,
+                             (Reference::KindArch)rec.kindArch,
+                             Reference::KindValue(rec.kindValue),
+                             rec.offsetInAtom, target, rec.addend);
+  }
+  return std::error_code();
+}
+
+namespace {
+
+struct Pools {
+  // Offset 0 is the empty string, so unset name fields read back empty.
+  std::string strings = std::string("\0", 1);
+  llvm::StringMap<uint32_t> stringIndex;
+  std::string content;
+
+  uint32_t addString(StringRef s) {
+    if (s.empty())
+      return 0;
+    auto it = stringIndex.insert(std::make_pair(s, 0));
+    if (it.second) {
+      it.first->second = strings.size();
+      strings.append(s.begin(), s.end());
+      strings.push_back('\0');
+    }
+    return it.first->second;
+  }
+
+  uint32_t addContent(ArrayRef<uint8_t> bytes) {
+    uint32_t offset = content.size();
+    content.append(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    return offset;
+  }
+};
+
+class BinaryWriter : public lld::Writer {
+public:
+  llvm::Error writeFile(const lld::File &file, StringRef path) override;
+};
+
+llvm::Error BinaryWriter::writeFile(const lld::File &file, StringRef path) {
+  // Assign the global index every atom is referred to by.
+  llvm::DenseMap<const Atom *, uint32_t> atomIndex;
+  uint32_t nextIndex = 0;
+  for (const DefinedAtom *atom : file.defined())
+    atomIndex[atom] = nextIndex++;
+  for (const UndefinedAtom *atom : file.undefined())
+    atomIndex[atom] = nextIndex++;
+  for (const SharedLibraryAtom *atom : file.sharedLibrary())
+    atomIndex[atom] = nextIndex++;
+  for (const AbsoluteAtom *atom : file.absolute())
+    atomIndex[atom] = nextIndex++;
+
+  Pools pools;
+  std::vector<DefinedAtomRecord> defined;
+  std::vector<ReferenceRecord> references;
+  std::vector<UndefinedAtomRecord> undefined;
+  std::vector<SharedLibraryAtomRecord> sharedLib;
+  std::vector<AbsoluteAtomRecord> absolute;
+
+  defined.reserve(file.defined().size());
+  for (const DefinedAtom *atom : file.defined()) {
+    DefinedAtomRecord rec = {};
+    rec.name = pools.addString(atom->name());
+    rec.customSectionName = pools.addString(atom->customSectionName());
+    rec.ordinal = atom->ordinal();
+    rec.size = atom->size();
+    rec.sectionSize = atom->sectionSize();
+    ArrayRef<uint8_t> bytes = atom->rawContent();
+    rec.contentOffset = pools.addContent(bytes);
+    rec.contentSize = bytes.size();
+    rec.referenceStart = references.size();
+    for (const Reference *ref : *atom) {
+      ReferenceRecord refRec = {};
+      refRec.offsetInAtom = ref->offsetInAtom();
+      refRec.addend = ref->addend();
+      if (const Atom *target = ref->target()) {
+        auto it = atomIndex.find(target);
+        if (it == atomIndex.end())
+          return llvm::make_error<GenericError>(
+              "reference target is not an atom of the file being written");
+        refRec.target = it->second;
+      } else {
+        refRec.target = NoTarget;
+      }
+      refRec.kindValue = ref->kindValue();
+      refRec.kindNamespace = (uint8_t)ref->kindNamespace();
+      refRec.kindArch = (uint8_t)ref->kindArch();
+      references.push_back(refRec);
+    }
+    rec.referenceCount = references.size() - rec.referenceStart;
+    rec.alignmentValue = atom->alignment().value;
+    rec.alignmentModulus = atom->alignment().modulus;
+    rec.scope = atom->scope();
+    rec.interposable = atom->interposable();
+    rec.merge = atom->merge();
+    rec.contentType = atom->contentType();
+    rec.sectionChoice = atom->sectionChoice();
+    rec.deadStrip = atom->deadStrip();
+    rec.dynamicExport = atom->dynamicExport();
+    rec.codeModel = atom->codeModel();
+    rec.permissions = atom->permissions();
+    defined.push_back(rec);
+  }
+
+  undefined.reserve(file.undefined().size());
+  for (const UndefinedAtom *atom : file.undefined()) {
+    UndefinedAtomRecord rec = {};
+    rec.name = pools.addString(atom->name());
+    rec.canBeNull = atom->canBeNull();
+    undefined.push_back(rec);
+  }
+
+  sharedLib.reserve(file.sharedLibrary().size());
+  for (const SharedLibraryAtom *atom : file.sharedLibrary()) {
+    SharedLibraryAtomRecord rec = {};
+    rec.name = pools.addString(atom->name());
+    rec.loadName = pools.addString(atom->loadName());
+    rec.size = atom->size();
+    rec.type = (uint8_t)atom->type();
+    rec.canBeNullAtRuntime = atom->canBeNullAtRuntime();
+    sharedLib.push_back(rec);
+  }
+
+  absolute.reserve(file.absolute().size());
+  for (const AbsoluteAtom *atom : file.absolute()) {
+    AbsoluteAtomRecord rec = {};
+    rec.name = pools.addString(atom->name());
+    rec.value = atom->value();
+    rec.scope = atom->scope();
+    absolute.push_back(rec);
+  }
+
+  FileHeader header = {};
+  memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.pathString = pools.addString(file.path());
+
+  uint64_t offset = sizeof(FileHeader);
+  auto placeTable = [&](ulittle32_t &offsetField, ulittle32_t &sizeField,
+                        uint64_t size, uint64_t count) {
+    offsetField = offset;
+    sizeField = count;
+    offset += size;
+  };
+  placeTable(header.definedOffset, header.definedCount,
+             defined.size() * sizeof(DefinedAtomRecord), defined.size());
+  placeTable(header.referencesOffset, header.referencesCount,
+             references.size() * sizeof(ReferenceRecord), references.size());
+  placeTable(header.undefinedOffset, header.undefinedCount,
+             undefined.size() * sizeof(UndefinedAtomRecord), undefined.size());
+  placeTable(header.sharedLibOffset, header.sharedLibCount,
+             sharedLib.size() * sizeof(SharedLibraryAtomRecord),
+             sharedLib.size());
+  placeTable(header.absoluteOffset, header.absoluteCount,
+             absolute.size() * sizeof(AbsoluteAtomRecord), absolute.size());
+  placeTable(header.stringsOffset, header.stringsSize, pools.strings.size(),
+             pools.strings.size());
+  placeTable(header.contentOffset, header.contentSize, pools.content.size(),
+             pools.content.size());
+
+  ErrorOr<std::unique_ptr<llvm::FileOutputBuffer>> outOrErr =
+      llvm::FileOutputBuffer::create(path, offset);
+  if (std::error_code ec = outOrErr.getError())
+    return llvm::errorCodeToError(ec);
+  std::unique_ptr<llvm::FileOutputBuffer> &out = *outOrErr;
+  uint8_t *buf = out->getBufferStart();
+  auto emit = [&](const void *data, uint64_t size) {
+    if (!size)
+      return;
+    memcpy(buf, data, size);
+    buf += size;
+  };
+  emit(&header, sizeof(header));
+  emit(defined.data(), defined.size() * sizeof(DefinedAtomRecord));
+  emit(references.data(), references.size() * sizeof(ReferenceRecord));
+  emit(undefined.data(), undefined.size() * sizeof(UndefinedAtomRecord));
+  emit(sharedLib.data(), sharedLib.size() * sizeof(SharedLibraryAtomRecord));
+  emit(absolute.data(), absolute.size() * sizeof(AbsoluteAtomRecord));
+  emit(pools.strings.data(), pools.strings.size());
+  emit(pools.content.data(), pools.content.size());
+  return llvm::errorCodeToError(out->commit());
+}
+
+class BinaryReader : public Reader {
+public:
+  bool canParse(file_magic magic, MemoryBufferRef mb) const override {
+    return mb.getBufferSize() >= sizeof(FileHeader) &&
+           memcmp(mb.getBufferStart(), Magic, sizeof(Magic)) == 0;
+  }
+
+  ErrorOr<std::unique_ptr<lld::File>>
+  loadFile(std::unique_ptr<MemoryBuffer> mb,
+           const class Registry &) const override {
+    std::unique_ptr<lld::File> file(new BinaryFile(std::move(mb)));
+    return std::move(file);
+  }
+};
+
+} // end anonymous namespace
+} // end namespace binary
+
+void Registry::addSupportBinarySnapshots() {
+  add(std::unique_ptr<Reader>(new binary::BinaryReader()));
+}
+
+std::unique_ptr<Writer> createWriterBinary(const LinkingContext &) {
+  return std::unique_ptr<Writer>(new binary::BinaryWriter());
+}
+
+} // end namespace lld
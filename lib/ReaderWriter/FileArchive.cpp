@@ -10,6 +10,7 @@
 #include "lld/Core/ArchiveLibraryFile.h"
 #include "lld/Core/File.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "lld/Core/Reader.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Object/Archive.h"
@@ -43,6 +44,12 @@ public:
       : ArchiveLibraryFile(path), _mb(std::shared_ptr<MemoryBuffer>(mb.release())),
         _registry(reg), _logLoading(logLoading) {}
 
+  ~FileArchive() override {
+    // Wait for any speculative member parses still in flight; they touch
+    // files owned by _preloaded.
+    _prefetchGroup.sync();
+  }
+
   /// \brief Check if any member of the archive contains an Atom with the
   /// specified name and return the File object for that member, or nullptr.
   File *find(StringRef name) override {
@@ -64,12 +71,25 @@ public:
     _membersInstantiated.insert(memberStart);
 
     std::unique_ptr<File> result;
-    if (instantiateMember(c, result))
+    auto preloaded = _preloaded.find(memberStart);
+    if (preloaded != _preloaded.end()) {
+      // A speculative parse of this member was started when a sibling was
+      // fetched.  parse() blocks until it completes and returns its error.
+      result = std::move(preloaded->second);
+      _preloaded.erase(preloaded);
+      if (result->parse())
+        return nullptr;
+    } else if (instantiateMember(c, result)) {
       return nullptr;
+    }
 
     File *file = result.get();
     _filesReturned.push_back(std::move(result));
 
+    // Speculatively parse the members this one's undefined symbols will drag
+    // in next, so their parse latency is hidden behind resolution.
+    prefetchReferencedMembers(*file);
+
     // Give up the file pointer. It was stored and will be destroyed with destruction of FileArchive
     return file;
   }
@@ -79,11 +99,15 @@ public:
   parseAllMembers(std::vector<std::unique_ptr<File>> &result) override {
     if (std::error_code ec = parse())
       return ec;
+    // Load every member first, then parse them in parallel.  File::parse()
+    // is thread-safe and caches its result, so the serial loop below just
+    // collects the error codes.
+    size_t firstMember = result.size();
     llvm::Error err = llvm::Error::success();
     for (auto mf = _archive->child_begin(err), me = _archive->child_end();
          mf != me; ++mf) {
       std::unique_ptr<File> file;
-      if (std::error_code ec = instantiateMember(*mf, file)) {
+      if (std::error_code ec = loadMember(*mf, file)) {
         // err is Success (or we wouldn't be in the loop body) but we can't
         // return without testing or consuming it.
         consumeError(std::move(err));
@@ -93,6 +117,11 @@ public:
     }
     if (err)
       return errorToErrorCode(std::move(err));
+    parallel_for_each(result.begin() + firstMember, result.end(),
+                      [](std::unique_ptr<File> &file) { file->parse(); });
+    for (size_t i = firstMember, e = result.size(); i != e; ++i)
+      if (std::error_code ec = result[i]->parse())
+        return ec;
     return std::error_code();
   }
 
@@ -133,8 +162,9 @@ protected:
   }
 
 private:
-  std::error_code instantiateMember(Archive::Child member,
-                                    std::unique_ptr<File> &result) const {
+  /// Create the File for a member without parsing it yet.
+  std::error_code loadMember(Archive::Child member,
+                             std::unique_ptr<File> &result) const {
     Expected<llvm::MemoryBufferRef> mbOrErr = member.getMemoryBufferRef();
     if (!mbOrErr)
       return errorToErrorCode(mbOrErr.takeError());
@@ -153,8 +183,6 @@ private:
     if (std::error_code ec = fileOrErr.getError())
       return ec;
     result = std::move(fileOrErr.get());
-    if (std::error_code ec = result->parse())
-      return ec;
     result->setArchivePath(_archive->getFileName());
 
     // The memory buffer is co-owned by the archive file and the children,
@@ -163,6 +191,39 @@ private:
     return std::error_code();
   }
 
+  std::error_code instantiateMember(Archive::Child member,
+                                    std::unique_ptr<File> &result) const {
+    if (std::error_code ec = loadMember(member, result))
+      return ec;
+    return result->parse();
+  }
+
+  /// Kick off background parses for the unreturned members that define the
+  /// undefined symbols of \p file, according to the archive symbol index.
+  /// The files are held in _preloaded until find() claims them.
+  void prefetchReferencedMembers(const File &file) {
+    for (const UndefinedAtom *atom : file.undefined()) {
+      auto member = _symbolMemberMap.find(atom->name());
+      if (member == _symbolMemberMap.end())
+        continue;
+      Expected<StringRef> buf = member->second.getBuffer();
+      if (!buf) {
+        consumeError(buf.takeError());
+        continue;
+      }
+      const char *memberStart = buf->data();
+      if (_membersInstantiated.count(memberStart) ||
+          _preloaded.count(memberStart))
+        continue;
+      std::unique_ptr<File> speculative;
+      if (loadMember(member->second, speculative))
+        continue;
+      File *f = speculative.get();
+      _preloaded[memberStart] = std::move(speculative);
+      _prefetchGroup.spawn([f] { f->parse(); });
+    }
+  }
+
   std::error_code buildTableOfContents() {
     DEBUG_WITH_TYPE("FileArchive", llvm::dbgs()
                                        << "Table of contents for archive '"
@@ -191,6 +252,8 @@ private:
   std::unique_ptr<Archive> _archive;
   MemberMap _symbolMemberMap;
   InstantiatedSet _membersInstantiated;
+  std::unordered_map<const char *, std::unique_ptr<File>> _preloaded;
+  TaskGroup _prefetchGroup;
   bool _logLoading;
   std::vector<std::unique_ptr<MemoryBuffer>> _memberBuffers;
   std::vector<std::unique_ptr<File>> _filesReturned;
@@ -1015,7 +1015,10 @@ void ArchHandler_arm::generateAtomContent(const DefinedAtom &atom,
   // Copy raw bytes.
   std::copy(atom.rawContent().begin(), atom.rawContent().end(),
             atomContentBuffer.begin());
-  // Apply fix-ups.
+  // Apply fix-ups. The atom's own address is loop-invariant; resolving
+  // it through the FindAddressForAtom callback once per reference was
+  // the hottest part of this loop.
+  uint64_t atomAddress = findAddress(atom);
   bool thumbMode = false;
   for (const Reference *ref : atom) {
     uint32_t offset = ref->offsetInAtom();
@@ -1026,7 +1029,6 @@ void ArchHandler_arm::generateAtomContent(const DefinedAtom &atom,
       targetAddress = findAddress(*target);
       targetIsThumb = isThumbFunction(*defTarg);
     }
-    uint64_t atomAddress = findAddress(atom);
     uint64_t fixupAddress = atomAddress + offset;
     if (relocatable) {
       applyFixupRelocatable(*ref, &atomContentBuffer[offset], fixupAddress,
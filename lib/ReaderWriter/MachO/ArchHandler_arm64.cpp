@@ -561,6 +561,10 @@ void ArchHandler_arm64::generateAtomContent(
                     << "\n");
   }
 #endif
+  // The atom's own address is loop-invariant; resolving it through the
+  // FindAddressForAtom callback once per reference was the hottest part
+  // of this loop.
+  uint64_t atomAddress = findAddress(atom);
   for (const Reference *ref : atom) {
     uint32_t offset = ref->offsetInAtom();
     const Atom *target = ref->target();
@@ -568,7 +572,6 @@ void ArchHandler_arm64::generateAtomContent(
     uint64_t targetAddress = 0;
     if (isa<DefinedAtom>(target))
       targetAddress = findAddress(*target);
-    uint64_t atomAddress = findAddress(atom);
     uint64_t fixupAddress = atomAddress + offset;
     if (relocatable) {
       applyFixupRelocatable(*ref, &atomContentBuffer[offset], fixupAddress,
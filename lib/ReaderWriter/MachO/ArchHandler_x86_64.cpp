@@ -518,14 +518,16 @@ void ArchHandler_x86_64::generateAtomContent(
   // Copy raw bytes.
   std::copy(atom.rawContent().begin(), atom.rawContent().end(),
             atomContentBuffer.begin());
-  // Apply fix-ups.
+  // Apply fix-ups. The atom's own address is loop-invariant; resolving
+  // it through the FindAddressForAtom callback once per reference was
+  // the hottest part of this loop.
+  uint64_t atomAddress = findAddress(atom);
   for (const Reference *ref : atom) {
     uint32_t offset = ref->offsetInAtom();
     const Atom *target = ref->target();
     uint64_t targetAddress = 0;
     if (isa<DefinedAtom>(target))
       targetAddress = findAddress(*target);
-    uint64_t atomAddress = findAddress(atom);
     uint64_t fixupAddress = atomAddress + offset;
     if (relocatable) {
       applyFixupRelocatable(*ref, &atomContentBuffer[offset],
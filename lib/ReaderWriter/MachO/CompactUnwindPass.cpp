@@ -20,9 +20,11 @@
 #include "lld/Core/DefinedAtom.h"
 #include "lld/Core/File.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "lld/Core/Reference.h"
 #include "lld/Core/Simple.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Format.h"
 
@@ -284,8 +286,8 @@ private:
   llvm::Error perform(SimpleFile &mergedFile) override {
     DEBUG(llvm::dbgs() << "MachO Compact Unwind pass\n");
 
-    std::map<const Atom *, CompactUnwindEntry> unwindLocs;
-    std::map<const Atom *, const Atom *> dwarfFrames;
+    llvm::DenseMap<const Atom *, CompactUnwindEntry> unwindLocs;
+    llvm::DenseMap<const Atom *, const Atom *> dwarfFrames;
     std::vector<const Atom *> personalities;
     uint32_t numLSDAs = 0;
 
@@ -358,7 +360,7 @@ private:
 
   void collectCompactUnwindEntries(
       const SimpleFile &mergedFile,
-      std::map<const Atom *, CompactUnwindEntry> &unwindLocs,
+      llvm::DenseMap<const Atom *, CompactUnwindEntry> &unwindLocs,
       std::vector<const Atom *> &personalities, uint32_t &numLSDAs) {
     DEBUG(llvm::dbgs() << "  Collecting __compact_unwind entries\n");
 
@@ -427,9 +429,9 @@ private:
     return entry;
   }
 
-  void
-  collectDwarfFrameEntries(const SimpleFile &mergedFile,
-                           std::map<const Atom *, const Atom *> &dwarfFrames) {
+  void collectDwarfFrameEntries(
+      const SimpleFile &mergedFile,
+      llvm::DenseMap<const Atom *, const Atom *> &dwarfFrames) {
     for (const DefinedAtom *ehFrameAtom : mergedFile.defined()) {
       if (ehFrameAtom->contentType() != DefinedAtom::typeCFI)
         continue;
@@ -449,27 +451,32 @@ private:
   ///     or too many personality functions to be accommodated.
   std::vector<CompactUnwindEntry> createUnwindInfoEntries(
       const SimpleFile &mergedFile,
-      const std::map<const Atom *, CompactUnwindEntry> &unwindLocs,
+      const llvm::DenseMap<const Atom *, CompactUnwindEntry> &unwindLocs,
       const std::vector<const Atom *> &personalities,
-      const std::map<const Atom *, const Atom *> &dwarfFrames) {
-    std::vector<CompactUnwindEntry> unwindInfos;
-
+      const llvm::DenseMap<const Atom *, const Atom *> &dwarfFrames) {
     DEBUG(llvm::dbgs() << "  Creating __unwind_info entries\n");
     // The final order in the __unwind_info section must be derived from the
     // order of typeCode atoms, since that's how they'll be put into the object
     // file eventually (yuck!).
-    for (const DefinedAtom *atom : mergedFile.defined()) {
-      if (atom->contentType() != DefinedAtom::typeCode)
-        continue;
-
-      unwindInfos.push_back(finalizeUnwindInfoEntryForAtom(
-          atom, unwindLocs, personalities, dwarfFrames));
+    std::vector<const DefinedAtom *> functions;
+    for (const DefinedAtom *atom : mergedFile.defined())
+      if (atom->contentType() == DefinedAtom::typeCode)
+        functions.push_back(atom);
+
+    // Finalizing an entry only reads the collected maps, so each function can
+    // be encoded independently.
+    std::vector<CompactUnwindEntry> unwindInfos(functions.size());
+    parallel_for(size_t(0), functions.size(), [&](size_t i) {
+      unwindInfos[i] = finalizeUnwindInfoEntryForAtom(
+          functions[i], unwindLocs, personalities, dwarfFrames);
+    });
 
-      DEBUG(llvm::dbgs() << "    Entry for " << atom->name()
-                         << ", final encoding="
-                         << llvm::format("0x%08x", unwindInfos.back().encoding)
-                         << '\n');
-    }
+    DEBUG({
+      for (size_t i = 0; i < functions.size(); ++i)
+        llvm::dbgs() << "    Entry for " << functions[i]->name()
+                     << ", final encoding="
+                     << llvm::format("0x%08x", unwindInfos[i].encoding) << '\n';
+    });
 
     return unwindInfos;
   }
@@ -479,10 +486,9 @@ private:
   /// An EH frame is considered unused if there is a corresponding compact
   /// unwind atom that doesn't require the EH frame.
   void pruneUnusedEHFrames(
-                   SimpleFile &mergedFile,
-                   const std::vector<CompactUnwindEntry> &unwindInfos,
-                   const std::map<const Atom *, CompactUnwindEntry> &unwindLocs,
-                   const std::map<const Atom *, const Atom *> &dwarfFrames) {
+      SimpleFile &mergedFile, const std::vector<CompactUnwindEntry> &unwindInfos,
+      const llvm::DenseMap<const Atom *, CompactUnwindEntry> &unwindLocs,
+      const llvm::DenseMap<const Atom *, const Atom *> &dwarfFrames) {
 
     // Worklist of all 'used' FDEs.
     std::vector<const DefinedAtom *> usedDwarfWorklist;
@@ -500,7 +506,7 @@ private:
         usedDwarfWorklist.push_back(cast<DefinedAtom>(entry.second));
 
     // Add all transitively referenced CFI atoms by processing the worklist.
-    std::set<const Atom *> usedDwarfFrames;
+    llvm::DenseSet<const Atom *> usedDwarfFrames;
     while (!usedDwarfWorklist.empty()) {
       const DefinedAtom *cfiAtom = usedDwarfWorklist.back();
       usedDwarfWorklist.pop_back();
@@ -523,9 +529,9 @@ private:
 
   CompactUnwindEntry finalizeUnwindInfoEntryForAtom(
       const DefinedAtom *function,
-      const std::map<const Atom *, CompactUnwindEntry> &unwindLocs,
+      const llvm::DenseMap<const Atom *, CompactUnwindEntry> &unwindLocs,
       const std::vector<const Atom *> &personalities,
-      const std::map<const Atom *, const Atom *> &dwarfFrames) {
+      const llvm::DenseMap<const Atom *, const Atom *> &dwarfFrames) const {
     auto unwindLoc = unwindLocs.find(function);
 
     CompactUnwindEntry entry;
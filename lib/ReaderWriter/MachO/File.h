@@ -35,7 +35,12 @@ public:
 
   /// Dummy file constructor - for virtual files.
   MachOFile(StringRef path)
-    : SimpleFile(path, File::kindMachObject) {}
+    : SimpleFile(path, File::kindMachObject), _ctx(nullptr) {}
+
+  // _atomStorage is a member of this class and so is destroyed before
+  // the base SimpleFile's owning atom vectors; destroy the atoms first
+  // so their destructors do not run on freed arena memory.
+  ~MachOFile() override { clearAtoms(); }
 
   void addDefinedAtom(StringRef name, Atom::Scope scope,
                       DefinedAtom::ContentType type, DefinedAtom::Merge merge,
@@ -54,8 +59,8 @@ public:
         inSection->alignment,
         sectionOffset % inSection->alignment);
     auto *atom =
-        new (allocator()) MachODefinedAtom(*this, name, scope, type, merge,
-                                           thumb, noDeadStrip, content, align);
+        new (_atomStorage) MachODefinedAtom(*this, name, scope, type, merge,
+                                            thumb, noDeadStrip, content, align);
     addAtomForSection(inSection, atom, sectionOffset);
   }
 
@@ -77,10 +82,10 @@ public:
         inSection->alignment,
         sectionOffset % inSection->alignment);
     auto *atom =
-        new (allocator()) MachODefinedCustomSectionAtom(*this, name, scope, type,
-                                                        merge, thumb,
-                                                        noDeadStrip, content,
-                                                        sectionName, align);
+        new (_atomStorage) MachODefinedCustomSectionAtom(*this, name, scope,
+                                                         type, merge, thumb,
+                                                         noDeadStrip, content,
+                                                         sectionName, align);
     addAtomForSection(inSection, atom, sectionOffset);
   }
 
@@ -109,8 +114,8 @@ public:
     }
 
     auto *atom =
-        new (allocator()) MachODefinedAtom(*this, name, scope, type, size,
-                                           noDeadStrip, align);
+        new (_atomStorage) MachODefinedAtom(*this, name, scope, type, size,
+                                            noDeadStrip, align);
     addAtomForSection(inSection, atom, sectionOffset);
   }
 
@@ -119,7 +124,7 @@ public:
       // Make a copy of the atom's name that is owned by this file.
       name = name.copy(allocator());
     }
-    auto *atom = new (allocator()) SimpleUndefinedAtom(*this, name);
+    auto *atom = new (_atomStorage) SimpleUndefinedAtom(*this, name);
     addAtom(*atom);
     _undefAtoms[name] = atom;
   }
@@ -130,8 +135,8 @@ public:
       // Make a copy of the atom's name that is owned by this file.
       name = name.copy(allocator());
     }
-    auto *atom =
-        new (allocator()) MachOTentativeDefAtom(*this, name, scope, size, align);
+    auto *atom = new (_atomStorage)
+        MachOTentativeDefAtom(*this, name, scope, size, align);
     addAtom(*atom);
     _undefAtoms[name] = atom;
   }
@@ -231,6 +236,8 @@ public:
     return F->kind() == File::kindMachObject;
   }
 
+  MachOLinkingContext *ctx() const { return _ctx; }
+
   void setDebugInfo(std::unique_ptr<DebugInfo> debugInfo) {
     _debugInfo = std::move(debugInfo);
   }
@@ -266,6 +273,16 @@ private:
                          std::vector<SectionOffsetAndAtom>>  SectionToAtoms;
   typedef llvm::StringMap<const lld::Atom *> NameToAtom;
 
+  // Atom objects get their own arena, separate from the file's
+  // general allocator() that also holds copied names, content and
+  // references. Interleaving atom headers with those variable-sized
+  // copies spreads them across slabs, and Resolver and pass
+  // traversals then miss cache on almost every atom; a dedicated
+  // arena keeps the headers densely packed in allocation order. The
+  // atoms' destructors still run via the OwningAtomPtrs registered
+  // by addAtom(); the arena only provides storage.
+  mutable llvm::BumpPtrAllocator _atomStorage;
+
   std::unique_ptr<MemoryBuffer> _mb;
   MachOLinkingContext          *_ctx;
   SectionToAtoms                _sectionAtoms;
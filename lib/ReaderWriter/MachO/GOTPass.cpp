@@ -38,6 +38,7 @@
 #include "lld/Core/DefinedAtom.h"
 #include "lld/Core/File.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "lld/Core/Reference.h"
 #include "lld/Core/Simple.h"
 #include "llvm/ADT/DenseMap.h"
@@ -98,23 +99,53 @@ public:
   }
 
 private:
+  bool isSplittable() const override { return true; }
+  uint32_t reads() const override { return resourceGOTReferences; }
+  uint32_t writes() const override { return resourceGOTReferences; }
+
   llvm::Error perform(SimpleFile &mergedFile) override {
-    // Scan all references in all atoms.
-    for (const DefinedAtom *atom : mergedFile.defined()) {
-      for (const Reference *ref : *atom) {
-        // Look at instructions accessing the GOT.
-        bool canBypassGOT;
-        if (!_archHandler.isGOTAccess(*ref, canBypassGOT))
-          continue;
-        const Atom *target = ref->target();
-        assert(target != nullptr);
-
-        if (!shouldReplaceTargetWithGOTAtom(target, canBypassGOT)) {
+    if (llvm::Error EC = sweep(mergedFile))
+      return EC;
+    return commit(mergedFile);
+  }
+
+  llvm::Error sweep(SimpleFile &mergedFile) override {
+    // Scan all references in all atoms, sharded across threads. The
+    // scan only reads atoms and their targets; references are rewritten
+    // and GOT entries created in commit(), walking the shards in atom
+    // order so the result is deterministic.
+    File::AtomRange<DefinedAtom> atoms = mergedFile.defined();
+    size_t numShards = atoms.size() < 1024 ? 1 : 16;
+    size_t step = (atoms.size() + numShards - 1) / numShards;
+    _shards.resize(numShards);
+    parallel_for(size_t(0), numShards, [&](size_t i) {
+      size_t end = std::min(atoms.size(), (i + 1) * step);
+      for (size_t j = i * step; j < end; ++j) {
+        for (const Reference *ref : *atoms[j].get()) {
+          // Look at instructions accessing the GOT.
+          bool canBypassGOT;
+          if (!_archHandler.isGOTAccess(*ref, canBypassGOT))
+            continue;
+          const Atom *target = ref->target();
+          assert(target != nullptr);
+          _shards[i].emplace_back(
+              ref, shouldReplaceTargetWithGOTAtom(target, canBypassGOT));
+        }
+      }
+    });
+    return llvm::Error::success();
+  }
+
+  llvm::Error commit(SimpleFile &mergedFile) override {
+    for (auto &shard : _shards) {
+      for (auto &use : shard) {
+        const Reference *ref = use.first;
+        if (!use.second) {
           // Update reference kind to reflect that target is a direct accesss.
           _archHandler.updateReferenceToGOT(ref, false);
         } else {
           // Replace the target with a reference to a GOT entry.
-          const DefinedAtom *gotEntry = makeGOTEntry(target);
+          const DefinedAtom *gotEntry = makeGOTEntry(ref->target());
           const_cast<Reference *>(ref)->setTarget(gotEntry);
           // Update reference kind to reflect that target is now a GOT entry.
           _archHandler.updateReferenceToGOT(ref, true);
@@ -173,6 +204,9 @@ private:
   mach_o::ArchHandler                             &_archHandler;
   MachOFile                                       &_file;
   llvm::DenseMap<const Atom*, const GOTEntryAtom*> _targetToGOT;
+  // GOT uses found by sweep(), per shard: the reference and whether its
+  // target needs a real GOT slot.
+  std::vector<std::vector<std::pair<const Reference *, bool>>> _shards;
 };
 
 void addGOTPass(PassManager &pm, const MachOLinkingContext &ctx) {
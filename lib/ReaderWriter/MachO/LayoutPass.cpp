@@ -196,22 +196,17 @@ static bool compareAtomsSub(const LayoutPass::SortKey &lc,
   }
 
   // Sort same permissions together.
-  DefinedAtom::ContentPermissions leftPerms = leftRoot->permissions();
-  DefinedAtom::ContentPermissions rightPerms = rightRoot->permissions();
-
-  if (leftPerms != rightPerms) {
-    DEBUG(reason =
-              formatReason("contentPerms", (int)leftPerms, (int)rightPerms));
-    return leftPerms < rightPerms;
+  if (lc._rootPerms != rc._rootPerms) {
+    DEBUG(reason = formatReason("contentPerms", (int)lc._rootPerms,
+                                (int)rc._rootPerms));
+    return lc._rootPerms < rc._rootPerms;
   }
 
   // Sort same content types together.
-  DefinedAtom::ContentType leftType = leftRoot->contentType();
-  DefinedAtom::ContentType rightType = rightRoot->contentType();
-
-  if (leftType != rightType) {
-    DEBUG(reason = formatReason("contentType", (int)leftType, (int)rightType));
-    return leftType < rightType;
+  if (lc._rootType != rc._rootType) {
+    DEBUG(reason =
+              formatReason("contentType", (int)lc._rootType, (int)rc._rootType));
+    return lc._rootType < rc._rootType;
   }
 
   // Use custom sorter if supplied.
@@ -222,23 +217,17 @@ static bool compareAtomsSub(const LayoutPass::SortKey &lc,
   }
 
   // Sort by .o order.
-  const File *leftFile = &leftRoot->file();
-  const File *rightFile = &rightRoot->file();
-
-  if (leftFile != rightFile) {
-    DEBUG(reason = formatReason(".o order", (int)leftFile->ordinal(),
-                                (int)rightFile->ordinal()));
-    return leftFile->ordinal() < rightFile->ordinal();
+  if (lc._rootFileOrdinal != rc._rootFileOrdinal) {
+    DEBUG(reason = formatReason(".o order", (int)lc._rootFileOrdinal,
+                                (int)rc._rootFileOrdinal));
+    return lc._rootFileOrdinal < rc._rootFileOrdinal;
   }
 
   // Sort by atom order with .o file.
-  uint64_t leftOrdinal = leftRoot->ordinal();
-  uint64_t rightOrdinal = rightRoot->ordinal();
-
-  if (leftOrdinal != rightOrdinal) {
-    DEBUG(reason = formatReason("ordinal", (int)leftRoot->ordinal(),
-                                (int)rightRoot->ordinal()));
-    return leftOrdinal < rightOrdinal;
+  if (lc._rootOrdinal != rc._rootOrdinal) {
+    DEBUG(reason = formatReason("ordinal", (int)lc._rootOrdinal,
+                                (int)rc._rootOrdinal));
+    return lc._rootOrdinal < rc._rootOrdinal;
   }
 
   llvm::errs() << "Unordered: <" << left->name() << "> <"
@@ -422,6 +411,7 @@ LayoutPass::buildOrdinalOverrideMap(const File::AtomRange<DefinedAtom> &range) {
 std::vector<LayoutPass::SortKey>
 LayoutPass::decorate(File::AtomRange<DefinedAtom> &atomRange) const {
   std::vector<SortKey> ret;
+  ret.reserve(atomRange.size());
   for (OwningAtomPtr<DefinedAtom> &atom : atomRange.owning_ptrs()) {
     auto ri = _followOnRoots.find(atom.get());
     auto oi = _ordinalOverrideMap.find(atom.get());
@@ -429,6 +419,18 @@ LayoutPass::decorate(File::AtomRange<DefinedAtom> &atomRange) const {
     uint64_t override = (oi == _ordinalOverrideMap.end()) ? 0 : oi->second;
     ret.push_back(SortKey(std::move(atom), root, override));
   }
+
+  // Cache each root's sort criteria as integers. The virtual calls
+  // into the root atoms happen once per atom here instead of once per
+  // comparison in the sort, and every key is written independently, so
+  // this parallelizes trivially.
+  parallel_for(size_t(0), ret.size(), [&](size_t i) {
+    SortKey &k = ret[i];
+    k._rootPerms = k._root->permissions();
+    k._rootType = k._root->contentType();
+    k._rootFileOrdinal = k._root->file().ordinal();
+    k._rootOrdinal = k._root->ordinal();
+  });
   return ret;
 }
 
@@ -461,10 +463,31 @@ llvm::Error LayoutPass::perform(SimpleFile &mergedFile) {
   });
 
   std::vector<LayoutPass::SortKey> vec = decorate(atomRange);
-  parallel_sort(vec.begin(), vec.end(),
-      [&](const LayoutPass::SortKey &l, const LayoutPass::SortKey &r) -> bool {
-        return compareAtoms(l, r, _customSorter);
-      });
+  if (_customSorter) {
+    parallel_sort(vec.begin(), vec.end(),
+        [&](const LayoutPass::SortKey &l, const LayoutPass::SortKey &r) -> bool {
+          return compareAtoms(l, r, _customSorter);
+        });
+  } else {
+    // Without a custom sorter the ordering collapses entirely to the
+    // integer keys cached in decorate(): distinct roots are ordered by
+    // (permissions, content type, file ordinal, atom ordinal), and atoms
+    // sharing a root by their override index within the chain.  Root
+    // ordinals are unique per file, so grouping by root falls out of the
+    // last two keys for free.
+    parallel_sort(vec.begin(), vec.end(),
+        [](const LayoutPass::SortKey &l, const LayoutPass::SortKey &r) -> bool {
+          if (l._root == r._root)
+            return l._override < r._override;
+          if (l._rootPerms != r._rootPerms)
+            return l._rootPerms < r._rootPerms;
+          if (l._rootType != r._rootType)
+            return l._rootType < r._rootType;
+          if (l._rootFileOrdinal != r._rootFileOrdinal)
+            return l._rootFileOrdinal < r._rootFileOrdinal;
+          return l._rootOrdinal < r._rootOrdinal;
+        });
+  }
   DEBUG(checkTransitivity(vec, _customSorter));
   undecorate(atomRange, vec);
 
@@ -478,11 +501,15 @@ llvm::Error LayoutPass::perform(SimpleFile &mergedFile) {
 }
 
 void addLayoutPass(PassManager &pm, const MachOLinkingContext &ctx) {
-  pm.add(llvm::make_unique<LayoutPass>(
-      ctx.registry(), [&](const DefinedAtom * left, const DefinedAtom * right,
-                          bool & leftBeforeRight) ->bool {
-    return ctx.customAtomOrderer(left, right, leftBeforeRight);
-  }));
+  // Only install the custom sorter when an order file was actually given;
+  // a null sorter lets the pass sort purely on cached integer keys.
+  LayoutPass::SortOverride sorter;
+  if (ctx.hasOrderFileEntries())
+    sorter = [&ctx](const DefinedAtom *left, const DefinedAtom *right,
+                    bool &leftBeforeRight) -> bool {
+      return ctx.customAtomOrderer(left, right, leftBeforeRight);
+    };
+  pm.add(llvm::make_unique<LayoutPass>(ctx.registry(), std::move(sorter)));
 }
 
 } // namespace mach_o
@@ -40,10 +40,22 @@ public:
     const DefinedAtom *_root;
     uint64_t _override;
 
+    // The root's sort criteria, cached as plain integers by decorate()
+    // so the sort comparator doesn't call back into the atom on every
+    // comparison.
+    uint32_t _rootPerms = 0;
+    uint32_t _rootType = 0;
+    uint64_t _rootFileOrdinal = 0;
+    uint64_t _rootOrdinal = 0;
+
     // Note, these are only here to appease MSVC bots which didn't like
     // the same methods being implemented/deleted in OwningAtomPtr.
     SortKey(SortKey &&key) : _atom(std::move(key._atom)), _root(key._root),
-                             _override(key._override) {
+                             _override(key._override),
+                             _rootPerms(key._rootPerms),
+                             _rootType(key._rootType),
+                             _rootFileOrdinal(key._rootFileOrdinal),
+                             _rootOrdinal(key._rootOrdinal) {
       key._root = nullptr;
     }
 
@@ -52,6 +64,10 @@ public:
       _root = key._root;
       key._root = nullptr;
       _override = key._override;
+      _rootPerms = key._rootPerms;
+      _rootType = key._rootType;
+      _rootFileOrdinal = key._rootFileOrdinal;
+      _rootOrdinal = key._rootOrdinal;
       return *this;
     }
 
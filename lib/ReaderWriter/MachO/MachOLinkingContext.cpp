@@ -463,6 +463,32 @@ bool MachOLinkingContext::fileExists(StringRef path) const {
   return found;
 }
 
+bool MachOLinkingContext::probeFileExists(StringRef path) const {
+  // Test mode bypasses the filesystem entirely; keep its semantics.
+  if (_testingFileUsage)
+    return fileExists(path);
+
+  StringRef dir = llvm::sys::path::parent_path(path);
+  StringRef name = llvm::sys::path::filename(path);
+  auto it = _dirListingCache.find(dir);
+  if (it == _dirListingCache.end()) {
+    // Read the directory once; every other probe against it is then a
+    // hash lookup. An unreadable directory caches as empty, so repeated
+    // probes of a missing search dir cost nothing.
+    llvm::StringSet<> &listing = _dirListingCache[dir];
+    std::error_code ec;
+    for (llvm::sys::fs::directory_iterator i(dir, ec), e; !ec && i != e;
+         i.increment(ec))
+      listing.insert(llvm::sys::path::filename(i->path()));
+    it = _dirListingCache.find(dir);
+  }
+
+  bool found = it->second.count(name);
+  if (!found)
+    addInputFileNotFound(path);
+  return found;
+}
+
 void MachOLinkingContext::setSysLibRoots(const StringRefVector &paths) {
   _syslibRoots = paths;
 }
@@ -535,7 +561,7 @@ MachOLinkingContext::searchDirForLibrary(StringRef path,
     // A request ending in .o is special: just search for the file directly.
     fullPath.assign(path);
     llvm::sys::path::append(fullPath, libName);
-    if (fileExists(fullPath))
+    if (probeFileExists(fullPath))
       return fullPath.str().copy(_allocator);
     return llvm::None;
   }
@@ -543,13 +569,13 @@ MachOLinkingContext::searchDirForLibrary(StringRef path,
   // Search for dynamic library
   fullPath.assign(path);
   llvm::sys::path::append(fullPath, Twine("lib") + libName + ".dylib");
-  if (fileExists(fullPath))
+  if (probeFileExists(fullPath))
     return fullPath.str().copy(_allocator);
 
   // If not, try for a static library
   fullPath.assign(path);
   llvm::sys::path::append(fullPath, Twine("lib") + libName + ".a");
-  if (fileExists(fullPath))
+  if (probeFileExists(fullPath))
     return fullPath.str().copy(_allocator);
 
   return llvm::None;
@@ -573,7 +599,7 @@ MachOLinkingContext::findPathForFramework(StringRef fwName) const{
   for (StringRef dir : frameworkDirs()) {
     fullPath.assign(dir);
     llvm::sys::path::append(fullPath, Twine(fwName) + ".framework", fwName);
-    if (fileExists(fullPath))
+    if (probeFileExists(fullPath))
       return fullPath.str().copy(_allocator);
   }
 
@@ -643,12 +669,12 @@ void MachOLinkingContext::addPasses(PassManager &pm) {
     mach_o::addStubsPass(pm, *this);
   if (needsCompactUnwindPass())
     mach_o::addCompactUnwindPass(pm, *this);
+  // The GOT and metadata passes declare disjoint reference footprints,
+  // so the pass manager overlaps their graph sweeps.
   if (needsGOTPass())
     mach_o::addGOTPass(pm, *this);
-  if (needsTLVPass())
-    mach_o::addTLVPass(pm, *this);
-  if (needsShimPass())
-    mach_o::addShimPass(pm, *this); // Shim pass must run after stubs pass.
+  if (needsTLVPass() || needsShimPass())
+    mach_o::addMetadataPass(pm, *this); // Must run after stubs pass.
 }
 
 Writer &MachOLinkingContext::writer() const {
@@ -659,13 +685,19 @@ Writer &MachOLinkingContext::writer() const {
 
 ErrorOr<std::unique_ptr<MemoryBuffer>>
 MachOLinkingContext::getMemoryBuffer(StringRef path) {
-  addInputFileDependency(path);
-
   ErrorOr<std::unique_ptr<MemoryBuffer>> mbOrErr =
     MemoryBuffer::getFileOrSTDIN(path);
-  if (std::error_code ec = mbOrErr.getError())
+  if (std::error_code ec = mbOrErr.getError()) {
+    addInputFileDependency(path);
     return ec;
-  std::unique_ptr<MemoryBuffer> mb = std::move(mbOrErr.get());
+  }
+  return getMemoryBuffer(path, std::move(mbOrErr.get()));
+}
+
+ErrorOr<std::unique_ptr<MemoryBuffer>>
+MachOLinkingContext::getMemoryBuffer(StringRef path,
+                                     std::unique_ptr<MemoryBuffer> mb) {
+  addInputFileDependency(path);
 
   // If buffer contains a fat file, find required arch in fat buffer
   // and switch buffer to point to just that required slice.
@@ -86,6 +86,7 @@ static std::error_code appendRelocations(Relocations &relocs, StringRef buffer,
   const any_relocation_info* relocsArray =
             reinterpret_cast<const any_relocation_info*>(buffer.begin()+reloff);
 
+  relocs.reserve(relocs.size() + nreloc);
   for(uint32_t i=0; i < nreloc; ++i) {
     relocs.push_back(unpackRelocation(relocsArray[i], bigEndian));
   }
@@ -102,6 +103,7 @@ appendIndirectSymbols(IndirectSymbols &isyms, StringRef buffer, bool isBig,
     return make_error_code(llvm::errc::executable_format_error);
   const uint8_t *indirectSymbolArray = (const uint8_t *)buffer.data();
 
+  isyms.reserve(isyms.size() + count);
   for(uint32_t i=0; i < count; ++i) {
     isyms.push_back(read32(
         indirectSymbolArray + (startIndex + i) * sizeof(uint32_t), isBig));
@@ -254,17 +256,35 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
   f->flags = smh->flags;
 
 
-  // Pre-scan load commands looking for indirect symbol table.
+  // Pre-scan load commands looking for the indirect symbol table and,
+  // for dependent dylibs, whether an export trie is present.
   uint32_t indirectSymbolTableOffset = 0;
   uint32_t indirectSymbolTableCount = 0;
+  // A dylib that records its exports in a trie only needs that trie
+  // normalized: resolution asks it for exported names, never for
+  // section contents or the nlist symbol table. Skipping the rest
+  // avoids paging in most of a large framework stack.
+  bool exportTrieOnly = false;
+  const bool isDylib = f->fileType == llvm::MachO::MH_DYLIB ||
+                       f->fileType == llvm::MachO::MH_DYLIB_STUB;
   auto ec = forEachLoadCommand(lcRange, lcCount, isBig, is64,
                                [&](uint32_t cmd, uint32_t size,
                                    const char *lc) -> bool {
-    if (cmd == LC_DYSYMTAB) {
+    switch (cmd) {
+    case LC_DYSYMTAB: {
       const dysymtab_command *d = reinterpret_cast<const dysymtab_command*>(lc);
       indirectSymbolTableOffset = read32(&d->indirectsymoff, isBig);
       indirectSymbolTableCount = read32(&d->nindirectsyms, isBig);
-      return true;
+      break;
+    }
+    case LC_DYLD_INFO:
+    case LC_DYLD_INFO_ONLY: {
+      const dyld_info_command *di =
+          reinterpret_cast<const dyld_info_command *>(lc);
+      if (isDylib && read32(&di->export_size, isBig) != 0)
+        exportTrieOnly = true;
+      break;
+    }
     }
     return false;
   });
@@ -279,7 +299,7 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
                     [&] (uint32_t cmd, uint32_t size, const char* lc) -> bool {
     switch(cmd) {
     case LC_SEGMENT_64:
-      if (is64) {
+      if (is64 && !exportTrieOnly) {
         const segment_command_64 *seg =
                               reinterpret_cast<const segment_command_64*>(lc);
         const unsigned sectionCount = read32(&seg->nsects, isBig);
@@ -322,7 +342,7 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
       }
       break;
     case LC_SEGMENT:
-      if (!is64) {
+      if (!is64 && !exportTrieOnly) {
         const segment_command *seg =
                               reinterpret_cast<const segment_command*>(lc);
         const unsigned sectionCount = read32(&seg->nsects, isBig);
@@ -364,6 +384,9 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
       }
       break;
     case LC_SYMTAB: {
+      // The export trie supersedes the symbol table for dylibs.
+      if (exportTrieOnly)
+        break;
       const symtab_command *st = reinterpret_cast<const symtab_command*>(lc);
       const char *strings = start + read32(&st->stroff, isBig);
       const uint32_t strSize = read32(&st->strsize, isBig);
@@ -379,6 +402,25 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
           return true;
         const nlist_64 *symbols =
             reinterpret_cast<const nlist_64 *>(start + symOffset);
+        // Size the symbol vectors up front so the conversion loop never
+        // reallocates. Classification only looks at the n_type byte, so
+        // this pre-pass needs no byte swapping.
+        uint32_t nStabs = 0, nUndefs = 0, nGlobals = 0, nLocals = 0;
+        for (uint32_t i = 0; i < symCount; ++i) {
+          uint8_t nType = symbols[i].n_type;
+          if (nType & N_STAB)
+            ++nStabs;
+          else if ((nType & N_TYPE) == N_UNDF)
+            ++nUndefs;
+          else if (nType & N_EXT)
+            ++nGlobals;
+          else
+            ++nLocals;
+        }
+        f->stabsSymbols.reserve(f->stabsSymbols.size() + nStabs);
+        f->undefinedSymbols.reserve(f->undefinedSymbols.size() + nUndefs);
+        f->globalSymbols.reserve(f->globalSymbols.size() + nGlobals);
+        f->localSymbols.reserve(f->localSymbols.size() + nLocals);
         // Convert each nlist_64 to a lld::mach_o::normalized::Symbol.
         for(uint32_t i=0; i < symCount; ++i) {
           nlist_64 tempSym;
@@ -411,6 +453,24 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
           return true;
         const nlist *symbols =
             reinterpret_cast<const nlist *>(start + symOffset);
+        // As above, pre-size the symbol vectors; the classification
+        // order below intentionally mirrors the conversion loop.
+        uint32_t nStabs = 0, nUndefs = 0, nGlobals = 0, nLocals = 0;
+        for (uint32_t i = 0; i < symCount; ++i) {
+          uint8_t nType = symbols[i].n_type;
+          if ((nType & N_TYPE) == N_UNDF)
+            ++nUndefs;
+          else if ((nType & (N_PEXT | N_EXT)) == N_EXT)
+            ++nGlobals;
+          else if (nType & N_STAB)
+            ++nStabs;
+          else
+            ++nLocals;
+        }
+        f->stabsSymbols.reserve(f->stabsSymbols.size() + nStabs);
+        f->undefinedSymbols.reserve(f->undefinedSymbols.size() + nUndefs);
+        f->globalSymbols.reserve(f->globalSymbols.size() + nGlobals);
+        f->localSymbols.reserve(f->localSymbols.size() + nLocals);
         // Convert each nlist to a lld::mach_o::normalized::Symbol.
         for(uint32_t i=0; i < symCount; ++i) {
           const nlist *sin = &symbols[i];
@@ -447,6 +507,8 @@ readBinary(std::unique_ptr<MemoryBuffer> &mb,
       }
       break;
     case LC_DATA_IN_CODE: {
+      if (exportTrieOnly)
+        break;
       const linkedit_data_command *ldc =
                             reinterpret_cast<const linkedit_data_command*>(lc);
       dataInCode = reinterpret_cast<const data_in_code_entry *>(
@@ -25,6 +25,7 @@
 #include "MachONormalizedFileBinaryUtils.h"
 #include "lld/Core/Error.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "llvm/ADT/ilist.h"
 #include "llvm/ADT/ilist_node.h"
 #include "llvm/ADT/SmallString.h"
@@ -1011,17 +1012,20 @@ llvm::Error MachOFileLayout::writeLoadCommands() {
 }
 
 void MachOFileLayout::writeSectionContent() {
-  for (const Section &s : _file.sections) {
+  // Each section was assigned a disjoint slice of the output file during
+  // layout, so the payload copies can be issued in parallel.  The lookup
+  // goes through find() rather than operator[] to keep _sectInfo read-only
+  // across threads.
+  parallel_for_each(_file.sections.begin(), _file.sections.end(),
+                    [&](const Section &s) {
     // Copy all section content to output buffer.
     if (isZeroFillSection(s.type))
-      continue;
+      return;
     if (s.content.empty())
-      continue;
-    uint32_t offset = _sectInfo[&s].fileOffset;
-    uint8_t *p = &_buffer[offset];
-    memcpy(p, &s.content[0], s.content.size());
-    p += s.content.size();
-  }
+      return;
+    uint32_t offset = _sectInfo.find(&s)->second.fileOffset;
+    memcpy(&_buffer[offset], &s.content[0], s.content.size());
+  });
 }
 
 void MachOFileLayout::writeRelocations() {
@@ -1038,32 +1042,45 @@ void MachOFileLayout::writeRelocations() {
 
 void MachOFileLayout::appendSymbols(const std::vector<Symbol> &symbols,
                                    uint32_t &symOffset, uint32_t &strOffset) {
-  for (const Symbol &sym : symbols) {
+  // Compute each symbol's slot in the string pool up front (a prefix
+  // sum of the name lengths), so every table entry and its string can
+  // be written independently and in parallel.
+  const size_t nlistSize = (_is64 ? sizeof(nlist_64) : sizeof(nlist));
+  std::vector<uint32_t> strOffsets(symbols.size());
+  uint32_t off = strOffset;
+  for (size_t i = 0, e = symbols.size(); i != e; ++i) {
+    strOffsets[i] = off;
+    off += symbols[i].name.size() + 1; // +1 for nul terminator.
+  }
+
+  parallel_for(size_t(0), symbols.size(), [&](size_t i) {
+    const Symbol &sym = symbols[i];
     if (_is64) {
-      nlist_64* nb = reinterpret_cast<nlist_64*>(&_buffer[symOffset]);
-      nb->n_strx = strOffset - _startOfSymbolStrings;
+      nlist_64* nb = reinterpret_cast<nlist_64*>(
+                                           &_buffer[symOffset + i*nlistSize]);
+      nb->n_strx = strOffsets[i] - _startOfSymbolStrings;
       nb->n_type = sym.type | sym.scope;
       nb->n_sect = sym.sect;
       nb->n_desc = sym.desc;
       nb->n_value = sym.value;
       if (_swap)
         swapStruct(*nb);
-      symOffset += sizeof(nlist_64);
     } else {
-      nlist* nb = reinterpret_cast<nlist*>(&_buffer[symOffset]);
-      nb->n_strx = strOffset - _startOfSymbolStrings;
+      nlist* nb = reinterpret_cast<nlist*>(&_buffer[symOffset + i*nlistSize]);
+      nb->n_strx = strOffsets[i] - _startOfSymbolStrings;
       nb->n_type = sym.type | sym.scope;
       nb->n_sect = sym.sect;
       nb->n_desc = sym.desc;
       nb->n_value = sym.value;
       if (_swap)
         swapStruct(*nb);
-      symOffset += sizeof(nlist);
     }
-    memcpy(&_buffer[strOffset], sym.name.begin(), sym.name.size());
-    strOffset += sym.name.size();
-    _buffer[strOffset++] ='\0'; // Strings in table have nul terminator.
-  }
+    memcpy(&_buffer[strOffsets[i]], sym.name.begin(), sym.name.size());
+    _buffer[strOffsets[i] + sym.name.size()] = '\0';
+  });
+
+  symOffset += nlistSize * symbols.size();
+  strOffset = off;
 }
 
 void MachOFileLayout::writeFunctionStartsInfo() {
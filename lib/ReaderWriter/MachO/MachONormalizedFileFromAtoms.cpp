@@ -26,6 +26,7 @@
 #include "MachONormalizedFileBinaryUtils.h"
 #include "lld/Core/Error.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Casting.h"
@@ -665,6 +666,11 @@ void Util::copySectionContent(NormalizedFile &file) {
     llvm_unreachable("atom not assigned to section");
   };
 
+  // Allocate every section's content buffer up front; the allocator in
+  // NormalizedFile is not thread-safe. Once addresses are assigned and
+  // the buffers exist, filling one section only reads the atom graph
+  // and the address map and writes that section's own buffer, so the
+  // sections are assembled in parallel.
   for (SectionInfo *si : _sectionInfos) {
     Section *normSect = &file.sections[si->normalizedSectionIndex];
     if (isZeroFillSection(si->type)) {
@@ -672,13 +678,20 @@ void Util::copySectionContent(NormalizedFile &file) {
       normSect->content = llvm::makeArrayRef(empty, si->size);
       continue;
     }
-    // Copy content from atoms to content buffer for section.
-    llvm::MutableArrayRef<uint8_t> sectionContent;
     if (si->size) {
       uint8_t *sectContent = file.ownedAllocations.Allocate<uint8_t>(si->size);
-      sectionContent = llvm::MutableArrayRef<uint8_t>(sectContent, si->size);
-      normSect->content = sectionContent;
+      normSect->content = llvm::makeArrayRef(sectContent, si->size);
     }
+  }
+
+  parallel_for_each(_sectionInfos.begin(), _sectionInfos.end(),
+                    [&](SectionInfo *si) {
+    if (isZeroFillSection(si->type) || !si->size)
+      return;
+    Section *normSect = &file.sections[si->normalizedSectionIndex];
+    llvm::MutableArrayRef<uint8_t> sectionContent(
+        const_cast<uint8_t *>(normSect->content.data()), si->size);
+    // Copy content from atoms to content buffer for section.
     for (AtomInfo &ai : si->atomsAndOffsets) {
       if (!ai.atom->size()) {
         assert(ai.atom->begin() == ai.atom->end() &&
@@ -691,7 +704,7 @@ void Util::copySectionContent(NormalizedFile &file) {
                                        sectionAddrForAtom, _ctx.baseAddress(),
                                        atomContent);
     }
-  }
+  });
 }
 
 void Util::copySectionInfo(NormalizedFile &file) {
@@ -1278,7 +1291,9 @@ void Util::segIndexForSection(const SectionInfo *sect, uint8_t &segmentIndex,
 }
 
 uint32_t Util::sectionIndexForAtom(const Atom *atom) {
-  uint64_t address = _atomToAddress[atom];
+  // lookup() rather than operator[]: this runs from concurrent
+  // per-section relocation encoding and must not mutate the map.
+  uint64_t address = _atomToAddress.lookup(atom);
   for (const SectionInfo *si : _sectionInfos) {
     if ((si->address <= address) && (address < si->address+si->size))
       return si->finalSectionIndex;
@@ -1309,7 +1324,11 @@ void Util::addSectionRelocs(const lld::File &, NormalizedFile &file) {
     return pos->second;
   };
 
-  for (SectionInfo *si : _sectionInfos) {
+  // Each section's relocations go into that section's own vector and
+  // the lookups above only read maps that are complete by now, so the
+  // sections are encoded in parallel.
+  parallel_for_each(_sectionInfos.begin(), _sectionInfos.end(),
+                    [&](SectionInfo *si) {
     Section &normSect = file.sections[si->normalizedSectionIndex];
     for (const AtomInfo &info : si->atomsAndOffsets) {
       const DefinedAtom *atom = info.atom;
@@ -1326,7 +1345,7 @@ void Util::addSectionRelocs(const lld::File &, NormalizedFile &file) {
                                               normSect.relocations);
       }
     }
-  }
+  });
 }
 
 void Util::addFunctionStarts(const lld::File &, NormalizedFile &file) {
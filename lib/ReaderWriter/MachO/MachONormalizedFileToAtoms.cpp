@@ -27,6 +27,7 @@
 #include "MachONormalizedFileBinaryUtils.h"
 #include "lld/Core/Error.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "llvm/DebugInfo/DWARF/DWARFFormValue.h"
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Debug.h"
@@ -224,17 +225,27 @@ Atom::Scope atomScope(uint8_t scope) {
   llvm_unreachable("unknown scope value!");
 }
 
-void appendSymbolsInSection(const std::vector<Symbol> &inSymbols,
-                            uint32_t sectionIndex,
-                            SmallVector<const Symbol *, 64> &outSyms) {
-  for (const Symbol &sym : inSymbols) {
-    // Only look at definition symbols.
-    if ((sym.type & N_TYPE) != N_SECT)
-      continue;
-    if (sym.sect != sectionIndex)
-      continue;
-    outSyms.push_back(&sym);
-  }
+// Bucket all definition symbols by their section index, so atomizing a
+// section costs one lookup instead of a scan over the whole symbol
+// table per section. Globals are appended before locals to preserve
+// the order the old per-section scans produced.
+std::vector<SmallVector<const Symbol *, 8>>
+symbolsBySection(const NormalizedFile &normalizedFile) {
+  std::vector<SmallVector<const Symbol *, 8>> buckets(
+      normalizedFile.sections.size() + 1);
+  auto add = [&](const std::vector<Symbol> &inSymbols) {
+    for (const Symbol &sym : inSymbols) {
+      // Only look at definition symbols.
+      if ((sym.type & N_TYPE) != N_SECT)
+        continue;
+      if (sym.sect == 0 || sym.sect > normalizedFile.sections.size())
+        continue;
+      buckets[sym.sect].push_back(&sym);
+    }
+  };
+  add(normalizedFile.globalSymbols);
+  add(normalizedFile.localSymbols);
+  return buckets;
 }
 
 void atomFromSymbol(DefinedAtom::ContentType atomType, const Section &section,
@@ -275,21 +286,13 @@ void atomFromSymbol(DefinedAtom::ContentType atomType, const Section &section,
 
 llvm::Error processSymboledSection(DefinedAtom::ContentType atomType,
                                    const Section &section,
+                                   ArrayRef<const Symbol *> sectionSymbols,
                                    const NormalizedFile &normalizedFile,
                                    MachOFile &file, bool scatterable,
                                    bool copyRefs) {
-  // Find section's index.
-  uint32_t sectIndex = 1;
-  for (auto &sect : normalizedFile.sections) {
-    if (&sect == &section)
-      break;
-    ++sectIndex;
-  }
-
-  // Find all symbols in this section.
-  SmallVector<const Symbol *, 64> symbols;
-  appendSymbolsInSection(normalizedFile.globalSymbols, sectIndex, symbols);
-  appendSymbolsInSection(normalizedFile.localSymbols,  sectIndex, symbols);
+  // All symbols in this section, pre-bucketed by the caller.
+  SmallVector<const Symbol *, 64> symbols(sectionSymbols.begin(),
+                                          sectionSymbols.end());
 
   // Sort symbols.
   std::sort(symbols.begin(), symbols.end(),
@@ -380,6 +383,7 @@ llvm::Error processSymboledSection(DefinedAtom::ContentType atomType,
 
 llvm::Error processSection(DefinedAtom::ContentType atomType,
                            const Section &section,
+                           ArrayRef<const Symbol *> sectionSymbols,
                            bool customSectionName,
                            const NormalizedFile &normalizedFile,
                            MachOFile &file, bool scatterable,
@@ -406,8 +410,8 @@ llvm::Error processSection(DefinedAtom::ContentType atomType,
 
   if (atomizeModel == atomizeAtSymbols) {
     // Break section up into atoms each with a fixed size.
-    return processSymboledSection(atomType, section, normalizedFile, file,
-                                  scatterable, copyRefs);
+    return processSymboledSection(atomType, section, sectionSymbols,
+                                  normalizedFile, file, scatterable, copyRefs);
   } else {
     unsigned int size;
     for (unsigned int offset = 0, e = section.content.size(); offset != e;) {
@@ -517,13 +521,29 @@ findAtomCoveringAddress(const NormalizedFile &normalizedFile, MachOFile &file,
   return atom;
 }
 
+// A Reference waiting to be attached to its atom. Relocation
+// conversion for different sections runs on the thread pool, but
+// SimpleDefinedAtom::addReference allocates from the file's
+// allocator, so conversion stages records here and they are attached
+// serially afterwards in section order.
+struct PendingReference {
+  MachODefinedAtom         *atom;
+  Reference::KindValue      kind;
+  uint32_t                  offsetInAtom;
+  const lld::Atom          *target;
+  Reference::Addend         addend;
+};
+
 // Walks all relocations for a section in a normalized .o file and
-// creates corresponding lld::Reference objects.
+// stages corresponding lld::Reference records into 'pendingRefs'.
+// Only reads the atom tables built during atom creation, so it is
+// safe to run for several sections concurrently.
 llvm::Error convertRelocs(const Section &section,
                           const NormalizedFile &normalizedFile,
                           bool scatterable,
                           MachOFile &file,
-                          ArchHandler &handler) {
+                          ArchHandler &handler,
+                          std::vector<PendingReference> &pendingRefs) {
   // Utility function for ArchHandler to find atom by its address.
   auto atomByAddr = [&] (uint32_t sectIndex, uint64_t addr,
                          const lld::Atom **atom, Reference::Addend *addend)
@@ -678,10 +698,9 @@ llvm::Error convertRelocs(const Section &section,
           });
       }
     }
-    // Instantiate an lld::Reference object and add to its atom.
-    inAtom->addReference(Reference::KindNamespace::mach_o,
-                         handler.kindArch(),
-                         kind, offsetInAtom, target, addend);
+    // Record the reference; it is turned into an lld::Reference and
+    // added to its atom once all sections have been converted.
+    pendingRefs.push_back({inAtom, kind, offsetInAtom, target, addend});
   }
 
   return llvm::Error::success();
@@ -939,6 +958,13 @@ readCompUnit(const NormalizedFile &normalizedFile,
 llvm::Error parseDebugInfo(MachOFile &file,
                            const NormalizedFile &normalizedFile, bool copyRefs) {
 
+  // If the link is not emitting a debug map (-S), the writer never
+  // consumes DebugInfo, so don't walk __debug_info/__debug_abbrev or
+  // the stabs at all.
+  if (file.ctx() && file.ctx()->debugInfoMode() ==
+                        MachOLinkingContext::DebugInfoMode::noDebugMap)
+    return llvm::Error::success();
+
   // Find the interesting debug info sections.
   const Section *debugInfo = nullptr;
   const Section *debugAbbrev = nullptr;
@@ -1435,8 +1461,15 @@ normalizedObjectToAtoms(MachOFile *file,
                     << file->path() << "\n");
   bool scatterable = ((normalizedFile.flags & MH_SUBSECTIONS_VIA_SYMBOLS) != 0);
 
+  // Bucket the symbol table by section once, instead of rescanning it
+  // for every section below.
+  std::vector<SmallVector<const Symbol *, 8>> sectionSymbols =
+      symbolsBySection(normalizedFile);
+
   // Create atoms from each section.
+  uint32_t sectIndex = 0;
   for (auto &sect : normalizedFile.sections) {
+    ++sectIndex;
 
     // If this is a debug-info section parse it specially.
     if (isDebugInfoSection(sect))
@@ -1455,8 +1488,9 @@ normalizedObjectToAtoms(MachOFile *file,
     bool customSectionName;
     DefinedAtom::ContentType atomType = atomTypeFromSection(sect,
                                                             customSectionName);
-    if (auto ec =  processSection(atomType, sect, customSectionName,
-                                  normalizedFile, *file, scatterable, copyRefs))
+    if (auto ec =  processSection(atomType, sect, sectionSymbols[sectIndex],
+                                  customSectionName, normalizedFile, *file,
+                                  scatterable, copyRefs))
       return ec;
   }
   // Create atoms from undefined symbols.
@@ -1471,16 +1505,38 @@ normalizedObjectToAtoms(MachOFile *file,
     }
   }
 
-  // Convert mach-o relocations to References
+  // Convert mach-o relocations to References. Each section is
+  // converted on the thread pool into a per-section staging vector;
+  // this is second only to atom creation in ingest cost, and the
+  // conversion only reads the atom tables built above. References are
+  // then attached to atoms serially in section order, so reference
+  // order, allocator use and error reporting match the sequential
+  // conversion.
   std::unique_ptr<mach_o::ArchHandler> handler
                                      = ArchHandler::create(normalizedFile.arch);
-  for (auto &sect : normalizedFile.sections) {
-    if (isDebugInfoSection(sect))
-      continue;
-    if (llvm::Error ec = convertRelocs(sect, normalizedFile, scatterable,
-                                       *file, *handler))
-      return ec;
-  }
+  std::vector<const Section *> relocSections;
+  for (auto &sect : normalizedFile.sections)
+    if (!isDebugInfoSection(sect))
+      relocSections.push_back(&sect);
+  std::vector<std::vector<PendingReference>> pendingRefs(relocSections.size());
+  // Every convertRelocs failure is a GenericError carrying a message,
+  // so errors cross the thread boundary as strings and the first one
+  // in section order is re-raised below.
+  std::vector<std::string> errs(relocSections.size());
+  parallel_for((size_t)0, relocSections.size(), [&](size_t i) {
+    if (llvm::Error ec = convertRelocs(*relocSections[i], normalizedFile,
+                                       scatterable, *file, *handler,
+                                       pendingRefs[i]))
+      errs[i] = llvm::toString(std::move(ec));
+  });
+  for (const std::string &err : errs)
+    if (!err.empty())
+      return llvm::make_error<GenericError>(err);
+  for (std::vector<PendingReference> &refs : pendingRefs)
+    for (PendingReference &ref : refs)
+      ref.atom->addReference(Reference::KindNamespace::mach_o,
+                             handler->kindArch(), ref.kind, ref.offsetInAtom,
+                             ref.target, ref.addend);
 
   // Add additional arch-specific References
   file->eachDefinedAtom([&](MachODefinedAtom* atom) -> void {
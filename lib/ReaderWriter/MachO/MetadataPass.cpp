@@ -0,0 +1,257 @@
+//===- lib/ReaderWriter/MachO/MetadataPass.cpp ----------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This pass fuses the former TLV and shim passes into a single sweep over
+// the atom graph. Both passes iterated all references of all defined atoms
+// back-to-back, each looking for a disjoint set of reference kinds:
+//
+// * TLV: thread-local-variable accesses are redirected through a
+//   synthesized TLVP entry and the reference kind is rewritten.
+//
+// * Shim: pc-rel non-call branches between thumb and arm code are
+//   redirected through a synthesized mode-switching shim (a tail call has
+//   no pc-rel BX, so the compiler's B instruction cannot switch modes by
+//   itself). Must run after the stubs pass.
+//
+// Classifying each reference once and dispatching to the interested
+// handler walks the graph once instead of twice. The handlers keep their
+// own synthesized-atom files so the atoms appear exactly as they did when
+// the passes were separate.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ArchHandler.h"
+#include "File.h"
+#include "MachOPasses.h"
+#include "lld/Core/DefinedAtom.h"
+#include "lld/Core/File.h"
+#include "lld/Core/LLVM.h"
+#include "lld/Core/Reference.h"
+#include "lld/Core/Simple.h"
+#include "lld/ReaderWriter/MachOLinkingContext.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+
+namespace lld {
+namespace mach_o {
+
+//
+// TLVP Entry Atom created by the TLV handler.
+//
+class TLVPEntryAtom : public SimpleDefinedAtom {
+public:
+  TLVPEntryAtom(const File &file, bool is64, StringRef name)
+      : SimpleDefinedAtom(file), _is64(is64), _name(name) {}
+
+  ~TLVPEntryAtom() override = default;
+
+  ContentType contentType() const override {
+    return DefinedAtom::typeTLVInitializerPtr;
+  }
+
+  Alignment alignment() const override {
+    return _is64 ? 8 : 4;
+  }
+
+  uint64_t size() const override {
+    return _is64 ? 8 : 4;
+  }
+
+  ContentPermissions permissions() const override {
+    return DefinedAtom::permRW_;
+  }
+
+  ArrayRef<uint8_t> rawContent() const override {
+    static const uint8_t zeros[] =
+      { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    return llvm::makeArrayRef(zeros, size());
+  }
+
+  StringRef slotName() const {
+    return _name;
+  }
+
+private:
+  const bool _is64;
+  StringRef _name;
+};
+
+class MetadataPass : public Pass {
+public:
+  MetadataPass(const MachOLinkingContext &context)
+      : _ctx(context), _archHandler(_ctx.archHandler()),
+        _doTLV(_ctx.needsTLVPass()), _doShim(_ctx.needsShimPass()) {
+    // Only make the per-handler files that will be used so file ordinals
+    // match the separate passes.
+    if (_doTLV) {
+      _tlvFile = _ctx.make_file<MachOFile>("<mach-o TLV pass>");
+      _tlvFile->setOrdinal(_ctx.getNextOrdinalAndIncrement());
+    }
+    if (_doShim) {
+      _shimFile = _ctx.make_file<MachOFile>("<mach-o shim pass>");
+      _shimFile->setOrdinal(_ctx.getNextOrdinalAndIncrement());
+    }
+  }
+
+private:
+  bool isSplittable() const override { return true; }
+  uint32_t reads() const override {
+    return resourceTLVReferences | resourceBranchReferences;
+  }
+  uint32_t writes() const override {
+    return resourceTLVReferences | resourceBranchReferences;
+  }
+
+  llvm::Error perform(SimpleFile &mergedFile) override {
+    if (llvm::Error EC = sweep(mergedFile))
+      return EC;
+    return commit(mergedFile);
+  }
+
+  llvm::Error sweep(SimpleFile &mergedFile) override {
+    bool allowTLV = _ctx.minOS("10.7", "1.0");
+
+    // Scan all references in all atoms, classifying each reference
+    // once. The sweep only records what to rewrite; commit() applies
+    // the rewrites and synthesizes the entry atoms.
+    for (const DefinedAtom *atom : mergedFile.defined()) {
+      for (const Reference *ref : *atom) {
+        if (_doTLV && _archHandler.isTLVAccess(*ref)) {
+          if (!allowTLV)
+            return llvm::make_error<GenericError>(
+              "targeted OS version does not support use of thread local "
+              "variables in " + atom->name() + " for architecture " +
+              _ctx.archName());
+          assert(ref->target() != nullptr);
+          _tlvUses.push_back(ref);
+          continue;
+        }
+        if (_doShim && _archHandler.isNonCallBranch(*ref)) {
+          const Atom *target = ref->target();
+          assert(target != nullptr);
+          if (const DefinedAtom *daTarget = dyn_cast<DefinedAtom>(target)) {
+            bool atomIsThumb = _archHandler.isThumbFunction(*atom);
+            bool targetIsThumb = _archHandler.isThumbFunction(*daTarget);
+            if (atomIsThumb != targetIsThumb)
+              _shimUses.push_back({ref, atomIsThumb});
+          }
+        }
+      }
+    }
+    return llvm::Error::success();
+  }
+
+  llvm::Error commit(SimpleFile &mergedFile) override {
+    for (const Reference *ref : _tlvUses) {
+      const DefinedAtom *tlvpEntry = makeTLVPEntry(ref->target());
+      const_cast<Reference *>(ref)->setTarget(tlvpEntry);
+      _archHandler.updateReferenceToTLV(ref);
+    }
+
+    for (ShimUse &use : _shimUses)
+      updateBranchToUseShim(use.thumbToArm,
+                            *cast<DefinedAtom>(use.ref->target()), use.ref);
+
+    // Add the synthesized atoms to the master file in the order the
+    // separate passes did: TLVP entries first, then shims, each sorted
+    // so the layout order is stable.
+    if (!_targetToTLVP.empty()) {
+      std::vector<const TLVPEntryAtom*> entries;
+      entries.reserve(_targetToTLVP.size());
+      for (auto &it : _targetToTLVP)
+        entries.push_back(it.second);
+      std::sort(entries.begin(), entries.end(),
+                [](const TLVPEntryAtom *lhs, const TLVPEntryAtom *rhs) {
+                  return (lhs->slotName().compare(rhs->slotName()) < 0);
+                });
+      for (const TLVPEntryAtom *slot : entries)
+        mergedFile.addAtom(*slot);
+    }
+
+    if (!_targetToShim.empty()) {
+      std::vector<const DefinedAtom *> shims;
+      shims.reserve(_targetToShim.size());
+      for (auto element : _targetToShim)
+        shims.push_back(element.second);
+      std::sort(shims.begin(), shims.end(),
+                [](const DefinedAtom *l, const DefinedAtom *r) {
+                  return (l->name() < r->name());
+                });
+      for (const DefinedAtom *shim : shims)
+        mergedFile.addAtom(*shim);
+    }
+
+    return llvm::Error::success();
+  }
+
+  const DefinedAtom *makeTLVPEntry(const Atom *target) {
+    auto pos = _targetToTLVP.find(target);
+
+    if (pos != _targetToTLVP.end())
+      return pos->second;
+
+    auto *tlvpEntry = new (_tlvFile->allocator())
+      TLVPEntryAtom(*_tlvFile, _ctx.is64Bit(), target->name());
+    _targetToTLVP[target] = tlvpEntry;
+    const ArchHandler::ReferenceInfo &nlInfo =
+      _archHandler.stubInfo().nonLazyPointerReferenceToBinder;
+    tlvpEntry->addReference(Reference::KindNamespace::mach_o, nlInfo.arch,
+                            nlInfo.kind, 0, target, 0);
+    return tlvpEntry;
+  }
+
+  void updateBranchToUseShim(bool thumbToArm, const DefinedAtom& target,
+                             const Reference *ref) {
+    // Make file-format specific stub and other support atoms.
+    const DefinedAtom *shim = this->getShim(thumbToArm, target);
+    assert(shim != nullptr);
+    // Switch branch site to target shim atom.
+    const_cast<Reference *>(ref)->setTarget(shim);
+  }
+
+  const DefinedAtom* getShim(bool thumbToArm, const DefinedAtom& target) {
+    auto pos = _targetToShim.find(&target);
+    if ( pos != _targetToShim.end() ) {
+      // Reuse an existing shim.
+      assert(pos->second != nullptr);
+      return pos->second;
+    } else {
+      // There is no existing shim, so create a new one.
+      const DefinedAtom *shim = _archHandler.createShim(*_shimFile, thumbToArm,
+                                                        target);
+       _targetToShim[&target] = shim;
+       return shim;
+    }
+  }
+
+  // A branch needing a mode-switch shim, found by sweep().
+  struct ShimUse {
+    const Reference *ref;
+    bool thumbToArm;
+  };
+
+  const MachOLinkingContext &_ctx;
+  mach_o::ArchHandler &_archHandler;
+  const bool           _doTLV;
+  const bool           _doShim;
+  MachOFile           *_tlvFile = nullptr;
+  MachOFile           *_shimFile = nullptr;
+  llvm::DenseMap<const Atom*, const TLVPEntryAtom*> _targetToTLVP;
+  llvm::DenseMap<const Atom*, const DefinedAtom*>   _targetToShim;
+  std::vector<const Reference *> _tlvUses;
+  std::vector<ShimUse>           _shimUses;
+};
+
+void addMetadataPass(PassManager &pm, const MachOLinkingContext &ctx) {
+  assert(ctx.needsTLVPass() || ctx.needsShimPass());
+  pm.add(llvm::make_unique<MetadataPass>(ctx));
+}
+
+} // end namespace mach_o
+} // end namespace lld
@@ -20,6 +20,7 @@
 #include "lld/Core/DefinedAtom.h"
 #include "lld/Core/File.h"
 #include "lld/Core/LLVM.h"
+#include "lld/Core/Parallel.h"
 #include "lld/Core/Reference.h"
 #include "lld/Core/Simple.h"
 #include "lld/ReaderWriter/MachOLinkingContext.h"
@@ -220,28 +221,42 @@ public:
     if (!this->noTextRelocs())
       return llvm::Error::success();
 
-    // Scan all references in all atoms.
-    for (const DefinedAtom *atom : mergedFile.defined()) {
-      for (const Reference *ref : *atom) {
-        // Look at call-sites.
-        if (!this->isCallSite(*ref))
-          continue;
-        const Atom *target = ref->target();
-        assert(target != nullptr);
-        if (isa<SharedLibraryAtom>(target)) {
-          // Calls to shared libraries go through stubs.
-          _targetToUses[target].push_back(ref);
-          continue;
-        }
-        const DefinedAtom *defTarget = dyn_cast<DefinedAtom>(target);
-        if (defTarget && defTarget->interposable() != DefinedAtom::interposeNo){
-          // Calls to interposable functions in same linkage unit must also go
-          // through a stub.
-          assert(defTarget->scope() != DefinedAtom::scopeTranslationUnit);
-          _targetToUses[target].push_back(ref);
+    // Scan all references in all atoms, sharded across threads. The
+    // scan is read-only; the uses are folded into _targetToUses
+    // serially, walking the shards in atom order so the use lists come
+    // out in the same order a sequential scan would produce.
+    File::AtomRange<DefinedAtom> atoms = mergedFile.defined();
+    size_t numShards = atoms.size() < 1024 ? 1 : 16;
+    size_t step = (atoms.size() + numShards - 1) / numShards;
+    std::vector<std::vector<const Reference *>> shards(numShards);
+    parallel_for(size_t(0), numShards, [&](size_t i) {
+      size_t end = std::min(atoms.size(), (i + 1) * step);
+      for (size_t j = i * step; j < end; ++j) {
+        for (const Reference *ref : *atoms[j].get()) {
+          // Look at call-sites.
+          if (!this->isCallSite(*ref))
+            continue;
+          const Atom *target = ref->target();
+          assert(target != nullptr);
+          if (isa<SharedLibraryAtom>(target)) {
+            // Calls to shared libraries go through stubs.
+            shards[i].push_back(ref);
+            continue;
+          }
+          const DefinedAtom *defTarget = dyn_cast<DefinedAtom>(target);
+          if (defTarget &&
+              defTarget->interposable() != DefinedAtom::interposeNo) {
+            // Calls to interposable functions in same linkage unit must also
+            // go through a stub.
+            assert(defTarget->scope() != DefinedAtom::scopeTranslationUnit);
+            shards[i].push_back(ref);
+          }
         }
       }
-    }
+    });
+    for (std::vector<const Reference *> &shard : shards)
+      for (const Reference *ref : shard)
+        _targetToUses[ref->target()].push_back(ref);
 
     // Exit early if no stubs needed.
     if (_targetToUses.empty())
@@ -667,8 +667,16 @@ template <> struct MappingTraits<const lld::File *> {
     }
 
     // Allocate a new copy of this string in _storage, so the strings
-    // can be freed when File is destroyed.
+    // can be freed when File is destroyed.  Unquoted scalars are handed to us
+    // as slices of the mmapped input buffer; that buffer is retained for the
+    // life of this File (via setSharedMemoryBuffer), so such strings can be
+    // used as-is without copying.
     StringRef copyString(StringRef str) {
+      YamlContext *info = reinterpret_cast<YamlContext *>(_io.getContext());
+      if (info && !info->_backingStorage.empty() &&
+          str.data() >= info->_backingStorage.begin() &&
+          str.end() <= info->_backingStorage.end())
+        return str;
       char *s = _storage.Allocate<char>(str.size());
       memcpy(s, str.data(), str.size());
       return StringRef(s, str.size());
@@ -1361,6 +1369,9 @@ public:
     YamlContext yamlContext;
     yamlContext._registry = &_registry;
     yamlContext._path = mb->getBufferIdentifier();
+    // The buffer is retained on the produced File below, so strings parsed
+    // out of it can be referenced in place instead of copied.
+    yamlContext._backingStorage = mb->getBuffer();
     llvm::yaml::Input yin(mb->getBuffer(), &yamlContext);
 
     // Fill vector with File objects created by parsing yaml.
@@ -9,19 +9,140 @@
 
 #include "lld/Support/Memory.h"
 
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 using namespace llvm;
 
 namespace lld {
-BumpPtrAllocator BAlloc;
-StringSaver Saver{BAlloc};
+HugePageArena BAlloc;
+
+// Strings are small and never walked in bulk, so they don't benefit
+// from huge pages; keep them in a plain malloc-backed arena.
+static BumpPtrAllocator StringAlloc;
+StringSaver Saver{StringAlloc};
+
+// Slab mappings returned by a resetArenas() epoch boundary are parked
+// here instead of being unmapped, keyed by their mapping size, so the
+// next epoch's allocations get back already-faulted (and possibly
+// THP-promoted) memory. freeArena() drains the cache for real.
+static std::mutex SlabCacheMu;
+static std::vector<std::pair<void *, size_t>> SlabCache;
+
+// Per-epoch statistics; see getArenaStats().
+static std::atomic<size_t> EpochBytes;
+static std::atomic<size_t> EpochSlabsMapped;
+static std::atomic<size_t> EpochSlabsReused;
 
-SpecificAllocBase::SpecificAllocBase() { Instances.push_back(this); }
+void *HugePageAllocator::Allocate(size_t Size, size_t Alignment) {
+  EpochBytes += Size;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (Size >= HugePageSize) {
+    // Round the mapping up to a whole number of huge pages; the kernel
+    // only promotes fully populated, aligned 2 MB extents. madvise is
+    // advisory, so if THP is disabled the mapping simply stays backed
+    // by normal pages.
+    size_t MapSize = alignTo(Size, HugePageSize);
+
+    // Reuse a cached slab if one of exactly this size is parked.
+    // Arena slab sizes follow the same growth sequence every link, so
+    // after the first link almost every request hits the cache. Only
+    // exact matches are taken because Deallocate recomputes the
+    // mapping size from the allocation size.
+    {
+      std::lock_guard<std::mutex> Lock(SlabCacheMu);
+      for (size_t I = 0, E = SlabCache.size(); I != E; ++I) {
+        if (SlabCache[I].second != MapSize)
+          continue;
+        void *P = SlabCache[I].first;
+        SlabCache.erase(SlabCache.begin() + I);
+        ++EpochSlabsReused;
+        return P;
+      }
+    }
+
+    void *P = ::mmap(nullptr, MapSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (P == MAP_FAILED)
+      report_fatal_error("arena slab allocation failed");
+    (void)::madvise(P, MapSize, MADV_HUGEPAGE);
+    ++EpochSlabsMapped;
+    return P;
+  }
+#endif
+  return MallocAllocator().Allocate(Size, Alignment);
+}
+
+void HugePageAllocator::Deallocate(const void *Ptr, size_t Size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (Size >= HugePageSize) {
+    std::lock_guard<std::mutex> Lock(SlabCacheMu);
+    SlabCache.emplace_back(const_cast<void *>(Ptr),
+                           alignTo(Size, HugePageSize));
+    return;
+  }
+#endif
+  MallocAllocator().Deallocate(Ptr, Size);
+}
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+static void drainSlabCache() {
+  std::lock_guard<std::mutex> Lock(SlabCacheMu);
+  for (std::pair<void *, size_t> &Slab : SlabCache)
+    ::munmap(Slab.first, Slab.second);
+  SlabCache.clear();
+}
+#else
+static void drainSlabCache() {}
+#endif
 
 std::vector<SpecificAllocBase *> SpecificAllocBase::Instances;
 
+// Arenas are created lazily by whichever thread first allocates a
+// given type, so registration must be locked.
+static std::mutex Mu;
+
+void SpecificAllocBase::add(SpecificAllocBase *Alloc) {
+  std::lock_guard<std::mutex> Lock(Mu);
+  Instances.push_back(Alloc);
+}
+
+void resetArenas() {
+  // Rewinding BAlloc hands all but its first slab back to
+  // HugePageAllocator::Deallocate, which parks them in the cache for
+  // the next epoch rather than unmapping them. Destructor-bearing
+  // arenas still pay for their destructor sweep; the reuse is what
+  // avoids re-faulting slab pages on the next link.
+  for (SpecificAllocBase *Alloc : SpecificAllocBase::Instances)
+    Alloc->reset();
+  BAlloc.Reset();
+  StringAlloc.Reset();
+  EpochBytes = 0;
+  EpochSlabsMapped = 0;
+  EpochSlabsReused = 0;
+}
+
+ArenaStats getArenaStats() {
+  ArenaStats S;
+  S.BytesAllocated = EpochBytes;
+  S.SlabsMapped = EpochSlabsMapped;
+  S.SlabsReused = EpochSlabsReused;
+  return S;
+}
+
 void freeArena() {
   for (SpecificAllocBase *Alloc : SpecificAllocBase::Instances)
     Alloc->reset();
   BAlloc.Reset();
+  StringAlloc.Reset();
+  drainSlabCache();
 }
 }
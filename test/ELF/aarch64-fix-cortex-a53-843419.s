@@ -0,0 +1,32 @@
+# RUN: llvm-mc -filetype=obj -triple=aarch64-unknown-freebsd %s -o %t.o
+# RUN: echo "SECTIONS { .text 0x10000 : { *(.text) } .data : { *(.data) } }" > %t.script
+# RUN: ld.lld --fix-cortex-a53-843419 --script %t.script %t.o -o %t
+# RUN: llvm-objdump -d %t | FileCheck %s
+# REQUIRES: aarch64
+
+# The adrp sits at 0x10ff8, the second-to-last word of a 4KiB page,
+# followed by a load and a load using the adrp result as its base:
+# the Cortex-A53 843419 erratum sequence. The final load at 0x11000
+# must be replaced with a branch to a veneer after the section, which
+# executes the moved load and branches back to 0x11004.
+
+        .text
+        .globl _start
+_start:
+        .space 4088
+        adrp x0, dat
+        ldr  x1, [x2]
+        ldr  x3, [x0, :lo12:dat]
+        ret
+
+        .data
+        .globl dat
+dat:
+        .xword 0
+
+# CHECK:      10ff8: {{.*}} adrp x0,
+# CHECK-NEXT: 10ffc: {{.*}} ldr x1, [x2]
+# CHECK-NEXT: 11000: {{.*}} b #8
+# CHECK-NEXT: 11004: {{.*}} ret
+# CHECK-NEXT: 11008: {{.*}} ldr x3, [x0,
+# CHECK-NEXT: 1100c: {{.*}} b #-8
@@ -0,0 +1,39 @@
+# REQUIRES: x86
+# RUN: llvm-mc -filetype=obj -triple=x86_64-pc-linux %s -o %t.o
+
+# RUN: echo "_foo3 _foo1 100" > %t_profile.txt
+# RUN: echo "_foo1 _foo4 50" >> %t_profile.txt
+# RUN: echo "_foo2 _foo5 10" >> %t_profile.txt
+# RUN: ld.lld --call-graph-ordering-file %t_profile.txt %t.o -o %t.out
+# RUN: llvm-objdump -s %t.out | FileCheck %s
+
+# The heaviest edges cluster _foo3, _foo1 and _foo4 together, then the
+# _foo2/_foo5 pair; sections not in the profile go last.
+
+# CHECK:      Contents of section .foo:
+# CHECK-NEXT:  201000 33114422 55
+
+# RUN: echo "_foo3 _foo1 oops" > %t_bad.txt
+# RUN: not ld.lld --call-graph-ordering-file %t_bad.txt %t.o -o %t.out 2>&1 \
+# RUN:   | FileCheck %s --check-prefix=ERR
+# ERR: malformed call graph profile line
+
+.section .foo,"ax",@progbits,unique,1
+_foo1:
+ .byte 0x11
+
+.section .foo,"ax",@progbits,unique,2
+_foo2:
+ .byte 0x22
+
+.section .foo,"ax",@progbits,unique,3
+_foo3:
+ .byte 0x33
+
+.section .foo,"ax",@progbits,unique,4
+_foo4:
+ .byte 0x44
+
+.section .foo,"ax",@progbits,unique,5
+_foo5:
+ .byte 0x55
@@ -0,0 +1,23 @@
+# REQUIRES: zlib
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld %t.o -o %t --compress-debug-sections=zlib
+# RUN: llvm-readobj -sections %t | FileCheck %s
+
+# The output debug section must carry SHF_COMPRESSED (and so start
+# with an Elf_Chdr).
+# CHECK:      Name: .debug_str
+# CHECK-NOT:  Name:
+# CHECK:      SHF_COMPRESSED
+
+# RUN: not ld.lld %t.o -o %t --compress-debug-sections=zstd 2>&1 | \
+# RUN:   FileCheck -check-prefix=ERR %s
+# ERR: unknown --compress-debug-sections value: zstd
+
+.globl _start
+_start:
+  ret
+
+.section .debug_str,"MS",@progbits,1
+.asciz "a fairly long string so that deflate has something to chew on"
+.asciz "another string for the string table"
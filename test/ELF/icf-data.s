@@ -0,0 +1,57 @@
+# REQUIRES: x86
+
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t
+
+# --icf=all only folds code; the identical .rodata sections survive.
+# RUN: ld.lld %t -o %t2 --icf=all --verbose | FileCheck --check-prefix=CODE %s
+
+# CODE-NOT: removed .rodata
+# CODE: selected .text.f1
+# CODE:   removed .text.f2
+# CODE-NOT: removed .rodata
+
+# --icf=all-data also folds read-only data.
+# RUN: ld.lld %t -o %t3 --icf=all-data --verbose | FileCheck %s
+
+# CHECK-DAG: removed .text.f2
+# CHECK-DAG: removed .rodata.d2
+# CHECK-DAG: removed .rodata.g2
+
+# In a DSO the global data symbols are exported, so their sections are
+# not folded even in all-data mode; the local ones still are.
+# RUN: ld.lld %t -o %t4 --shared --icf=all-data --verbose | \
+# RUN:   FileCheck --check-prefix=EXPORTED %s
+
+# EXPORTED-NOT: removed .rodata.g2
+# EXPORTED: removed .rodata.d2
+# EXPORTED-NOT: removed .rodata.g2
+
+.globl _start, f1, f2, g1, g2
+_start:
+  ret
+
+.section .text.f1, "ax"
+f1:
+  mov $60, %rax
+  syscall
+
+.section .text.f2, "ax"
+f2:
+  mov $60, %rax
+  syscall
+
+.section .rodata.d1, "a"
+d1:
+  .quad 1
+
+.section .rodata.d2, "a"
+d2:
+  .quad 1
+
+.section .rodata.g1, "a"
+g1:
+  .quad 2
+
+.section .rodata.g2, "a"
+g2:
+  .quad 2
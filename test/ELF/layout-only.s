@@ -0,0 +1,21 @@
+# REQUIRES: x86
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: rm -f %t1
+# RUN: ld.lld %t.o -o %t1 --layout-only=- | FileCheck %s
+# RUN: not test -e %t1
+# RUN: ld.lld %t.o -o %t1 --layout-only=%t1.json
+# RUN: FileCheck %s < %t1.json
+# RUN: not test -e %t1
+
+.global _start
+_start:
+ nop
+.global f
+f:
+ nop
+
+# CHECK:      "sections": [
+# CHECK:      {"name": ".text", "address": {{[0-9]+}}, "size": 2, "align": 4}
+# CHECK:      "symbols": [
+# CHECK-DAG:  {"name": "_start", "value": {{[0-9]+}}, "size": 0}
+# CHECK-DAG:  {"name": "f", "value": {{[0-9]+}}, "size": 0}
@@ -0,0 +1,20 @@
+# REQUIRES: x86
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld %t.o -o %t1 -Map=%t1.map
+# RUN: FileCheck %s < %t1.map
+# RUN: ld.lld %t.o -o %t2 --print-map | FileCheck %s
+# RUN: ld.lld %t.o -o %t3 -M | FileCheck %s
+
+.global _start
+_start:
+ nop
+.global f
+f:
+ nop
+
+# CHECK:      Address          Size             Align Out     In      File    Symbol
+# CHECK:      {{[0-9a-f]+}} {{[0-9a-f]+}} 4 .text
+# CHECK-NEXT: {{[0-9a-f]+}} {{[0-9a-f]+}} 4 .text
+# CHECK-NEXT: {{[0-9a-f]+}} {{[0-9a-f]+}} 4 {{.*}}map-file.s.tmp.o
+# CHECK-NEXT: {{[0-9a-f]+}} {{[0-9a-f]+}} 0 _start
+# CHECK-NEXT: {{[0-9a-f]+}} {{[0-9a-f]+}} 0 f
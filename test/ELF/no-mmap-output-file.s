@@ -0,0 +1,11 @@
+// RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+// RUN: ld.lld --no-mmap-output-file %t.o -o %t
+// RUN: llvm-readobj -file-headers %t | FileCheck %s
+
+// The in-memory output engine must produce the same file as the
+// default mmap'ed FileOutputBuffer.
+// CHECK: Type: Executable
+
+.globl _start
+_start:
+  ret
@@ -0,0 +1,30 @@
+// RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+// RUN: ld.lld -shared --pack-dyn-relocs=relr %t.o -o %t.so
+// RUN: llvm-readobj -sections -dynamic-table -r %t.so | FileCheck %s
+
+// All relocations here are word-aligned relative relocations, so
+// .rela.dyn should be empty and .relr.dyn should hold them. A run of
+// eight adjacent words fits in one address entry plus one bitmap
+// word (SHT_RELR is type 19, DT_RELRSZ/DT_RELR/DT_RELRENT are
+// 0x23/0x24/0x25).
+// CHECK:      Name: .relr.dyn
+// CHECK-NEXT: Type: Unknown (0x13)
+// CHECK:      Size: 16
+
+// CHECK:      0x0000000000000023
+// CHECK:      0x0000000000000024
+// CHECK:      0x0000000000000025
+
+// CHECK:      Relocations [
+// CHECK-NEXT: ]
+
+.data
+.balign 8
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
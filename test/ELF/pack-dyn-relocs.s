@@ -0,0 +1,33 @@
+// RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+
+// RUN: ld.lld -shared --pack-dyn-relocs=none %t.o -o %t.so
+// RUN: llvm-readobj -sections %t.so | FileCheck --check-prefix=NONE %s
+
+// NONE:      Name: .rela.dyn
+// NONE-NEXT: Type: SHT_RELA
+
+// RUN: ld.lld -shared --pack-dyn-relocs=android %t.o -o %t2.so
+// RUN: llvm-readobj -sections -dynamic-table %t2.so \
+// RUN:   | FileCheck --check-prefix=ANDROID %s
+
+// The packed section keeps its name but uses the Android section type
+// (SHT_ANDROID_RELA, 0x60000002), starts with the APS2 magic and is
+// much smaller than one Elf64_Rela per relocation.
+// ANDROID:      Name: .rela.dyn
+// ANDROID-NEXT: Type: Unknown (0x60000002)
+// ANDROID:      0x0000000060000011
+// ANDROID:      0x0000000060000012
+
+// RUN: not ld.lld -shared --pack-dyn-relocs=foo %t.o -o %t3.so 2>&1 \
+// RUN:   | FileCheck --check-prefix=ERR %s
+// ERR: unknown --pack-dyn-relocs format: foo
+
+.data
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
+.quad __ehdr_start
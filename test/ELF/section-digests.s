@@ -0,0 +1,15 @@
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld %t.o -o %t --section-digests=%t.digests
+# RUN: FileCheck %s < %t.digests
+
+# Each manifest line is "<xxHash64> <size> <name>". Identical inputs
+# must produce identical digests, so a relink is checked against the
+# first manifest.
+# RUN: ld.lld %t.o -o %t2 --section-digests=%t2.digests
+# RUN: diff %t.digests %t2.digests
+
+# CHECK: {{^[0-9a-f]{16} +[0-9]+ \.text$}}
+
+.globl _start
+_start:
+  ret
@@ -0,0 +1,28 @@
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld %t.o -o %t --separate-debug-file
+# RUN: llvm-readobj -sections %t | FileCheck %s
+# RUN: llvm-readobj -sections %t.debug | FileCheck --check-prefix=DEBUG %s
+
+# The main image must not contain the debug sections, only the
+# .gnu_debuglink stub referring to the separate file.
+# CHECK-NOT: Name: .debug_info
+# CHECK:     Name: .gnu_debuglink
+# CHECK-NOT: Name: .debug_info
+
+# The separate file holds the debug sections and its own .shstrtab.
+# DEBUG: Name: .debug_info
+# DEBUG: Name: .shstrtab
+
+# An explicit file name overrides the <output>.debug default.
+# RUN: ld.lld %t.o -o %t2 --separate-debug-file=%t2.dwo
+# RUN: llvm-readobj -sections %t2.dwo | FileCheck --check-prefix=DEBUG %s
+
+.globl _start
+_start:
+  ret
+
+.section .debug_info,"",@progbits
+  .long 0x11223344
+
+.section .debug_str,"MS",@progbits,1
+  .asciz "separate debug file test string"
@@ -0,0 +1,39 @@
+# REQUIRES: x86
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+
+## Without --sort-section, members of .rodata keep command-line order.
+# RUN: ld.lld %t.o -o %t1
+# RUN: llvm-nm -n %t1 | FileCheck --check-prefix=DEFAULT %s
+# DEFAULT: R a
+# DEFAULT: R b
+# DEFAULT: R c
+
+## With --sort-section alignment, the most aligned members come first,
+## which minimizes padding between them.
+# RUN: ld.lld --sort-section alignment %t.o -o %t2
+# RUN: llvm-nm -n %t2 | FileCheck --check-prefix=SORTED %s
+# SORTED: R c
+# SORTED: R b
+# SORTED: R a
+
+.globl _start
+_start:
+  ret
+
+.section .rodata.a,"a",@progbits
+.align 4
+.globl a
+a:
+.long 1
+
+.section .rodata.b,"a",@progbits
+.align 16
+.globl b
+b:
+.long 2
+
+.section .rodata.c,"a",@progbits
+.align 64
+.globl c
+c:
+.long 3
@@ -0,0 +1,17 @@
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+
+# A streamed link must produce the same bytes as a regular one.
+# RUN: ld.lld %t.o -o %t
+# RUN: ld.lld %t.o --stream-output > %t.streamed
+# RUN: cmp %t %t.streamed
+
+# The build-id is backfilled after the copy phase, so this
+# configuration composes fully and streams at commit; the output must
+# still be identical.
+# RUN: ld.lld %t.o --build-id=md5 -o %t2
+# RUN: ld.lld %t.o --build-id=md5 --stream-output > %t2.streamed
+# RUN: cmp %t2 %t2.streamed
+
+.globl _start
+_start:
+  ret
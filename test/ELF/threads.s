@@ -0,0 +1,17 @@
+# REQUIRES: x86
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld %t.o -o %t --threads=2
+# RUN: ld.lld %t.o -o %t --threads=2:pin
+# RUN: ld.lld %t.o -o %t --threads=1:none
+
+# RUN: not ld.lld %t.o -o %t --threads=all 2>&1 | \
+# RUN:   FileCheck --check-prefix=BADNUM %s
+# BADNUM: --threads: number expected, but got all
+
+# RUN: not ld.lld %t.o -o %t --threads=2:fast 2>&1 | \
+# RUN:   FileCheck --check-prefix=BADPOLICY %s
+# BADPOLICY: --threads: unknown policy: fast
+
+.globl _start
+_start:
+  ret
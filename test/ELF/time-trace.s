@@ -0,0 +1,14 @@
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-linux %s -o %t.o
+# RUN: ld.lld %t.o -o %t --time-trace=%t.json
+# RUN: FileCheck %s < %t.json
+
+# The profile is one Chrome trace-event JSON object with complete
+# ("ph":"X") spans carrying thread ids and microsecond timestamps.
+# CHECK: {"traceEvents":[
+# CHECK-SAME: "ph":"X"
+# CHECK-SAME: "tid":
+# CHECK-SAME: "ts":
+
+.globl _start
+_start:
+  ret
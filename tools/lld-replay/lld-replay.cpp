@@ -0,0 +1,308 @@
+//===- lld-replay.cpp -----------------------------------------------------===//
+//
+//                             The LLVM Linker
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Replays a link invocation recorded with --reproduce and reports, per
+// run: wall time, peak RSS and (on Linux) hardware counters. The
+// per-pass breakdown comes from the driver itself; pass --stats to
+// forward lld's own timing output.
+//
+// Usage: lld-replay [options] <foo.cpio>
+//   --lld=<path>   linker binary to run (default: ld.lld next to this tool)
+//   --runs=N       number of runs (default: 5)
+//   --stats        forward --stats to the linker for the pass breakdown
+//
+// The archive is the odc cpio file the driver writes for --reproduce:
+// it contains a response.txt plus a snapshot of every input file, so
+// replaying the same archive against two linker versions compares them
+// on identical inputs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(_MSC_VER) && !defined(__MINGW32__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace llvm;
+
+static void die(const Twine &Msg) {
+  errs() << "lld-replay: " << Msg << "\n";
+  exit(1);
+}
+
+// Reads one octal ASCII field of the odc cpio header.
+static uint64_t readOctal(StringRef &S, size_t Len) {
+  uint64_t V = 0;
+  if (S.size() < Len)
+    die("truncated cpio header");
+  for (size_t I = 0; I != Len; ++I)
+    V = V * 8 + (S[I] - '0');
+  S = S.substr(Len);
+  return V;
+}
+
+// Unpacks the archive into Dir and returns the in-archive path of
+// response.txt. The driver writes plain odc members, no hard links or
+// directories, so extraction is a flat loop.
+static std::string extractCpio(StringRef Archive, StringRef Dir) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+      MemoryBuffer::getFile(Archive);
+  if (!MBOrErr)
+    die("cannot open " + Archive + ": " + MBOrErr.getError().message());
+  StringRef Data = (*MBOrErr)->getBuffer();
+
+  std::string Response;
+  for (;;) {
+    if (!Data.startswith("070707"))
+      die(Archive + ": not an odc cpio archive");
+    Data = Data.substr(6);
+    for (int I = 0; I != 7; ++I)
+      readOctal(Data, 6);  // dev, ino, mode, uid, gid, nlink, rdev
+    readOctal(Data, 11);   // mtime
+    uint64_t NameSize = readOctal(Data, 6);
+    uint64_t FileSize = readOctal(Data, 11);
+    if (Data.size() < NameSize + FileSize)
+      die(Archive + ": truncated member");
+    StringRef Name = Data.substr(0, NameSize - 1); // drop the NUL
+    StringRef Contents = Data.substr(NameSize, FileSize);
+    Data = Data.substr(NameSize + FileSize);
+
+    if (Name == "TRAILER!!!")
+      break;
+    if (sys::path::filename(Name) == "response.txt")
+      Response = Name.str();
+
+    SmallString<256> Path(Dir);
+    sys::path::append(Path, Name);
+    if (std::error_code EC =
+            sys::fs::create_directories(sys::path::parent_path(Path)))
+      die("cannot create " + Path + ": " + EC.message());
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+    if (EC)
+      die("cannot write " + Path + ": " + EC.message());
+    OS << Contents;
+  }
+  if (Response.empty())
+    die(Archive + ": no response.txt in archive");
+  return Response;
+}
+
+namespace {
+struct RunResult {
+  double WallMs = 0;
+  uint64_t MaxRssKb = 0;
+  uint64_t Cycles = 0;
+  uint64_t LLCMisses = 0;
+  uint64_t ITlbMisses = 0;
+  bool HaveCounters = false;
+  int ExitCode = 0;
+};
+}
+
+#if defined(__linux__)
+static int openCounter(pid_t Pid, uint32_t Type, uint64_t Cfg) {
+  perf_event_attr Attr;
+  memset(&Attr, 0, sizeof(Attr));
+  Attr.size = sizeof(Attr);
+  Attr.type = Type;
+  Attr.config = Cfg;
+  Attr.inherit = 1; // include the linker's worker threads
+  Attr.disabled = 0;
+  Attr.exclude_kernel = 1;
+  Attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &Attr, Pid, -1, -1, 0);
+}
+
+static uint64_t readCounter(int Fd) {
+  uint64_t V = 0;
+  if (Fd >= 0 && read(Fd, &V, sizeof(V)) != sizeof(V))
+    V = 0;
+  return V;
+}
+#endif
+
+// Runs the linker once in Dir and fills in the measurements. Uses
+// fork/exec directly instead of ExecuteAndWait because we need the
+// child's rusage and a pid to attach the counters to.
+static RunResult runOnce(StringRef Dir, const std::vector<std::string> &Argv) {
+  RunResult Res;
+#if !defined(_MSC_VER) && !defined(__MINGW32__)
+  // The child blocks on this pipe until the parent has attached the
+  // performance counters, so the counters see the whole run.
+  int Gate[2];
+  if (pipe(Gate) != 0)
+    die("pipe failed");
+
+  auto Start = std::chrono::steady_clock::now();
+  pid_t Pid = fork();
+  if (Pid < 0)
+    die("fork failed");
+  if (Pid == 0) {
+    close(Gate[1]);
+    char C;
+    (void)!read(Gate[0], &C, 1);
+    close(Gate[0]);
+    if (chdir(Dir.str().c_str()) != 0)
+      _exit(127);
+    std::vector<char *> Args;
+    for (const std::string &S : Argv)
+      Args.push_back(const_cast<char *>(S.c_str()));
+    Args.push_back(nullptr);
+    execvp(Args[0], Args.data());
+    _exit(127);
+  }
+  close(Gate[0]);
+
+#if defined(__linux__)
+  int CyclesFd = openCounter(Pid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  int LLCFd = openCounter(Pid, PERF_TYPE_HW_CACHE,
+                          PERF_COUNT_HW_CACHE_LL |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  int ITlbFd = openCounter(Pid, PERF_TYPE_HW_CACHE,
+                           PERF_COUNT_HW_CACHE_ITLB |
+                               (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  Res.HaveCounters = CyclesFd >= 0;
+#endif
+
+  // Release the child.
+  (void)!write(Gate[1], "x", 1);
+  close(Gate[1]);
+
+  int Status = 0;
+  rusage RU;
+  memset(&RU, 0, sizeof(RU));
+  if (wait4(Pid, &Status, 0, &RU) != Pid)
+    die("wait4 failed");
+  auto End = std::chrono::steady_clock::now();
+
+  Res.WallMs =
+      std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
+          End - Start)
+          .count();
+  Res.MaxRssKb = (uint64_t)RU.ru_maxrss;
+  Res.ExitCode = WIFEXITED(Status) ? WEXITSTATUS(Status) : -1;
+
+#if defined(__linux__)
+  Res.Cycles = readCounter(CyclesFd);
+  Res.LLCMisses = readCounter(LLCFd);
+  Res.ITlbMisses = readCounter(ITlbFd);
+  if (CyclesFd >= 0)
+    close(CyclesFd);
+  if (LLCFd >= 0)
+    close(LLCFd);
+  if (ITlbFd >= 0)
+    close(ITlbFd);
+#endif
+#else
+  // No fork on Windows; fall back to wall time only.
+  std::vector<const char *> Args;
+  for (const std::string &S : Argv)
+    Args.push_back(S.c_str());
+  Args.push_back(nullptr);
+  auto Start = std::chrono::steady_clock::now();
+  Res.ExitCode = sys::ExecuteAndWait(Argv[0], Args.data());
+  auto End = std::chrono::steady_clock::now();
+  Res.WallMs =
+      std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(
+          End - Start)
+          .count();
+#endif
+  return Res;
+}
+
+int main(int Argc, char **Argv) {
+  std::string Lld;
+  std::string Archive;
+  int Runs = 5;
+  bool Stats = false;
+
+  for (int I = 1; I != Argc; ++I) {
+    StringRef Arg = Argv[I];
+    if (Arg.startswith("--lld="))
+      Lld = Arg.substr(6).str();
+    else if (Arg.startswith("--runs="))
+      Arg.substr(7).getAsInteger(10, Runs);
+    else if (Arg == "--stats")
+      Stats = true;
+    else if (Arg.startswith("-"))
+      die("unknown option: " + Arg);
+    else
+      Archive = Arg.str();
+  }
+  if (Archive.empty())
+    die("usage: lld-replay [--lld=<path>] [--runs=N] [--stats] <foo.cpio>");
+
+  // Default to the ld.lld next to this binary.
+  if (Lld.empty()) {
+    SmallString<256> P(sys::fs::getMainExecutable(Argv[0], (void *)&main));
+    sys::path::remove_filename(P);
+    sys::path::append(P, "ld.lld");
+    Lld = P.str().str();
+  }
+
+  SmallString<256> Dir;
+  if (std::error_code EC =
+          sys::fs::createUniqueDirectory("lld-replay", Dir))
+    die("cannot create temporary directory: " + EC.message());
+  std::string Response = extractCpio(Archive, Dir);
+
+  std::vector<std::string> Cmd;
+  Cmd.push_back(Lld);
+  Cmd.push_back("@" + Response);
+  if (Stats)
+    Cmd.push_back("--stats");
+
+  outs() << "replaying " << Archive << " (" << Runs << " runs)\n";
+  outs() << format("%4s %12s %12s %16s %16s %16s\n", "run", "wall-ms",
+                   "max-rss-kb", "cycles", "llc-misses", "itlb-misses");
+  double BestMs = 1e100;
+  for (int I = 0; I != Runs; ++I) {
+    RunResult R = runOnce(Dir, Cmd);
+    if (R.ExitCode != 0)
+      die("linker exited with code " + Twine(R.ExitCode));
+    if (R.WallMs < BestMs)
+      BestMs = R.WallMs;
+    outs() << format("%4d %12.2f %12llu ", I, R.WallMs,
+                     (unsigned long long)R.MaxRssKb);
+    if (R.HaveCounters)
+      outs() << format("%16llu %16llu %16llu",
+                       (unsigned long long)R.Cycles,
+                       (unsigned long long)R.LLCMisses,
+                       (unsigned long long)R.ITlbMisses);
+    else
+      outs() << format("%16s %16s %16s", "-", "-", "-");
+    outs() << "\n";
+  }
+  outs() << format("best %11.2f ms\n", BestMs);
+  return 0;
+}
@@ -20,11 +20,24 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/StringSaver.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 
+#if LLVM_ON_UNIX
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 using namespace lld;
 using namespace llvm;
 using namespace llvm::sys;
@@ -92,26 +105,224 @@ static Flavor parseFlavor(std::vector<const char *> &V) {
   return parseProgname(Arg0);
 }
 
-/// Universal linker main(). This linker emulates the gnu, darwin, or
-/// windows linker based on the argv[0] or -flavor option.
-int main(int Argc, const char **Argv) {
-  // Standard set up, so program fails gracefully.
-  sys::PrintStackTraceOnErrorSignal(Argv[0]);
-  PrettyStackTraceProgram StackPrinter(Argc, Argv);
-  llvm_shutdown_obj Shutdown;
-
-  std::vector<const char *> Args(Argv, Argv + Argc);
+static int dispatch(std::vector<const char *> Args, bool CanExitEarly = true) {
   switch (parseFlavor(Args)) {
   case Gnu:
-    return !elf::link(Args, true);
+    return !elf::link(Args, CanExitEarly);
   case WinLink:
     return !coff::link(Args);
   case Darwin:
     return !mach_o::link(Args);
   case Hanafuda:
-    return !hanafuda::link(Args, true);
+    return !hanafuda::link(Args, CanExitEarly);
   default:
     die("lld is a generic driver.\n"
         "Invoke ld.lld (Unix), ld (Mac) or lld-link (Windows) instead.");
   }
 }
+
+// Batch mode. "lld -batch <response-file>..." runs one link per
+// response file in a single process. Each response file holds a
+// complete command line (typically starting with -flavor), tokenized
+// with the usual response-file rules. Running many small links in one
+// process amortizes startup, keeps shared inputs warm in the OS page
+// cache, and lets the arena allocator reuse its high-water slab
+// capacity from link to link instead of re-faulting it. Links run
+// sequentially for now: the flavored drivers keep per-link global
+// state, so they are not reentrant yet.
+static int runBatch(int Argc, const char **Argv) {
+  if (Argc < 3)
+    die("usage: lld -batch <response-file>...");
+  int Ret = 0;
+  for (int I = 2; I != Argc; ++I) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> MB =
+        MemoryBuffer::getFile(Argv[I]);
+    if (!MB)
+      die("batch: cannot open " + Twine(Argv[I]));
+    BumpPtrAllocator Alloc;
+    StringSaver Saver(Alloc);
+    SmallVector<const char *, 256> Tokens;
+    Tokens.push_back(Argv[0]);
+    cl::TokenizeGNUCommandLine((*MB)->getBuffer(), Saver, Tokens);
+    // A failed link poisons the exit code but the batch carries on, so
+    // the driver must return instead of calling exit().
+    if (dispatch(std::vector<const char *>(Tokens.begin(), Tokens.end()),
+                 /*CanExitEarly=*/false))
+      Ret = 1;
+  }
+  return Ret;
+}
+
+#if LLVM_ON_UNIX
+// Daemon mode. Build systems that invoke the linker many times for
+// small outputs pay process startup (exec, dynamic loading, runtime
+// init) on every invocation. "lld -daemon <socket>" starts a resident
+// process listening on a unix socket; a client invocation with
+// LLD_DAEMON_SOCKET set forwards its argv there instead of linking
+// itself. The daemon forks a child per request, so every link starts
+// from a pristine copy of the warmed-up image and a crashed link
+// cannot poison the daemon.
+//
+// Wire format, client to daemon: the client's working directory, then
+// each argument (argv[0] excluded), all NUL-terminated, then one empty
+// string. Daemon to client: the link's diagnostic output, then a NUL
+// and a one-byte exit code. A reply without the trailer means the link
+// died before finishing and is treated as a failure.
+
+// Reads NUL-terminated strings off Fd until the terminating empty one.
+static bool readRequest(int Fd, std::vector<std::string> &Strings) {
+  std::string Cur;
+  char Buf[4096];
+  for (;;) {
+    ssize_t N = read(Fd, Buf, sizeof(Buf));
+    if (N <= 0)
+      return false;
+    for (ssize_t I = 0; I != N; ++I) {
+      if (Buf[I] != '\0') {
+        Cur += Buf[I];
+        continue;
+      }
+      if (Cur.empty())
+        return true;
+      Strings.push_back(Cur);
+      Cur.clear();
+    }
+  }
+}
+
+static void writeAll(int Fd, const char *Data, size_t Size) {
+  while (Size > 0) {
+    ssize_t N = write(Fd, Data, Size);
+    if (N <= 0)
+      return;
+    Data += N;
+    Size -= N;
+  }
+}
+
+// Serves one connection in a forked child: run the link with the
+// socket as stdout/stderr, then append the exit-code trailer.
+static void serveRequest(int Conn) {
+  std::vector<std::string> Req;
+  if (!readRequest(Conn, Req) || Req.empty() || chdir(Req[0].c_str()) != 0)
+    _exit(1);
+
+  dup2(Conn, STDOUT_FILENO);
+  dup2(Conn, STDERR_FILENO);
+
+  std::vector<const char *> Args;
+  Args.push_back("lld");
+  for (size_t I = 1, E = Req.size(); I != E; ++I)
+    Args.push_back(Req[I].c_str());
+  int Ret = dispatch(std::move(Args));
+
+  fflush(stdout);
+  char Trailer[2] = {'\0', (char)Ret};
+  writeAll(Conn, Trailer, 2);
+  _exit(Ret);
+}
+
+static int runDaemon(StringRef Path) {
+  int Sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (Sock < 0)
+    die("daemon: cannot create socket");
+  sockaddr_un Addr = {};
+  Addr.sun_family = AF_UNIX;
+  if (Path.size() >= sizeof(Addr.sun_path))
+    die("daemon: socket path too long: " + Path);
+  memcpy(Addr.sun_path, Path.data(), Path.size());
+  unlink(Addr.sun_path);
+  if (bind(Sock, (sockaddr *)&Addr, sizeof(Addr)) != 0 ||
+      listen(Sock, 8) != 0)
+    die("daemon: cannot listen on " + Path);
+
+  // Children are fire-and-forget; the client sees the result over the
+  // socket, so just keep them from becoming zombies.
+  signal(SIGCHLD, SIG_IGN);
+  signal(SIGPIPE, SIG_IGN);
+
+  for (;;) {
+    int Conn = accept(Sock, nullptr, nullptr);
+    if (Conn < 0)
+      continue;
+    pid_t Pid = fork();
+    if (Pid == 0) {
+      close(Sock);
+      serveRequest(Conn);
+    }
+    close(Conn);
+  }
+}
+
+// Forwards this invocation to the daemon at Path. Returns the exit
+// code to use, or -1 if the daemon cannot be reached (the caller then
+// links in-process as usual).
+static int runDaemonClient(StringRef Path, int Argc, const char **Argv) {
+  int Sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (Sock < 0)
+    return -1;
+  sockaddr_un Addr = {};
+  Addr.sun_family = AF_UNIX;
+  if (Path.size() >= sizeof(Addr.sun_path))
+    return -1;
+  memcpy(Addr.sun_path, Path.data(), Path.size());
+  if (connect(Sock, (sockaddr *)&Addr, sizeof(Addr)) != 0) {
+    close(Sock);
+    return -1;
+  }
+
+  SmallString<256> CWD;
+  if (fs::current_path(CWD))
+    return -1;
+  writeAll(Sock, CWD.c_str(), CWD.size() + 1);
+  for (int I = 1; I != Argc; ++I)
+    writeAll(Sock, Argv[I], strlen(Argv[I]) + 1);
+  writeAll(Sock, "", 1);
+
+  std::string Reply;
+  char Buf[4096];
+  ssize_t N;
+  while ((N = read(Sock, Buf, sizeof(Buf))) > 0)
+    Reply.append(Buf, N);
+  close(Sock);
+
+  // The trailer is the fixed last two bytes: a NUL separator followed
+  // by the exit code. The exit code byte is itself NUL on success, so
+  // the separator cannot be searched for; it must be read by position.
+  if (Reply.size() < 2 || Reply[Reply.size() - 2] != '\0') {
+    // The daemon-side link died before writing the trailer.
+    errs() << Reply;
+    return 1;
+  }
+  errs() << StringRef(Reply.data(), Reply.size() - 2);
+  return (unsigned char)Reply.back();
+}
+#endif
+
+/// Universal linker main(). This linker emulates the gnu, darwin, or
+/// windows linker based on the argv[0] or -flavor option.
+int main(int Argc, const char **Argv) {
+  // Standard set up, so program fails gracefully.
+  sys::PrintStackTraceOnErrorSignal(Argv[0]);
+  PrettyStackTraceProgram StackPrinter(Argc, Argv);
+  llvm_shutdown_obj Shutdown;
+
+  if (Argc > 1 && StringRef(Argv[1]) == "-batch")
+    return runBatch(Argc, Argv);
+
+#if LLVM_ON_UNIX
+  if (Argc > 1 && StringRef(Argv[1]) == "-daemon") {
+    if (Argc != 3)
+      die("usage: lld -daemon <socket-path>");
+    return runDaemon(Argv[2]);
+  }
+  if (const char *Socket = getenv("LLD_DAEMON_SOCKET")) {
+    int Ret = runDaemonClient(Socket, Argc, Argv);
+    if (Ret >= 0)
+      return Ret;
+    // Daemon unreachable; fall through and link in-process.
+  }
+#endif
+
+  return dispatch(std::vector<const char *>(Argv, Argv + Argc));
+}